@@ -37,13 +37,18 @@ limitations under the License.
 namespace tensorflow {
 
 constexpr BFCAllocator::ChunkHandle BFCAllocator::kInvalidChunkHandle;
+constexpr int BFCAllocator::kNumCachedBins;
+constexpr int BFCAllocator::kMaxCachedChunksPerBin;
+constexpr int BFCAllocator::kNumChunkCaches;
 
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name,
-                           bool garbage_collection)
+                           bool garbage_collection, bool use_chunk_cache)
     : garbage_collection_(garbage_collection),
       sub_allocator_(sub_allocator),
       name_(name),
+      chunk_caches_(use_chunk_cache ? new ChunkCache[kNumChunkCaches]
+                                    : nullptr),
       free_chunks_list_(kInvalidChunkHandle),
       next_allocation_id_(1) {
   if (allow_growth) {
@@ -378,6 +383,13 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // The BFC allocator tries to find the best fit first.
   BinNum bin_num = BinNumForSize(rounded_bytes);
 
+  if (chunk_caches_ != nullptr && bin_num < kNumCachedBins) {
+    void* ptr = AllocateFromChunkCache(bin_num, rounded_bytes, num_bytes);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
+
   mutex_lock l(lock_);
   if (!timestamped_chunks_.empty()) {
     // Merge timestamped chunks whose counts have become safe for general use.
@@ -389,6 +401,15 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
     return ptr;
   }
 
+  // Reuse the free chunks in the chunk caches before growing.
+  if (FlushChunkCaches()) {
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
+    if (ptr != nullptr) {
+      AddTraceMe("MemoryAllocation", ptr);
+      return ptr;
+    }
+  }
+
   // Try to extend
   if (Extend(unused_alignment, rounded_bytes)) {
     ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
@@ -533,13 +554,17 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
         chunk->requested_size = num_bytes;
         // Assign a unique id and increment the id counter, marking the
         // chunk as being in use.
-        chunk->allocation_id = next_allocation_id_++;
+        chunk->allocation_id =
+            next_allocation_id_.fetch_add(1, std::memory_order_relaxed);
 
-        // Update stats.
+        // Update stats.  Chunks in the chunk caches count as in use in
+        // stats_, but not towards the peak.
         ++stats_.num_allocs;
         stats_.bytes_in_use += chunk->size;
-        stats_.peak_bytes_in_use =
-            std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+        stats_.peak_bytes_in_use = std::max(
+            stats_.peak_bytes_in_use,
+            stats_.bytes_in_use -
+                cached_bytes_.load(std::memory_order_relaxed));
         stats_.largest_alloc_size =
             std::max<std::size_t>(stats_.largest_alloc_size, chunk->size);
 
@@ -626,11 +651,18 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     VLOG(2) << "tried to deallocate nullptr";
     return;
   }
+  if (chunk_caches_ != nullptr && DeallocateToChunkCache(ptr)) {
+    return;
+  }
   mutex_lock l(lock_);
 
   // Find the chunk from the ptr.
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle);
+  FreeChunk(h);
+}
+
+void BFCAllocator::FreeChunk(ChunkHandle h) {
   // Record chunk information before it's freed.
   Chunk* chunk = ChunkFromHandle(h);
   void* chunk_ptr = chunk->ptr;
@@ -656,6 +688,126 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
   }
 }
 
+namespace {
+// Raises `max` to `value` if it is smaller.
+void UpdateMax(std::atomic<int64>& max, int64 value) {
+  int64 current = max.load(std::memory_order_relaxed);
+  while (current < value &&
+         !max.compare_exchange_weak(current, value,
+                                    std::memory_order_relaxed)) {
+  }
+}
+}  // namespace
+
+BFCAllocator::ChunkCache* BFCAllocator::ThreadChunkCache() {
+  static std::atomic<int> next_cache_index{0};
+  static thread_local const int cache_index =
+      next_cache_index.fetch_add(1, std::memory_order_relaxed) %
+      kNumChunkCaches;
+  return &chunk_caches_[cache_index];
+}
+
+// The chunk caches only access the metadata of in-use chunks, so they hold
+// lock_ in shared mode, which the thread safety analysis does not model for
+// ChunkFromHandle().
+void* BFCAllocator::AllocateFromChunkCache(BinNum bin_num, size_t rounded_bytes,
+                                           size_t num_bytes)
+    TF_NO_THREAD_SAFETY_ANALYSIS {
+  ChunkCache* cache = ThreadChunkCache();
+  CachedChunk cached = {kInvalidChunkHandle, 0};
+  {
+    mutex_lock l(cache->mu);
+    std::vector<CachedChunk>& chunks = cache->bins[bin_num];
+    // Prefer the most recently freed chunk, whose memory is most likely to
+    // still be in the caches of the CPU.
+    for (int i = static_cast<int>(chunks.size()) - 1; i >= 0; --i) {
+      if (chunks[i].size >= rounded_bytes) {
+        cached = chunks[i];
+        chunks.erase(chunks.begin() + i);
+        break;
+      }
+    }
+  }
+  if (cached.handle == kInvalidChunkHandle) {
+    return nullptr;
+  }
+  num_cached_allocs_.fetch_add(1, std::memory_order_relaxed);
+  UpdateMax(cached_largest_alloc_size_, cached.size);
+
+  tf_shared_lock l(lock_);
+  const int64 cached_bytes =
+      cached_bytes_.fetch_sub(cached.size, std::memory_order_relaxed) -
+      cached.size;
+  // stats_.bytes_in_use only changes under lock_ in exclusive mode.
+  UpdateMax(cached_peak_bytes_in_use_, stats_.bytes_in_use - cached_bytes);
+  Chunk* chunk = ChunkFromHandle(cached.handle);
+  DCHECK(chunk->in_use());
+  chunk->requested_size = num_bytes;
+  // Like a chunk from the bins, a chunk from the cache gets a new id.
+  chunk->allocation_id =
+      next_allocation_id_.fetch_add(1, std::memory_order_relaxed);
+  return chunk->ptr;
+}
+
+bool BFCAllocator::DeallocateToChunkCache(void* ptr)
+    TF_NO_THREAD_SAFETY_ANALYSIS {
+  CachedChunk cached;
+  BinNum bin_num;
+  {
+    tf_shared_lock l(lock_);
+    cached.handle = region_manager_.get_handle(ptr);
+    CHECK(cached.handle != kInvalidChunkHandle);
+    cached.size = ChunkFromHandle(cached.handle)->size;
+    bin_num = BinNumForSize(cached.size);
+  }
+  if (bin_num >= kNumCachedBins) {
+    return false;
+  }
+
+  std::vector<CachedChunk> evicted;
+  {
+    ChunkCache* cache = ThreadChunkCache();
+    mutex_lock l(cache->mu);
+    std::vector<CachedChunk>& chunks = cache->bins[bin_num];
+    chunks.push_back(cached);
+    if (chunks.size() > static_cast<size_t>(kMaxCachedChunksPerBin)) {
+      const auto evicted_end = chunks.begin() + chunks.size() / 2;
+      evicted.assign(chunks.begin(), evicted_end);
+      chunks.erase(chunks.begin(), evicted_end);
+    }
+  }
+  cached_bytes_.fetch_add(cached.size, std::memory_order_relaxed);
+
+  if (!evicted.empty()) {
+    mutex_lock l(lock_);
+    for (const CachedChunk& c : evicted) {
+      cached_bytes_.fetch_sub(c.size, std::memory_order_relaxed);
+      FreeChunk(c.handle);
+    }
+  }
+  return true;
+}
+
+bool BFCAllocator::FlushChunkCaches() {
+  if (chunk_caches_ == nullptr) {
+    return false;
+  }
+  bool flushed = false;
+  for (int i = 0; i < kNumChunkCaches; ++i) {
+    ChunkCache& cache = chunk_caches_[i];
+    mutex_lock l(cache.mu);
+    for (std::vector<CachedChunk>& chunks : cache.bins) {
+      for (const CachedChunk& c : chunks) {
+        cached_bytes_.fetch_sub(c.size, std::memory_order_relaxed);
+        FreeChunk(c.handle);
+        flushed = true;
+      }
+      chunks.clear();
+    }
+  }
+  return flushed;
+}
+
 // Merges h1 and h2 when Chunk(h1)->next is h2 and Chunk(h2)->prev is c1.
 // We merge Chunk(h2) into Chunk(h1).
 void BFCAllocator::Merge(BFCAllocator::ChunkHandle h1,
@@ -1141,13 +1293,27 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
 
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
   mutex_lock l(lock_);
-  return stats_;
+  AllocatorStats stats = stats_;
+  // Chunks in the chunk caches are free from the point of view of the caller.
+  stats.bytes_in_use -= cached_bytes_.load(std::memory_order_relaxed);
+  stats.num_allocs += num_cached_allocs_.load(std::memory_order_relaxed);
+  stats.peak_bytes_in_use =
+      std::max(stats.peak_bytes_in_use,
+               cached_peak_bytes_in_use_.load(std::memory_order_relaxed));
+  stats.largest_alloc_size = std::max<std::size_t>(
+      stats.largest_alloc_size,
+      cached_largest_alloc_size_.load(std::memory_order_relaxed));
+  return stats;
 }
 
 void BFCAllocator::ClearStats() {
   mutex_lock l(lock_);
+  num_cached_allocs_ = 0;
+  cached_peak_bytes_in_use_ = 0;
+  cached_largest_alloc_size_ = 0;
   stats_.num_allocs = 0;
-  stats_.peak_bytes_in_use = stats_.bytes_in_use;
+  stats_.peak_bytes_in_use =
+      stats_.bytes_in_use - cached_bytes_.load(std::memory_order_relaxed);
   stats_.largest_alloc_size = 0;
 }
 
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
 #include <array>
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <string>
@@ -46,12 +47,22 @@ class MemoryDump;
 // coalescing.  One assumption we make is that the process using this
 // allocator owns pretty much all of the memory, and that nearly
 // all requests to allocate memory go through this interface.
+//
+// If 'use_chunk_cache' is true, freed chunks smaller than 16KB are kept in
+// caches that are shared by a few threads each, and are reused for
+// allocations from the same threads without taking the allocator-wide lock
+// exclusively.  This reduces contention when many threads allocate small
+// buffers concurrently, e.g. when the allocator serves the CPU devices.  A
+// cached chunk is still in use as far as the bins are concerned, so it is not
+// coalesced with its neighbors until it is returned to the bins, which
+// happens in batches when a cache fills up and for all caches before the
+// allocator grows.  The cache cannot be used together with SetTimingCounter().
 class BFCAllocator : public Allocator {
  public:
   // Takes ownership of sub_allocator.
   BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                bool allow_growth, const string& name,
-               bool garbage_collection = false);
+               bool garbage_collection = false, bool use_chunk_cache = false);
   ~BFCAllocator() override;
 
   string Name() override { return name_; }
@@ -77,7 +88,11 @@ class BFCAllocator : public Allocator {
 
   void ClearStats() override;
 
-  void SetTimingCounter(SharedCounter* sc) { timing_counter_ = sc; }
+  void SetTimingCounter(SharedCounter* sc) {
+    CHECK(chunk_caches_ == nullptr)
+        << "The chunk cache cannot be used with a timing counter";
+    timing_counter_ = sc;
+  }
 
   void SetSafeFrontier(uint64 count) override;
 
@@ -140,6 +155,16 @@ class BFCAllocator : public Allocator {
   // The following means that the largest bin'd chunk size is 256 << 21 = 512MB.
   static constexpr int kNumBins = 21;
 
+  // The chunk caches hold chunks from the first kNumCachedBins bins, i.e.
+  // chunks smaller than 256 << 6 = 16KB.
+  static constexpr int kNumCachedBins = 6;
+  // The number of chunks of each bin that a chunk cache holds before it
+  // returns half of them to the bins.
+  static constexpr int kMaxCachedChunksPerBin = 16;
+  // The number of chunk caches.  Threads are assigned to the caches
+  // round-robin.
+  static constexpr int kNumChunkCaches = 16;
+
   // A Chunk points to a piece of memory that's either entirely free or entirely
   // in use by one user memory allocation.
   //
@@ -436,6 +461,23 @@ class BFCAllocator : public Allocator {
   // Removes the chunk metadata represented by 'h'.
   void DeleteChunk(ChunkHandle h) TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Marks the in-use chunk 'h' as free and returns it to the bins.
+  void FreeChunk(ChunkHandle h) TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns a chunk of at least 'rounded_bytes' from the chunk cache of the
+  // calling thread, or nullptr if that cache has none.
+  void* AllocateFromChunkCache(BinNum bin_num, size_t rounded_bytes,
+                               size_t num_bytes) TF_LOCKS_EXCLUDED(lock_);
+
+  // Adds the chunk of 'ptr' to the chunk cache of the calling thread, and
+  // returns the oldest half of that cache to the bins if it is full.  Returns
+  // false, and does nothing, if the chunk is too large to be cached.
+  bool DeallocateToChunkCache(void* ptr) TF_LOCKS_EXCLUDED(lock_);
+
+  // Returns the chunks in all chunk caches to the bins.  Returns true if any
+  // chunk was returned.
+  bool FlushChunkCaches() TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   string RenderOccupancy() TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
   void DumpMemoryLog(size_t num_bytes) TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
   MemoryDump RecordMemoryMapInternal() TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
@@ -534,7 +576,42 @@ class BFCAllocator : public Allocator {
 
   std::atomic<uint64> safe_frontier_ = {0};
 
+  // A free chunk in a chunk cache.  The chunk is marked as in use in chunks_,
+  // so its metadata does not change while it is cached.
+  struct CachedChunk {
+    ChunkHandle handle;
+    size_t size;
+  };
+
+  struct ChunkCache {
+    // Lock ordering: lock_ < mu.
+    mutex mu;
+    // The cached chunks of each cached bin, from the least to the most
+    // recently freed.
+    std::array<std::vector<CachedChunk>, kNumCachedBins> bins TF_GUARDED_BY(mu);
+  };
+
+  // Returns the chunk cache of the calling thread.
+  ChunkCache* ThreadChunkCache();
+
+  // Array of kNumChunkCaches chunk caches, or nullptr if the chunk cache is
+  // disabled.
+  std::unique_ptr<ChunkCache[]> chunk_caches_;
+
+  // The total size of the chunks in the chunk caches, and the number of
+  // allocations that were served from them, which are not reflected in
+  // stats_.
+  std::atomic<int64> cached_bytes_{0};
+  std::atomic<int64> num_cached_allocs_{0};
+  // The peak bytes in use and largest allocation size reached by allocations
+  // served from the chunk caches, which GetStats() merges into stats_.
+  std::atomic<int64> cached_peak_bytes_in_use_{0};
+  std::atomic<int64> cached_largest_alloc_size_{0};
+
   // Structures mutable after construction
+  //
+  // Paths that only access the metadata of in-use chunks owned by the calling
+  // thread may hold lock_ in shared mode.
   mutable mutex lock_;
   RegionManager region_manager_ TF_GUARDED_BY(lock_);
 
@@ -544,8 +621,9 @@ class BFCAllocator : public Allocator {
   ChunkHandle free_chunks_list_ TF_GUARDED_BY(lock_);
 
   // Counter containing the next unique identifier to assign to a
-  // newly-created chunk.
-  int64 next_allocation_id_ TF_GUARDED_BY(lock_);
+  // newly-created chunk.  Atomic because chunk cache hits assign ids while
+  // holding lock_ only in shared mode.
+  std::atomic<int64> next_allocation_id_;
 
   // Stats.
   AllocatorStats stats_ TF_GUARDED_BY(lock_);
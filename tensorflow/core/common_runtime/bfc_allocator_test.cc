@@ -0,0 +1,188 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/pool_allocator.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+SubAllocator* NewCPUSubAllocator() {
+  return new BasicCPUAllocator(port::kNUMANoAffinity, {}, {});
+}
+
+TEST(BFCAllocatorTest, ChunkCacheReusesChunks) {
+  BFCAllocator a(NewCPUSubAllocator(), 1 << 30, true /*allow_growth*/,
+                 "cpu_bfc", false /*garbage_collection*/,
+                 true /*use_chunk_cache*/);
+  void* p1 = a.AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  ASSERT_NE(nullptr, p1);
+  a.DeallocateRaw(p1);
+  EXPECT_EQ(0, a.GetStats()->bytes_in_use);
+
+  // The freed chunk is served from the cache of this thread.
+  void* p2 = a.AllocateRaw(Allocator::kAllocatorAlignment, 900);
+  EXPECT_EQ(p1, p2);
+  EXPECT_EQ(900, a.RequestedSize(p2));
+  EXPECT_EQ(1024, a.AllocatedSize(p2));
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  EXPECT_EQ(2, stats->num_allocs);
+  EXPECT_EQ(1024, stats->bytes_in_use);
+  a.DeallocateRaw(p2);
+}
+
+TEST(BFCAllocatorTest, ChunkCacheHitsAreTrackedLikeOtherAllocations) {
+  BFCAllocator a(NewCPUSubAllocator(), 1 << 30, true /*allow_growth*/,
+                 "cpu_bfc", false /*garbage_collection*/,
+                 true /*use_chunk_cache*/);
+  void* p1 = a.AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  const int64 id1 = a.AllocationId(p1);
+  a.DeallocateRaw(p1);
+  a.ClearStats();
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  EXPECT_EQ(0, stats->peak_bytes_in_use);
+  EXPECT_EQ(0, stats->largest_alloc_size);
+
+  // A cache hit gets a fresh allocation id and counts towards the peak.
+  void* p2 = a.AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  EXPECT_EQ(p1, p2);
+  EXPECT_GT(a.AllocationId(p2), id1);
+  stats = a.GetStats();
+  EXPECT_EQ(1024, stats->peak_bytes_in_use);
+  EXPECT_EQ(1024, stats->largest_alloc_size);
+
+  void* p3 = a.AllocateRaw(Allocator::kAllocatorAlignment, 1000);
+  EXPECT_NE(a.AllocationId(p2), a.AllocationId(p3));
+  EXPECT_EQ(2048, a.GetStats()->peak_bytes_in_use);
+  a.DeallocateRaw(p2);
+  a.DeallocateRaw(p3);
+  EXPECT_EQ(0, a.GetStats()->bytes_in_use);
+  EXPECT_EQ(2048, a.GetStats()->peak_bytes_in_use);
+}
+
+TEST(BFCAllocatorTest, ChunkCacheIsFlushedBeforeGrowing) {
+  const size_t kMemoryLimit = 1 << 20;
+  BFCAllocator a(NewCPUSubAllocator(), kMemoryLimit, false /*allow_growth*/,
+                 "cpu_bfc", false /*garbage_collection*/,
+                 true /*use_chunk_cache*/);
+  // Fill half of the memory with small chunks and free them, so that some of
+  // them stay in the cache of this thread.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 64; ++i) {
+    ptrs.push_back(a.AllocateRaw(Allocator::kAllocatorAlignment, 8192));
+    ASSERT_NE(nullptr, ptrs.back());
+  }
+  for (void* p : ptrs) {
+    a.DeallocateRaw(p);
+  }
+
+  // This allocation only fits if the cached chunks are coalesced.
+  AllocationAttributes attr;
+  attr.retry_on_failure = false;
+  void* p = a.AllocateRaw(Allocator::kAllocatorAlignment,
+                          kMemoryLimit * 3 / 4, attr);
+  EXPECT_NE(nullptr, p);
+  a.DeallocateRaw(p);
+  EXPECT_EQ(0, a.GetStats()->bytes_in_use);
+}
+
+TEST(BFCAllocatorTest, ConcurrentAllocationsWithChunkCache) {
+  BFCAllocator a(NewCPUSubAllocator(), 1 << 30, true /*allow_growth*/,
+                 "cpu_bfc", false /*garbage_collection*/,
+                 true /*use_chunk_cache*/);
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 8);
+    for (int t = 0; t < 8; ++t) {
+      pool.Schedule([&a, t]() {
+        random::PhiloxRandom philox(123, t);
+        random::SimplePhilox rand(&philox);
+        std::vector<std::pair<char*, size_t>> live;
+        for (int i = 0; i < 1000; ++i) {
+          if (live.size() == 16 || (!live.empty() && rand.OneIn(2))) {
+            // Check that no other allocation overwrote the buffer.
+            const int index = rand.Uniform(live.size());
+            char* p = live[index].first;
+            const size_t bytes = live[index].second;
+            EXPECT_EQ(bytes, static_cast<size_t>(std::count(
+                                 p, p + bytes, static_cast<char>(t))));
+            a.DeallocateRaw(p);
+            live[index] = live.back();
+            live.pop_back();
+          } else {
+            const size_t bytes = 1 + rand.Uniform(32768);
+            char* p = static_cast<char*>(
+                a.AllocateRaw(Allocator::kAllocatorAlignment, bytes));
+            ASSERT_NE(nullptr, p);
+            memset(p, t, bytes);
+            live.emplace_back(p, bytes);
+          }
+        }
+        for (const auto& buffer : live) {
+          a.DeallocateRaw(buffer.first);
+        }
+      });
+    }
+  }
+  EXPECT_EQ(0, a.GetStats()->bytes_in_use);
+}
+
+// Measures the allocations per second of 'num_threads' threads that allocate
+// and free small buffers concurrently.
+static void BM_AllocationThreaded(int iters, int num_threads,
+                                  int use_chunk_cache) {
+  BFCAllocator a(NewCPUSubAllocator(), 1uLL << 33, true /*allow_growth*/,
+                 "cpu_bfc", false /*garbage_collection*/, use_chunk_cache);
+  std::atomic_int_fast32_t count(iters);
+  {
+    thread::ThreadPool pool(Env::Default(), "test", num_threads);
+    for (int t = 0; t < num_threads; t++) {
+      pool.Schedule([&a, &count]() {
+        // Exercise a few different allocation sizes
+        std::vector<int> sizes = {256, 4096, 512, 1024, 8192, 65536};
+        int size_index = 0;
+        while (count.fetch_sub(1) > 0) {
+          int bytes = sizes[size_index++ % sizes.size()];
+          void* p = a.AllocateRaw(1, bytes);
+          a.DeallocateRaw(p);
+        }
+      });
+    }
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters));
+}
+BENCHMARK(BM_AllocationThreaded)
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1)
+    ->ArgPair(4, 0)
+    ->ArgPair(4, 1)
+    ->ArgPair(16, 0)
+    ->ArgPair(16, 1)
+    ->ArgPair(64, 0)
+    ->ArgPair(64, 1);
+
+}  // namespace
+}  // namespace tensorflow
@@ -266,6 +266,34 @@ TEST_F(DirectSessionMinusAXTest,
       absl::StrContains(s.error_message(), "disable_output_partition_graphs"));
 }
 
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_UsePlannedMemory) {
+  Initialize({3, 2, -1, 0});
+  SessionOptions options(DefaultSessionOptions());
+  options.config.mutable_experimental()->set_use_planned_memory(true);
+  auto session = absl::WrapUnique(NewSession(options));
+
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_names = {y_ + ":0", z_ + ":0"};
+  std::vector<string> target_nodes = {y_neg_};
+
+  // The first step records the memory plan, and the following steps are
+  // served from it. The outputs of earlier steps stay valid.
+  std::vector<std::vector<Tensor>> outputs(5);
+  for (std::vector<Tensor>& step_outputs : outputs) {
+    TF_ASSERT_OK(
+        session->Run(inputs, output_names, target_nodes, &step_outputs));
+  }
+  for (const std::vector<Tensor>& step_outputs : outputs) {
+    ASSERT_EQ(2, step_outputs.size());
+    test::ExpectTensorEqual<float>(
+        step_outputs[0], test::AsTensor<float>({5, -1}, TensorShape({2, 1})));
+    test::ExpectTensorEqual<float>(
+        step_outputs[1], test::AsTensor<float>({-5, 1}, TensorShape({2, 1})));
+  }
+}
+
 TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_FinalizeWithCallables) {
   Initialize({3, 2, -1, 0});
   auto session = CreateSession();
@@ -0,0 +1,253 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/elementwise_fusion.h"
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/shape_refiner.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
+#include "tensorflow/core/lib/gtl/flatset.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace {
+
+using shape_inference::InferenceContext;
+using shape_inference::ShapeHandle;
+
+constexpr char kFusedElementwiseOp[] = "_FusedElementwise";
+
+// The elementwise ops that _FusedElementwise implements. These must be kept in
+// sync with the kernel in kernels/fused_elementwise_op.cc.
+bool IsFusibleUnaryOp(const Node* n) {
+  static const gtl::FlatSet<string>* const kOps = new gtl::FlatSet<string>(
+      {"Abs", "Exp", "Inv", "Log", "Neg", "Reciprocal", "Relu", "Rsqrt",
+       "Sigmoid", "Sqrt", "Square", "Tanh"});
+  return kOps->count(n->type_string()) > 0;
+}
+
+bool IsFusibleBinaryOp(const Node* n) {
+  static const gtl::FlatSet<string>* const kOps = new gtl::FlatSet<string>(
+      {"Add", "AddV2", "Div", "Maximum", "Minimum", "Mul", "RealDiv",
+       "SquaredDifference", "Sub"});
+  return kOps->count(n->type_string()) > 0;
+}
+
+// Maximum and Minimum are not listed: when exactly one input is NaN, their
+// kernels return one of the inputs depending on the order of the inputs.
+bool IsCommutativeBinaryOp(const Node* n) {
+  static const gtl::FlatSet<string>* const kOps = new gtl::FlatSet<string>(
+      {"Add", "AddV2", "Mul", "SquaredDifference"});
+  return kOps->count(n->type_string()) > 0;
+}
+
+bool IsFusible(const Node* n) {
+  if (!n->IsOp() || (!IsFusibleUnaryOp(n) && !IsFusibleBinaryOp(n))) {
+    return false;
+  }
+  DataType dtype;
+  if (!GetNodeAttr(n->attrs(), "T", &dtype).ok()) return false;
+  return dtype == DT_FLOAT || dtype == DT_DOUBLE;
+}
+
+// Returns true if the binary op `n` does not broadcast its input
+// `chain_input`, i.e. if its other input provably has the same shape or is a
+// scalar.
+bool PreservesInputShape(const ShapeRefiner& refiner, const Node* n,
+                         int chain_input) {
+  InferenceContext* c = refiner.GetContext(n);
+  if (c == nullptr) return false;
+  const ShapeHandle chain_shape = c->input(chain_input);
+  const ShapeHandle other_shape = c->input(1 - chain_input);
+  if (c->RankKnown(other_shape) && c->Rank(other_shape) == 0) return true;
+  if (chain_shape.SameHandle(other_shape)) return true;
+  if (!c->FullyDefined(chain_shape) || !c->FullyDefined(other_shape) ||
+      c->Rank(chain_shape) != c->Rank(other_shape)) {
+    return false;
+  }
+  for (int i = 0; i < c->Rank(chain_shape); ++i) {
+    if (c->Value(c->Dim(chain_shape, i)) != c->Value(c->Dim(other_shape, i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if the fusible op `n` can consume the output of a preceding
+// link as its input `chain_input`.
+bool CanChainThroughInput(const ShapeRefiner& refiner, const Node* n,
+                          int chain_input) {
+  if (IsFusibleUnaryOp(n)) return true;
+  return (chain_input == 0 || IsCommutativeBinaryOp(n)) &&
+         PreservesInputShape(refiner, n, chain_input);
+}
+
+// Returns the only out edge of the fusible op `n` if its destination can be the
+// next link of a chain through `n`, and nullptr otherwise.
+const Edge* FusibleOutEdge(const ShapeRefiner& refiner, const Node* n) {
+  if (n->out_edges().size() != 1) return nullptr;
+  const Edge* e = *n->out_edges().begin();
+  const Node* dst = e->dst();
+  if (e->IsControlEdge() || !IsFusible(dst) ||
+      dst->input_type(e->dst_input()) != n->output_type(0) ||
+      dst->assigned_device_name() != n->assigned_device_name() ||
+      dst->requested_device() != n->requested_device() ||
+      !CanChainThroughInput(refiner, dst, e->dst_input())) {
+    return nullptr;
+  }
+  return e;
+}
+
+struct ElementwiseChain {
+  // The links of the chain, in order.
+  std::vector<Node*> nodes;
+  // The input of each link that consumes the output of the previous link, or
+  // for the first link, the input of the chain.
+  std::vector<int> chain_inputs;
+};
+
+// Finds the maximal disjoint chains of at least two fusible ops in `g`.
+std::vector<ElementwiseChain> FindChains(const Graph& g) {
+  std::vector<Node*> order;
+  GetReversePostOrder(g, &order);
+
+  ShapeRefiner refiner(g.versions(), g.op_registry());
+  for (const Node* n : order) {
+    // Nodes that fail shape inference, and their fan-out, are not fused.
+    refiner.AddNode(n).IgnoreError();
+  }
+
+  // The edge from each fusible op to the next link of its chain. Since a
+  // binary op may be the only consumer of both of its inputs, each node is
+  // claimed as the next link at most once.
+  gtl::FlatMap<const Node*, const Edge*> next;
+  gtl::FlatSet<const Node*> has_previous;
+  for (const Node* n : order) {
+    if (!IsFusible(n)) continue;
+    const Edge* e = FusibleOutEdge(refiner, n);
+    if (e != nullptr && has_previous.insert(e->dst()).second) {
+      next[n] = e;
+    }
+  }
+
+  std::vector<ElementwiseChain> chains;
+  for (Node* n : order) {
+    if (next.count(n) == 0 || has_previous.count(n) > 0) continue;
+    ElementwiseChain chain;
+    if (IsFusibleUnaryOp(n) || PreservesInputShape(refiner, n, 0)) {
+      chain.nodes.push_back(n);
+      chain.chain_inputs.push_back(0);
+    } else if (IsCommutativeBinaryOp(n) && PreservesInputShape(refiner, n, 1)) {
+      chain.nodes.push_back(n);
+      chain.chain_inputs.push_back(1);
+    }
+    // If `n` broadcasts, the chain starts at its consumer, with the output of
+    // `n` as the input of the chain.
+    for (const Edge* e = next[n]; e != nullptr;) {
+      chain.nodes.push_back(e->dst());
+      chain.chain_inputs.push_back(e->dst_input());
+      auto it = next.find(e->dst());
+      e = it == next.end() ? nullptr : it->second;
+    }
+    if (chain.nodes.size() >= 2) {
+      chains.push_back(std::move(chain));
+    }
+  }
+  return chains;
+}
+
+// Replaces the links of `chain` with a single _FusedElementwise node.
+Status FuseChain(Graph* g, const ElementwiseChain& chain) {
+  Node* const head = chain.nodes.front();
+  Node* const tail = chain.nodes.back();
+
+  const Edge* input_edge;
+  TF_RETURN_IF_ERROR(head->input_edge(chain.chain_inputs.front(), &input_edge));
+  std::vector<const Edge*> arg_edges;
+  std::vector<string> fused_ops;
+  std::vector<Node*> control_inputs;
+  for (int i = 0; i < chain.nodes.size(); ++i) {
+    Node* n = chain.nodes[i];
+    fused_ops.push_back(n->type_string());
+    if (IsFusibleBinaryOp(n)) {
+      const Edge* e;
+      TF_RETURN_IF_ERROR(n->input_edge(1 - chain.chain_inputs[i], &e));
+      arg_edges.push_back(e);
+    }
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge()) control_inputs.push_back(e->src());
+    }
+  }
+
+  const DataType dtype = tail->output_type(0);
+  std::vector<NodeDefBuilder::NodeOut> args;
+  for (const Edge* e : arg_edges) {
+    args.emplace_back(e->src()->name(), e->src_output(), dtype);
+  }
+  NodeDef def;
+  TF_RETURN_IF_ERROR(
+      NodeDefBuilder(tail->name(), kFusedElementwiseOp, g->op_registry())
+          .Input(input_edge->src()->name(), input_edge->src_output(), dtype)
+          .Input(args)
+          .Attr("fused_ops", fused_ops)
+          .Device(tail->requested_device())
+          .Finalize(&def));
+
+  Status status;
+  Node* fused = g->AddNode(def, &status);
+  TF_RETURN_IF_ERROR(status);
+  fused->set_assigned_device_name(tail->assigned_device_name());
+  g->AddEdge(input_edge->src(), input_edge->src_output(), fused, 0);
+  for (int i = 0; i < arg_edges.size(); ++i) {
+    g->AddEdge(arg_edges[i]->src(), arg_edges[i]->src_output(), fused, i + 1);
+  }
+  for (Node* control_input : control_inputs) {
+    g->AddControlEdge(control_input, fused, /*allow_duplicates=*/false);
+  }
+  for (const Edge* e : tail->out_edges()) {
+    g->AddEdge(fused, e->src_output(), e->dst(), e->dst_input());
+  }
+  for (Node* n : chain.nodes) {
+    g->RemoveNode(n);
+  }
+  VLOG(2) << "Fused " << chain.nodes.size() << " elementwise ops into "
+          << fused->name();
+  return Status::OK();
+}
+
+}  // namespace
+
+bool FuseElementwiseOps(Graph* g) {
+  bool changed = false;
+  for (const ElementwiseChain& chain : FindChains(*g)) {
+    // Each chain only reads the edges around its own nodes, which remain valid
+    // after the preceding chains have been fused.
+    const Status s = FuseChain(g, chain);
+    if (!s.ok()) {
+      // FuseChain() only fails before it modifies the graph.
+      VLOG(1) << "Failed to fuse elementwise ops: " << s;
+      continue;
+    }
+    changed = true;
+  }
+  return changed;
+}
+
+}  // namespace tensorflow
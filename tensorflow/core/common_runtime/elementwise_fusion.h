@@ -0,0 +1,40 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_ELEMENTWISE_FUSION_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_ELEMENTWISE_FUSION_H_
+
+#include "tensorflow/core/graph/graph.h"
+
+namespace tensorflow {
+
+// Replaces chains of two or more elementwise ops (e.g. Add -> Mul -> Tanh) in
+// "g" with single _FusedElementwise ops, which evaluate the chain in one pass
+// over memory without allocating the intermediate results.
+//
+// A chain link is fused only if its output is consumed by nothing but the
+// next link, and if the shape inference of "g" proves that each binary link
+// does not broadcast its chain input, i.e. that its other input has the same
+// shape or is a scalar. The fused node takes the name of the last link.
+//
+// _FusedElementwise only has a CPU kernel, so all nodes of "g" must be placed
+// on a CPU device.
+//
+// Returns true if and only if "g" is mutated.
+bool FuseElementwiseOps(Graph* g);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_ELEMENTWISE_FUSION_H_
@@ -0,0 +1,203 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/elementwise_fusion.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+std::vector<string> FusedOps(const Node* n) {
+  std::vector<string> fused_ops;
+  TF_CHECK_OK(GetNodeAttr(n->attrs(), "fused_ops", &fused_ops));
+  return fused_ops;
+}
+
+const Node* Input(const Node* n, int index) {
+  const Node* input;
+  TF_CHECK_OK(n->input_node(index, &input));
+  return input;
+}
+
+TEST(ElementwiseFusionTest, FusesChain) {
+  Scope s = Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({2, 3}));
+  auto a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT,
+                            ops::Placeholder::Shape({2, 3}));
+  auto c = ops::Placeholder(s.WithOpName("c"), DT_FLOAT,
+                            ops::Placeholder::Shape({2, 3}));
+  auto add = ops::AddV2(s.WithOpName("add"), x, a);
+  auto mul = ops::Mul(s.WithOpName("mul"), add, 2.0f);
+  auto tanh = ops::Tanh(s.WithOpName("tanh"), mul);
+  auto sub = ops::Sub(s.WithOpName("sub"), tanh, c);
+  ops::Identity(s.WithOpName("out"), sub);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(s.ToGraph(&g));
+
+  EXPECT_TRUE(FuseElementwiseOps(&g));
+
+  std::unordered_map<string, Node*> index = g.BuildNodeNameIndex();
+  EXPECT_EQ(0, index.count("add"));
+  EXPECT_EQ(0, index.count("mul"));
+  EXPECT_EQ(0, index.count("tanh"));
+  const Node* fused = index.at("sub");
+  EXPECT_EQ("_FusedElementwise", fused->type_string());
+  EXPECT_EQ(std::vector<string>({"AddV2", "Mul", "Tanh", "Sub"}),
+            FusedOps(fused));
+  ASSERT_EQ(4, fused->num_inputs());
+  EXPECT_EQ("x", Input(fused, 0)->name());
+  EXPECT_EQ("a", Input(fused, 1)->name());
+  EXPECT_TRUE(Input(fused, 2)->IsConstant());
+  EXPECT_EQ("c", Input(fused, 3)->name());
+  EXPECT_EQ(fused, Input(index.at("out"), 0));
+}
+
+TEST(ElementwiseFusionTest, ChainsThroughSecondInputOfCommutativeOp) {
+  Scope s = Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({8}));
+  auto mul = ops::Mul(s.WithOpName("mul"), 0.5f, x);
+  auto relu = ops::Relu(s.WithOpName("relu"), mul);
+  ops::Identity(s.WithOpName("out"), relu);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(s.ToGraph(&g));
+
+  EXPECT_TRUE(FuseElementwiseOps(&g));
+
+  std::unordered_map<string, Node*> index = g.BuildNodeNameIndex();
+  const Node* fused = index.at("relu");
+  EXPECT_EQ(std::vector<string>({"Mul", "Relu"}), FusedOps(fused));
+  EXPECT_EQ("x", Input(fused, 0)->name());
+  EXPECT_TRUE(Input(fused, 1)->IsConstant());
+}
+
+TEST(ElementwiseFusionTest, FusesUnknownShapesFromSameSource) {
+  Scope s = Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({-1, 3}));
+  auto tanh = ops::Tanh(s.WithOpName("tanh"), x);
+  auto exp = ops::Exp(s.WithOpName("exp"), x);
+  auto add = ops::AddV2(s.WithOpName("add"), tanh, exp);
+  ops::Identity(s.WithOpName("out"), add);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(s.ToGraph(&g));
+
+  EXPECT_TRUE(FuseElementwiseOps(&g));
+
+  std::unordered_map<string, Node*> index = g.BuildNodeNameIndex();
+  const Node* fused = index.at("add");
+  EXPECT_EQ("_FusedElementwise", fused->type_string());
+  // Either of the unary ops may be fused into the Add.
+  ASSERT_EQ(2, FusedOps(fused).size());
+  EXPECT_EQ("AddV2", FusedOps(fused)[1]);
+  EXPECT_EQ(2, fused->num_inputs());
+}
+
+TEST(ElementwiseFusionTest, DoesNotFuseBroadcastingOps) {
+  Scope s = Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({2, 3}));
+  auto b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT,
+                            ops::Placeholder::Shape({2, 1}));
+  auto unknown = ops::Placeholder(s.WithOpName("unknown"), DT_FLOAT);
+  auto tanh = ops::Tanh(s.WithOpName("tanh"), x);
+  auto add = ops::AddV2(s.WithOpName("add"), tanh, b);
+  auto mul = ops::Mul(s.WithOpName("mul"), add, unknown);
+  ops::Identity(s.WithOpName("out"), mul);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(s.ToGraph(&g));
+
+  EXPECT_FALSE(FuseElementwiseOps(&g));
+}
+
+TEST(ElementwiseFusionTest, DoesNotFuseSharedOutputs) {
+  Scope s = Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({4}));
+  auto tanh = ops::Tanh(s.WithOpName("tanh"), x);
+  auto exp = ops::Exp(s.WithOpName("exp"), tanh);
+  ops::Identity(s.WithOpName("out0"), tanh);
+  ops::Identity(s.WithOpName("out1"), exp);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(s.ToGraph(&g));
+
+  EXPECT_FALSE(FuseElementwiseOps(&g));
+}
+
+TEST(ElementwiseFusionTest, DoesNotChainThroughSecondInputOfSub) {
+  Scope s = Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({4}));
+  auto tanh = ops::Tanh(s.WithOpName("tanh"), x);
+  auto sub = ops::Sub(s.WithOpName("sub"), 1.0f, tanh);
+  ops::Identity(s.WithOpName("out"), sub);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(s.ToGraph(&g));
+
+  EXPECT_FALSE(FuseElementwiseOps(&g));
+}
+
+TEST(ElementwiseFusionTest, DoesNotChainThroughSecondInputOfMaximum) {
+  // Maximum(1, NaN) and Maximum(NaN, 1) may differ, so the inputs of Maximum
+  // cannot be swapped to continue the chain.
+  Scope s = Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({4}));
+  auto tanh = ops::Tanh(s.WithOpName("tanh"), x);
+  auto max = ops::Maximum(s.WithOpName("max"), 1.0f, tanh);
+  ops::Identity(s.WithOpName("out"), max);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(s.ToGraph(&g));
+
+  EXPECT_FALSE(FuseElementwiseOps(&g));
+}
+
+TEST(ElementwiseFusionTest, MovesControlInputs) {
+  Scope s = Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({4}));
+  auto dep = ops::NoOp(s.WithOpName("dep"));
+  auto tanh = ops::Tanh(s.WithOpName("tanh"), x);
+  auto exp = ops::Exp(s.WithOpName("exp").WithControlDependencies({dep}), tanh);
+  ops::Identity(s.WithOpName("out"), exp);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(s.ToGraph(&g));
+
+  EXPECT_TRUE(FuseElementwiseOps(&g));
+
+  std::unordered_map<string, Node*> index = g.BuildNodeNameIndex();
+  const Node* fused = index.at("exp");
+  EXPECT_EQ(std::vector<string>({"Tanh", "Exp"}), FusedOps(fused));
+  bool has_control_input = false;
+  for (const Edge* e : fused->in_edges()) {
+    if (e->IsControlEdge() && e->src()->name() == "dep") {
+      has_control_input = true;
+    }
+  }
+  EXPECT_TRUE(has_control_input);
+}
+
+}  // namespace
+}  // namespace tensorflow
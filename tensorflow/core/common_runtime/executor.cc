@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/executor.h"
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <vector>
@@ -25,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/graph_view.h"
 #include "tensorflow/core/common_runtime/immutable_executor_state.h"
+#include "tensorflow/core/common_runtime/memory_planner.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
 #include "tensorflow/core/common_runtime/propagator_state.h"
 #include "tensorflow/core/common_runtime/renamed_device.h"
@@ -134,17 +136,55 @@ typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
 
 class ExecutorImpl : public Executor {
  public:
-  explicit ExecutorImpl(const LocalExecutorParams& p) : immutable_state_(p) {}
+  explicit ExecutorImpl(const LocalExecutorParams& p,
+                        bool use_priority_scheduling = false)
+      : immutable_state_(p),
+        use_priority_scheduling_(use_priority_scheduling) {}
+
+  ~ExecutorImpl() override {
+    if (memory_planner_ != nullptr) {
+      memory_planner_->Unref();
+    }
+  }
 
   Status Initialize(const Graph& graph) {
     TF_RETURN_IF_ERROR(immutable_state_.Initialize(graph));
     kernel_stats_.Initialize(immutable_state_.graph_view());
+    Device* device = immutable_state_.params().device;
+    if (immutable_state_.params().use_planned_memory &&
+        device->device_type() == DEVICE_CPU) {
+      memory_planner_ =
+          new MemoryPlanner(device->GetAllocator(AllocatorAttributes()));
+    }
+    if (use_priority_scheduling_) {
+      // No kernel has been timed yet, so the initial priorities only count the
+      // nodes on each path. `MaybeUpdatePriorities()` refines them with the
+      // measured kernel costs once steps have run.
+      immutable_state_.InitializePriorities(
+          graph, [](const NodeItem& item) { return 0; });
+    }
     return Status::OK();
   }
 
   void RunAsync(const Args& args, DoneCallback done) override;
 
  private:
+  // Recomputes the node priorities from the measured kernel costs before steps
+  // 1, 2, 4, ..., 1024 and then before every 1024th step, so that the
+  // priorities follow the kernel costs without recomputing them for every
+  // step.
+  void MaybeUpdatePriorities() {
+    const uint64 step = num_steps_started_.fetch_add(1);
+    if (step == 0 ||
+        ((step & (step - 1)) != 0 && step % kPriorityUpdateInterval != 0)) {
+      return;
+    }
+    mutex_lock l(update_priorities_mu_);
+    immutable_state_.UpdatePriorities([this](const NodeItem& item) {
+      return kernel_stats_.MeasuredCost(item);
+    });
+  }
+
   template <class PropagatorStateType>
   friend class ExecutorState;
 
@@ -157,11 +197,14 @@ class ExecutorImpl : public Executor {
       is_expensive_ = absl::make_unique<std::atomic<bool>[]>(gview.num_nodes());
       cost_estimates_ =
           absl::make_unique<std::atomic_uint_fast64_t[]>(gview.num_nodes());
+      measured_costs_ =
+          absl::make_unique<std::atomic_uint_fast64_t[]>(gview.num_nodes());
       for (int32 i = 0; i < gview.num_nodes(); ++i) {
         if (gview.node(i)) {
           is_expensive_[i] =
               gview.node(i)->kernel && gview.node(i)->kernel->IsExpensive();
           cost_estimates_[i] = kInitialCostEstimateCycles;
+          measured_costs_[i] = 0;
         }
       }
     }
@@ -175,9 +218,29 @@ class ExecutorImpl : public Executor {
               kOpIsExpensiveThresholdCycles);
     }
 
+    // Returns the estimated cost (in CPU cycles) of the given node, or zero if
+    // the node is considered inexpensive.
+    uint64 CostEstimate(const NodeItem& node) const {
+      return IsExpensive(node) ? cost_estimates_[node.node_id].load(
+                                     std::memory_order_relaxed)
+                               : 0;
+    }
+
+    // Returns the measured cost (in CPU cycles) of the given node, or zero if
+    // the node is considered inexpensive or has not been timed yet. Unlike
+    // `CostEstimate()`, the measured cost does not start from
+    // `kInitialCostEstimateCycles`, so it reflects the actual costs of the
+    // kernels from their first run.
+    uint64 MeasuredCost(const NodeItem& node) const {
+      return IsExpensive(node) ? measured_costs_[node.node_id].load(
+                                     std::memory_order_relaxed)
+                               : 0;
+    }
+
     // Updates the dynamic cost estimate, which is used to determine whether the
     // given node is expensive. The new cost estimate is a weighted average of
-    // the old cost estimate and the latest cost.
+    // the old cost estimate and the latest cost. The measured cost is updated
+    // in the same way, except that it starts from the first measurement.
     //
     // NOTE: We currently only expect updates to the cost estimate when
     // `is_expensive_[node.node_id]` is true (or at least, it *was* true, when
@@ -194,6 +257,15 @@ class ExecutorImpl : public Executor {
                                 kCostDecay +
                             (elapsed_cycles / kCostDecay);
       cost_estimate.store(new_estimate, std::memory_order_relaxed);
+      std::atomic_uint_fast64_t& measured_cost = measured_costs_[node.node_id];
+      const uint64 old_measured_cost =
+          measured_cost.load(std::memory_order_relaxed);
+      measured_cost.store(
+          old_measured_cost == 0
+              ? elapsed_cycles
+              : (kCostDecay - 1) * old_measured_cost / kCostDecay +
+                    (elapsed_cycles / kCostDecay),
+          std::memory_order_relaxed);
       if (new_estimate < kOpIsExpensiveThresholdCycles) {
         is_expensive_[node.node_id].store(false, std::memory_order_relaxed);
       }
@@ -209,10 +281,24 @@ class ExecutorImpl : public Executor {
 
     std::unique_ptr<std::atomic<bool>[]> is_expensive_;
     std::unique_ptr<std::atomic_uint_fast64_t[]> cost_estimates_;
+    std::unique_ptr<std::atomic_uint_fast64_t[]> measured_costs_;
   };
 
+  // After the first 1024 steps, the priorities are recomputed every
+  // `kPriorityUpdateInterval` steps.
+  static constexpr uint64 kPriorityUpdateInterval = 1024;
+
   ImmutableExecutorState immutable_state_;
   KernelStats kernel_stats_;
+  // If true, ready nodes are dispatched in the order of their priorities in
+  // `immutable_state_`, rather than in the order in which they became ready.
+  const bool use_priority_scheduling_;
+  // The number of steps started by `RunAsync()`.
+  std::atomic<uint64> num_steps_started_{0};
+  // Serializes the calls to `ImmutableExecutorState::UpdatePriorities()`.
+  mutex update_priorities_mu_;
+  // If not null, serves the tensors of each step from a planned arena.
+  MemoryPlanner* memory_planner_ = nullptr;
 
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
@@ -271,7 +357,8 @@ class ExecutorState {
  public:
   ExecutorState(const Executor::Args& args,
                 const ImmutableExecutorState& immutable_state_,
-                ExecutorImpl::KernelStats* kernel_stats_);
+                ExecutorImpl::KernelStats* kernel_stats_,
+                bool use_priority_scheduling, MemoryPlanner* memory_planner);
   ~ExecutorState();
 
   void RunAsync(Executor::DoneCallback done);
@@ -323,6 +410,17 @@ class ExecutorState {
   // REQUIRES: `!ready->empty()`.
   void ScheduleReady(TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready);
 
+  // Like `ScheduleReady()`, but considers the nodes in `*ready` in the order
+  // of their priorities, and dispatches the nodes that do not run inline
+  // through `priority_queue_`, so that the thread pool runs the pending node
+  // with the highest priority first.
+  void ScheduleReadyByPriority(TaggedNodeSeq* ready,
+                               TaggedNodeReadyQueue* inline_ready,
+                               int64 scheduled_nsec);
+
+  // Processes the node with the highest priority in `priority_queue_`.
+  void ProcessHighestPriority(int64 scheduled_nsec);
+
   // Clean up when this executor is done.
   void Finish();
   void ScheduleFinish();
@@ -362,6 +460,10 @@ class ExecutorState {
   Executor::Args::Runner runner_;
   bool sync_on_finish_;
   const bool run_all_kernels_inline_;
+  const bool use_priority_scheduling_;
+  // If not null, the allocator of this step in the memory planner of the
+  // executor.
+  PlannedAllocator* const planned_allocator_;
 
   PropagatorStateType propagator_;
 
@@ -378,12 +480,36 @@ class ExecutorState {
 
   mutex mu_;
   Status status_ TF_GUARDED_BY(mu_);
+
+  // A node in `priority_queue_`. Nodes with equal priorities are ordered by
+  // the time at which they were added to the queue.
+  struct PrioritizedNode {
+    uint64 priority;
+    uint64 sequence_number;
+    TaggedNode tagged_node;
+
+    bool operator<(const PrioritizedNode& other) const {
+      return priority < other.priority ||
+             (priority == other.priority &&
+              sequence_number > other.sequence_number);
+    }
+  };
+
+  // If `use_priority_scheduling_` is true, a max-heap of the nodes that have
+  // been dispatched to `runner_` but have not started yet. Each closure passed
+  // to `runner_` processes the node at the top of the heap, rather than a
+  // particular node.
+  mutex priority_queue_mu_;
+  std::vector<PrioritizedNode> priority_queue_
+      TF_GUARDED_BY(priority_queue_mu_);
+  uint64 next_sequence_number_ TF_GUARDED_BY(priority_queue_mu_) = 0;
 };
 
 template <class PropagatorStateType>
 ExecutorState<PropagatorStateType>::ExecutorState(
     const Executor::Args& args, const ImmutableExecutorState& immutable_state,
-    ExecutorImpl::KernelStats* kernel_stats)
+    ExecutorImpl::KernelStats* kernel_stats, bool use_priority_scheduling,
+    MemoryPlanner* memory_planner)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
       step_id_(args.step_id),
@@ -406,6 +532,9 @@ ExecutorState<PropagatorStateType>::ExecutorState(
       runner_(args.runner),
       sync_on_finish_(args.sync_on_finish),
       run_all_kernels_inline_(args.run_all_kernels_inline),
+      use_priority_scheduling_(use_priority_scheduling),
+      planned_allocator_(memory_planner != nullptr ? memory_planner->BeginStep()
+                                                   : nullptr),
       propagator_(immutable_state, step_id_, vlog_),
       num_outstanding_ops_(0) {
   if (args.user_intra_op_threadpool != nullptr) {
@@ -420,6 +549,17 @@ ExecutorState<PropagatorStateType>::~ExecutorState() {
   if (device_context_) {
     device_context_->Unref();
   }
+  if (planned_allocator_ != nullptr) {
+    bool ok;
+    {
+      mutex_lock l(mu_);
+      ok = status_.ok();
+    }
+    // All the kernels of the step have completed, so the tensors that are
+    // still live have escaped the step.
+    planned_allocator_->EndStep(ok);
+    planned_allocator_->Unref();
+  }
   delete slice_reader_cache_;
 }
 
@@ -677,6 +817,7 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
   params.runner = &runner_;
   params.run_all_kernels_inline = run_all_kernels_inline_;
   params.stats_collector = stats_collector_;
+  params.planned_allocator = planned_allocator_;
   params.inc_num_deferred_ops_function = [this]() {
     mutex_lock lock(num_deferred_ops_mu_);
     num_deferred_ops_++;
@@ -763,6 +904,7 @@ void ExecutorState<PropagatorStateType>::Process(TaggedNode tagged_node,
 
       // Set up compute params.
       params.op_kernel = item.kernel;
+      params.planned_node_id = id;
       params.frame_iter = propagator_.GetFrameAndIter(tagged_node);
       params.is_input_dead = is_input_dead;
       params.output_attr_array = item.output_attrs();
@@ -1126,6 +1268,8 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
         inline_ready->push_back(tagged_node);
       }
     }
+  } else if (use_priority_scheduling_) {
+    ScheduleReadyByPriority(ready, inline_ready, scheduled_nsec);
   } else {
     const TaggedNode* curr_expensive_node = nullptr;
     if (inline_ready == nullptr) {
@@ -1164,6 +1308,65 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
   ready->clear();
 }
 
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::ScheduleReadyByPriority(
+    TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready,
+    int64 scheduled_nsec) {
+  std::stable_sort(ready->begin(), ready->end(),
+                   [this](const TaggedNode& a, const TaggedNode& b) {
+                     return immutable_state_.priority(a.get_node_item()) >
+                            immutable_state_.priority(b.get_node_item());
+                   });
+
+  // As in `ScheduleReady()`, inexpensive nodes run inline, and this thread
+  // keeps the expensive node with the highest priority if it has nothing else
+  // to do. The other expensive nodes are dispatched.
+  TaggedNodeSeq expensive_nodes;
+  for (const TaggedNode& tagged_node : *ready) {
+    if (inline_ready != nullptr &&
+        (tagged_node.get_is_dead() ||
+         !kernel_stats_->IsExpensive(tagged_node.get_node_item()))) {
+      inline_ready->push_back(tagged_node);
+    } else {
+      expensive_nodes.push_back(tagged_node);
+    }
+  }
+  auto it = expensive_nodes.begin();
+  if (inline_ready != nullptr && inline_ready->empty() &&
+      it != expensive_nodes.end()) {
+    inline_ready->push_back(*it);
+    ++it;
+  }
+  const size_t num_dispatched = expensive_nodes.end() - it;
+  if (num_dispatched == 0) return;
+  {
+    mutex_lock l(priority_queue_mu_);
+    for (; it != expensive_nodes.end(); ++it) {
+      priority_queue_.push_back({immutable_state_.priority(it->get_node_item()),
+                                 next_sequence_number_++, *it});
+      std::push_heap(priority_queue_.begin(), priority_queue_.end());
+    }
+  }
+  for (size_t i = 0; i < num_dispatched; ++i) {
+    runner_(
+        [this, scheduled_nsec]() { ProcessHighestPriority(scheduled_nsec); });
+  }
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::ProcessHighestPriority(
+    int64 scheduled_nsec) {
+  const TaggedNode tagged_node = [this]() {
+    mutex_lock l(priority_queue_mu_);
+    DCHECK(!priority_queue_.empty());
+    std::pop_heap(priority_queue_.begin(), priority_queue_.end());
+    const TaggedNode tagged_node = priority_queue_.back().tagged_node;
+    priority_queue_.pop_back();
+    return tagged_node;
+  }();
+  Process(tagged_node, scheduled_nsec);
+}
+
 template <class PropagatorStateType>
 void ExecutorState<PropagatorStateType>::ScheduleFinish() {
   // Checks condition to decide if needs to invoke Finish(). If there are
@@ -1298,12 +1501,19 @@ void ExecutorState<PropagatorStateType>::Finish() {
 }
 
 void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
+  if (use_priority_scheduling_) {
+    MaybeUpdatePriorities();
+  }
   if (immutable_state_.requires_control_flow_support()) {
-    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_))
+    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_,
+                                        use_priority_scheduling_,
+                                        memory_planner_))
         ->RunAsync(std::move(done));
   } else {
     (new ExecutorState<SimplePropagatorState>(args, immutable_state_,
-                                              &kernel_stats_))
+                                              &kernel_stats_,
+                                              use_priority_scheduling_,
+                                              memory_planner_))
         ->RunAsync(std::move(done));
   }
 }
@@ -1357,6 +1567,31 @@ class DefaultExecutorRegistrar {
 };
 static DefaultExecutorRegistrar registrar;
 
+// Registers the "PRIORITY" executor, which is the default executor with
+// critical-path-aware scheduling: when more nodes are ready than there are
+// threads to run them, the nodes with the most expensive paths to the end of
+// the graph run first. The costs of the paths come from the kernel costs
+// measured in the previous steps.
+class PriorityExecutorRegistrar {
+ public:
+  PriorityExecutorRegistrar() {
+    ExecutorFactory::Register("PRIORITY", new Factory);
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      auto impl = absl::make_unique<ExecutorImpl>(
+          params, /*use_priority_scheduling=*/true);
+      TF_RETURN_IF_ERROR(impl->Initialize(graph));
+      *out_executor = std::move(impl);
+      return Status::OK();
+    }
+  };
+};
+static PriorityExecutorRegistrar priority_registrar;
+
 }  // namespace
 
 }  // namespace tensorflow
@@ -23,23 +23,30 @@ limitations under the License.
 #include "tensorflow/cc/ops/control_flow_ops_internal.h"
 #include "tensorflow/cc/ops/function_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/cc/ops/while_loop.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
+#include "tensorflow/core/common_runtime/immutable_executor_state.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/common_runtime/lower_functional_ops.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -48,6 +55,22 @@ limitations under the License.
 
 namespace tensorflow {
 
+// Returns the parameters of an executor that runs the kernels of a graph with
+// producer version `version` on `device`.
+LocalExecutorParams ExecutorParams(Device* device, int version) {
+  LocalExecutorParams params;
+  params.device = device;
+  params.create_kernel =
+      [device, version](const std::shared_ptr<const NodeProperties>& props,
+                        OpKernel** kernel) {
+        return CreateNonCachedKernel(device, nullptr, props, version, kernel);
+      };
+  params.delete_kernel = [](OpKernel* kernel) {
+    DeleteNonCachedKernel(kernel);
+  };
+  return params;
+}
+
 class ExecutorTest : public ::testing::Test {
  protected:
   ExecutorTest()
@@ -66,23 +89,17 @@ class ExecutorTest : public ::testing::Test {
     delete exec_;
   }
 
-  // Resets executor_ with a new executor based on a graph 'gdef'.
-  void Create(std::unique_ptr<const Graph> graph) {
-    const int version = graph->versions().producer();
-    LocalExecutorParams params;
-    params.device = device_.get();
-    params.create_kernel =
-        [this, version](const std::shared_ptr<const NodeProperties>& props,
-                        OpKernel** kernel) {
-          return CreateNonCachedKernel(device_.get(), nullptr, props, version,
-                                       kernel);
-        };
-    params.delete_kernel = [](OpKernel* kernel) {
-      DeleteNonCachedKernel(kernel);
-    };
+  // Resets executor_ with a new executor of type 'executor_type' based on a
+  // graph 'gdef'.
+  void Create(std::unique_ptr<const Graph> graph,
+              const string& executor_type = "") {
+    LocalExecutorParams params =
+        ExecutorParams(device_.get(), graph->versions().producer());
     rendez_ = NewLocalRendezvous();
     delete exec_;
-    TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    std::unique_ptr<Executor> executor;
+    TF_CHECK_OK(NewExecutor(executor_type, params, *graph, &executor));
+    exec_ = executor.release();
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
   }
 
@@ -255,6 +272,202 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreeWithPriorityScheduling) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g), "PRIORITY");
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
+// Nodes of a graph in which a constant feeds a long and a short branch, which
+// are then added and sent to "out".
+struct BranchNodes {
+  Node* root;
+  Node* short1;
+  Node* long1;
+  Node* long2;
+  Node* long3;
+  Node* join;
+};
+
+BranchNodes BuildLongAndShortBranches(Graph* g) {
+  BranchNodes nodes;
+  nodes.root = test::graph::Constant(g, V(1.0));
+  // The short branch is added first, so that its node comes first in the
+  // out edges of the root.
+  nodes.short1 = test::graph::Identity(g, nodes.root);
+  nodes.long1 = test::graph::Identity(g, nodes.root);
+  nodes.long2 = test::graph::Identity(g, nodes.long1);
+  nodes.long3 = test::graph::Identity(g, nodes.long2);
+  nodes.join = test::graph::Add(g, nodes.short1, nodes.long3);
+  test::graph::Send(g, nodes.join, "out", BOB, 1, ALICE);
+  FixupSourceAndSinkEdges(g);
+  return nodes;
+}
+
+TEST_F(ExecutorTest, PrioritySchedulingRunsLongBranchFirst) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BranchNodes nodes = BuildLongAndShortBranches(g.get());
+  Create(std::move(g), "PRIORITY");
+  TF_ASSERT_OK(Run(rendez_));
+  Rendezvous::Args args;
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "out"), args, &out,
+                             &is_dead));
+  EXPECT_EQ(2.0, V(out));
+
+  // All nodes are inexpensive, so they run one after the other on the thread
+  // that runs the root, in the order in which they are scheduled. When the
+  // root finishes, the head of the long branch runs before the short branch.
+  step_stats_collector_.Finalize();
+  ASSERT_EQ(step_stats_.dev_stats_size(), 1);
+  std::vector<string> order;
+  for (const NodeExecStats& stats : step_stats_.dev_stats(0).node_stats()) {
+    order.push_back(stats.node_name());
+  }
+  auto position = [&order](const Node* n) {
+    return static_cast<int>(std::find(order.begin(), order.end(), n->name()) -
+                            order.begin());
+  };
+  ASSERT_LT(position(nodes.join), static_cast<int>(order.size()));
+  EXPECT_EQ(position(nodes.long1), position(nodes.root) + 1);
+  EXPECT_EQ(position(nodes.short1), position(nodes.root) + 2);
+  EXPECT_LT(position(nodes.long3), position(nodes.join));
+}
+
+TEST(ImmutableExecutorStateTest, InitializePriorities) {
+  std::unique_ptr<Device> device =
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0");
+  Graph g(OpRegistry::Global());
+  BranchNodes nodes = BuildLongAndShortBranches(&g);
+  ImmutableExecutorState state(
+      ExecutorParams(device.get(), g.versions().producer()));
+  TF_ASSERT_OK(state.Initialize(g));
+  auto priority = [&state](const Node* n) {
+    return state.priority(*state.graph_view().node(n->id()));
+  };
+
+  // Each node costs one step, so a priority is the length of the longest path
+  // to the end of the graph.
+  state.InitializePriorities(g, [](const NodeItem& item) { return 0; });
+  EXPECT_EQ(priority(nodes.join) + 1, priority(nodes.long3));
+  EXPECT_EQ(priority(nodes.join) + 1, priority(nodes.short1));
+  EXPECT_EQ(priority(nodes.join) + 3, priority(nodes.long1));
+  EXPECT_EQ(priority(nodes.join) + 4, priority(nodes.root));
+
+  // An expensive node on the short branch makes it the critical path.
+  const int short1_id = nodes.short1->id();
+  state.UpdatePriorities([short1_id](const NodeItem& item) {
+    return item.node_id == short1_id ? 10 : 0;
+  });
+  EXPECT_EQ(priority(nodes.join) + 11, priority(nodes.short1));
+  EXPECT_EQ(priority(nodes.join) + 12, priority(nodes.root));
+  EXPECT_GT(priority(nodes.short1), priority(nodes.long1));
+}
+
+// Sleeps for `delay_micros` and forwards its input. Records the names of the
+// kernels in the order in which they start.
+class RecordingDelayOp : public OpKernel {
+ public:
+  explicit RecordingDelayOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("delay_micros", &delay_micros_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    {
+      mutex_lock l(*mu());
+      started()->push_back(name());
+    }
+    Env::Default()->SleepForMicroseconds(delay_micros_);
+    ctx->set_output(0, ctx->input(0));
+  }
+
+  // Returns the names of the kernels that started since the last call.
+  static std::vector<string> TakeStartedKernels() {
+    mutex_lock l(*mu());
+    std::vector<string> result;
+    result.swap(*started());
+    return result;
+  }
+
+ private:
+  static mutex* mu() {
+    static mutex* mu = new mutex;
+    return mu;
+  }
+  static std::vector<string>* started() {
+    static std::vector<string>* started = new std::vector<string>;
+    return started;
+  }
+
+  int64 delay_micros_;
+};
+
+REGISTER_OP("RecordingDelay")
+    .Input("x: float")
+    .Output("y: float")
+    .Attr("delay_micros: int")
+    .SetShapeFn(shape_inference::UnchangedShape);
+REGISTER_KERNEL_BUILDER(Name("RecordingDelay").Device(DEVICE_CPU),
+                        RecordingDelayOp);
+
+Node* RecordingDelay(Graph* g, Node* in, int64 delay_micros) {
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "RecordingDelay")
+                  .Input(in)
+                  .Attr("delay_micros", delay_micros)
+                  .Finalize(g, &ret));
+  return ret;
+}
+
+TEST_F(ExecutorTest, PrioritySchedulingUsesMeasuredKernelCosts) {
+  // The short branch has a single slow kernel, and the long branch has three
+  // fast kernels. All of them are expensive, so only one of the heads of the
+  // branches runs on the thread that ran the root.
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  Node* root = test::graph::Constant(g.get(), V(1.0));
+  Node* short1 = RecordingDelay(g.get(), root, /*delay_micros=*/20000);
+  Node* long1 = RecordingDelay(g.get(), root, /*delay_micros=*/0);
+  Node* long2 = RecordingDelay(g.get(), long1, /*delay_micros=*/0);
+  Node* long3 = RecordingDelay(g.get(), long2, /*delay_micros=*/0);
+  Node* join = test::graph::Add(g.get(), short1, long3);
+  test::graph::Send(g.get(), join, "out", BOB, 1, ALICE);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g), "PRIORITY");
+  // With a single thread, the kernels run in the order of their priorities.
+  thread::ThreadPool pool(Env::Default(), "priority_test", 1);
+  runner_ = [&pool](std::function<void()> fn) { pool.Schedule(std::move(fn)); };
+
+  auto run_step = [this]() {
+    TF_EXPECT_OK(Run(rendez_));
+    Rendezvous::Args args;
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_EXPECT_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "out"), args,
+                               &out, &is_dead));
+    EXPECT_EQ(2.0, V(out));
+    return RecordingDelayOp::TakeStartedKernels();
+  };
+  RecordingDelayOp::TakeStartedKernels();
+
+  // Before any kernel has been timed, the long branch is the critical path.
+  EXPECT_EQ(run_step(), std::vector<string>({long1->name(), long2->name(),
+                                             long3->name(), short1->name()}));
+  // The priorities of the second step use the measured costs, which make the
+  // slow kernel the critical path.
+  EXPECT_EQ(run_step(), std::vector<string>({short1->name(), long1->name(),
+                                             long2->name(), long3->name()}));
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -329,6 +542,24 @@ TEST_F(ExecutorTest, SimpleSwitchDead) {
   EXPECT_TRUE(is_dead);
 }
 
+TEST_F(ExecutorTest, SimpleSwitchDeadWithPriorityScheduling) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+  auto in1 = test::graph::Constant(g.get(), VB(true));
+  auto tmp = test::graph::Switch(g.get(), in0, in1);
+  test::graph::Send(g.get(), tmp, "c", BOB, 1, ALICE);
+  Create(std::move(g), "PRIORITY");
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0),
+                             false));  // in0 = 1.0
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out, &is_dead));
+  EXPECT_TRUE(is_dead);
+}
+
 TEST_F(ExecutorTest, Abort) {
   // e = a + b + c + d
   auto g = absl::make_unique<Graph>(OpRegistry::Global());
@@ -430,10 +661,101 @@ TEST_F(ExecutorTest, NoInputTensors) {
   TF_ASSERT_OK(Run(rendez_));
 }
 
+// Builds a graph that computes
+//
+//     i = 0
+//     while (i < loop_iters)
+//       i = i + 1;
+//
+// with a `Switch`/`Merge`-style loop, whose body fans the new value of `i` out
+// to `width` Identity nodes and fans them back in with control edges. The
+// Identity nodes of an iteration complete concurrently, and all propagate
+// their outputs in the same frame. Returns the node that outputs the final
+// value of `i`.
+Node* BuildWideWhileLoop(int loop_iters, int width, Graph* g) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto zero = ops::Const(root.WithOpName("zero"), 0);
+  OutputList outputs;
+  TF_CHECK_OK(ops::BuildWhileLoop(
+      root, {zero},
+      [loop_iters](const Scope& s, const std::vector<Output>& inputs,
+                   Output* output) {
+        *output = ops::Less(s, inputs[0], loop_iters);
+        return s.status();
+      },
+      [width](const Scope& s, const std::vector<Output>& inputs,
+              std::vector<Output>* outputs) {
+        auto next = ops::Add(s, inputs[0], 1);
+        std::vector<Operation> fanout;
+        fanout.reserve(width);
+        for (int i = 0; i < width; ++i) {
+          fanout.push_back(ops::Identity(s, next).output.op());
+        }
+        outputs->push_back(
+            ops::Identity(s.WithControlDependencies(fanout), next));
+        return s.status();
+      },
+      "wide_loop", &outputs));
+  ops::Identity(root.WithOpName("result"), outputs[0]);
+  TF_CHECK_OK(root.ToGraph(g));
+  for (Node* n : g->op_nodes()) {
+    if (n->name() == "result") return n;
+  }
+  LOG(FATAL) << "No result node in the wide while loop";
+  return nullptr;
+}
+
+TEST_F(ExecutorTest, WideWhileLoop) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  Node* result = BuildWideWhileLoop(/*loop_iters=*/20, /*width=*/512, g.get());
+  test::graph::Send(g.get(), result, "out", BOB, 1, ALICE);
+  Create(std::move(g));
+  TF_ASSERT_OK(Run(rendez_));
+  Rendezvous::Args args;
+  Tensor out = VI(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "out"), args, &out,
+                             &is_dead));
+  EXPECT_FALSE(is_dead);
+  EXPECT_EQ(20, out.scalar<int32>()());
+}
+
+TEST(ImmutableExecutorStateTest, InitializePrioritiesIgnoresBackEdges) {
+  std::unique_ptr<Device> device =
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0");
+  Graph g(OpRegistry::Global());
+  BuildWideWhileLoop(/*loop_iters=*/2, /*width=*/2, &g);
+  ImmutableExecutorState state(
+      ExecutorParams(device.get(), g.versions().producer()));
+  TF_ASSERT_OK(state.Initialize(g));
+  state.InitializePriorities(g, [](const NodeItem& item) { return 0; });
+  auto priority = [&state](const Node* n) {
+    return state.priority(*state.graph_view().node(n->id()));
+  };
+
+  std::vector<const Node*> merges;
+  std::vector<const Node*> next_iterations;
+  for (const Node* n : g.op_nodes()) {
+    if (n->IsMerge()) merges.push_back(n);
+    if (n->IsNextIteration()) next_iterations.push_back(n);
+  }
+  ASSERT_FALSE(merges.empty());
+  ASSERT_FALSE(next_iterations.empty());
+  // The only out edge of a NextIteration node is the back edge to its Merge
+  // node, so the NextIteration node ends a path.
+  for (const Node* next_iteration : next_iterations) {
+    EXPECT_EQ(priority(next_iteration), 1u);
+    for (const Node* merge : merges) {
+      EXPECT_GT(priority(merge), priority(next_iteration));
+    }
+  }
+}
+
 // Create a graph that is 'depth' deep. At each level, fan-in and fan-out a
 // maximum of 'width' nodes. All nodes are no-ops and all dependencies are
 // control dependencies.
-static void BM_executor(int iters, int width, int depth) {
+static void BM_executor_impl(int iters, int width, int depth,
+                             const char* executor_type) {
   testing::StopTiming();
 #ifdef PLATFORM_GOOGLE
   BenchmarkUseRealTime();
@@ -472,9 +794,22 @@ static void BM_executor(int iters, int width, int depth) {
 #endif  // PLATFORM_GOOGLE
   FixupSourceAndSinkEdges(g);
   testing::StartTiming();
-  test::Benchmark("cpu", g).Run(iters);
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr, executor_type)
+      .Run(iters);
+}
+
+static void BM_executor(int iters, int width, int depth) {
+  BM_executor_impl(iters, width, depth, "");
 }
 
+static void BM_priority_executor(int iters, int width, int depth) {
+  BM_executor_impl(iters, width, depth, "PRIORITY");
+}
+
+BENCHMARK(BM_priority_executor)->ArgPair(16, 1024);
+BENCHMARK(BM_priority_executor)->ArgPair(1024, 16);
+BENCHMARK(BM_priority_executor)->ArgPair(1024, 1024);
+
 // Tall skinny graphs
 BENCHMARK(BM_executor)->ArgPair(16, 1024);
 BENCHMARK(BM_executor)->ArgPair(32, 8192);
@@ -694,4 +1029,26 @@ BENCHMARK(BM_FunctionalWhileLoop)
     ->ArgPair(10, 100)
     ->ArgPair(100, 100)
     ->ArgPair(1000, 100);
+
+// Measures the contention between inter-op threads that propagate outputs in
+// the same loop frame: every iteration of the loop runs `width` nodes in
+// parallel, all of which activate the same successor.
+static void BM_WideWhileLoop(int iters, int loop_iters, int width) {
+  testing::StopTiming();
+#ifdef PLATFORM_GOOGLE
+  BenchmarkUseRealTime();
+#endif  // PLATFORM_GOOGLE
+  Graph* g = new Graph(OpRegistry::Global());
+  BuildWideWhileLoop(loop_iters, width, g);
+#ifdef PLATFORM_GOOGLE
+  SetBenchmarkItemsProcessed(static_cast<int64>(iters) * loop_iters * width);
+#endif  // PLATFORM_GOOGLE
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+BENCHMARK(BM_WideWhileLoop)
+    ->ArgPair(100, 16)
+    ->ArgPair(100, 256)
+    ->ArgPair(100, 4096)
+    ->ArgPair(10, 16384);
 }  // namespace tensorflow
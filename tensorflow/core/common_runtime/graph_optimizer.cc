@@ -16,6 +16,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/graph_optimizer.h"
 
 #include "tensorflow/core/common_runtime/constant_folding.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/elementwise_fusion.h"
 #include "tensorflow/core/common_runtime/function_utils.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/common_runtime/inline_function_utils.h"
@@ -130,6 +132,13 @@ void GraphOptimizer::Optimize(
     if (!changed) break;
   }
 
+  // Fusion runs once the other passes have converged, since it hides the
+  // fused ops from constant folding and CSE.
+  if (opts_.do_elementwise_fusion() && device != nullptr &&
+      device->device_type() == DEVICE_CPU && FuseElementwiseOps(g)) {
+    DumpGraph("FuseElementwiseOps", g);
+  }
+
   // Note that we use the Graph constructor that copies the input
   // FunctionLibraryDefinition, since the original lib def will go out of scope.
   std::unique_ptr<Graph> copy(new Graph(g->flib_def()));
@@ -15,10 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/immutable_executor_state.h"
 
+#include <algorithm>
+
 #include "absl/memory/memory.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_node_util.h"
@@ -372,4 +375,49 @@ void ImmutableExecutorState::InitializePending(const Graph* graph,
     }
   }
 }
+
+void ImmutableExecutorState::InitializePriorities(
+    const Graph& graph,
+    const std::function<uint64(const NodeItem&)>& node_cost) {
+  priorities_ = absl::make_unique<std::atomic<uint64>[]>(gview_.num_nodes());
+  for (int32 i = 0; i < gview_.num_nodes(); ++i) {
+    priorities_[i] = 0;
+  }
+  // Ignoring the back edges makes the graph acyclic, so the post order visits
+  // every node after all of its successors.
+  std::vector<Node*> order;
+  GetPostOrder(graph, &order, NodeComparatorID(), [](const Edge& edge) {
+    return !edge.src()->IsNextIteration();
+  });
+  priority_order_.clear();
+  for (const Node* n : order) {
+    if (gview_.node(n->id()) != nullptr) priority_order_.push_back(n->id());
+  }
+  UpdatePriorities(node_cost);
+}
+
+void ImmutableExecutorState::UpdatePriorities(
+    const std::function<uint64(const NodeItem&)>& node_cost) {
+  DCHECK(priorities_ != nullptr);
+  for (int32 id : priority_order_) {
+    const NodeItem& item = *gview_.node(id);
+    uint64 max_successor_priority = 0;
+    // The out edges of a NextIteration node are the back edges of its loop.
+    if (!item.is_next_iteration) {
+      for (const EdgeInfo& e : item.output_edges()) {
+        max_successor_priority =
+            std::max(max_successor_priority,
+                     priorities_[e.dst_id].load(std::memory_order_relaxed));
+      }
+      for (const ControlEdgeInfo& e : item.output_control_edges()) {
+        max_successor_priority =
+            std::max(max_successor_priority,
+                     priorities_[e.dst_id].load(std::memory_order_relaxed));
+      }
+    }
+    priorities_[id].store(max_successor_priority + 1 + node_cost(item),
+                          std::memory_order_relaxed);
+  }
+}
+
 }  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <atomic>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -101,6 +102,35 @@ class ImmutableExecutorState {
 
   bool requires_control_flow_support() const { return requires_control_flow_; }
 
+  // Computes the priorities of the nodes in `graph` for critical-path-aware
+  // scheduling. The priority of a node is the cost of the most expensive path
+  // from the node to the end of the graph, where each node on the path costs
+  // `1 + node_cost(node)`, so nodes on the critical path have the highest
+  // priorities. The back edges of loops are ignored.
+  //
+  // REQUIRES: `Initialize(graph)` has been called.
+  void InitializePriorities(
+      const Graph& graph,
+      const std::function<uint64(const NodeItem&)>& node_cost);
+
+  // Recomputes the priorities computed by `InitializePriorities()` with new
+  // node costs, e.g. the costs measured while running the graph.
+  //
+  // May run concurrently with `priority()`, which then returns either the old
+  // or the new priority of a node, but not with another call to
+  // `UpdatePriorities()`.
+  //
+  // REQUIRES: `InitializePriorities()` has been called.
+  void UpdatePriorities(
+      const std::function<uint64(const NodeItem&)>& node_cost);
+
+  // Returns the priority of the given node.
+  //
+  // REQUIRES: `InitializePriorities()` has been called.
+  uint64 priority(const NodeItem& node_item) const {
+    return priorities_[node_item.node_id].load(std::memory_order_relaxed);
+  }
+
   // Copies the pending counts for nodes in this graph to the given array.
   //
   // This method provides a more efficient way of initializing
@@ -155,6 +185,14 @@ class ImmutableExecutorState {
   // Shallow copies of the constant tensors used in the graph.
   std::vector<Tensor> const_tensors_;
 
+  // The priorities of the nodes, indexed by node ID. Null unless
+  // `InitializePriorities()` has been called.
+  std::unique_ptr<std::atomic<uint64>[]> priorities_;
+
+  // The IDs of the nodes in an order that visits every node after all of its
+  // successors, ignoring the back edges of loops.
+  std::vector<int32> priority_order_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ImmutableExecutorState);
 };
 
@@ -47,6 +47,11 @@ struct LocalExecutorParams {
                        OpKernel**)>
       create_kernel;
   std::function<void(OpKernel*)> delete_kernel;
+
+  // If true and `device` is a CPU device, the tensors that the kernels
+  // allocate and deallocate within a step are served from a per-step arena
+  // whose layout is planned from the first step. See MemoryPlanner.
+  bool use_planned_memory = false;
 };
 
 }  // end namespace tensorflow
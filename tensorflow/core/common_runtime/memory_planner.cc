@@ -0,0 +1,337 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_planner.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <numeric>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace {
+
+size_t RoundUp(size_t n, size_t alignment) {
+  return (n + alignment - 1) / alignment * alignment;
+}
+
+bool LifetimesOverlap(const BufferLifetime& a, const BufferLifetime& b) {
+  return a.first_use <= b.last_use && b.first_use <= a.last_use;
+}
+
+}  // namespace
+
+size_t PlanArenaOffsets(gtl::ArraySlice<BufferLifetime> buffers,
+                        size_t alignment, std::vector<size_t>* offsets) {
+  std::vector<int> order(buffers.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&buffers](int a, int b) {
+    if (buffers[a].size != buffers[b].size) {
+      return buffers[a].size > buffers[b].size;
+    }
+    return buffers[a].first_use < buffers[b].first_use;
+  });
+
+  offsets->assign(buffers.size(), 0);
+  // The buffers placed so far, in increasing order of offset.
+  std::vector<int> placed;
+  placed.reserve(buffers.size());
+  size_t arena_bytes = 0;
+  for (int i : order) {
+    const size_t size = RoundUp(buffers[i].size, alignment);
+    size_t best_offset = std::numeric_limits<size_t>::max();
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    // The end of the placed buffers considered so far that are live at the
+    // same time as buffer `i`.
+    size_t end = 0;
+    for (int j : placed) {
+      if (!LifetimesOverlap(buffers[i], buffers[j])) continue;
+      const size_t offset = (*offsets)[j];
+      if (offset >= end + size && offset - end < best_gap) {
+        best_gap = offset - end;
+        best_offset = end;
+      }
+      end = std::max(end, offset + RoundUp(buffers[j].size, alignment));
+    }
+    if (best_offset == std::numeric_limits<size_t>::max()) {
+      best_offset = end;
+    }
+    (*offsets)[i] = best_offset;
+    placed.insert(std::upper_bound(placed.begin(), placed.end(), best_offset,
+                                   [offsets](size_t offset, int j) {
+                                     return offset < (*offsets)[j];
+                                   }),
+                  i);
+    arena_bytes = std::max(arena_bytes, best_offset + size);
+  }
+  return arena_bytes;
+}
+
+constexpr int MemoryPlanner::kMaxRecordedSteps;
+
+MemoryPlanner::MemoryPlanner(Allocator* allocator) : allocator_(allocator) {}
+
+MemoryPlanner::~MemoryPlanner() {
+  for (void* arena : free_arenas_) {
+    allocator_->DeallocateRaw(arena);
+  }
+}
+
+PlannedAllocator* MemoryPlanner::BeginStep() {
+  std::shared_ptr<const Plan> plan;
+  void* arena = nullptr;
+  {
+    mutex_lock l(mu_);
+    if (plan_ == nullptr) {
+      // Only one step at a time records a plan.
+      if (recording_ || num_recorded_steps_ >= kMaxRecordedSteps) {
+        return nullptr;
+      }
+      recording_ = true;
+      ++num_recorded_steps_;
+      return new PlannedAllocator(this, nullptr, nullptr);
+    }
+    plan = plan_;
+    if (!free_arenas_.empty()) {
+      arena = free_arenas_.back();
+      free_arenas_.pop_back();
+    }
+  }
+  if (arena == nullptr) {
+    AllocationAttributes attr;
+    attr.retry_on_failure = false;
+    arena = allocator_->AllocateRaw(Allocator::kAllocatorAlignment,
+                                    plan->arena_bytes, attr);
+    if (arena == nullptr) {
+      VLOG(1) << "Failed to reserve a planned arena of " << plan->arena_bytes
+              << " bytes from " << allocator_->Name();
+      return nullptr;
+    }
+  }
+  return new PlannedAllocator(this, std::move(plan), arena);
+}
+
+void MemoryPlanner::RecordingDone(std::unique_ptr<const Plan> plan) {
+  mutex_lock l(mu_);
+  recording_ = false;
+  if (plan != nullptr) {
+    VLOG(1) << "Planned " << plan->slots.size() << " tensors in an arena of "
+            << plan->arena_bytes << " bytes";
+    plan_ = std::move(plan);
+  }
+}
+
+void MemoryPlanner::PlannedStepDone(const Plan* plan, int64 num_hits,
+                                    int64 num_misses) {
+  std::vector<void*> stale_arenas;
+  {
+    mutex_lock l(mu_);
+    if (plan != plan_.get() || num_misses <= num_hits) return;
+    VLOG(1) << num_misses << " of " << (num_hits + num_misses)
+            << " planned tensors did not fit in the arena; discarding the plan";
+    plan_.reset();
+    stale_arenas.swap(free_arenas_);
+  }
+  for (void* arena : stale_arenas) {
+    allocator_->DeallocateRaw(arena);
+  }
+}
+
+void MemoryPlanner::ReleaseArena(const Plan* plan, void* arena) {
+  {
+    mutex_lock l(mu_);
+    if (plan == plan_.get()) {
+      free_arenas_.push_back(arena);
+      return;
+    }
+  }
+  allocator_->DeallocateRaw(arena);
+}
+
+PlannedAllocator::PlannedAllocator(
+    MemoryPlanner* planner, std::shared_ptr<const MemoryPlanner::Plan> plan,
+    void* arena)
+    : planner_(planner),
+      allocator_(planner->allocator_),
+      plan_(std::move(plan)),
+      arena_(static_cast<char*>(arena)) {
+  planner_->Ref();
+}
+
+PlannedAllocator::~PlannedAllocator() {
+  bool release_arena;
+  {
+    mutex_lock l(mu_);
+    release_arena = arena_ != nullptr && !arena_released_;
+  }
+  if (release_arena) {
+    planner_->ReleaseArena(plan_.get(), arena_);
+  }
+  planner_->Unref();
+}
+
+void* PlannedAllocator::AllocateRaw(
+    size_t alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
+  if (arena_ != nullptr && allocation_attr.plan_key >= 0) {
+    void* ptr =
+        AllocateFromArena(alignment, num_bytes, allocation_attr.plan_key);
+    if (ptr != nullptr) return ptr;
+  }
+  void* ptr = allocator_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  if (ptr == nullptr) return nullptr;
+  Ref();
+  if (plan_ == nullptr && allocation_attr.plan_key >= 0 && num_bytes > 0) {
+    mutex_lock l(mu_);
+    if (!step_done_) {
+      live_buffers_[ptr] = {allocation_attr.plan_key, num_bytes,
+                            next_event_++};
+      ++num_allocations_[allocation_attr.plan_key];
+    }
+  }
+  return ptr;
+}
+
+void* PlannedAllocator::AllocateFromArena(size_t alignment, size_t num_bytes,
+                                          int64 plan_key) {
+  auto slot = plan_->slots.find(plan_key);
+  if (slot == plan_->slots.end()) return nullptr;
+  const size_t begin = slot->second.offset;
+  const size_t end = begin + slot->second.size;
+  mutex_lock l(mu_);
+  if (arena_released_) return nullptr;
+  if (num_bytes > slot->second.size || alignment > kAllocatorAlignment) {
+    ++num_misses_;
+    return nullptr;
+  }
+  // The range of the slot must not overlap any range that is in use.
+  auto next = live_ranges_.lower_bound(begin);
+  if ((next != live_ranges_.end() && next->first < end) ||
+      (next != live_ranges_.begin() && std::prev(next)->second > begin)) {
+    ++num_misses_;
+    return nullptr;
+  }
+  live_ranges_.emplace_hint(next, begin, end);
+  ++num_hits_;
+  Ref();
+  return arena_ + begin;
+}
+
+bool PlannedAllocator::InArena(const void* ptr) const {
+  // Once the arena has been released, its memory may be handed out again by
+  // the underlying allocator.
+  const char* p = static_cast<const char*>(ptr);
+  return arena_ != nullptr && !arena_released_ && p >= arena_ &&
+         p < arena_ + plan_->arena_bytes;
+}
+
+bool PlannedAllocator::ShouldReleaseArena() {
+  if (arena_ == nullptr || arena_released_ || !step_done_ ||
+      !live_ranges_.empty()) {
+    return false;
+  }
+  arena_released_ = true;
+  return true;
+}
+
+void PlannedAllocator::DeallocateRaw(void* ptr) {
+  bool in_arena = false;
+  bool release_arena = false;
+  if (arena_ != nullptr) {
+    mutex_lock l(mu_);
+    if (InArena(ptr)) {
+      in_arena = true;
+      live_ranges_.erase(static_cast<char*>(ptr) - arena_);
+      release_arena = ShouldReleaseArena();
+    }
+  }
+  if (release_arena) {
+    planner_->ReleaseArena(plan_.get(), arena_);
+  }
+  if (!in_arena) {
+    if (plan_ == nullptr) {
+      // The buffer must be removed from `live_buffers_` before it is returned
+      // to the underlying allocator, which may hand it out again.
+      mutex_lock l(mu_);
+      auto it = live_buffers_.find(ptr);
+      if (it != live_buffers_.end()) {
+        lifetimes_[it->second.plan_key] = {it->second.size,
+                                           it->second.first_use, next_event_++};
+        live_buffers_.erase(it);
+      }
+    }
+    allocator_->DeallocateRaw(ptr);
+  }
+  Unref();
+}
+
+void PlannedAllocator::EndStep(bool ok) {
+  if (plan_ != nullptr) {
+    int64 num_hits;
+    int64 num_misses;
+    bool release_arena;
+    {
+      mutex_lock l(mu_);
+      step_done_ = true;
+      num_hits = num_hits_;
+      num_misses = num_misses_;
+      release_arena = ShouldReleaseArena();
+    }
+    planner_->PlannedStepDone(plan_.get(), num_hits, num_misses);
+    // Tensors allocated from the underlying allocator, e.g. the outputs of
+    // the step, may keep this allocator alive for much longer; they do not
+    // need the arena.
+    if (release_arena) {
+      planner_->ReleaseArena(plan_.get(), arena_);
+    }
+    return;
+  }
+
+  std::unique_ptr<MemoryPlanner::Plan> plan;
+  {
+    mutex_lock l(mu_);
+    step_done_ = true;
+    if (ok) {
+      // Tensors that are still live, e.g. the outputs of the step, are not
+      // planned.
+      std::vector<int64> keys;
+      std::vector<BufferLifetime> buffers;
+      for (const auto& it : lifetimes_) {
+        if (num_allocations_[it.first] == 1) {
+          keys.push_back(it.first);
+          buffers.push_back(it.second);
+        }
+      }
+      if (!buffers.empty()) {
+        plan.reset(new MemoryPlanner::Plan);
+        std::vector<size_t> offsets;
+        plan->arena_bytes =
+            PlanArenaOffsets(buffers, kAllocatorAlignment, &offsets);
+        for (size_t i = 0; i < keys.size(); ++i) {
+          const size_t size = RoundUp(buffers[i].size, kAllocatorAlignment);
+          plan->slots[keys[i]] = {offsets[i], size};
+        }
+      }
+    }
+    live_buffers_.clear();
+    lifetimes_.clear();
+    num_allocations_.clear();
+  }
+  planner_->RecordingDone(std::move(plan));
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,196 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PLANNER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PLANNER_H_
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The lifetime of a buffer that is allocated and deallocated within one step.
+// Times are logical: they are the indices of the allocation and deallocation
+// events among all the events of the step.
+struct BufferLifetime {
+  size_t size;
+  int64 first_use;
+  int64 last_use;
+};
+
+// Assigns each of `buffers` an offset in a single arena, such that buffers
+// with overlapping lifetimes do not overlap in memory, and returns the size of
+// the arena. All offsets are multiples of `alignment`.
+//
+// Like TFLite's ArenaPlanner, this places the buffers in decreasing order of
+// size, each one in the smallest gap that fits it between the already placed
+// buffers whose lifetimes overlap its own, or after the last of them.
+size_t PlanArenaOffsets(gtl::ArraySlice<BufferLifetime> buffers,
+                        size_t alignment, std::vector<size_t>* offsets);
+
+class PlannedAllocator;
+
+// MemoryPlanner serves the tensors of repeated steps of one executor from a
+// static memory plan.
+//
+// The first step records the size and the lifetime of every tensor that the
+// kernels allocate and deallocate within the step. Tensors are identified
+// across steps by the plan key that OpKernelContext sets in their
+// AllocationAttributes. At the end of that step, the planner computes an
+// offset for each tensor with PlanArenaOffsets(). Every following step
+// reserves one arena with a single call to the underlying allocator, and
+// serves the planned tensors from their offsets in it. Arenas are reused by
+// later steps once all their tensors have been deallocated.
+//
+// Steps do not need to be deterministic. A planned tensor is served from the
+// arena only if it is no larger than in the recorded step, and if its range
+// of the arena is not in use, e.g. because the inter-op threads ran the nodes
+// of the step in a different order. Otherwise it is allocated from the
+// underlying allocator. If most planned tensors of a step fall back to the
+// underlying allocator, e.g. because the shapes changed, the next step records
+// a new plan, and the planner gives up after `kMaxRecordedSteps` such steps.
+class MemoryPlanner : public core::RefCounted {
+ public:
+  // Does not take ownership of `allocator`, which must outlive all the tensors
+  // that are allocated through this planner.
+  explicit MemoryPlanner(Allocator* allocator);
+
+  // Returns the allocator for a new step, or nullptr if the tensors of the step
+  // should be allocated from the underlying allocator. The caller owns a
+  // reference on the returned allocator, and must call `EndStep()` on it
+  // once all the kernels of the step have completed.
+  PlannedAllocator* BeginStep();
+
+  // The maximum number of steps that record a plan.
+  static constexpr int kMaxRecordedSteps = 3;
+
+ private:
+  friend class PlannedAllocator;
+
+  struct Plan {
+    struct Slot {
+      size_t offset;
+      size_t size;
+    };
+    gtl::FlatMap<int64, Slot> slots;
+    size_t arena_bytes = 0;
+  };
+
+  ~MemoryPlanner() override;
+
+  // Called by the allocator of a recording step when the step ends.
+  void RecordingDone(std::unique_ptr<const Plan> plan);
+  // Called by the allocator of a planned step when the step ends.
+  void PlannedStepDone(const Plan* plan, int64 num_hits, int64 num_misses);
+  // Called by the allocator of a planned step when all its tensors have been
+  // deallocated.
+  void ReleaseArena(const Plan* plan, void* arena);
+
+  Allocator* const allocator_;  // Not owned.
+
+  mutex mu_;
+  std::shared_ptr<const Plan> plan_ TF_GUARDED_BY(mu_);
+  // Arenas of `plan_` that are not in use by any step.
+  std::vector<void*> free_arenas_ TF_GUARDED_BY(mu_);
+  bool recording_ TF_GUARDED_BY(mu_) = false;
+  int num_recorded_steps_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryPlanner);
+};
+
+// The allocator of one step of a MemoryPlanner. Allocations without a plan key
+// are forwarded to the underlying allocator.
+//
+// Like TrackingAllocator, a PlannedAllocator can outlive its step: each
+// outstanding allocation holds a reference on it. The arena is returned to the
+// planner as soon as the step has ended and all the tensors in the arena have
+// been deallocated, so that tensors allocated from the underlying allocator,
+// e.g. fetched outputs or tensors held by a queue, do not keep it reserved.
+class PlannedAllocator : public Allocator, public core::RefCounted {
+ public:
+  std::string Name() override { return allocator_->Name(); }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return AllocateRaw(alignment, num_bytes, AllocationAttributes());
+  }
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override;
+  void DeallocateRaw(void* ptr) override;
+  absl::optional<AllocatorStats> GetStats() override {
+    return allocator_->GetStats();
+  }
+  void ClearStats() override { allocator_->ClearStats(); }
+
+  // Marks the end of the step. Tensors that are deallocated after this call
+  // are not part of a recorded plan.
+  void EndStep(bool ok);
+
+ private:
+  friend class MemoryPlanner;
+
+  // Creates the allocator of a step that records a plan if `plan` is nullptr,
+  // and otherwise of a step that serves `plan` from `arena`.
+  PlannedAllocator(MemoryPlanner* planner,
+                   std::shared_ptr<const MemoryPlanner::Plan> plan,
+                   void* arena);
+  ~PlannedAllocator() override;
+
+  void* AllocateFromArena(size_t alignment, size_t num_bytes, int64 plan_key);
+  bool InArena(const void* ptr) const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Returns true, once, when the arena can be returned to the planner.
+  bool ShouldReleaseArena() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  MemoryPlanner* const planner_;
+  Allocator* const allocator_;  // Not owned.
+  const std::shared_ptr<const MemoryPlanner::Plan> plan_;
+  char* const arena_;
+
+  mutex mu_;
+  bool step_done_ TF_GUARDED_BY(mu_) = false;
+  bool arena_released_ TF_GUARDED_BY(mu_) = false;
+
+  // Recording steps only.
+  struct LiveBuffer {
+    int64 plan_key;
+    size_t size;
+    int64 first_use;
+  };
+  int64 next_event_ TF_GUARDED_BY(mu_) = 0;
+  gtl::FlatMap<const void*, LiveBuffer> live_buffers_ TF_GUARDED_BY(mu_);
+  gtl::FlatMap<int64, BufferLifetime> lifetimes_ TF_GUARDED_BY(mu_);
+  // The number of allocations with each plan key. Keys that are allocated
+  // more than once in a step, e.g. in a loop, are not planned.
+  gtl::FlatMap<int64, int> num_allocations_ TF_GUARDED_BY(mu_);
+
+  // Planned steps only. Maps the offset of each range of the arena that is in
+  // use to the end of the range.
+  std::map<size_t, size_t> live_ranges_ TF_GUARDED_BY(mu_);
+  int64 num_hits_ TF_GUARDED_BY(mu_) = 0;
+  int64 num_misses_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PlannedAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PLANNER_H_
@@ -0,0 +1,289 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_planner.h"
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// Checks that buffers with overlapping lifetimes do not overlap in memory.
+void ExpectValidPlan(const std::vector<BufferLifetime>& buffers,
+                     const std::vector<size_t>& offsets, size_t arena_bytes) {
+  ASSERT_EQ(buffers.size(), offsets.size());
+  for (int i = 0; i < buffers.size(); ++i) {
+    EXPECT_LE(offsets[i] + buffers[i].size, arena_bytes);
+    for (int j = i + 1; j < buffers.size(); ++j) {
+      if (buffers[i].first_use > buffers[j].last_use ||
+          buffers[j].first_use > buffers[i].last_use) {
+        continue;
+      }
+      EXPECT_TRUE(offsets[i] + buffers[i].size <= offsets[j] ||
+                  offsets[j] + buffers[j].size <= offsets[i])
+          << "Buffers " << i << " and " << j << " overlap";
+    }
+  }
+}
+
+TEST(PlanArenaOffsetsTest, DisjointLifetimesShareMemory) {
+  const std::vector<BufferLifetime> buffers = {{100, 0, 1}, {200, 2, 3}};
+  std::vector<size_t> offsets;
+  EXPECT_EQ(256, PlanArenaOffsets(buffers, 64, &offsets));
+  EXPECT_EQ(std::vector<size_t>({0, 0}), offsets);
+}
+
+TEST(PlanArenaOffsetsTest, FillsSmallestGap) {
+  const std::vector<BufferLifetime> buffers = {
+      {256, 0, 1}, {64, 0, 5}, {128, 2, 3}, {64, 2, 3}};
+  std::vector<size_t> offsets;
+  const size_t arena_bytes = PlanArenaOffsets(buffers, 64, &offsets);
+  ExpectValidPlan(buffers, offsets, arena_bytes);
+  EXPECT_EQ(320, arena_bytes);
+  // The last buffer fits between the second and the third ones.
+  EXPECT_EQ(std::vector<size_t>({0, 256, 0, 128}), offsets);
+}
+
+TEST(PlanArenaOffsetsTest, ManyBuffers) {
+  std::vector<BufferLifetime> buffers;
+  for (int i = 0; i < 100; ++i) {
+    buffers.push_back({static_cast<size_t>(1 + (i * 7919) % 1000),
+                       (i * 31) % 50, (i * 31) % 50 + i % 7});
+  }
+  std::vector<size_t> offsets;
+  const size_t arena_bytes = PlanArenaOffsets(buffers, 64, &offsets);
+  ExpectValidPlan(buffers, offsets, arena_bytes);
+  for (size_t offset : offsets) {
+    EXPECT_EQ(0, offset % 64);
+  }
+}
+
+void* Allocate(Allocator* a, int64 plan_key, size_t num_bytes) {
+  AllocationAttributes attr;
+  attr.plan_key = plan_key;
+  void* ptr = a->AllocateRaw(Allocator::kAllocatorAlignment, num_bytes, attr);
+  CHECK(ptr != nullptr);
+  memset(ptr, static_cast<int>(plan_key), num_bytes);
+  return ptr;
+}
+
+// Runs a step in which tensor 0 is freed before tensor 2 is allocated. Returns
+// the addresses of the three tensors.
+std::vector<void*> RunStep(MemoryPlanner* planner, size_t num_bytes) {
+  PlannedAllocator* a = planner->BeginStep();
+  CHECK(a != nullptr);
+  std::vector<void*> ptrs;
+  ptrs.push_back(Allocate(a, 0, num_bytes));
+  ptrs.push_back(Allocate(a, 1, num_bytes));
+  a->DeallocateRaw(ptrs[0]);
+  ptrs.push_back(Allocate(a, 2, num_bytes / 2));
+  a->DeallocateRaw(ptrs[1]);
+  a->DeallocateRaw(ptrs[2]);
+  a->EndStep(true);
+  a->Unref();
+  return ptrs;
+}
+
+TEST(MemoryPlannerTest, ServesPlannedStepsFromArena) {
+  MemoryPlanner* planner = new MemoryPlanner(cpu_allocator());
+  core::ScopedUnref unref(planner);
+
+  // The first step records the plan, and meanwhile other steps are not
+  // planned.
+  PlannedAllocator* a = planner->BeginStep();
+  ASSERT_NE(nullptr, a);
+  EXPECT_EQ(nullptr, planner->BeginStep());
+  void* p0 = Allocate(a, 0, 1000);
+  void* p1 = Allocate(a, 1, 1000);
+  a->DeallocateRaw(p0);
+  void* p2 = Allocate(a, 2, 500);
+  a->DeallocateRaw(p1);
+  a->DeallocateRaw(p2);
+  // The output of the step is live when the step ends, and is not planned.
+  void* output = Allocate(a, 3, 100);
+  a->EndStep(true);
+  a->Unref();
+  a->DeallocateRaw(output);
+
+  // Tensors 0 and 2 share memory, which precedes the memory of tensor 1.
+  for (int i = 0; i < 3; ++i) {
+    std::vector<void*> ptrs = RunStep(planner, 1000);
+    EXPECT_EQ(ptrs[0], ptrs[2]);
+    EXPECT_EQ(static_cast<char*>(ptrs[0]) + 1024, ptrs[1]);
+  }
+}
+
+TEST(MemoryPlannerTest, FallsBackWhenRangeIsInUse) {
+  MemoryPlanner* planner = new MemoryPlanner(cpu_allocator());
+  core::ScopedUnref unref(planner);
+  RunStep(planner, 1000);
+
+  // Tensor 2 is allocated while tensor 0 is still live, so they cannot share
+  // memory in this step.
+  PlannedAllocator* a = planner->BeginStep();
+  ASSERT_NE(nullptr, a);
+  void* p0 = Allocate(a, 0, 1000);
+  void* p1 = Allocate(a, 1, 1000);
+  void* p2 = Allocate(a, 2, 500);
+  EXPECT_NE(p0, p2);
+  // Tensor 3 was not planned, and tensor 1 is larger than planned.
+  void* p3 = Allocate(a, 3, 100);
+  a->DeallocateRaw(p1);
+  p1 = Allocate(a, 1, 2000);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(0, static_cast<char*>(p0)[i]);
+  }
+  for (int i = 0; i < 500; ++i) {
+    ASSERT_EQ(2, static_cast<char*>(p2)[i]);
+  }
+  a->DeallocateRaw(p0);
+  a->DeallocateRaw(p2);
+  a->DeallocateRaw(p3);
+  a->EndStep(true);
+  a->Unref();
+  // The larger tensor 1 came from the underlying allocator, and can still be
+  // deallocated after the arena has been released.
+  a->DeallocateRaw(p1);
+}
+
+TEST(MemoryPlannerTest, ReusesArenaWhileOutputsAreAlive) {
+  MemoryPlanner* planner = new MemoryPlanner(cpu_allocator());
+  core::ScopedUnref unref(planner);
+  RunStep(planner, 1000);
+
+  // Each step produces an output that the caller keeps, e.g. a fetched tensor.
+  // The outputs keep the allocators of their steps alive, but not the arenas.
+  std::vector<std::pair<PlannedAllocator*, void*>> outputs;
+  void* arena_tensor = nullptr;
+  for (int i = 0; i < 3; ++i) {
+    PlannedAllocator* a = planner->BeginStep();
+    ASSERT_NE(nullptr, a);
+    void* p0 = Allocate(a, 0, 1000);
+    void* p1 = Allocate(a, 1, 1000);
+    a->DeallocateRaw(p0);
+    void* p2 = Allocate(a, 2, 500);
+    a->DeallocateRaw(p1);
+    a->DeallocateRaw(p2);
+    outputs.emplace_back(a, Allocate(a, 3, 100));
+    a->EndStep(true);
+    a->Unref();
+    if (i == 0) {
+      arena_tensor = p0;
+    } else {
+      EXPECT_EQ(arena_tensor, p0);
+    }
+  }
+  for (const auto& output : outputs) {
+    output.first->DeallocateRaw(output.second);
+  }
+}
+
+TEST(MemoryPlannerTest, ReleasesArenaWhenLastArenaTensorIsFreed) {
+  MemoryPlanner* planner = new MemoryPlanner(cpu_allocator());
+  core::ScopedUnref unref(planner);
+  RunStep(planner, 1000);
+
+  PlannedAllocator* a = planner->BeginStep();
+  ASSERT_NE(nullptr, a);
+  void* p0 = Allocate(a, 0, 1000);
+  void* p1 = Allocate(a, 1, 1000);
+  a->DeallocateRaw(p0);
+  void* p2 = Allocate(a, 2, 500);
+  a->DeallocateRaw(p2);
+  void* output = Allocate(a, 3, 100);
+  a->EndStep(true);
+  a->Unref();
+  // Tensor 1 still holds the arena, so the next step reserves another one.
+  std::vector<void*> ptrs = RunStep(planner, 1000);
+  EXPECT_NE(p0, ptrs[0]);
+  // Once tensor 1 is deallocated, the arena is released even though the
+  // output of the step is still alive, and the next step reuses it.
+  a->DeallocateRaw(p1);
+  PlannedAllocator* b = planner->BeginStep();
+  ASSERT_NE(nullptr, b);
+  void* q0 = Allocate(b, 0, 1000);
+  EXPECT_EQ(p0, q0);
+  b->DeallocateRaw(q0);
+  b->EndStep(true);
+  b->Unref();
+  a->DeallocateRaw(output);
+}
+
+TEST(MemoryPlannerTest, ReplansWhenShapesChange) {
+  MemoryPlanner* planner = new MemoryPlanner(cpu_allocator());
+  core::ScopedUnref unref(planner);
+  RunStep(planner, 1000);
+
+  // No tensor fits in the arena, so the next step records a new plan.
+  RunStep(planner, 4000);
+  RunStep(planner, 4000);
+  std::vector<void*> ptrs = RunStep(planner, 4000);
+  EXPECT_EQ(ptrs[0], ptrs[2]);
+  EXPECT_EQ(static_cast<char*>(ptrs[0]) + 4032, ptrs[1]);
+}
+
+TEST(MemoryPlannerTest, GivesUpAfterMaxRecordedSteps) {
+  MemoryPlanner* planner = new MemoryPlanner(cpu_allocator());
+  core::ScopedUnref unref(planner);
+  for (int i = 0; i < MemoryPlanner::kMaxRecordedSteps; ++i) {
+    PlannedAllocator* a = planner->BeginStep();
+    ASSERT_NE(nullptr, a);
+    a->EndStep(false);
+    a->Unref();
+  }
+  EXPECT_EQ(nullptr, planner->BeginStep());
+}
+
+// Measures steps that allocate a chain of `num_tensors` tensors, each of which
+// is freed once the next one has been allocated.
+static void BM_StepAllocations(int iters, int num_tensors, int planned) {
+  MemoryPlanner* planner = new MemoryPlanner(cpu_allocator());
+  core::ScopedUnref unref(planner);
+  for (int i = 0; i < iters; ++i) {
+    PlannedAllocator* planned_allocator =
+        planned ? planner->BeginStep() : nullptr;
+    Allocator* a = planned_allocator != nullptr
+                       ? static_cast<Allocator*>(planned_allocator)
+                       : cpu_allocator();
+    void* prev = nullptr;
+    for (int j = 0; j < num_tensors; ++j) {
+      AllocationAttributes attr;
+      attr.plan_key = j;
+      void* ptr = a->AllocateRaw(Allocator::kAllocatorAlignment,
+                                 1024 << (j % 8), attr);
+      if (prev != nullptr) a->DeallocateRaw(prev);
+      prev = ptr;
+    }
+    a->DeallocateRaw(prev);
+    if (planned_allocator != nullptr) {
+      planned_allocator->EndStep(true);
+      planned_allocator->Unref();
+    }
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_tensors);
+}
+BENCHMARK(BM_StepAllocations)
+    ->ArgPair(16, 0)
+    ->ArgPair(16, 1)
+    ->ArgPair(1024, 0)
+    ->ArgPair(1024, 1);
+
+}  // namespace
+}  // namespace tensorflow
@@ -16,6 +16,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <atomic>
+
 #include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/logging.h"
@@ -230,6 +232,21 @@ class PendingCounts {
     }
   }
 
+  // The same as the above, but performs the update with a single atomic
+  // read-modify-write, so that it is safe to call concurrently on the same
+  // "h" from several threads. All other routines on "h" must still be
+  // externally synchronized with calls to this one.
+  AdjustResult adjust_for_activation_atomic(Handle h, bool increment_dead) {
+    DCHECK_GE(pending(h), 1);
+    if (h.is_large_) {
+      return adjust_for_activation_shared_atomic(LargeAtomic(h),
+                                                 increment_dead);
+    } else {
+      return adjust_for_activation_shared_atomic(PackedAtomic(h),
+                                                 increment_dead);
+    }
+  }
+
   class Handle {
    public:
     Handle() : byte_offset_(0), is_large_(0) {}
@@ -250,6 +267,26 @@ class PendingCounts {
     return AdjustResult(c->dead_count, c->pending);
   }
 
+  template <typename T>
+  inline AdjustResult adjust_for_activation_shared_atomic(std::atomic<T>* c,
+                                                          bool increment_dead) {
+    T old_val = c->load(std::memory_order_relaxed);
+    while (true) {
+      T new_val = old_val;
+      if (increment_dead && PENDING_NOTREADY == NodeStateForStruct(&new_val)) {
+        new_val.dead_count++;
+      }
+      new_val.pending -= 1;
+      // Acquire and release, so that the thread that makes the node ready
+      // observes the input tensors written by the other producers.
+      if (TF_PREDICT_TRUE(c->compare_exchange_weak(
+              old_val, new_val, std::memory_order_acq_rel,
+              std::memory_order_relaxed))) {
+        return AdjustResult(new_val.dead_count, new_val.pending);
+      }
+    }
+  }
+
   // We keep track of the pending count and dead input count for each
   // graph node.  The representation used here is designed to be cache
   // efficient for graphs with large numbers of nodes, where most
@@ -298,6 +335,19 @@ class PendingCounts {
     return reinterpret_cast<PackedCounts*>(bytes_ + h.byte_offset_);
   }
 
+  // The counts are stored in place, so the atomic and plain representations
+  // must be interchangeable.
+  static_assert(sizeof(std::atomic<PackedCounts>) == sizeof(PackedCounts),
+                "std::atomic<PackedCounts> must have the same layout");
+  static_assert(sizeof(std::atomic<LargeCounts>) == sizeof(LargeCounts),
+                "std::atomic<LargeCounts> must have the same layout");
+  inline std::atomic<LargeCounts>* LargeAtomic(Handle h) {
+    return reinterpret_cast<std::atomic<LargeCounts>*>(Large(h));
+  }
+  inline std::atomic<PackedCounts>* PackedAtomic(Handle h) {
+    return reinterpret_cast<std::atomic<PackedCounts>*>(Packed(h));
+  }
+
   const int num_bytes_;  // Just for bounds checking in debug mode
   char* bytes_;          // Array of num_bytes_ bytes
 
@@ -13,10 +13,13 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 
 #include "tensorflow/core/common_runtime/pending_counts.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -165,4 +168,73 @@ TEST(PendingCounts, AdjustForActivation) {
   }
 }
 
+TEST(PendingCounts, AdjustForActivationAtomic) {
+  PendingCounts::Layout layout;
+  PendingCounts::Handle handles[2];
+  handles[0] = layout.CreateHandle(5, 4);
+  handles[1] = layout.CreateHandle(15, 4);
+  for (int id = 0; id < 2; id++) {
+    PendingCounts::Handle h = handles[id];
+    // Test for both packed and large.
+    int count = (id == 0) ? 5 : 15;
+
+    PendingCounts c(layout);
+    c.set_initial_count(h, count);
+
+    PendingCounts::AdjustResult result =
+        c.adjust_for_activation_atomic(h, false);
+    EXPECT_EQ(c.pending(h), count - 1);
+    EXPECT_TRUE(result.any_pending);
+    EXPECT_EQ(c.dead_count(h), 0);
+    EXPECT_FALSE(result.any_dead);
+
+    result = c.adjust_for_activation_atomic(h, true);
+    EXPECT_EQ(c.pending(h), count - 2);
+    EXPECT_TRUE(result.any_pending);
+    EXPECT_EQ(c.dead_count(h), 1);
+    EXPECT_TRUE(result.any_dead);
+  }
+}
+
+TEST(PendingCounts, AdjustForActivationAtomicConcurrent) {
+  const int kNumHandles = 64;
+  const int kNumActivations = 100;
+  PendingCounts::Layout layout;
+  std::vector<PendingCounts::Handle> h(kNumHandles);
+  for (int id = 0; id < kNumHandles; id++) {
+    // Mix packed and large handles, so that neighbouring packed counts share
+    // a word.
+    h[id] = (id % 4 == 0) ? layout.CreateHandle(kNumActivations, 0)
+                          : layout.CreateHandle(id % 8, 0);
+  }
+  PendingCounts c(layout);
+  std::vector<int> initial_count(kNumHandles);
+  for (int id = 0; id < kNumHandles; id++) {
+    initial_count[id] = (id % 4 == 0) ? kNumActivations : id % 8;
+    c.set_initial_count(h[id], initial_count[id]);
+  }
+
+  // Each handle becomes ready exactly once, no matter how the activations
+  // interleave.
+  std::atomic<int> num_ready(0);
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 16);
+    for (int id = 0; id < kNumHandles; id++) {
+      for (int i = 0; i < initial_count[id]; ++i) {
+        pool.Schedule([&c, &h, &num_ready, id]() {
+          if (!c.adjust_for_activation_atomic(h[id], false).any_pending) {
+            num_ready++;
+          }
+        });
+      }
+    }
+  }
+  int expected_ready = 0;
+  for (int id = 0; id < kNumHandles; id++) {
+    EXPECT_EQ(c.pending(h[id]), 0);
+    if (initial_count[id] > 0) ++expected_ready;
+  }
+  EXPECT_EQ(num_ready, expected_ready);
+}
+
 }  // namespace tensorflow
@@ -99,10 +99,19 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
         LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
       }
       int64 cpu_mem_limit = cpu_mem_limit_in_mb * (1LL << 20);
+      // Caching small chunks reduces contention when many inter-op threads
+      // allocate small tensors concurrently.
+      bool use_chunk_cache = false;
+      status = ReadBoolFromEnvVar("TF_CPU_BFC_USE_CHUNK_CACHE", false,
+                                  &use_chunk_cache);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+      }
       DCHECK(sub_allocator);
       allocator =
           new BFCAllocator(sub_allocator, cpu_mem_limit, true /*allow_growth*/,
-                           "bfc_cpu_allocator_for_gpu" /*name*/);
+                           "bfc_cpu_allocator_for_gpu" /*name*/,
+                           false /*garbage_collection*/, use_chunk_cache);
       VLOG(2) << "Using BFCAllocator with memory limit of "
               << cpu_mem_limit_in_mb << " MB for ProcessState CPU allocator";
     } else if (sub_allocator) {
@@ -134,6 +143,15 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
   return cpu_allocators_[numa_node];
 }
 
+bool ProcessState::EnableNUMA() {
+  mutex_lock lock(mu_);
+  if (!numa_enabled_ && !cpu_allocators_.empty()) {
+    return false;
+  }
+  numa_enabled_ = true;
+  return true;
+}
+
 void ProcessState::AddCPUAllocVisitor(SubAllocator::Visitor visitor) {
   VLOG(1) << "AddCPUAllocVisitor";
   mutex_lock lock(mu_);
@@ -92,10 +92,8 @@ void PropagatorState::PropagateOutputs(const TaggedNode& tagged_node,
     // Fast path for nodes types that don't need special handling
     DCHECK_EQ(input_frame, output_frame);
     // Normal path for most nodes
-    mutex_lock l(input_frame->mu);
-    output_frame->ActivateNodes(item, is_dead, output_iter, outputs, ready);
-    is_frame_done =
-        input_frame->DecrementOutstandingOpsLocked(input_iter, ready);
+    is_frame_done = input_frame->ActivateNodesAndAdjustOutstanding(
+        item, is_dead, output_iter, outputs, ready);
   } else if (item->is_enter) {
     FindOrCreateChildFrame(input_frame, input_iter, *item, &output_frame);
     {
@@ -381,9 +379,22 @@ void PropagatorState::CleanupFramesIterations(FrameState* frame,
 void PropagatorState::FrameState::ActivateNodesFastPath(
     const NodeItem* item, const bool is_dead, IterationState* iter_state,
     EntryVector* outputs, TaggedNodeSeq* ready) {
+  const size_t num_ready = ready->size();
+  ActivateNodesFastPathShared(item, is_dead, iter_state, outputs, ready);
+  iter_state->outstanding_ops += ready->size() - num_ready;
+}
+
+void PropagatorState::FrameState::ActivateNodesFastPathShared(
+    const NodeItem* item, const bool is_dead, IterationState* iter_state,
+    EntryVector* outputs, TaggedNodeSeq* ready) {
   // If we know that none of the item's edge destinations require special
   // handling (i.e. none of the nodes is a merge or control trigger node), we
   // can take a fast path that avoids accessing the destination NodeItem.
+  //
+  // Several threads may activate the successors of different nodes in the
+  // same iteration concurrently. Each pending count is updated atomically, so
+  // exactly one of them adds a given successor to its `ready` queue, and each
+  // input tensor slot has a single producer.
   const GraphView& gview = immutable_state.graph_view();
 
 // Add dst to the ready queue if it's ready
@@ -399,7 +410,6 @@ void PropagatorState::FrameState::ActivateNodesFastPath(
       t.input_frame = this;                               \
       t.input_iter = iter_state;                          \
       t.is_dead = adjust_result.any_dead;                 \
-      iter_state->outstanding_ops++;                      \
     }                                                     \
   } while (0);
 
@@ -414,7 +424,8 @@ void PropagatorState::FrameState::ActivateNodesFastPath(
     const bool increment_dead =
         (is_dead || ((*outputs)[src_slot].state == Entry::State::NO_VALUE));
     const PendingCounts::AdjustResult adjust_result =
-        iter_state->adjust_for_activation(dst_pending_id, increment_dead);
+        iter_state->adjust_for_activation_atomic(dst_pending_id,
+                                                 increment_dead);
     const int dst_loc = e.input_slot;
     if (e.is_last) {
       input_tensors[dst_loc] = std::move((*outputs)[src_slot]);
@@ -429,7 +440,7 @@ void PropagatorState::FrameState::ActivateNodesFastPath(
     const PendingCounts::Handle dst_pending_id =
         immutable_state.pending_ids()[dst_id];
     const PendingCounts::AdjustResult adjust_result =
-        iter_state->adjust_for_activation(dst_pending_id, is_dead);
+        iter_state->adjust_for_activation_atomic(dst_pending_id, is_dead);
     MAYBE_ADD_TO_READY(dst_id, adjust_result);
   }
 #undef MAYBE_ADD_TO_READY
@@ -558,6 +569,35 @@ void PropagatorState::FrameState::ActivateNodes(const NodeItem* item,
   }
 }
 
+bool PropagatorState::FrameState::ActivateNodesAndAdjustOutstanding(
+    const NodeItem* item, const bool is_dead, IterationState* iter_state,
+    EntryVector* outputs, TaggedNodeSeq* ready) {
+  if (TF_PREDICT_FALSE(item->is_any_consumer_merge_or_control_trigger)) {
+    mutex_lock l(mu);
+    ActivateNodesSlowPath(item, is_dead, iter_state, outputs, ready);
+    return DecrementOutstandingOpsLocked(iter_state, ready);
+  }
+
+  {
+    tf_shared_lock l(mu);
+    DCHECK(ready->empty());
+    ActivateNodesFastPathShared(item, is_dead, iter_state, outputs, ready);
+    // Account for the newly ready nodes and the completion of `item` in a
+    // single update. Only the thread that brings the count to zero can
+    // observe a done iteration, because no node can be added to an iteration
+    // once it is done.
+    const size_t delta = ready->size() - 1;
+    const size_t old_outstanding_ops =
+        iter_state->outstanding_ops.fetch_add(delta, std::memory_order_acq_rel);
+    if (old_outstanding_ops + delta != 0 || !IsIterationDone(iter_state)) {
+      return false;
+    }
+  }
+
+  mutex_lock l(mu);
+  return CleanupIterations(iter_state, ready);
+}
+
 void PropagatorState::FrameState::ActivateNexts(IterationState* iter_state,
                                                 TaggedNodeSeq* ready) {
   // Propagate the deferred NextIteration nodes to the new iteration.
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_PROPAGATOR_STATE_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_PROPAGATOR_STATE_H_
 
+#include <atomic>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/entry.h"
@@ -143,7 +144,11 @@ class PropagatorState {
     Entry* input_tensors;
 
     // The number of outstanding ops for each iteration.
-    size_t outstanding_ops;
+    //
+    // NOTE: This is atomic so that `FrameState::ActivateNodesFastPathShared()`
+    // can update it while holding `FrameState::mu` in shared mode. All other
+    // updates hold `FrameState::mu` exclusively.
+    std::atomic<size_t> outstanding_ops;
 
     // The number of outstanding frames for each iteration.
     int outstanding_frame_count;
@@ -170,6 +175,10 @@ class PropagatorState {
                                                       bool increment_dead) {
       return counts.adjust_for_activation(h, increment_dead);
     }
+    PendingCounts::AdjustResult adjust_for_activation_atomic(
+        PendingCounts::Handle h, bool increment_dead) {
+      return counts.adjust_for_activation_atomic(h, increment_dead);
+    }
 
     ~IterationState() { delete[] input_tensors; }
 
@@ -283,7 +292,7 @@ class PropagatorState {
     void InitializeFrameInfo(const ImmutableExecutorState::FrameInfo& finfo);
 
     inline IterationState* GetIteration(int64 iter)
-        TF_EXCLUSIVE_LOCKS_REQUIRED(mu) {
+        TF_SHARED_LOCKS_REQUIRED(mu) {
       if (TF_PREDICT_TRUE(iter == 0)) {
         return iterations_first;
       } else {
@@ -304,12 +313,26 @@ class PropagatorState {
     bool DecrementOutstandingOpsLocked(IterationState* iter_state,
                                        TaggedNodeSeq* ready);
 
+    // Activate the successors of a node, and adjust the outstanding op count
+    // of `iter_state` for the newly ready nodes and the completion of `item`.
+    // Return true iff the execution of the frame is done.
+    //
+    // Unless a successor of `item` is a merge or control trigger node, the
+    // successors are activated while holding `mu` in shared mode, so that
+    // concurrent completions in the same frame do not serialize on `mu`.
+    bool ActivateNodesAndAdjustOutstanding(const NodeItem* item,
+                                           const bool is_dead,
+                                           IterationState* iter_state,
+                                           EntryVector* outputs,
+                                           TaggedNodeSeq* ready)
+        TF_LOCKS_EXCLUDED(mu);
+
     // Returns true if the computation in the frame is completed.
     bool IsFrameDone();
 
     // Returns true if the iteration of the frame is completed.
     bool IsIterationDone(IterationState* iter_state)
-        TF_EXCLUSIVE_LOCKS_REQUIRED(mu);
+        TF_SHARED_LOCKS_REQUIRED(mu);
 
     // Increments the iteration id. If this is a new iteration, initialize it.
     //
@@ -368,6 +391,16 @@ class PropagatorState {
                                IterationState* iter_state, EntryVector* outputs,
                                TaggedNodeSeq* ready)
         TF_EXCLUSIVE_LOCKS_REQUIRED(mu);
+
+    // The same as `ActivateNodesFastPath()`, but updates the pending counts
+    // atomically and leaves the outstanding op count of `iter_state`
+    // unchanged, so that it is safe to call while holding `mu` in shared mode.
+    //
+    // REQUIRES: `!item->is_any_consumer_merge_or_control_trigger`.
+    void ActivateNodesFastPathShared(const NodeItem* item, const bool is_dead,
+                                     IterationState* iter_state,
+                                     EntryVector* outputs, TaggedNodeSeq* ready)
+        TF_SHARED_LOCKS_REQUIRED(mu);
   };
 
  public:
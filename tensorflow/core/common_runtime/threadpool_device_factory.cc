@@ -38,6 +38,15 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
   Status CreateDevices(const SessionOptions& options, const string& name_prefix,
                        std::vector<std::unique_ptr<Device>>* devices) override {
     int num_numa_nodes = port::NUMANumNodes();
+    // Make the allocators of the devices below local to their NUMA nodes.
+    // This is only possible before the first CPU allocator is created, e.g.
+    // by an earlier session in the same process.
+    if (options.config.experimental().use_numa_affinity() &&
+        !ProcessState::singleton()->EnableNUMA()) {
+      LOG(WARNING) << "use_numa_affinity is set, but the CPU allocators "
+                   << "already exist, so the CPU devices of " << name_prefix
+                   << " will not allocate from their NUMA nodes";
+    }
     int n = 1;
     auto iter = options.config.device_count().find("CPU");
     if (iter != options.config.device_count().end()) {
@@ -0,0 +1,76 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/process_state.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+// A ProcessState that is not the process-wide singleton.
+class TestProcessState : public ProcessState {
+ public:
+  ~TestProcessState() override { TestOnlyReset(); }
+};
+
+TEST(ProcessStateTest, EnableNUMABeforeCPUAllocators) {
+  TestProcessState process_state;
+  EXPECT_TRUE(process_state.EnableNUMA());
+  EXPECT_TRUE(process_state.NUMAEnabled());
+  // The allocator is built on a NUMA-local sub-allocator rather than being
+  // the default CPU allocator.
+  EXPECT_NE(process_state.GetCPUAllocator(0), cpu_allocator_base());
+  EXPECT_TRUE(process_state.EnableNUMA());
+}
+
+TEST(ProcessStateTest, EnableNUMAAfterCPUAllocators) {
+  TestProcessState process_state;
+  Allocator* allocator = process_state.GetCPUAllocator(port::kNUMANoAffinity);
+  EXPECT_FALSE(process_state.EnableNUMA());
+  EXPECT_FALSE(process_state.NUMAEnabled());
+  EXPECT_EQ(process_state.GetCPUAllocator(0), allocator);
+}
+
+TEST(ThreadPoolDeviceFactoryTest, NUMAAffinity) {
+  const int num_numa_nodes = port::NUMANumNodes();
+  SessionOptions options;
+  options.config.mutable_experimental()->set_use_numa_affinity(true);
+  (*options.config.mutable_device_count())["CPU"] = num_numa_nodes;
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory("CPU")->CreateDevices(
+      options, "/job:localhost/replica:0/task:0", &devices));
+
+  // No CPU allocator exists before the devices are created, so the devices
+  // get allocators local to their NUMA nodes.
+  ProcessState* process_state = ProcessState::singleton();
+  EXPECT_TRUE(process_state->NUMAEnabled());
+  ASSERT_EQ(devices.size(), static_cast<size_t>(num_numa_nodes));
+  for (int i = 0; i < num_numa_nodes; ++i) {
+    EXPECT_EQ(devices[i]->NumaNode(), i);
+    EXPECT_EQ(devices[i]->GetAllocator(AllocatorAttributes()),
+              process_state->GetCPUAllocator(i));
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
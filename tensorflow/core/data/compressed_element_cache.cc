@@ -0,0 +1,181 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/compressed_element_cache.h"
+
+#include "tensorflow/core/data/compression_utils.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/path.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kMemoryTier[] = "memory";
+constexpr char kFileTier[] = "file";
+constexpr char kSpillFilePrefix[] = "compressed_element_cache";
+constexpr char kSpillFileSuffix[] = ".spill";
+
+}  // namespace
+
+CompressedElementCache::CompressedElementCache(Env* env,
+                                               const Options& options)
+    : env_(env), options_(options) {}
+
+CompressedElementCache::~CompressedElementCache() {
+  mutex_lock l(mu_);
+  if (spill_filename_.empty()) {
+    return;
+  }
+  if (spill_writer_) {
+    Status s = spill_writer_->Close();
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to close " << spill_filename_ << ": " << s;
+    }
+  }
+  spill_reader_.reset();
+  Status s = env_->DeleteFile(spill_filename_);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to delete " << spill_filename_ << ": " << s;
+  }
+}
+
+Status CompressedElementCache::Append(const std::vector<Tensor>& element) {
+  auto compressed = std::make_shared<CompressedElement>();
+  TF_RETURN_IF_ERROR(CompressElement(element, compressed.get()));
+  return AppendCompressed(std::move(compressed));
+}
+
+Status CompressedElementCache::AppendCompressed(
+    std::shared_ptr<const CompressedElement> element) {
+  mutex_lock l(mu_);
+  Entry entry;
+  entry.num_bytes = element->ByteSizeLong();
+  entry.element = std::move(element);
+  lru_.push_front(entries_.size());
+  entry.lru_position = lru_.begin();
+  memory_bytes_ += entry.num_bytes;
+  metrics::RecordTFDataMemoryCacheBytes(kMemoryTier, entry.num_bytes);
+  entries_.push_back(std::move(entry));
+  return MaybeEvict();
+}
+
+Status CompressedElementCache::Get(int64 index, std::vector<Tensor>* element) {
+  std::shared_ptr<const CompressedElement> compressed;
+  TF_RETURN_IF_ERROR(GetCompressed(index, &compressed));
+  return UncompressElement(*compressed, element);
+}
+
+Status CompressedElementCache::GetCompressed(
+    int64 index, std::shared_ptr<const CompressedElement>* element) {
+  RandomAccessFile* reader;
+  std::string filename;
+  uint64 offset;
+  uint64 num_bytes;
+  {
+    mutex_lock l(mu_);
+    if (index < 0 || index >= entries_.size()) {
+      return errors::OutOfRange("Index ", index,
+                                " is out of range for a cache of size ",
+                                entries_.size(), ".");
+    }
+    Entry& entry = entries_[index];
+    if (entry.element) {
+      lru_.splice(lru_.begin(), lru_, entry.lru_position);
+      *element = entry.element;
+      metrics::RecordTFDataMemoryCacheLookup(kMemoryTier);
+      return Status::OK();
+    }
+    if (spill_writer_dirty_) {
+      TF_RETURN_IF_ERROR(spill_writer_->Flush());
+      spill_writer_dirty_ = false;
+    }
+    reader = spill_reader_.get();
+    filename = spill_filename_;
+    offset = entry.offset;
+    num_bytes = entry.num_bytes;
+  }
+  // The scratch file is append-only, so the read does not need to hold `mu_`.
+  std::string scratch(num_bytes, '\0');
+  StringPiece data;
+  TF_RETURN_IF_ERROR(reader->Read(offset, num_bytes, &data, &scratch[0]));
+  auto compressed = std::make_shared<CompressedElement>();
+  if (!compressed->ParseFromArray(data.data(), data.size())) {
+    return errors::DataLoss("Failed to parse element at index ", index,
+                            " from ", filename, ".");
+  }
+  metrics::RecordTFDataMemoryCacheLookup(kFileTier);
+  *element = std::move(compressed);
+  return Status::OK();
+}
+
+int64 CompressedElementCache::size() {
+  mutex_lock l(mu_);
+  return entries_.size();
+}
+
+int64 CompressedElementCache::memory_bytes() {
+  mutex_lock l(mu_);
+  return memory_bytes_;
+}
+
+Status CompressedElementCache::MaybeEvict() {
+  if (options_.max_memory_bytes <= 0) {
+    return Status::OK();
+  }
+  while (memory_bytes_ > options_.max_memory_bytes && !lru_.empty()) {
+    if (!spill_writer_) {
+      TF_RETURN_IF_ERROR(OpenSpillFile());
+    }
+    Entry& entry = entries_[lru_.back()];
+    std::string serialized;
+    if (!entry.element->SerializeToString(&serialized)) {
+      return errors::Internal("Failed to serialize a compressed element.");
+    }
+    TF_RETURN_IF_ERROR(spill_writer_->Append(serialized));
+    entry.offset = spill_file_size_;
+    spill_file_size_ += serialized.size();
+    spill_writer_dirty_ = true;
+    metrics::RecordTFDataMemoryCacheBytes(kFileTier, serialized.size());
+    memory_bytes_ -= entry.num_bytes;
+    entry.element.reset();
+    lru_.pop_back();
+  }
+  return Status::OK();
+}
+
+Status CompressedElementCache::OpenSpillFile() {
+  std::string filename;
+  if (options_.spill_directory.empty()) {
+    if (!env_->LocalTempFilename(&filename)) {
+      return errors::Internal(
+          "Failed to create a temporary file for the compressed cache.");
+    }
+  } else {
+    TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(options_.spill_directory));
+    filename = io::JoinPath(options_.spill_directory, kSpillFilePrefix);
+    if (!env_->CreateUniqueFileName(&filename, kSpillFileSuffix)) {
+      return errors::Internal("Failed to create a unique file name in ",
+                              options_.spill_directory, ".");
+    }
+  }
+  TF_RETURN_IF_ERROR(env_->NewWritableFile(filename, &spill_writer_));
+  spill_filename_ = filename;
+  return env_->NewRandomAccessFile(filename, &spill_reader_);
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,114 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_COMPRESSED_ELEMENT_CACHE_H_
+#define TENSORFLOW_CORE_DATA_COMPRESSED_ELEMENT_CACHE_H_
+
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/data/dataset.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+namespace data {
+
+// A thread-safe, append-only store of dataset elements, indexed by insertion
+// order. Elements are kept in memory as `CompressedElement`s.
+//
+// If the store has a memory budget, the least recently used elements are
+// evicted to a local scratch file whenever the compressed bytes held in memory
+// exceed the budget. Evicted elements are read back from the file on demand
+// and are not re-admitted to memory, so that repeated sequential scans (the
+// access pattern of a cache that is read once per epoch) do not thrash the
+// memory tier.
+class CompressedElementCache {
+ public:
+  struct Options {
+    // If positive, at most this many compressed bytes are kept in memory.
+    int64 max_memory_bytes = 0;
+    // Directory for the scratch file holding evicted elements. If empty, a
+    // local temporary directory is used.
+    std::string spill_directory;
+  };
+
+  CompressedElementCache(Env* env, const Options& options);
+
+  // Deletes the scratch file, if any.
+  ~CompressedElementCache();
+
+  // Compresses `element` and appends it to the store.
+  Status Append(const std::vector<Tensor>& element) TF_LOCKS_EXCLUDED(mu_);
+
+  // Appends an already compressed element to the store.
+  Status AppendCompressed(std::shared_ptr<const CompressedElement> element)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Uncompresses the element at `index` into `element`.
+  Status Get(int64 index, std::vector<Tensor>* element) TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the compressed element at `index`.
+  Status GetCompressed(int64 index,
+                       std::shared_ptr<const CompressedElement>* element)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the number of elements in the store.
+  int64 size() TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the number of compressed bytes held in memory.
+  int64 memory_bytes() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Entry {
+    // The element, while it is resident in memory.
+    std::shared_ptr<const CompressedElement> element;
+    // Serialized size of the element in bytes.
+    uint64 num_bytes = 0;
+    // Position in `lru_`, while the element is resident in memory.
+    std::list<int64>::iterator lru_position;
+    // Offset of the element in the scratch file, once it has been evicted.
+    uint64 offset = 0;
+  };
+
+  // Evicts least recently used elements until the memory budget is met.
+  Status MaybeEvict() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Creates the scratch file and opens it for writing and reading.
+  Status OpenSpillFile() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Env* const env_;
+  const Options options_;
+
+  mutex mu_;
+  std::vector<Entry> entries_ TF_GUARDED_BY(mu_);
+  // Indices of the elements resident in memory, most recently used first.
+  std::list<int64> lru_ TF_GUARDED_BY(mu_);
+  int64 memory_bytes_ TF_GUARDED_BY(mu_) = 0;
+  std::string spill_filename_ TF_GUARDED_BY(mu_);
+  std::unique_ptr<WritableFile> spill_writer_ TF_GUARDED_BY(mu_);
+  // The reader is only created once and is safe to use concurrently.
+  std::unique_ptr<RandomAccessFile> spill_reader_ TF_GUARDED_BY(mu_);
+  uint64 spill_file_size_ TF_GUARDED_BY(mu_) = 0;
+  // Whether `spill_writer_` has buffered data that is not visible to readers.
+  bool spill_writer_dirty_ TF_GUARDED_BY(mu_) = false;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_COMPRESSED_ELEMENT_CACHE_H_
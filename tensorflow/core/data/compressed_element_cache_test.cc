@@ -0,0 +1,95 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/compressed_element_cache.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+class CompressedElementCacheTest : public DatasetOpsTestBase {
+ protected:
+  std::vector<Tensor> MakeElement(int64 i) {
+    return {CreateTensor<int64>(TensorShape({}), {i}),
+            CreateTensor<tstring>(TensorShape({}), {strings::StrCat("e", i)})};
+  }
+
+  void AppendElements(CompressedElementCache* cache, int64 num_elements) {
+    for (int64 i = 0; i < num_elements; ++i) {
+      TF_ASSERT_OK(cache->Append(MakeElement(i)));
+    }
+  }
+
+  void ExpectElements(CompressedElementCache* cache, int64 num_elements) {
+    for (int64 i = 0; i < num_elements; ++i) {
+      std::vector<Tensor> element;
+      TF_ASSERT_OK(cache->Get(i, &element));
+      TF_EXPECT_OK(ExpectEqual(element, MakeElement(i),
+                               /*compare_order=*/true));
+    }
+  }
+};
+
+TEST_F(CompressedElementCacheTest, Unbounded) {
+  CompressedElementCache cache(Env::Default(), {});
+  AppendElements(&cache, 10);
+  EXPECT_EQ(cache.size(), 10);
+  EXPECT_GT(cache.memory_bytes(), 0);
+  ExpectElements(&cache, 10);
+}
+
+TEST_F(CompressedElementCacheTest, EvictsToFile) {
+  CompressedElementCache::Options options;
+  options.max_memory_bytes = 64;
+  options.spill_directory = io::JoinPath(testing::TmpDir(), "spill");
+  CompressedElementCache cache(Env::Default(), options);
+  AppendElements(&cache, 100);
+  EXPECT_EQ(cache.size(), 100);
+  EXPECT_LE(cache.memory_bytes(), options.max_memory_bytes);
+  std::vector<string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(options.spill_directory, &children));
+  EXPECT_EQ(children.size(), 1);
+  // Read the cache twice, as a cache dataset does for consecutive epochs.
+  ExpectElements(&cache, 100);
+  ExpectElements(&cache, 100);
+  EXPECT_LE(cache.memory_bytes(), options.max_memory_bytes);
+}
+
+TEST_F(CompressedElementCacheTest, InterleavedAppendAndGet) {
+  CompressedElementCache::Options options;
+  options.max_memory_bytes = 1;
+  CompressedElementCache cache(Env::Default(), options);
+  for (int64 i = 0; i < 20; ++i) {
+    TF_ASSERT_OK(cache.Append(MakeElement(i)));
+    ExpectElements(&cache, i + 1);
+  }
+}
+
+TEST_F(CompressedElementCacheTest, OutOfRange) {
+  CompressedElementCache cache(Env::Default(), {});
+  AppendElements(&cache, 2);
+  std::vector<Tensor> element;
+  EXPECT_EQ(cache.Get(2, &element).code(), error::OUT_OF_RANGE);
+  EXPECT_EQ(cache.Get(-1, &element).code(), error::OUT_OF_RANGE);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
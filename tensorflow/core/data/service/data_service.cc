@@ -17,11 +17,13 @@ limitations under the License.
 
 #include "grpcpp/create_channel.h"
 #include "grpcpp/security/credentials.h"
+#include "absl/strings/match.h"
 #include "tensorflow/core/data/service/credentials_factory.h"
 #include "tensorflow/core/data/service/dispatcher.grpc.pb.h"
 #include "tensorflow/core/data/service/grpc_util.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
 #include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/platform/host_info.h"
 
 namespace tensorflow {
 namespace data {
@@ -29,6 +31,7 @@ namespace data {
 namespace {
 constexpr const char kParallelEpochs[] = "parallel_epochs";
 constexpr const char kOneEpoch[] = "one_epoch";
+constexpr const char kSharedEpoch[] = "shared_epoch";
 }  // namespace
 
 Status ParseProcessingMode(const std::string& s, ProcessingMode* mode) {
@@ -36,6 +39,8 @@ Status ParseProcessingMode(const std::string& s, ProcessingMode* mode) {
     *mode = ProcessingMode::PARALLEL_EPOCHS;
   } else if (s == kOneEpoch) {
     *mode = ProcessingMode::ONE_EPOCH;
+  } else if (s == kSharedEpoch) {
+    *mode = ProcessingMode::SHARED_EPOCH;
   } else {
     return errors::InvalidArgument("Unrecognized processing mode: ", s);
   }
@@ -48,12 +53,26 @@ std::string ProcessingModeToString(ProcessingMode mode) {
       return kParallelEpochs;
     case ProcessingMode::ONE_EPOCH:
       return kOneEpoch;
+    case ProcessingMode::SHARED_EPOCH:
+      return kSharedEpoch;
     default:
       DCHECK(false);
       return "Unknown";
   }
 }
 
+bool IsLocalAddress(absl::string_view address) {
+  absl::string_view host = address;
+  if (absl::StartsWith(host, "[")) {
+    // IPv6 addresses are enclosed in brackets, e.g. "[::1]:5000".
+    host = host.substr(1, host.find(']') - 1);
+  } else {
+    host = host.substr(0, host.rfind(':'));
+  }
+  return host == "localhost" || host == "127.0.0.1" || host == "::1" ||
+         host == port::Hostname();
+}
+
 Status DataServiceDispatcherClient::RegisterWorker(
     const std::string& worker_address, std::vector<TaskDef>& tasks) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
@@ -104,6 +123,24 @@ Status DataServiceDispatcherClient::GetDatasetDef(int64 dataset_id,
   return Status::OK();
 }
 
+Status DataServiceDispatcherClient::GetSplit(int64 job_id, int64 task_id,
+                                             int64& split_index,
+                                             bool& end_of_splits) {
+  TF_RETURN_IF_ERROR(EnsureInitialized());
+  GetSplitRequest req;
+  req.set_job_id(job_id);
+  req.set_task_id(task_id);
+  GetSplitResponse resp;
+  grpc::ClientContext client_ctx;
+  grpc::Status status = stub_->GetSplit(&client_ctx, req, &resp);
+  if (!status.ok()) {
+    return grpc_util::WrapError("Failed to get split", status);
+  }
+  end_of_splits = resp.end_of_splits();
+  split_index = resp.split_index();
+  return Status::OK();
+}
+
 Status DataServiceDispatcherClient::RegisterDataset(GraphDef dataset,
                                                     int64* dataset_id) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
@@ -244,6 +281,30 @@ Status DataServiceWorkerClient::GetElement(int64 task_id,
   return Status::OK();
 }
 
+Status DataServiceWorkerClient::GetElements(
+    int64 task_id, int64 max_elements, std::vector<CompressedElement>* elements,
+    bool* end_of_sequence) {
+  TF_RETURN_IF_ERROR(EnsureInitialized());
+  GetElementRequest req;
+  req.set_task_id(task_id);
+  req.set_max_elements(max_elements);
+  GetElementResponse resp;
+  grpc::ClientContext ctx;
+  grpc::Status s = stub_->GetElement(&ctx, req, &resp);
+  if (!s.ok()) {
+    return grpc_util::WrapError("Failed to get elements", s);
+  }
+  *end_of_sequence = resp.end_of_sequence();
+  if (!*end_of_sequence) {
+    elements->reserve(elements->size() + 1 + resp.additional_elements_size());
+    elements->push_back(std::move(*resp.mutable_compressed_element()));
+    for (CompressedElement& element : *resp.mutable_additional_elements()) {
+      elements->push_back(std::move(element));
+    }
+  }
+  return Status::OK();
+}
+
 Status DataServiceWorkerClient::EnsureInitialized() {
   mutex_lock l(mu_);
   if (stub_) {
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_DATA_SERVICE_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_DATA_SERVICE_H_
 
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/data/service/dispatcher.grpc.pb.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -31,6 +32,11 @@ enum class ProcessingMode : int64 {
   PARALLEL_EPOCHS = 0,
   // Processing of a single epoch is distributed across all tf.data workers.
   ONE_EPOCH = 1,
+  // Each tf.data worker processes an entire epoch, like PARALLEL_EPOCHS, but
+  // all SHARED_EPOCH jobs reading the same dataset share the elements that a
+  // worker produces. Jobs that start while another job is already reading see
+  // the epoch from the start of the worker's sliding window of elements.
+  SHARED_EPOCH = 2,
 };
 
 // Parses a string representing a processing mode and stores the result in
@@ -40,6 +46,10 @@ Status ParseProcessingMode(const std::string& s, ProcessingMode* mode);
 // Converts a processing mode to its corresponding string.
 std::string ProcessingModeToString(ProcessingMode mode);
 
+// Returns whether `address`, in the form "hostname:port", refers to the local
+// host. Clients use this to prefer reading from co-located workers.
+bool IsLocalAddress(absl::string_view address);
+
 // Base class for data service clients. Data service clients are
 // threadsafe.
 class DataServiceClientBase {
@@ -86,6 +96,12 @@ class DataServiceDispatcherClient : public DataServiceClientBase {
   // definition in `dataset_def`.
   Status GetDatasetDef(int64 dataset_id, DatasetDef& dataset_def);
 
+  // Gets the next split of a ONE_EPOCH job for the task with id `task_id`,
+  // storing its index in `split_index`. If all splits have been handed out,
+  // sets `end_of_splits` to `true` instead.
+  Status GetSplit(int64 job_id, int64 task_id, int64& split_index,
+                  bool& end_of_splits);
+
   // Registers a dataset with the tf.data service, and stores the generated
   // dataset id in `*dataset_id`.
   Status RegisterDataset(GraphDef dataset, int64* dataset_id);
@@ -139,6 +155,15 @@ class DataServiceWorkerClient : public DataServiceClientBase {
   Status GetElement(int64 task_id, CompressedElement* element,
                     bool* end_of_sequence);
 
+  // Fetches up to `max_elements` next elements for the specified task_id,
+  // appending their compressed tensors to `*elements`. The worker returns the
+  // elements it has already produced, so fewer than `max_elements` elements
+  // may be returned. If no element is available, `*end_of_sequence` will be
+  // `true`, and `elements` will be left unchanged.
+  Status GetElements(int64 task_id, int64 max_elements,
+                     std::vector<CompressedElement>* elements,
+                     bool* end_of_sequence);
+
  protected:
   Status EnsureInitialized() override;
 
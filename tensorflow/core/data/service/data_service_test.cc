@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "grpcpp/create_channel.h"
 #include "grpcpp/security/credentials.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "tensorflow/core/data/compression_utils.h"
 #include "tensorflow/core/data/service/dispatcher.grpc.pb.h"
@@ -30,14 +31,52 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/host_info.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace data {
 
 namespace {
 constexpr const char kProtocol[] = "grpc+local";
+
+// Registers the dataset of `test_case` and creates a job for it, storing the
+// job's tasks in `tasks`.
+Status CreateJob(const std::string& dispatcher_address,
+                 const test_util::GraphDefTestCase& test_case,
+                 ProcessingMode processing_mode, std::vector<TaskInfo>& tasks) {
+  DataServiceDispatcherClient dispatcher(dispatcher_address, kProtocol);
+  int64 dataset_id;
+  TF_RETURN_IF_ERROR(dispatcher.RegisterDataset(test_case.graph_def,
+                                                &dataset_id));
+  int64 job_client_id;
+  TF_RETURN_IF_ERROR(
+      dispatcher.CreateJob(dataset_id, processing_mode, &job_client_id));
+  bool job_finished;
+  return dispatcher.GetTasks(job_client_id, &tasks, &job_finished);
+}
+
+// Reads all elements of `task`, fetching up to `max_elements` per request, and
+// appends them to `elements`.
+Status ReadTask(const TaskInfo& task, int64 max_elements,
+                std::vector<std::vector<Tensor>>& elements) {
+  DataServiceWorkerClient worker(task.worker_address(), kProtocol);
+  while (true) {
+    std::vector<CompressedElement> compressed;
+    bool end_of_sequence;
+    TF_RETURN_IF_ERROR(worker.GetElements(task.task_id(), max_elements,
+                                          &compressed, &end_of_sequence));
+    if (end_of_sequence) {
+      return Status::OK();
+    }
+    for (const CompressedElement& element : compressed) {
+      elements.emplace_back();
+      TF_RETURN_IF_ERROR(UncompressElement(element, &elements.back()));
+    }
+  }
 }
+}  // namespace
 
 TEST(DataService, ParseParallelEpochsProcessingMode) {
   ProcessingMode mode;
@@ -63,6 +102,14 @@ TEST(DataService, ProcessingModeToString) {
   EXPECT_EQ("one_epoch", ProcessingModeToString(ProcessingMode::ONE_EPOCH));
 }
 
+TEST(DataService, IsLocalAddress) {
+  EXPECT_TRUE(IsLocalAddress("localhost:5000"));
+  EXPECT_TRUE(IsLocalAddress("127.0.0.1:5000"));
+  EXPECT_TRUE(IsLocalAddress("[::1]:5000"));
+  EXPECT_TRUE(IsLocalAddress(absl::StrCat(port::Hostname(), ":5000")));
+  EXPECT_FALSE(IsLocalAddress("remote.invalid:5000"));
+}
+
 TEST(DataService, GetWorkers) {
   TestCluster cluster(1);
   TF_ASSERT_OK(cluster.Initialize());
@@ -73,5 +120,261 @@ TEST(DataService, GetWorkers) {
   EXPECT_EQ(1, workers.size());
 }
 
+TEST(DataService, GetSplits) {
+  TestCluster cluster(1);
+  TF_ASSERT_OK(cluster.Initialize());
+  DataServiceDispatcherClient dispatcher(cluster.DispatcherAddress(),
+                                         kProtocol);
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::map_test_case(&test_case));
+  int64 dataset_id;
+  TF_ASSERT_OK(dispatcher.RegisterDataset(test_case.graph_def, &dataset_id));
+  int64 job_client_id;
+  TF_ASSERT_OK(dispatcher.CreateJob(dataset_id, ProcessingMode::ONE_EPOCH,
+                                    &job_client_id));
+  std::vector<TaskInfo> tasks;
+  bool job_finished;
+  TF_ASSERT_OK(dispatcher.GetTasks(job_client_id, &tasks, &job_finished));
+  ASSERT_EQ(tasks.size(), 1);
+
+  int64 num_splits = 0;
+  while (true) {
+    int64 split_index;
+    bool end_of_splits;
+    TF_ASSERT_OK(dispatcher.GetSplit(tasks[0].job_id(), tasks[0].task_id(),
+                                     split_index, end_of_splits));
+    if (end_of_splits) {
+      break;
+    }
+    EXPECT_EQ(split_index, num_splits);
+    ++num_splits;
+  }
+  // The number of splits is capped at the number of elements of the range.
+  EXPECT_EQ(num_splits, 10);
+}
+
+TEST(DataService, GetSplitsForParallelEpochsJob) {
+  TestCluster cluster(1);
+  TF_ASSERT_OK(cluster.Initialize());
+  DataServiceDispatcherClient dispatcher(cluster.DispatcherAddress(),
+                                         kProtocol);
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::map_test_case(&test_case));
+  int64 dataset_id;
+  TF_ASSERT_OK(dispatcher.RegisterDataset(test_case.graph_def, &dataset_id));
+  int64 job_client_id;
+  TF_ASSERT_OK(dispatcher.CreateJob(
+      dataset_id, ProcessingMode::PARALLEL_EPOCHS, &job_client_id));
+  std::vector<TaskInfo> tasks;
+  bool job_finished;
+  TF_ASSERT_OK(dispatcher.GetTasks(job_client_id, &tasks, &job_finished));
+  ASSERT_EQ(tasks.size(), 1);
+  int64 split_index;
+  bool end_of_splits;
+  Status s = dispatcher.GetSplit(tasks[0].job_id(), tasks[0].task_id(),
+                                 split_index, end_of_splits);
+  EXPECT_EQ(s.code(), error::FAILED_PRECONDITION);
+}
+
+TEST(DataService, GetElements) {
+  TestCluster cluster(1);
+  TF_ASSERT_OK(cluster.Initialize());
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::range_compressed_test_case(100, &test_case));
+  std::vector<TaskInfo> tasks;
+  TF_ASSERT_OK(CreateJob(cluster.DispatcherAddress(), test_case,
+                         ProcessingMode::PARALLEL_EPOCHS, tasks));
+  ASSERT_EQ(tasks.size(), 1);
+  std::vector<std::vector<Tensor>> elements;
+  TF_ASSERT_OK(ReadTask(tasks[0], /*max_elements=*/16, elements));
+  ASSERT_EQ(elements.size(), test_case.output.size());
+  for (int i = 0; i < elements.size(); ++i) {
+    TF_EXPECT_OK(DatasetOpsTestBase::ExpectEqual(elements[i],
+                                                 test_case.output[i],
+                                                 /*compare_order=*/true));
+  }
+}
+
+TEST(DataService, OneEpochProducesEachElementOnce) {
+  TestCluster cluster(2);
+  TF_ASSERT_OK(cluster.Initialize());
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::range_compressed_test_case(100, &test_case));
+  std::vector<TaskInfo> tasks;
+  TF_ASSERT_OK(CreateJob(cluster.DispatcherAddress(), test_case,
+                         ProcessingMode::ONE_EPOCH, tasks));
+  ASSERT_EQ(tasks.size(), 2);
+  std::vector<std::vector<Tensor>> elements;
+  for (const TaskInfo& task : tasks) {
+    TF_ASSERT_OK(ReadTask(task, /*max_elements=*/4, elements));
+  }
+  std::vector<int64> values;
+  for (const auto& element : elements) {
+    values.push_back(element[0].scalar<int64>()());
+  }
+  std::vector<int64> expected;
+  for (const auto& element : test_case.output) {
+    expected.push_back(element[0].scalar<int64>()());
+  }
+  EXPECT_THAT(values, ::testing::UnorderedElementsAreArray(expected));
+}
+
+TEST(DataService, OneEpochFewerElementsThanSplits) {
+  TestCluster cluster(2);
+  TF_ASSERT_OK(cluster.Initialize());
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::range_compressed_test_case(5, &test_case));
+  std::vector<TaskInfo> tasks;
+  TF_ASSERT_OK(CreateJob(cluster.DispatcherAddress(), test_case,
+                         ProcessingMode::ONE_EPOCH, tasks));
+  ASSERT_EQ(tasks.size(), 2);
+  std::vector<std::vector<Tensor>> elements;
+  for (const TaskInfo& task : tasks) {
+    TF_ASSERT_OK(ReadTask(task, /*max_elements=*/4, elements));
+  }
+  std::vector<int64> values;
+  for (const auto& element : elements) {
+    values.push_back(element[0].scalar<int64>()());
+  }
+  EXPECT_THAT(values, ::testing::UnorderedElementsAre(0, 1, 2, 3, 4));
+}
+
+TEST(DataService, OneEpochFewerFilesThanSplits) {
+  TestCluster cluster(2);
+  TF_ASSERT_OK(cluster.Initialize());
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::tf_record_compressed_test_case(
+      testing::TmpDir(), /*num_files=*/3, /*records_per_file=*/5, &test_case));
+  std::vector<TaskInfo> tasks;
+  TF_ASSERT_OK(CreateJob(cluster.DispatcherAddress(), test_case,
+                         ProcessingMode::ONE_EPOCH, tasks));
+  ASSERT_EQ(tasks.size(), 2);
+  std::vector<std::vector<Tensor>> elements;
+  for (const TaskInfo& task : tasks) {
+    TF_ASSERT_OK(ReadTask(task, /*max_elements=*/4, elements));
+  }
+  std::vector<tstring> values;
+  for (const auto& element : elements) {
+    values.push_back(element[0].scalar<tstring>()());
+  }
+  std::vector<tstring> expected;
+  for (const auto& element : test_case.output) {
+    expected.push_back(element[0].scalar<tstring>()());
+  }
+  EXPECT_THAT(values, ::testing::UnorderedElementsAreArray(expected));
+}
+
+TEST(DataService, OneEpochZipReadsEachElementOnce) {
+  TestCluster cluster(2);
+  TF_ASSERT_OK(cluster.Initialize());
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::zip_compressed_test_case(10, &test_case));
+  std::vector<TaskInfo> tasks;
+  TF_ASSERT_OK(CreateJob(cluster.DispatcherAddress(), test_case,
+                         ProcessingMode::ONE_EPOCH, tasks));
+  ASSERT_EQ(tasks.size(), 2);
+  // The dataset zips two sources, so it is processed as a single split
+  // instead of splitting one source and dropping elements of the other.
+  std::vector<std::vector<Tensor>> elements;
+  for (const TaskInfo& task : tasks) {
+    TF_ASSERT_OK(ReadTask(task, /*max_elements=*/4, elements));
+  }
+  std::vector<std::pair<int64, int64>> values;
+  for (const auto& element : elements) {
+    ASSERT_EQ(element.size(), 2);
+    values.emplace_back(element[0].scalar<int64>()(),
+                        element[1].scalar<int64>()());
+  }
+  std::vector<std::pair<int64, int64>> expected;
+  for (const auto& element : test_case.output) {
+    expected.emplace_back(element[0].scalar<int64>()(),
+                          element[1].scalar<int64>()());
+  }
+  EXPECT_THAT(values, ::testing::UnorderedElementsAreArray(expected));
+}
+
+TEST(DataService, OneEpochTFRecordReaderReadsEachRecordOnce) {
+  TestCluster cluster(2);
+  TF_ASSERT_OK(cluster.Initialize());
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::tf_record_reader_compressed_test_case(
+      testing::TmpDir(), /*num_files=*/3, /*records_per_file=*/5, &test_case));
+  std::vector<TaskInfo> tasks;
+  TF_ASSERT_OK(CreateJob(cluster.DispatcherAddress(), test_case,
+                         ProcessingMode::ONE_EPOCH, tasks));
+  ASSERT_EQ(tasks.size(), 2);
+  std::vector<std::vector<Tensor>> elements;
+  for (const TaskInfo& task : tasks) {
+    TF_ASSERT_OK(ReadTask(task, /*max_elements=*/4, elements));
+  }
+  std::vector<tstring> values;
+  for (const auto& element : elements) {
+    values.push_back(element[0].scalar<tstring>()());
+  }
+  std::vector<tstring> expected;
+  for (const auto& element : test_case.output) {
+    expected.push_back(element[0].scalar<tstring>()());
+  }
+  EXPECT_THAT(values, ::testing::UnorderedElementsAreArray(expected));
+}
+
+TEST(DataService, SharedEpochJobsReadEntireEpoch) {
+  TestCluster cluster(1);
+  TF_ASSERT_OK(cluster.Initialize());
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::range_compressed_test_case(100, &test_case));
+  std::vector<TaskInfo> tasks1;
+  TF_ASSERT_OK(CreateJob(cluster.DispatcherAddress(), test_case,
+                         ProcessingMode::SHARED_EPOCH, tasks1));
+  std::vector<TaskInfo> tasks2;
+  TF_ASSERT_OK(CreateJob(cluster.DispatcherAddress(), test_case,
+                         ProcessingMode::SHARED_EPOCH, tasks2));
+  ASSERT_EQ(tasks1.size(), 1);
+  ASSERT_EQ(tasks2.size(), 1);
+  EXPECT_NE(tasks1[0].job_id(), tasks2[0].job_id());
+  for (const TaskInfo& task : {tasks1[0], tasks2[0]}) {
+    std::vector<std::vector<Tensor>> elements;
+    TF_ASSERT_OK(ReadTask(task, /*max_elements=*/8, elements));
+    ASSERT_EQ(elements.size(), test_case.output.size());
+    for (int i = 0; i < elements.size(); ++i) {
+      TF_EXPECT_OK(DatasetOpsTestBase::ExpectEqual(elements[i],
+                                                   test_case.output[i],
+                                                   /*compare_order=*/true));
+    }
+  }
+}
+
+static void BM_GetElements(int iters, int max_elements) {
+  testing::StopTiming();
+  TestCluster cluster(1);
+  TF_CHECK_OK(cluster.Initialize());
+  test_util::GraphDefTestCase test_case;
+  TF_CHECK_OK(test_util::range_compressed_test_case(iters, &test_case));
+  std::vector<TaskInfo> tasks;
+  TF_CHECK_OK(CreateJob(cluster.DispatcherAddress(), test_case,
+                        ProcessingMode::PARALLEL_EPOCHS, tasks));
+  CHECK_EQ(tasks.size(), 1);
+  DataServiceWorkerClient worker(tasks[0].worker_address(), kProtocol);
+  TF_CHECK_OK(worker.Initialize());
+
+  testing::StartTiming();
+  int64 num_elements = 0;
+  while (true) {
+    std::vector<CompressedElement> elements;
+    bool end_of_sequence;
+    TF_CHECK_OK(worker.GetElements(tasks[0].task_id(), max_elements,
+                                   &elements, &end_of_sequence));
+    if (end_of_sequence) {
+      break;
+    }
+    num_elements += elements.size();
+  }
+  testing::StopTiming();
+  CHECK_EQ(num_elements, iters);
+  testing::ItemsProcessed(num_elements);
+}
+
+BENCHMARK(BM_GetElements)->Arg(1)->Arg(4)->Arg(16);
+
 }  // namespace data
 }  // namespace tensorflow
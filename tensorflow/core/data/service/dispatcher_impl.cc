@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/dispatcher_impl.h"
 
+#include <algorithm>
 #include <memory>
 #include <tuple>
 #include <utility>
@@ -34,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/dispatcher.pb.h"
 #include "tensorflow/core/data/service/grpc_util.h"
 #include "tensorflow/core/data/service/journal.h"
+#include "tensorflow/core/data/service/utils.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
@@ -51,6 +53,8 @@ namespace {
 constexpr char kJournalDir[] = "tf_data_dispatcher_journal";
 // The name of the datasets directory inside the dispatcher's working directory.
 constexpr char kDatasetsDir[] = "datasets";
+// The default number of splits for ONE_EPOCH jobs.
+constexpr int64 kDefaultNumSplits = 64;
 
 using Dataset = DispatcherState::Dataset;
 using Worker = DispatcherState::Worker;
@@ -170,23 +174,7 @@ Status DataServiceDispatcherImpl::RegisterWorker(
     } else {
       TF_RETURN_IF_ERROR(CreateTask(job, worker_address, &task));
     }
-    TaskDef* task_def = response->add_tasks();
-    std::shared_ptr<const Dataset> dataset;
-    TF_RETURN_IF_ERROR(state_.DatasetFromId(job->dataset_id, &dataset));
-    std::string dataset_key =
-        DatasetKey(dataset->dataset_id, dataset->fingerprint);
-    if (config_.work_dir().empty()) {
-      std::shared_ptr<const DatasetDef> dataset_def;
-      TF_RETURN_IF_ERROR(dataset_store_->Get(dataset_key, dataset_def));
-      *task_def->mutable_dataset_def() = *dataset_def;
-    } else {
-      std::string path =
-          io::JoinPath(DatasetsDir(config_.work_dir()), dataset_key);
-      task_def->set_path(path);
-    }
-    task_def->set_dataset_id(job->dataset_id);
-    task_def->set_job_id(job->job_id);
-    task_def->set_task_id(task->task_id);
+    TF_RETURN_IF_ERROR(PopulateTaskDef(task, response->add_tasks()));
   }
 
   VLOG(1) << "Registered worker at address " << request->worker_address();
@@ -228,6 +216,33 @@ Status DataServiceDispatcherImpl::GetDatasetDef(
   return Status::OK();
 }
 
+Status DataServiceDispatcherImpl::GetSplit(const GetSplitRequest* request,
+                                           GetSplitResponse* response) {
+  mutex_lock l(mu_);
+  std::shared_ptr<const Job> job;
+  TF_RETURN_IF_ERROR(state_.JobFromId(request->job_id(), &job));
+  if (job->processing_mode != ProcessingMode::ONE_EPOCH) {
+    return errors::FailedPrecondition(
+        "Splits are only available for ONE_EPOCH jobs, but job ", job->job_id,
+        " has processing mode ", ProcessingModeToString(job->processing_mode));
+  }
+  if (job->next_split_index >= job->num_splits) {
+    response->set_end_of_splits(true);
+    return Status::OK();
+  }
+  int64 split_index = job->next_split_index;
+  Update update;
+  AssignSplitUpdate* assign_split = update.mutable_assign_split();
+  assign_split->set_job_id(job->job_id);
+  assign_split->set_split_index(split_index);
+  assign_split->set_task_id(request->task_id());
+  TF_RETURN_IF_ERROR(Apply(update));
+  response->set_split_index(split_index);
+  VLOG(3) << "Assigned split " << split_index << " of job " << job->job_id
+          << " to task " << request->task_id();
+  return Status::OK();
+}
+
 Status DataServiceDispatcherImpl::GetOrRegisterDataset(
     const GetOrRegisterDatasetRequest* request,
     GetOrRegisterDatasetResponse* response) {
@@ -380,11 +395,9 @@ Status DataServiceDispatcherImpl::CreateJob(
     EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   switch (processing_mode) {
     case ProcessingMode::PARALLEL_EPOCHS:
-      break;
     case ProcessingMode::ONE_EPOCH:
-      return errors::Unimplemented(
-          "CreateJob only supports the PARALLEL_EPOCHS job mode. "
-          "ONE_EPOCH is not currently supported.");
+    case ProcessingMode::SHARED_EPOCH:
+      break;
     default:
       return errors::Unimplemented("ProcessingMode ",
                                    ProcessingModeToString(processing_mode),
@@ -396,6 +409,11 @@ Status DataServiceDispatcherImpl::CreateJob(
   create_job->set_job_id(job_id);
   create_job->set_dataset_id(dataset_id);
   create_job->set_processing_mode(ProcessingModeDef(processing_mode));
+  if (processing_mode == ProcessingMode::ONE_EPOCH) {
+    int64 num_splits;
+    TF_RETURN_IF_ERROR(NumSplitsForDataset(dataset_id, num_splits));
+    create_job->set_num_splits(num_splits);
+  }
   if (named_job_key.has_value()) {
     NamedJobKeyDef* key = create_job->mutable_named_job_key();
     key->set_name(named_job_key->name);
@@ -406,6 +424,32 @@ Status DataServiceDispatcherImpl::CreateJob(
   return Status::OK();
 }
 
+Status DataServiceDispatcherImpl::NumSplitsForDataset(int64 dataset_id,
+                                                      int64& num_splits)
+    EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  num_splits =
+      config_.num_splits() > 0 ? config_.num_splits() : kDefaultNumSplits;
+  std::shared_ptr<const Dataset> dataset;
+  TF_RETURN_IF_ERROR(state_.DatasetFromId(dataset_id, &dataset));
+  std::shared_ptr<const DatasetDef> dataset_def;
+  TF_RETURN_IF_ERROR(dataset_store_->Get(
+      DatasetKey(dataset->dataset_id, dataset->fingerprint), dataset_def));
+  int64 max_num_splits;
+  Status s = MaxNumSplits(dataset_def->graph(), max_num_splits);
+  if (!s.ok()) {
+    LOG(INFO) << "Processing dataset " << dataset_id
+              << " as a single split: " << s;
+    num_splits = 1;
+    return Status::OK();
+  }
+  if (max_num_splits >= 0) {
+    // Splits beyond the number of source files or elements would all be
+    // empty.
+    num_splits = std::max<int64>(std::min(num_splits, max_num_splits), 1);
+  }
+  return Status::OK();
+}
+
 Status DataServiceDispatcherImpl::AcquireJobClientId(
     const std::shared_ptr<const Job>& job, int64& job_client_id)
     EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -450,6 +494,32 @@ Status DataServiceDispatcherImpl::CreateTask(std::shared_ptr<const Job> job,
   return Status::OK();
 }
 
+Status DataServiceDispatcherImpl::PopulateTaskDef(
+    std::shared_ptr<const Task> task, TaskDef* task_def)
+    EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  std::shared_ptr<const Job> job;
+  TF_RETURN_IF_ERROR(state_.JobFromId(task->job_id, &job));
+  std::shared_ptr<const Dataset> dataset;
+  TF_RETURN_IF_ERROR(state_.DatasetFromId(task->dataset_id, &dataset));
+  std::string dataset_key =
+      DatasetKey(dataset->dataset_id, dataset->fingerprint);
+  if (config_.work_dir().empty()) {
+    std::shared_ptr<const DatasetDef> dataset_def;
+    TF_RETURN_IF_ERROR(dataset_store_->Get(dataset_key, dataset_def));
+    *task_def->mutable_dataset_def() = *dataset_def;
+  } else {
+    std::string path =
+        io::JoinPath(DatasetsDir(config_.work_dir()), dataset_key);
+    task_def->set_path(path);
+  }
+  task_def->set_dataset_id(task->dataset_id);
+  task_def->set_job_id(task->job_id);
+  task_def->set_task_id(task->task_id);
+  task_def->set_processing_mode(ProcessingModeDef(job->processing_mode));
+  task_def->set_num_splits(job->num_splits);
+  return Status::OK();
+}
+
 Status DataServiceDispatcherImpl::AssignTasks(
     std::vector<std::shared_ptr<const Task>> tasks) LOCKS_EXCLUDED(mu_) {
   for (const auto& task : tasks) {
@@ -490,25 +560,10 @@ Status DataServiceDispatcherImpl::AssignTask(std::shared_ptr<const Task> task)
           << task->worker_address;
   grpc::ClientContext client_ctx;
   ProcessTaskRequest req;
-  TaskDef* task_def = req.mutable_task();
-  task_def->set_dataset_id(task->dataset_id);
   {
     mutex_lock l(mu_);
-    std::shared_ptr<const Dataset> dataset;
-    TF_RETURN_IF_ERROR(state_.DatasetFromId(task->dataset_id, &dataset));
-    std::string dataset_key =
-        DatasetKey(dataset->dataset_id, dataset->fingerprint);
-    if (config_.work_dir().empty()) {
-      std::shared_ptr<const DatasetDef> dataset_def;
-      TF_RETURN_IF_ERROR(dataset_store_->Get(dataset_key, dataset_def));
-      *task_def->mutable_dataset_def() = *dataset_def;
-    } else {
-      std::string path =
-          io::JoinPath(DatasetsDir(config_.work_dir()), dataset_key);
-      task_def->set_path(path);
-    }
+    TF_RETURN_IF_ERROR(PopulateTaskDef(task, req.mutable_task()));
   }
-  task_def->set_task_id(task->task_id);
   ProcessTaskResponse resp;
   WorkerService::Stub* stub;
   TF_RETURN_IF_ERROR(GetOrCreateWorkerStub(task->worker_address, &stub));
@@ -61,6 +61,7 @@ class DataServiceDispatcherImpl {
                       WorkerUpdateResponse* response);
   Status GetDatasetDef(const GetDatasetDefRequest* request,
                        GetDatasetDefResponse* response);
+  Status GetSplit(const GetSplitRequest* request, GetSplitResponse* response);
 
   /// Client-facing API.
   Status GetOrRegisterDataset(const GetOrRegisterDatasetRequest* request,
@@ -91,6 +92,12 @@ class DataServiceDispatcherImpl {
                    absl::optional<DispatcherState::NamedJobKey> named_job_key,
                    std::shared_ptr<const DispatcherState::Job>* job)
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Computes the number of splits of a ONE_EPOCH job over the given dataset:
+  // `DispatcherConfig.num_splits`, capped at the number of files or elements
+  // of the dataset's source when it is known. Datasets that cannot be split
+  // are processed as a single split by one task.
+  Status NumSplitsForDataset(int64 dataset_id, int64& num_splits)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Acquires a job client id to read from the given job and sets
   // `job_client_id`.
   Status AcquireJobClientId(
@@ -108,6 +115,10 @@ class DataServiceDispatcherImpl {
   Status CreateTask(std::shared_ptr<const DispatcherState::Job> job,
                     const std::string& worker_address,
                     std::shared_ptr<const DispatcherState::Task>* task);
+  // Fills in `task_def` with the dataset and job information needed by a
+  // worker to process `task`.
+  Status PopulateTaskDef(std::shared_ptr<const DispatcherState::Task> task,
+                         TaskDef* task_def) EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Assigns the list of tasks to the workers indicated by their
   // `worker_address` fields.
   Status AssignTasks(
@@ -48,6 +48,9 @@ Status DispatcherState::Apply(Update update) {
     case Update::kFinishTask:
       FinishTask(update.finish_task());
       break;
+    case Update::kAssignSplit:
+      AssignSplit(update.assign_split());
+      break;
     case Update::UPDATE_TYPE_NOT_SET:
       return errors::Internal("Update type not set.");
   }
@@ -84,7 +87,7 @@ void DispatcherState::CreateJob(const CreateJobUpdate& create_job) {
   }
   auto job = std::make_shared<Job>(job_id, create_job.dataset_id(),
                                    ProcessingMode(create_job.processing_mode()),
-                                   named_job_key);
+                                   named_job_key, create_job.num_splits());
   DCHECK(!jobs_.contains(job_id));
   jobs_[job_id] = job;
   tasks_by_job_[job_id] = std::vector<std::shared_ptr<Task>>();
@@ -146,6 +149,15 @@ void DispatcherState::FinishTask(const FinishTaskUpdate& finish_task) {
   jobs_[task->job_id]->finished = all_finished;
 }
 
+void DispatcherState::AssignSplit(const AssignSplitUpdate& assign_split) {
+  int64 job_id = assign_split.job_id();
+  std::shared_ptr<Job>& job = jobs_[job_id];
+  DCHECK(job != nullptr);
+  DCHECK_EQ(assign_split.split_index(), job->next_split_index);
+  DCHECK_LT(assign_split.split_index(), job->num_splits);
+  job->next_split_index = assign_split.split_index() + 1;
+}
+
 int64 DispatcherState::NextAvailableDatasetId() const {
   return next_available_dataset_id_;
 }
@@ -96,16 +96,21 @@ class DispatcherState {
   // A job for processing a dataset.
   struct Job {
     explicit Job(int64 job_id, int64 dataset_id, ProcessingMode processing_mode,
-                 absl::optional<NamedJobKey> named_job_key)
+                 absl::optional<NamedJobKey> named_job_key, int64 num_splits)
         : job_id(job_id),
           dataset_id(dataset_id),
           processing_mode(processing_mode),
-          named_job_key(named_job_key) {}
+          named_job_key(named_job_key),
+          num_splits(num_splits) {}
 
     const int64 job_id;
     const int64 dataset_id;
     const ProcessingMode processing_mode;
     const absl::optional<NamedJobKey> named_job_key;
+    // For ONE_EPOCH jobs, the number of splits the dataset is divided into.
+    const int64 num_splits;
+    // For ONE_EPOCH jobs, the index of the next split to assign to a task.
+    int64 next_split_index = 0;
     int64 num_clients = 0;
     int64 last_client_released_micros = -1;
     bool finished = false;
@@ -178,6 +183,7 @@ class DispatcherState {
   void ReleaseJobClient(const ReleaseJobClientUpdate& release_job_client);
   void CreateTask(const CreateTaskUpdate& create_task);
   void FinishTask(const FinishTaskUpdate& finish_task);
+  void AssignSplit(const AssignSplitUpdate& assign_split);
 
   int64 next_available_dataset_id_ = 0;
   // Registered datasets, keyed by dataset ids.
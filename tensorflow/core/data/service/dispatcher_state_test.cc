@@ -81,6 +81,18 @@ Status CreateNamedJob(int64 job_id, int64 dataset_id, NamedJobKey named_job_key,
   return Status::OK();
 }
 
+Status CreateOneEpochJob(int64 job_id, int64 dataset_id, int64 num_splits,
+                         DispatcherState* state) {
+  Update update;
+  CreateJobUpdate* create_job = update.mutable_create_job();
+  create_job->set_job_id(job_id);
+  create_job->set_dataset_id(dataset_id);
+  create_job->set_processing_mode(ProcessingModeDef::ONE_EPOCH);
+  create_job->set_num_splits(num_splits);
+  TF_RETURN_IF_ERROR(state->Apply(update));
+  return Status::OK();
+}
+
 Status AcquireJobClientId(int64 job_id, int64 job_client_id,
                           DispatcherState* state) {
   Update update;
@@ -122,6 +134,17 @@ Status FinishTask(int64 task_id, DispatcherState* state) {
   TF_RETURN_IF_ERROR(state->Apply(update));
   return Status::OK();
 }
+
+Status AssignSplit(int64 job_id, int64 split_index, int64 task_id,
+                   DispatcherState* state) {
+  Update update;
+  AssignSplitUpdate* assign_split = update.mutable_assign_split();
+  assign_split->set_job_id(job_id);
+  assign_split->set_split_index(split_index);
+  assign_split->set_task_id(task_id);
+  TF_RETURN_IF_ERROR(state->Apply(update));
+  return Status::OK();
+}
 }  // namespace
 
 TEST(DispatcherState, RegisterDataset) {
@@ -467,5 +490,38 @@ TEST(DispatcherState, ReleaseJobClientId) {
   EXPECT_EQ(s.code(), error::NOT_FOUND);
 }
 
+TEST(DispatcherState, OneEpochJob) {
+  int64 job_id = 3;
+  int64 dataset_id = 10;
+  int64 num_splits = 8;
+  DispatcherState state;
+  TF_EXPECT_OK(RegisterDataset(dataset_id, &state));
+  TF_EXPECT_OK(CreateOneEpochJob(job_id, dataset_id, num_splits, &state));
+  std::shared_ptr<const Job> job;
+  TF_EXPECT_OK(state.JobFromId(job_id, &job));
+  EXPECT_EQ(job->processing_mode, ProcessingMode::ONE_EPOCH);
+  EXPECT_EQ(job->num_splits, num_splits);
+  EXPECT_EQ(job->next_split_index, 0);
+}
+
+TEST(DispatcherState, AssignSplits) {
+  int64 job_id = 3;
+  int64 dataset_id = 10;
+  int64 num_splits = 3;
+  int64 task_id_1 = 4;
+  int64 task_id_2 = 5;
+  DispatcherState state;
+  TF_EXPECT_OK(RegisterDataset(dataset_id, &state));
+  TF_EXPECT_OK(CreateOneEpochJob(job_id, dataset_id, num_splits, &state));
+  TF_EXPECT_OK(CreateTask(task_id_1, job_id, dataset_id, "worker_1", &state));
+  TF_EXPECT_OK(CreateTask(task_id_2, job_id, dataset_id, "worker_2", &state));
+  TF_EXPECT_OK(AssignSplit(job_id, /*split_index=*/0, task_id_1, &state));
+  TF_EXPECT_OK(AssignSplit(job_id, /*split_index=*/1, task_id_2, &state));
+  TF_EXPECT_OK(AssignSplit(job_id, /*split_index=*/2, task_id_1, &state));
+  std::shared_ptr<const Job> job;
+  TF_EXPECT_OK(state.JobFromId(job_id, &job));
+  EXPECT_EQ(job->next_split_index, num_splits);
+}
+
 }  // namespace data
 }  // namespace tensorflow
@@ -48,6 +48,7 @@ class GrpcDispatcherImpl : public DispatcherService::Service {
   HANDLER(RegisterWorker);
   HANDLER(WorkerUpdate);
   HANDLER(GetDatasetDef);
+  HANDLER(GetSplit);
   HANDLER(GetOrRegisterDataset);
   HANDLER(CreateJob);
   HANDLER(ReleaseJobClient);
@@ -0,0 +1,188 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/data/service/shared_epoch_cache.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace data {
+
+SharedEpochCache::SharedEpochCache(int64 window_size, int64 stall_timeout_us,
+                                   ProduceFn produce)
+    : window_size_(std::max<int64>(window_size, 1)),
+      stall_timeout_us_(stall_timeout_us),
+      produce_(std::move(produce)) {}
+
+Status SharedEpochCache::RegisterConsumer(int64& consumer_id) {
+  mutex_lock l(mu_);
+  if (window_start_ > 0) {
+    return errors::FailedPrecondition(
+        "The shared epoch has already evicted its first ", window_start_,
+        " elements");
+  }
+  if (end_of_sequence_ || !status_.ok()) {
+    return errors::FailedPrecondition("The shared epoch has finished");
+  }
+  consumer_id = next_consumer_id_++;
+  Consumer& consumer = consumers_[consumer_id];
+  consumer.position = window_start_;
+  consumer.last_active_us = Env::Default()->NowMicros();
+  return Status::OK();
+}
+
+void SharedEpochCache::UnregisterConsumer(int64 consumer_id) {
+  mutex_lock l(mu_);
+  consumers_.erase(consumer_id);
+  cv_.notify_all();
+}
+
+Status SharedEpochCache::GetNext(int64 consumer_id, CompressedElement& element,
+                                 bool& end_of_sequence) {
+  {
+    mutex_lock l(mu_);
+    auto it = consumers_.find(consumer_id);
+    if (it == consumers_.end()) {
+      return errors::NotFound("Consumer ", consumer_id, " is not registered");
+    }
+    it->second.reading = true;
+  }
+  Status s = GetNextInternal(consumer_id, element, end_of_sequence);
+  mutex_lock l(mu_);
+  auto it = consumers_.find(consumer_id);
+  if (it != consumers_.end()) {
+    it->second.reading = false;
+    it->second.last_active_us = Env::Default()->NowMicros();
+  }
+  return s;
+}
+
+Status SharedEpochCache::GetNextInternal(int64 consumer_id,
+                                         CompressedElement& element,
+                                         bool& end_of_sequence) {
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      while (true) {
+        // Look the consumer up on every iteration; `consumers_` may rehash
+        // while we wait.
+        auto it = consumers_.find(consumer_id);
+        if (it == consumers_.end()) {
+          return errors::NotFound("Consumer ", consumer_id,
+                                  " is not registered");
+        }
+        int64& position = it->second.position;
+        if (position < window_start_) {
+          return errors::DataLoss(
+              "Consumer ", consumer_id, " of the shared epoch did not read for ",
+              stall_timeout_us_ / 1000, "ms, and ", window_start_ - position,
+              " elements that it had not read were evicted");
+        }
+        if (position < window_start_ + window_.size()) {
+          element.CopyFrom(*window_[position - window_start_]);
+          ++position;
+          end_of_sequence = false;
+          cv_.notify_all();
+          return Status::OK();
+        }
+        if (!status_.ok()) {
+          return status_;
+        }
+        if (end_of_sequence_) {
+          end_of_sequence = true;
+          return Status::OK();
+        }
+        int64 next_stall_us = -1;
+        if (!producing_) {
+          if (window_.size() >= window_size_ &&
+              MinPosition(Env::Default()->NowMicros()) > window_start_) {
+            window_.pop_front();
+            ++window_start_;
+          }
+          if (window_.size() < window_size_) {
+            producing_ = true;
+            break;
+          }
+          next_stall_us = NextStallUs(Env::Default()->NowMicros());
+        }
+        if (next_stall_us < 0) {
+          cv_.wait(l);
+        } else {
+          // Wake up when the consumers holding back the window stall.
+          int64 wait_us = next_stall_us - Env::Default()->NowMicros();
+          cv_.wait_for(
+              l, std::chrono::microseconds(std::max<int64>(wait_us, 1)));
+        }
+      }
+    }
+    // Produce outside the lock so that other consumers can keep reading the
+    // window.
+    auto produced = std::make_shared<CompressedElement>();
+    bool produced_end_of_sequence = false;
+    Status s = produce_(*produced, produced_end_of_sequence);
+    mutex_lock l(mu_);
+    producing_ = false;
+    cv_.notify_all();
+    if (!s.ok()) {
+      status_ = s;
+    } else if (produced_end_of_sequence) {
+      end_of_sequence_ = true;
+    } else {
+      window_.push_back(std::move(produced));
+    }
+  }
+}
+
+bool SharedEpochCache::finished() {
+  mutex_lock l(mu_);
+  return end_of_sequence_ || !status_.ok();
+}
+
+bool SharedEpochCache::Stalled(const Consumer& consumer, int64 now_us) const {
+  return !consumer.reading &&
+         now_us - consumer.last_active_us >= stall_timeout_us_;
+}
+
+int64 SharedEpochCache::MinPosition(int64 now_us) {
+  int64 min_position = window_start_ + window_.size();
+  for (const auto& consumer : consumers_) {
+    if (!Stalled(consumer.second, now_us)) {
+      min_position = std::min(min_position, consumer.second.position);
+    }
+  }
+  return min_position;
+}
+
+int64 SharedEpochCache::NextStallUs(int64 now_us) {
+  int64 next_stall_us = -1;
+  for (const auto& consumer : consumers_) {
+    if (consumer.second.position > window_start_ || consumer.second.reading ||
+        Stalled(consumer.second, now_us)) {
+      continue;
+    }
+    int64 stall_us = consumer.second.last_active_us + stall_timeout_us_;
+    if (next_stall_us < 0 || stall_us < next_stall_us) {
+      next_stall_us = stall_us;
+    }
+  }
+  return next_stall_us;
+}
+
+}  // namespace data
+}  // namespace tensorflow
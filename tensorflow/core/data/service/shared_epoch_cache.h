@@ -0,0 +1,125 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_SHARED_EPOCH_CACHE_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_SHARED_EPOCH_CACHE_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/data/dataset.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace data {
+
+// A sliding window of dataset elements shared by the tasks of several jobs
+// that read the same dataset in SHARED_EPOCH mode.
+//
+// Elements are produced once, on demand, by whichever consumer first needs
+// them, and every registered consumer reads every element of the epoch. The
+// window keeps the `window_size` most recent elements. Consumers can only
+// register while the window still holds the first element of the epoch, so
+// jobs that start within `window_size` elements of each other share the
+// cache, and later jobs must read from a new cache. Once the window is full,
+// an element is only evicted after all consumers have read it, so the fastest
+// consumer can run at most `window_size` elements ahead of the slowest one.
+//
+// The one exception is a consumer that has not asked for an element for
+// `stall_timeout_us`, e.g. because its client stopped reading: it no longer
+// holds back eviction. If elements it has not read are evicted, its following
+// `GetNext` calls return DATA_LOSS rather than skipping those elements.
+class SharedEpochCache {
+ public:
+  // Produces the next element of the dataset, setting `end_of_sequence` to
+  // true once the dataset is exhausted. Never called concurrently.
+  using ProduceFn =
+      std::function<Status(CompressedElement& element, bool& end_of_sequence)>;
+
+  SharedEpochCache(int64 window_size, int64 stall_timeout_us,
+                   ProduceFn produce);
+
+  // Registers a new consumer, which starts reading from the first element of
+  // the epoch, and stores its id in `consumer_id`. Returns FAILED_PRECONDITION
+  // if the window no longer holds the first element, or if the dataset has
+  // been exhausted or failed; the consumer should then use a new cache.
+  Status RegisterConsumer(int64& consumer_id) TF_LOCKS_EXCLUDED(mu_);
+
+  // Unregisters a consumer so that it no longer holds back eviction. Pending
+  // and future `GetNext` calls for the consumer return NOT_FOUND.
+  void UnregisterConsumer(int64 consumer_id) TF_LOCKS_EXCLUDED(mu_);
+
+  // Copies the next element for `consumer_id` into `element`, producing it if
+  // necessary. Blocks while the consumer is `window_size` elements ahead of the
+  // slowest consumer that has not stalled. Returns DATA_LOSS if the consumer
+  // stalled and its next element has been evicted.
+  Status GetNext(int64 consumer_id, CompressedElement& element,
+                 bool& end_of_sequence) TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns whether the dataset has been exhausted or failed.
+  bool finished() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Consumer {
+    // The position of the next element to read.
+    int64 position;
+    // Whether the consumer is in a `GetNext` call.
+    bool reading = false;
+    // The time at which the consumer last returned from `GetNext` or
+    // registered.
+    int64 last_active_us;
+  };
+
+  Status GetNextInternal(int64 consumer_id, CompressedElement& element,
+                         bool& end_of_sequence) TF_LOCKS_EXCLUDED(mu_);
+  // Returns whether `consumer` has stalled at time `now_us`.
+  bool Stalled(const Consumer& consumer, int64 now_us) const;
+  // Returns the smallest position among registered consumers that have not
+  // stalled.
+  int64 MinPosition(int64 now_us) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Returns the earliest time after `now_us` at which a consumer at the start
+  // of the window stalls, or -1 if no such consumer can stall.
+  int64 NextStallUs(int64 now_us) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int64 window_size_;
+  const int64 stall_timeout_us_;
+  const ProduceFn produce_;
+
+  mutex mu_;
+  // Notified when an element is produced or consumed, or a consumer is
+  // unregistered.
+  condition_variable cv_;
+  // The elements in the window. `window_.front()` is the element at position
+  // `window_start_` of the dataset.
+  std::deque<std::shared_ptr<const CompressedElement>> window_
+      TF_GUARDED_BY(mu_);
+  int64 window_start_ TF_GUARDED_BY(mu_) = 0;
+  // The registered consumers, keyed by consumer id.
+  absl::flat_hash_map<int64, Consumer> consumers_ TF_GUARDED_BY(mu_);
+  int64 next_consumer_id_ TF_GUARDED_BY(mu_) = 0;
+  // Whether a consumer is currently producing the next element.
+  bool producing_ TF_GUARDED_BY(mu_) = false;
+  bool end_of_sequence_ TF_GUARDED_BY(mu_) = false;
+  // The error returned by `produce_`, if any.
+  Status status_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_SHARED_EPOCH_CACHE_H_
@@ -0,0 +1,217 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/shared_epoch_cache.h"
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+
+namespace {
+// A stall timeout that no consumer reaches during a test.
+constexpr int64 kNoStall = 3600ll * 1000 * 1000;
+
+// Returns a producer of `num_elements` elements whose data is their index,
+// counting the elements it produces in `num_produced`.
+SharedEpochCache::ProduceFn RangeProducer(int64 num_elements,
+                                          int64* num_produced) {
+  return [num_elements, num_produced](CompressedElement& element,
+                                      bool& end_of_sequence) {
+    if (*num_produced >= num_elements) {
+      end_of_sequence = true;
+      return Status::OK();
+    }
+    element.set_data(absl::StrCat((*num_produced)++));
+    end_of_sequence = false;
+    return Status::OK();
+  };
+}
+
+// Registers a new consumer of `cache` and returns its id.
+int64 Register(SharedEpochCache& cache) {
+  int64 consumer_id;
+  TF_CHECK_OK(cache.RegisterConsumer(consumer_id));
+  return consumer_id;
+}
+
+// Reads the next element for `consumer_id`, returning its data or "eos".
+std::string Next(SharedEpochCache& cache, int64 consumer_id) {
+  CompressedElement element;
+  bool end_of_sequence;
+  TF_CHECK_OK(cache.GetNext(consumer_id, element, end_of_sequence));
+  return end_of_sequence ? "eos" : element.data();
+}
+}  // namespace
+
+TEST(SharedEpochCache, SingleConsumer) {
+  int64 num_produced = 0;
+  SharedEpochCache cache(/*window_size=*/2, kNoStall,
+                         RangeProducer(5, &num_produced));
+  int64 consumer = Register(cache);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(Next(cache, consumer), absl::StrCat(i));
+  }
+  EXPECT_FALSE(cache.finished());
+  EXPECT_EQ(Next(cache, consumer), "eos");
+  EXPECT_TRUE(cache.finished());
+}
+
+TEST(SharedEpochCache, ConsumersShareElements) {
+  int64 num_produced = 0;
+  SharedEpochCache cache(/*window_size=*/2, kNoStall,
+                         RangeProducer(5, &num_produced));
+  int64 consumer1 = Register(cache);
+  int64 consumer2 = Register(cache);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(Next(cache, consumer1), absl::StrCat(i));
+    EXPECT_EQ(Next(cache, consumer2), absl::StrCat(i));
+  }
+  EXPECT_EQ(Next(cache, consumer1), "eos");
+  EXPECT_EQ(Next(cache, consumer2), "eos");
+  EXPECT_EQ(num_produced, 5);
+}
+
+TEST(SharedEpochCache, LateConsumerReadsWholeEpoch) {
+  int64 num_produced = 0;
+  SharedEpochCache cache(/*window_size=*/4, kNoStall,
+                         RangeProducer(10, &num_produced));
+  int64 consumer1 = Register(cache);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(Next(cache, consumer1), absl::StrCat(i));
+  }
+  // The window still holds the first element, so a late consumer can join.
+  int64 consumer2 = Register(cache);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(Next(cache, consumer2), absl::StrCat(i));
+    if (i + 3 < 10) {
+      EXPECT_EQ(Next(cache, consumer1), absl::StrCat(i + 3));
+    }
+  }
+  EXPECT_EQ(Next(cache, consumer1), "eos");
+  EXPECT_EQ(Next(cache, consumer2), "eos");
+  EXPECT_EQ(num_produced, 10);
+}
+
+TEST(SharedEpochCache, CannotJoinAdvancedWindow) {
+  int64 num_produced = 0;
+  SharedEpochCache cache(/*window_size=*/2, kNoStall,
+                         RangeProducer(10, &num_produced));
+  int64 consumer = Register(cache);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(Next(cache, consumer), absl::StrCat(i));
+  }
+  // Elements 0 to 2 have been evicted.
+  int64 late_consumer;
+  EXPECT_TRUE(errors::IsFailedPrecondition(
+      cache.RegisterConsumer(late_consumer)));
+}
+
+TEST(SharedEpochCache, CannotJoinFinishedEpoch) {
+  int64 num_produced = 0;
+  SharedEpochCache cache(/*window_size=*/4, kNoStall,
+                         RangeProducer(2, &num_produced));
+  int64 consumer = Register(cache);
+  EXPECT_EQ(Next(cache, consumer), "0");
+  EXPECT_EQ(Next(cache, consumer), "1");
+  EXPECT_EQ(Next(cache, consumer), "eos");
+  int64 late_consumer;
+  EXPECT_TRUE(errors::IsFailedPrecondition(
+      cache.RegisterConsumer(late_consumer)));
+}
+
+TEST(SharedEpochCache, UnregisterReleasesWindow) {
+  int64 num_produced = 0;
+  SharedEpochCache cache(/*window_size=*/2, kNoStall,
+                         RangeProducer(5, &num_produced));
+  int64 consumer1 = Register(cache);
+  int64 consumer2 = Register(cache);
+  EXPECT_EQ(Next(cache, consumer1), "0");
+  EXPECT_EQ(Next(cache, consumer1), "1");
+  // `consumer1` is now a full window ahead of `consumer2`, and reading further
+  // would block until `consumer2` reads or leaves.
+  cache.UnregisterConsumer(consumer2);
+  EXPECT_EQ(Next(cache, consumer1), "2");
+  CompressedElement element;
+  bool end_of_sequence;
+  EXPECT_TRUE(errors::IsNotFound(
+      cache.GetNext(consumer2, element, end_of_sequence)));
+}
+
+TEST(SharedEpochCache, ProducerError) {
+  SharedEpochCache cache(
+      /*window_size=*/2, kNoStall,
+      [](CompressedElement& element, bool& end_of_sequence) {
+        return errors::DataLoss("Failed to produce");
+      });
+  int64 consumer1 = Register(cache);
+  int64 consumer2 = Register(cache);
+  CompressedElement element;
+  bool end_of_sequence;
+  EXPECT_TRUE(
+      errors::IsDataLoss(cache.GetNext(consumer1, element, end_of_sequence)));
+  EXPECT_TRUE(
+      errors::IsDataLoss(cache.GetNext(consumer2, element, end_of_sequence)));
+  EXPECT_TRUE(cache.finished());
+}
+
+TEST(SharedEpochCache, StalledConsumerDoesNotBlockOthers) {
+  int64 num_produced = 0;
+  SharedEpochCache cache(/*window_size=*/2, /*stall_timeout_us=*/10 * 1000,
+                         RangeProducer(10, &num_produced));
+  int64 consumer1 = Register(cache);
+  int64 consumer2 = Register(cache);
+  EXPECT_EQ(Next(cache, consumer2), "0");
+  // `consumer2` stops reading. `consumer1` blocks once it is a full window
+  // ahead, until `consumer2` stalls.
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(Next(cache, consumer1), absl::StrCat(i));
+  }
+  EXPECT_EQ(Next(cache, consumer1), "eos");
+  // When `consumer2` resumes, the elements it has not read are gone. It fails
+  // rather than skipping them, and keeps failing.
+  CompressedElement element;
+  bool end_of_sequence;
+  EXPECT_TRUE(
+      errors::IsDataLoss(cache.GetNext(consumer2, element, end_of_sequence)));
+  EXPECT_TRUE(
+      errors::IsDataLoss(cache.GetNext(consumer2, element, end_of_sequence)));
+  EXPECT_EQ(num_produced, 10);
+}
+
+TEST(SharedEpochCache, StalledConsumerResumesBeforeEviction) {
+  int64 num_produced = 0;
+  SharedEpochCache cache(/*window_size=*/4, /*stall_timeout_us=*/10 * 1000,
+                         RangeProducer(3, &num_produced));
+  int64 consumer1 = Register(cache);
+  int64 consumer2 = Register(cache);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(Next(cache, consumer1), absl::StrCat(i));
+  }
+  EXPECT_EQ(Next(cache, consumer1), "eos");
+  // `consumer2` stalls, but the window never filled up, so nothing it needs
+  // was evicted.
+  Env::Default()->SleepForMicroseconds(20 * 1000);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(Next(cache, consumer2), absl::StrCat(i));
+  }
+  EXPECT_EQ(Next(cache, consumer2), "eos");
+}
+
+}  // namespace data
+}  // namespace tensorflow
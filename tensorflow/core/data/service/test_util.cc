@@ -15,7 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/test_util.h"
 
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/path.h"
 
@@ -53,6 +59,213 @@ Status map_test_case(GraphDefTestCase* test_case) {
   return Status::OK();
 }
 
+Status range_compressed_test_case(int64 num_elements,
+                                  GraphDefTestCase* test_case) {
+  using test::function::NDef;
+  FunctionDef compress = FunctionDefHelper::Create(
+      "Compress", {"x: int64"}, {"y: variant"}, {},
+      {{{"compressed"},
+        "CompressElement",
+        {"x"},
+        {{"input_types", DataTypeVector{DT_INT64}}}}},
+      {{"y", "compressed:compressed:0"}});
+  std::vector<TensorShape> scalar_shapes = {TensorShape({})};
+  GraphDef graph_def = test::function::GDef(
+      {NDef("start", "Const", {},
+            {{"dtype", DT_INT64}, {"value", Tensor(int64{0})}}),
+       NDef("stop", "Const", {},
+            {{"dtype", DT_INT64}, {"value", Tensor(num_elements)}}),
+       NDef("step", "Const", {},
+            {{"dtype", DT_INT64}, {"value", Tensor(int64{1})}}),
+       NDef("range", "RangeDataset", {"start", "stop", "step"},
+            {{"output_types", DataTypeVector{DT_INT64}},
+             {"output_shapes", scalar_shapes}}),
+       NDef("map", "MapDataset", {"range"},
+            {{"f", FunctionDefHelper::FunctionRef("Compress")},
+             {"Targuments", DataTypeVector{}},
+             {"output_types", DataTypeVector{DT_VARIANT}},
+             {"output_shapes", scalar_shapes}}),
+       NDef("dataset", "_Retval", {"map"},
+            {{"T", DT_VARIANT}, {"index", 0}})},
+      {compress});
+  std::vector<std::vector<Tensor>> outputs(num_elements);
+  for (int64 i = 0; i < num_elements; ++i) {
+    outputs[i] = CreateTensors<int64>(TensorShape{}, {{i}});
+  }
+  *test_case = {"RangeCompressedGraph", graph_def, outputs};
+  return Status::OK();
+}
+
+Status zip_compressed_test_case(int64 num_elements,
+                                GraphDefTestCase* test_case) {
+  using test::function::NDef;
+  FunctionDef compress = FunctionDefHelper::Create(
+      "Compress", {"x: int64", "y: int64"}, {"z: variant"}, {},
+      {{{"compressed"},
+        "CompressElement",
+        {"x", "y"},
+        {{"input_types", DataTypeVector{DT_INT64, DT_INT64}}}}},
+      {{"z", "compressed:compressed:0"}});
+  std::vector<TensorShape> scalar_shapes = {TensorShape({})};
+  std::vector<TensorShape> pair_shapes = {TensorShape({}), TensorShape({})};
+  const int64 value = 42;
+  GraphDef graph_def = test::function::GDef(
+      {NDef("start", "Const", {},
+            {{"dtype", DT_INT64}, {"value", Tensor(int64{0})}}),
+       NDef("stop", "Const", {},
+            {{"dtype", DT_INT64}, {"value", Tensor(num_elements)}}),
+       NDef("step", "Const", {},
+            {{"dtype", DT_INT64}, {"value", Tensor(int64{1})}}),
+       NDef("range", "RangeDataset", {"start", "stop", "step"},
+            {{"output_types", DataTypeVector{DT_INT64}},
+             {"output_shapes", scalar_shapes}}),
+       NDef("value", "Const", {},
+            {{"dtype", DT_INT64}, {"value", Tensor(value)}}),
+       NDef("tensor", "TensorDataset", {"value"},
+            {{"Toutput_types", DataTypeVector{DT_INT64}},
+             {"output_shapes", scalar_shapes}}),
+       NDef("count", "Const", {},
+            {{"dtype", DT_INT64}, {"value", Tensor(int64{-1})}}),
+       NDef("repeat", "RepeatDataset", {"tensor", "count"},
+            {{"output_types", DataTypeVector{DT_INT64}},
+             {"output_shapes", scalar_shapes}}),
+       NDef("zip", "ZipDataset", {"range", "repeat"},
+            {{"output_types", DataTypeVector{DT_INT64, DT_INT64}},
+             {"output_shapes", pair_shapes},
+             {"N", 2}}),
+       NDef("map", "MapDataset", {"zip"},
+            {{"f", FunctionDefHelper::FunctionRef("Compress")},
+             {"Targuments", DataTypeVector{}},
+             {"output_types", DataTypeVector{DT_VARIANT}},
+             {"output_shapes", scalar_shapes}}),
+       NDef("dataset", "_Retval", {"map"},
+            {{"T", DT_VARIANT}, {"index", 0}})},
+      {compress});
+  std::vector<std::vector<Tensor>> outputs(num_elements);
+  for (int64 i = 0; i < num_elements; ++i) {
+    outputs[i] = CreateTensors<int64>(TensorShape{}, {{i}, {value}});
+  }
+  *test_case = {"ZipCompressedGraph", graph_def, outputs};
+  return Status::OK();
+}
+
+namespace {
+// Writes `num_files` TFRecord files with `records_per_file` records each to
+// `dir`, storing their names in `filenames` and their records as scalar string
+// elements in `outputs`.
+Status WriteTFRecordFiles(const std::string& dir, int64 num_files,
+                          int64 records_per_file,
+                          std::vector<tstring>& filenames,
+                          std::vector<std::vector<Tensor>>& outputs) {
+  for (int64 i = 0; i < num_files; ++i) {
+    std::string filename = io::JoinPath(dir, absl::StrCat("file_", i));
+    std::unique_ptr<WritableFile> file;
+    TF_RETURN_IF_ERROR(Env::Default()->NewWritableFile(filename, &file));
+    io::RecordWriter writer(file.get());
+    for (int64 j = 0; j < records_per_file; ++j) {
+      tstring record = absl::StrCat("file_", i, "_record_", j);
+      TF_RETURN_IF_ERROR(writer.WriteRecord(record));
+      outputs.push_back(CreateTensors<tstring>(TensorShape{}, {{record}}));
+    }
+    TF_RETURN_IF_ERROR(writer.Close());
+    TF_RETURN_IF_ERROR(file->Close());
+    filenames.push_back(filename);
+  }
+  return Status::OK();
+}
+
+FunctionDef CompressString() {
+  return FunctionDefHelper::Create(
+      "Compress", {"x: string"}, {"y: variant"}, {},
+      {{{"compressed"},
+        "CompressElement",
+        {"x"},
+        {{"input_types", DataTypeVector{DT_STRING}}}}},
+      {{"y", "compressed:compressed:0"}});
+}
+}  // namespace
+
+Status tf_record_compressed_test_case(const std::string& dir, int64 num_files,
+                                      int64 records_per_file,
+                                      GraphDefTestCase* test_case) {
+  using test::function::NDef;
+  std::vector<tstring> filenames;
+  std::vector<std::vector<Tensor>> outputs;
+  TF_RETURN_IF_ERROR(
+      WriteTFRecordFiles(dir, num_files, records_per_file, filenames, outputs));
+
+  FunctionDef read_file = FunctionDefHelper::Create(
+      "ReadFile", {"filename: string"}, {"dataset: variant"}, {},
+      {{{"compression_type"},
+        "Const",
+        {},
+        {{"dtype", DT_STRING}, {"value", Tensor(tstring(""))}}},
+       {{"buffer_size"},
+        "Const",
+        {},
+        {{"dtype", DT_INT64}, {"value", Tensor(int64{0})}}},
+       {{"reader"},
+        "TFRecordDataset",
+        {"filename", "compression_type:output:0", "buffer_size:output:0"},
+        {}}},
+      {{"dataset", "reader:handle:0"}});
+  std::vector<TensorShape> scalar_shapes = {TensorShape({})};
+  GraphDef graph_def = test::function::GDef(
+      {NDef("filenames", "Const", {},
+            {{"dtype", DT_STRING},
+             {"value", test::AsTensor<tstring>(filenames, {num_files})}}),
+       NDef("files", "TensorSliceDataset", {"filenames"},
+            {{"Toutput_types", DataTypeVector{DT_STRING}},
+             {"output_shapes", scalar_shapes}}),
+       NDef("records", "FlatMapDataset", {"files"},
+            {{"f", FunctionDefHelper::FunctionRef("ReadFile")},
+             {"Targuments", DataTypeVector{}},
+             {"output_types", DataTypeVector{DT_STRING}},
+             {"output_shapes", scalar_shapes}}),
+       NDef("map", "MapDataset", {"records"},
+            {{"f", FunctionDefHelper::FunctionRef("Compress")},
+             {"Targuments", DataTypeVector{}},
+             {"output_types", DataTypeVector{DT_VARIANT}},
+             {"output_shapes", scalar_shapes}}),
+       NDef("dataset", "_Retval", {"map"},
+            {{"T", DT_VARIANT}, {"index", 0}})},
+      {read_file, CompressString()});
+  *test_case = {"TFRecordCompressedGraph", graph_def, outputs};
+  return Status::OK();
+}
+
+Status tf_record_reader_compressed_test_case(const std::string& dir,
+                                             int64 num_files,
+                                             int64 records_per_file,
+                                             GraphDefTestCase* test_case) {
+  using test::function::NDef;
+  std::vector<tstring> filenames;
+  std::vector<std::vector<Tensor>> outputs;
+  TF_RETURN_IF_ERROR(
+      WriteTFRecordFiles(dir, num_files, records_per_file, filenames, outputs));
+  std::vector<TensorShape> scalar_shapes = {TensorShape({})};
+  GraphDef graph_def = test::function::GDef(
+      {NDef("filenames", "Const", {},
+            {{"dtype", DT_STRING},
+             {"value", test::AsTensor<tstring>(filenames, {num_files})}}),
+       NDef("compression_type", "Const", {},
+            {{"dtype", DT_STRING}, {"value", Tensor(tstring(""))}}),
+       NDef("buffer_size", "Const", {},
+            {{"dtype", DT_INT64}, {"value", Tensor(int64{0})}}),
+       NDef("records", "TFRecordDataset",
+            {"filenames", "compression_type", "buffer_size"}, {}),
+       NDef("map", "MapDataset", {"records"},
+            {{"f", FunctionDefHelper::FunctionRef("Compress")},
+             {"Targuments", DataTypeVector{}},
+             {"output_types", DataTypeVector{DT_VARIANT}},
+             {"output_shapes", scalar_shapes}}),
+       NDef("dataset", "_Retval", {"map"},
+            {{"T", DT_VARIANT}, {"index", 0}})},
+      {CompressString()});
+  *test_case = {"TFRecordReaderCompressedGraph", graph_def, outputs};
+  return Status::OK();
+}
+
 }  // namespace test_util
 }  // namespace data
 }  // namespace tensorflow
@@ -37,6 +37,39 @@ struct GraphDefTestCase {
 // dataset graph execution.
 Status map_test_case(GraphDefTestCase* test_case);
 
+// Fills in the input test_case pointer with test case data representing the
+// dataset tf.data.Dataset.range(num_elements), with each element compressed
+// into a scalar `CompressedElement` variant, as the tf.data service expects of
+// the datasets that it distributes. The expected output holds the elements
+// before compression.
+Status range_compressed_test_case(int64 num_elements,
+                                  GraphDefTestCase* test_case);
+
+// Fills in the input test_case pointer with test case data representing
+// `Dataset.range(num_elements)` zipped with a repeated constant scalar, which
+// has two source datasets. Each (int64, int64) element is compressed into a
+// scalar `CompressedElement` variant. The expected output holds the elements
+// before compression.
+Status zip_compressed_test_case(int64 num_elements,
+                                GraphDefTestCase* test_case);
+
+// Fills in the input test_case pointer with test case data representing a
+// dataset that reads `num_files` TFRecord files, written to `dir` by this
+// function, by flat-mapping a TFRecordDataset over a dataset of their names.
+// Each file holds `records_per_file` records, and each element is compressed
+// into a scalar `CompressedElement` variant. The expected output holds the
+// records before compression.
+Status tf_record_compressed_test_case(const std::string& dir, int64 num_files,
+                                      int64 records_per_file,
+                                      GraphDefTestCase* test_case);
+
+// Like `tf_record_compressed_test_case`, but reads the files with a single
+// TFRecordDataset over their constant list of names.
+Status tf_record_reader_compressed_test_case(const std::string& dir,
+                                             int64 num_files,
+                                             int64 records_per_file,
+                                             GraphDefTestCase* test_case);
+
 }  // namespace test_util
 }  // namespace data
 }  // namespace tensorflow
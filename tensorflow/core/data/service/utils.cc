@@ -15,7 +15,21 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/utils.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/data/service/common.pb.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
@@ -25,6 +39,270 @@ limitations under the License.
 namespace tensorflow {
 namespace data {
 
+namespace {
+constexpr char kRetvalOp[] = "_Retval";
+constexpr char kConstOp[] = "Const";
+constexpr char kRangeDatasetOp[] = "RangeDataset";
+constexpr char kTensorSliceDatasetOp[] = "TensorSliceDataset";
+constexpr char kShardDatasetOp[] = "ShardDataset";
+constexpr char kTakeDatasetOp[] = "TakeDataset";
+constexpr char kSkipDatasetOp[] = "SkipDataset";
+constexpr char kReduceDatasetOp[] = "ReduceDataset";
+constexpr char kTFRecordDatasetOp[] = "TFRecordDataset";
+constexpr char kTextLineDatasetOp[] = "TextLineDataset";
+constexpr char kFixedLengthRecordDatasetOp[] = "FixedLengthRecordDataset";
+constexpr char kFixedLengthRecordDatasetV2Op[] = "FixedLengthRecordDatasetV2";
+constexpr char kNumSplitsNode[] = "tf_data_service_split/num_splits";
+constexpr char kSplitIndexNode[] = "tf_data_service_split/split_index";
+constexpr char kShardNode[] = "tf_data_service_split/ShardDataset";
+constexpr char kFilenamesNode[] = "tf_data_service_split/filenames";
+constexpr char kOutputTypes[] = "output_types";
+constexpr char kOutputShapes[] = "output_shapes";
+constexpr char kToutputTypes[] = "Toutput_types";
+constexpr char kRequireNonEmpty[] = "require_non_empty";
+
+using NodeMap = absl::flat_hash_map<absl::string_view, const NodeDef*>;
+
+void AddInt64Const(const std::string& name, int64 value, GraphDef& graph) {
+  NodeDef* node = graph.add_node();
+  node->set_name(name);
+  node->set_op(kConstOp);
+  (*node->mutable_attr())["dtype"].set_type(DT_INT64);
+  TensorProto* tensor = (*node->mutable_attr())["value"].mutable_tensor();
+  tensor->set_dtype(DT_INT64);
+  tensor->mutable_tensor_shape();
+  tensor->add_int64_val(value);
+}
+
+bool IsControlInput(absl::string_view input) {
+  return absl::StartsWith(input, "^");
+}
+
+// Returns the name of the node that produces `input`.
+absl::string_view InputNodeName(absl::string_view input) {
+  return input.substr(0, input.find(':'));
+}
+
+// Returns whether `op` produces a dataset, e.g. "MapDataset" or
+// "ParallelInterleaveDatasetV4".
+bool IsDatasetOp(absl::string_view op) {
+  size_t version = op.rfind('V');
+  if (version != absl::string_view::npos && version + 1 < op.size() &&
+      std::all_of(op.begin() + version + 1, op.end(), absl::ascii_isdigit)) {
+    op = op.substr(0, version);
+  }
+  // ReduceDataset consumes a dataset, but produces tensors.
+  return absl::EndsWith(op, "Dataset") && op != kReduceDatasetOp;
+}
+
+// Returns whether `op` reads the files named by its first input.
+bool IsFileReaderOp(absl::string_view op) {
+  return op == kTFRecordDatasetOp || op == kTextLineDatasetOp ||
+         op == kFixedLengthRecordDatasetOp ||
+         op == kFixedLengthRecordDatasetV2Op;
+}
+
+// Returns whether the output of `op` depends on the positions of its input
+// elements, so that splitting its input changes which elements it produces.
+bool IsPositionDependentOp(absl::string_view op) {
+  return op == kTakeDatasetOp || op == kSkipDatasetOp ||
+         op == kShardDatasetOp;
+}
+
+// Finds the `_Retval` node of `graph` and the dataset node that it returns.
+Status FindOutputDataset(const GraphDef& graph, const NodeMap& nodes,
+                         const NodeDef*& dataset_node) {
+  const NodeDef* retval = nullptr;
+  for (const NodeDef& node : graph.node()) {
+    if (node.op() == kRetvalOp) {
+      retval = &node;
+    }
+  }
+  if (retval == nullptr || retval->input_size() < 1) {
+    return errors::NotFound("Failed to find a _Retval op in the given dataset");
+  }
+  auto it = nodes.find(InputNodeName(retval->input(0)));
+  if (it == nodes.end() || !IsDatasetOp(it->second->op())) {
+    return errors::InvalidArgument(
+        "Failed to find the dataset node returned by ", retval->name());
+  }
+  dataset_node = it->second;
+  return Status::OK();
+}
+
+// Adds the source datasets of `node` to `sources`, i.e. the datasets in its
+// input pipeline that have no dataset inputs.
+void FindSourceDatasets(const NodeMap& nodes, const NodeDef& node,
+                        absl::flat_hash_set<const NodeDef*>& visited,
+                        std::vector<const NodeDef*>& sources) {
+  if (!visited.insert(&node).second) {
+    return;
+  }
+  bool has_dataset_input = false;
+  for (const std::string& input : node.input()) {
+    if (IsControlInput(input)) {
+      continue;
+    }
+    auto it = nodes.find(InputNodeName(input));
+    if (it == nodes.end() || !IsDatasetOp(it->second->op())) {
+      continue;
+    }
+    has_dataset_input = true;
+    FindSourceDatasets(nodes, *it->second, visited, sources);
+  }
+  if (!has_dataset_input) {
+    sources.push_back(&node);
+  }
+}
+
+NodeMap BuildNodeMap(const GraphDef& graph) {
+  NodeMap nodes;
+  for (const NodeDef& node : graph.node()) {
+    nodes[node.name()] = &node;
+  }
+  return nodes;
+}
+
+// Returns the value of the tensor constant that produces `input`, or nullptr
+// if `input` is not produced by a constant.
+const TensorProto* GetConstTensor(const NodeMap& nodes,
+                                  absl::string_view input) {
+  auto it = nodes.find(InputNodeName(input));
+  if (it == nodes.end() || it->second->op() != kConstOp) {
+    return nullptr;
+  }
+  auto value = it->second->attr().find("value");
+  if (value == it->second->attr().end() || !value->second.has_tensor()) {
+    return nullptr;
+  }
+  return &value->second.tensor();
+}
+
+bool GetInt64ScalarConst(const NodeMap& nodes, absl::string_view input,
+                         int64& value) {
+  const TensorProto* tensor = GetConstTensor(nodes, input);
+  if (tensor == nullptr || tensor->dtype() != DT_INT64 ||
+      tensor->tensor_shape().dim_size() != 0) {
+    return false;
+  }
+  if (tensor->int64_val_size() == 1) {
+    value = tensor->int64_val(0);
+    return true;
+  }
+  if (tensor->tensor_content().size() == sizeof(int64)) {
+    memcpy(&value, tensor->tensor_content().data(), sizeof(int64));
+    return true;
+  }
+  return false;
+}
+
+// Returns the number of elements of the source dataset `node` if it can be
+// computed from constant inputs, and -1 otherwise.
+int64 StaticCardinality(const NodeMap& nodes, const NodeDef& node) {
+  if (node.op() == kRangeDatasetOp && node.input_size() >= 3) {
+    int64 start, stop, step;
+    if (!GetInt64ScalarConst(nodes, node.input(0), start) ||
+        !GetInt64ScalarConst(nodes, node.input(1), stop) ||
+        !GetInt64ScalarConst(nodes, node.input(2), step) || step == 0) {
+      return -1;
+    }
+    if (step > 0) {
+      return stop > start ? (stop - start - 1) / step + 1 : 0;
+    }
+    return start > stop ? (start - stop - 1) / -step + 1 : 0;
+  }
+  if (node.op() == kTensorSliceDatasetOp && node.input_size() >= 1) {
+    const TensorProto* tensor = GetConstTensor(nodes, node.input(0));
+    if (tensor != nullptr && tensor->tensor_shape().dim_size() > 0 &&
+        !tensor->tensor_shape().unknown_rank()) {
+      return std::max<int64>(tensor->tensor_shape().dim(0).size(), -1);
+    }
+  }
+  return -1;
+}
+
+// Stores the file names read by the reader dataset `node` in `filenames`.
+// Returns false if they are not a constant scalar or vector.
+bool GetFilenamesConst(const NodeMap& nodes, const NodeDef& node,
+                       std::vector<tstring>& filenames) {
+  if (node.input_size() < 1) {
+    return false;
+  }
+  const TensorProto* proto = GetConstTensor(nodes, node.input(0));
+  Tensor tensor;
+  if (proto == nullptr || proto->dtype() != DT_STRING ||
+      !tensor.FromProto(*proto) || tensor.dims() > 1) {
+    return false;
+  }
+  auto flat = tensor.flat<tstring>();
+  filenames.assign(flat.data(), flat.data() + flat.size());
+  return true;
+}
+
+// Finds the dataset of `graph` that `ShardDatasetGraph` splits. This is the
+// only source dataset of the graph, i.e. the only dataset without dataset
+// inputs, and it must be a range or a slice of tensors, or read a constant
+// list of files. Returns FAILED_PRECONDITION if there is no such dataset, or
+// if the pipeline contains datasets whose output would change when their
+// input is split.
+Status FindSplitSource(const GraphDef& graph, const NodeMap& nodes,
+                       const NodeDef*& source) {
+  const NodeDef* dataset_node;
+  TF_RETURN_IF_ERROR(FindOutputDataset(graph, nodes, dataset_node));
+  absl::flat_hash_set<const NodeDef*> visited;
+  std::vector<const NodeDef*> sources;
+  FindSourceDatasets(nodes, *dataset_node, visited, sources);
+  if (sources.size() != 1) {
+    // Splitting one source, e.g. one input of a ZipDataset, would drop the
+    // elements of the other sources that it is combined with.
+    return errors::FailedPrecondition("The dataset has ", sources.size(),
+                                      " source datasets, and only datasets "
+                                      "with a single source can be split");
+  }
+  for (const NodeDef* node : visited) {
+    if (IsPositionDependentOp(node->op())) {
+      return errors::FailedPrecondition(
+          "The dataset cannot be split because its output depends on the "
+          "positions of the input elements of ",
+          node->name(), " (", node->op(), ")");
+    }
+  }
+  source = sources[0];
+  if (source->op() == kRangeDatasetOp ||
+      source->op() == kTensorSliceDatasetOp) {
+    return Status::OK();
+  }
+  if (IsFileReaderOp(source->op())) {
+    std::vector<tstring> filenames;
+    if (!GetFilenamesConst(nodes, *source, filenames)) {
+      return errors::FailedPrecondition(
+          "The file names read by ", source->name(), " (", source->op(),
+          ") are not a constant, so its files cannot be split");
+    }
+    return Status::OK();
+  }
+  return errors::FailedPrecondition("The source dataset ", source->name(),
+                                    " (", source->op(),
+                                    ") cannot be split");
+}
+
+// Sets the output types and shapes of `shard`, which shards the output of the
+// range or tensor slice dataset `source`.
+void SetOutputSignature(const NodeDef& source, NodeDef& shard) {
+  auto& attr = *shard.mutable_attr();
+  for (const char* types : {kOutputTypes, kToutputTypes}) {
+    auto it = source.attr().find(types);
+    if (it != source.attr().end()) {
+      attr[kOutputTypes] = it->second;
+    }
+  }
+  auto it = source.attr().find(kOutputShapes);
+  if (it != source.attr().end()) {
+    attr[kOutputShapes] = it->second;
+  }
+}
+}  // namespace
+
 Status WriteDatasetDef(const std::string& path, const DatasetDef& dataset_def) {
   std::unique_ptr<WritableFile> file;
   TF_RETURN_IF_ERROR(Env::Default()->NewWritableFile(path, &file));
@@ -50,5 +328,88 @@ Status ReadDatasetDef(const std::string& path, DatasetDef& dataset_def) {
   return Status::OK();
 }
 
+Status ShardDatasetGraph(const GraphDef& graph, int64 num_splits,
+                         int64 split_index, GraphDef& split_graph) {
+  if (split_index < 0 || split_index >= num_splits) {
+    return errors::InvalidArgument("Split index ", split_index,
+                                   " is out of range for ", num_splits,
+                                   " splits");
+  }
+  if (num_splits == 1) {
+    split_graph = graph;
+    return Status::OK();
+  }
+  NodeMap nodes = BuildNodeMap(graph);
+  const NodeDef* source;
+  TF_RETURN_IF_ERROR(FindSplitSource(graph, nodes, source));
+  const std::string source_name = source->name();
+
+  if (IsFileReaderOp(source->op())) {
+    // Reads the range of files [begin, end) instead of all files.
+    std::vector<tstring> filenames;
+    GetFilenamesConst(nodes, *source, filenames);
+    const int64 num_files = filenames.size();
+    const int64 begin = split_index * num_files / num_splits;
+    const int64 end = (split_index + 1) * num_files / num_splits;
+    Tensor split_filenames_value(DT_STRING, TensorShape({end - begin}));
+    std::copy(filenames.begin() + begin, filenames.begin() + end,
+              split_filenames_value.vec<tstring>().data());
+    NodeDef split_filenames;
+    split_filenames.set_name(kFilenamesNode);
+    split_filenames.set_op(kConstOp);
+    (*split_filenames.mutable_attr())["dtype"].set_type(DT_STRING);
+    split_filenames_value.AsProtoField(
+        (*split_filenames.mutable_attr())["value"].mutable_tensor());
+    split_graph = graph;
+    for (NodeDef& node : *split_graph.mutable_node()) {
+      if (node.name() == source_name) {
+        node.set_input(0, kFilenamesNode);
+      }
+    }
+    *split_graph.add_node() = std::move(split_filenames);
+    return Status::OK();
+  }
+
+  // Keeps the elements of the source with index `split_index` modulo
+  // `num_splits`.
+  NodeDef shard;
+  shard.set_name(kShardNode);
+  shard.set_op(kShardDatasetOp);
+  shard.add_input(source_name);
+  shard.add_input(kNumSplitsNode);
+  shard.add_input(kSplitIndexNode);
+  // Splits may be empty, e.g. when there are fewer elements than splits.
+  (*shard.mutable_attr())[kRequireNonEmpty].set_b(false);
+  SetOutputSignature(*source, shard);
+
+  split_graph = graph;
+  for (NodeDef& node : *split_graph.mutable_node()) {
+    for (int i = 0; i < node.input_size(); ++i) {
+      if (!IsControlInput(node.input(i)) &&
+          InputNodeName(node.input(i)) == source_name) {
+        node.set_input(i, kShardNode);
+      }
+    }
+  }
+  AddInt64Const(kNumSplitsNode, num_splits, split_graph);
+  AddInt64Const(kSplitIndexNode, split_index, split_graph);
+  *split_graph.add_node() = std::move(shard);
+  return Status::OK();
+}
+
+Status MaxNumSplits(const GraphDef& graph, int64& max_num_splits) {
+  NodeMap nodes = BuildNodeMap(graph);
+  const NodeDef* source;
+  TF_RETURN_IF_ERROR(FindSplitSource(graph, nodes, source));
+  if (IsFileReaderOp(source->op())) {
+    std::vector<tstring> filenames;
+    GetFilenamesConst(nodes, *source, filenames);
+    max_num_splits = filenames.size();
+  } else {
+    max_num_splits = StaticCardinality(nodes, *source);
+  }
+  return Status::OK();
+}
+
 }  // namespace data
 }  // namespace tensorflow
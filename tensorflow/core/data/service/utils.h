@@ -16,6 +16,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DATA_SERVICE_UTILS_H_
 
 #include "tensorflow/core/data/service/common.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/platform/env.h"
@@ -32,6 +33,30 @@ Status WriteDatasetDef(const std::string& path, const DatasetDef& dataset_def);
 // `dataset_def`. Returns NOT_FOUND if the path cannot be found.
 Status ReadDatasetDef(const std::string& path, DatasetDef& dataset_def);
 
+// Rewrites the dataset graph `graph` so that it only produces split
+// `split_index` out of `num_splits`, and stores the result in `split_graph`.
+//
+// The graph is split at its only source dataset, i.e. the only dataset without
+// dataset inputs, so the rest of the pipeline only processes the source
+// elements of the split:
+// - A reader dataset such as `TFRecordDataset` with a constant list of file
+//   names reads a contiguous range of the files.
+// - A range or tensor slice dataset, e.g. the list of file names that an
+//   interleave reads from, is followed by a `ShardDataset` that keeps the
+//   elements with index `split_index` modulo `num_splits`.
+// Splits may be empty. A single split is the unchanged graph. Returns
+// FAILED_PRECONDITION if the graph cannot be split into several splits, e.g.
+// because it zips several sources, or takes or skips elements of its source.
+Status ShardDatasetGraph(const GraphDef& graph, int64 num_splits,
+                         int64 split_index, GraphDef& split_graph);
+
+// Computes the largest number of non-empty splits that `ShardDatasetGraph` can
+// divide `graph` into: the number of files or elements of its source, or -1 if
+// this cannot be determined without running the graph, e.g. when the source
+// lists files with `list_files`. Returns FAILED_PRECONDITION if the graph
+// cannot be split, in which case it must be processed as a single split.
+Status MaxNumSplits(const GraphDef& graph, int64& max_num_splits);
+
 }  // namespace data
 }  // namespace tensorflow
 
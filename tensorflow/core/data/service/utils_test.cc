@@ -14,8 +14,14 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/service/utils.h"
 
+#include "tensorflow/core/data/compression_utils.h"
 #include "tensorflow/core/data/service/common.pb.h"
+#include "tensorflow/core/data/service/test_util.h"
+#include "tensorflow/core/data/standalone.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/path.h"
@@ -31,6 +37,29 @@ DatasetDef DatasetDefWithVersion(int32 version) {
   def.mutable_graph()->set_version(version);
   return def;
 }
+
+// Produces all elements of split `split_index` of the dataset `graph`.
+Status ReadSplit(const GraphDef& graph, int64 num_splits, int64 split_index,
+                 std::vector<std::vector<Tensor>>& elements) {
+  GraphDef split_graph;
+  TF_RETURN_IF_ERROR(
+      ShardDatasetGraph(graph, num_splits, split_index, split_graph));
+  standalone::Dataset::Params params;
+  std::unique_ptr<standalone::Dataset> dataset;
+  TF_RETURN_IF_ERROR(
+      standalone::Dataset::FromGraph(params, split_graph, &dataset));
+  std::unique_ptr<standalone::Iterator> iterator;
+  TF_RETURN_IF_ERROR(dataset->MakeIterator(&iterator));
+  while (true) {
+    std::vector<Tensor> outputs;
+    bool end_of_input;
+    TF_RETURN_IF_ERROR(iterator->GetNext(&outputs, &end_of_input));
+    if (end_of_input) {
+      return Status::OK();
+    }
+    elements.push_back(std::move(outputs));
+  }
+}
 }  // namespace
 
 TEST(Utils, ReadWriteDataset) {
@@ -66,5 +95,279 @@ TEST(Utils, ReadDatasetNotFound) {
   EXPECT_EQ(s.code(), error::NOT_FOUND);
 }
 
+TEST(Utils, ShardDatasetGraph) {
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::map_test_case(&test_case));
+  const int64 num_splits = 3;
+  std::vector<int64> result;
+  for (int64 split_index = 0; split_index < num_splits; ++split_index) {
+    std::vector<std::vector<Tensor>> elements;
+    TF_ASSERT_OK(
+        ReadSplit(test_case.graph_def, num_splits, split_index, elements));
+    for (const auto& element : elements) {
+      ASSERT_EQ(element.size(), 1);
+      result.push_back(element[0].scalar<int64>()());
+    }
+  }
+  std::vector<int64> expected;
+  for (const auto& element : test_case.output) {
+    expected.push_back(element[0].scalar<int64>()());
+  }
+  EXPECT_THAT(result, ::testing::UnorderedElementsAreArray(expected));
+}
+
+TEST(Utils, ShardDatasetGraphMoreSplitsThanElements) {
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::map_test_case(&test_case));
+  const int64 num_splits = 64;
+  ASSERT_LT(test_case.output.size(), num_splits);
+  std::vector<int64> result;
+  for (int64 split_index = 0; split_index < num_splits; ++split_index) {
+    std::vector<std::vector<Tensor>> elements;
+    TF_ASSERT_OK(
+        ReadSplit(test_case.graph_def, num_splits, split_index, elements));
+    EXPECT_LE(elements.size(), 1);
+    for (const auto& element : elements) {
+      result.push_back(element[0].scalar<int64>()());
+    }
+  }
+  std::vector<int64> expected;
+  for (const auto& element : test_case.output) {
+    expected.push_back(element[0].scalar<int64>()());
+  }
+  EXPECT_THAT(result, ::testing::UnorderedElementsAreArray(expected));
+}
+
+TEST(Utils, ShardDatasetGraphShardsAtSource) {
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::range_compressed_test_case(10, &test_case));
+  GraphDef split_graph;
+  TF_ASSERT_OK(ShardDatasetGraph(test_case.graph_def, /*num_splits=*/2,
+                                 /*split_index=*/1, split_graph));
+  int num_shards = 0;
+  for (const NodeDef& node : split_graph.node()) {
+    if (node.op() == "ShardDataset") {
+      ++num_shards;
+      ASSERT_GE(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "range");
+      EXPECT_FALSE(node.attr().at("require_non_empty").b());
+    }
+    if (node.name() == "map") {
+      EXPECT_EQ(node.input(0), "tf_data_service_split/ShardDataset");
+    }
+  }
+  EXPECT_EQ(num_shards, 1);
+}
+
+TEST(Utils, ShardDatasetGraphFewerFilesThanSplits) {
+  const int64 num_files = 3;
+  const int64 records_per_file = 4;
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::tf_record_compressed_test_case(
+      testing::TmpDir(), num_files, records_per_file, &test_case));
+  const int64 num_splits = 8;
+  std::vector<tstring> result;
+  int64 num_nonempty_splits = 0;
+  for (int64 split_index = 0; split_index < num_splits; ++split_index) {
+    std::vector<std::vector<Tensor>> elements;
+    TF_ASSERT_OK(
+        ReadSplit(test_case.graph_def, num_splits, split_index, elements));
+    if (elements.empty()) {
+      continue;
+    }
+    // Each non-empty split holds exactly one file.
+    ++num_nonempty_splits;
+    EXPECT_EQ(elements.size(), records_per_file);
+    for (const auto& element : elements) {
+      ASSERT_EQ(element.size(), 1);
+      std::vector<Tensor> uncompressed;
+      TF_ASSERT_OK(UncompressElement(
+          *element[0].scalar<Variant>()().get<CompressedElement>(),
+          &uncompressed));
+      result.push_back(uncompressed[0].scalar<tstring>()());
+    }
+  }
+  EXPECT_EQ(num_nonempty_splits, num_files);
+  std::vector<tstring> expected;
+  for (const auto& element : test_case.output) {
+    expected.push_back(element[0].scalar<tstring>()());
+  }
+  EXPECT_THAT(result, ::testing::UnorderedElementsAreArray(expected));
+}
+
+TEST(Utils, ShardDatasetGraphRetvalWithControlInput) {
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::map_test_case(&test_case));
+  GraphDef graph = test_case.graph_def;
+  NodeDef* no_op = graph.add_node();
+  no_op->set_name("control_dependency");
+  no_op->set_op("NoOp");
+  NodeDef* retval = nullptr;
+  for (NodeDef& node : *graph.mutable_node()) {
+    if (node.op() == "_Retval") {
+      retval = &node;
+    }
+  }
+  ASSERT_NE(retval, nullptr);
+  const std::string retval_name = retval->name();
+  const std::string dataset_input = retval->input(0);
+  retval->add_input("^control_dependency");
+
+  GraphDef split_graph;
+  TF_ASSERT_OK(ShardDatasetGraph(graph, /*num_splits=*/2, /*split_index=*/0,
+                                 split_graph));
+  for (const NodeDef& node : split_graph.node()) {
+    if (node.name() == retval_name) {
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), dataset_input);
+      EXPECT_EQ(node.input(1), "^control_dependency");
+    }
+  }
+  std::vector<std::vector<Tensor>> elements;
+  TF_ASSERT_OK(ReadSplit(graph, /*num_splits=*/2, /*split_index=*/0, elements));
+  EXPECT_EQ(elements.size(), test_case.output.size() / 2);
+}
+
+TEST(Utils, ShardDatasetGraphInvalidSplitIndex) {
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::map_test_case(&test_case));
+  GraphDef split_graph;
+  Status s = ShardDatasetGraph(test_case.graph_def, /*num_splits=*/2,
+                               /*split_index=*/2, split_graph);
+  EXPECT_EQ(s.code(), error::INVALID_ARGUMENT);
+}
+
+TEST(Utils, ShardDatasetGraphWithoutRetval) {
+  GraphDef split_graph;
+  Status s = ShardDatasetGraph(GraphDef(), /*num_splits=*/2,
+                               /*split_index=*/0, split_graph);
+  EXPECT_EQ(s.code(), error::NOT_FOUND);
+}
+
+TEST(Utils, ShardDatasetGraphSplitsFilesOfReader) {
+  const int64 num_files = 5;
+  const int64 records_per_file = 3;
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::tf_record_reader_compressed_test_case(
+      testing::TmpDir(), num_files, records_per_file, &test_case));
+  const int64 num_splits = 2;
+  GraphDef split_graph;
+  TF_ASSERT_OK(ShardDatasetGraph(test_case.graph_def, num_splits,
+                                 /*split_index=*/0, split_graph));
+  for (const NodeDef& node : split_graph.node()) {
+    // The files are split, rather than the records after reading all files.
+    EXPECT_NE(node.op(), "ShardDataset");
+    if (node.op() == "TFRecordDataset") {
+      EXPECT_EQ(node.input(0), "tf_data_service_split/filenames");
+    }
+  }
+
+  std::vector<tstring> result;
+  for (int64 split_index = 0; split_index < num_splits; ++split_index) {
+    std::vector<std::vector<Tensor>> elements;
+    TF_ASSERT_OK(
+        ReadSplit(test_case.graph_def, num_splits, split_index, elements));
+    // Split 0 reads files [0, 2) and split 1 reads files [2, 5).
+    EXPECT_EQ(elements.size(),
+              (split_index == 0 ? 2 : 3) * records_per_file);
+    for (const auto& element : elements) {
+      ASSERT_EQ(element.size(), 1);
+      std::vector<Tensor> uncompressed;
+      TF_ASSERT_OK(UncompressElement(
+          *element[0].scalar<Variant>()().get<CompressedElement>(),
+          &uncompressed));
+      result.push_back(uncompressed[0].scalar<tstring>()());
+    }
+  }
+  std::vector<tstring> expected;
+  for (const auto& element : test_case.output) {
+    expected.push_back(element[0].scalar<tstring>()());
+  }
+  EXPECT_THAT(result, ::testing::UnorderedElementsAreArray(expected));
+}
+
+TEST(Utils, ShardDatasetGraphMultipleSources) {
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::zip_compressed_test_case(10, &test_case));
+  GraphDef split_graph;
+  Status s = ShardDatasetGraph(test_case.graph_def, /*num_splits=*/2,
+                               /*split_index=*/0, split_graph);
+  EXPECT_EQ(s.code(), error::FAILED_PRECONDITION);
+  int64 max_num_splits;
+  s = MaxNumSplits(test_case.graph_def, max_num_splits);
+  EXPECT_EQ(s.code(), error::FAILED_PRECONDITION);
+
+  // A single split produces the whole dataset.
+  std::vector<std::vector<Tensor>> elements;
+  TF_ASSERT_OK(ReadSplit(test_case.graph_def, /*num_splits=*/1,
+                         /*split_index=*/0, elements));
+  EXPECT_EQ(elements.size(), test_case.output.size());
+}
+
+TEST(Utils, ShardDatasetGraphTakeFromSource) {
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::range_compressed_test_case(10, &test_case));
+  GraphDef graph = test_case.graph_def;
+  NodeDef* count = graph.add_node();
+  count->set_name("count");
+  count->set_op("Const");
+  (*count->mutable_attr())["dtype"].set_type(DT_INT64);
+  TensorProto* value = (*count->mutable_attr())["value"].mutable_tensor();
+  value->set_dtype(DT_INT64);
+  value->mutable_tensor_shape();
+  value->add_int64_val(5);
+  NodeDef* take = graph.add_node();
+  take->set_name("take");
+  take->set_op("TakeDataset");
+  take->add_input("range");
+  take->add_input("count");
+  for (NodeDef& node : *graph.mutable_node()) {
+    if (node.name() == "map") {
+      node.set_input(0, "take");
+    }
+    if (node.name() == "range") {
+      (*take->mutable_attr())["output_types"] = node.attr().at("output_types");
+      (*take->mutable_attr())["output_shapes"] =
+          node.attr().at("output_shapes");
+    }
+  }
+  // Taking 5 elements from each split would produce more than 5 elements.
+  GraphDef split_graph;
+  Status s = ShardDatasetGraph(graph, /*num_splits=*/2, /*split_index=*/0,
+                               split_graph);
+  EXPECT_EQ(s.code(), error::FAILED_PRECONDITION);
+}
+
+TEST(Utils, MaxNumSplits) {
+  test_util::GraphDefTestCase test_case;
+  int64 max_num_splits;
+  TF_ASSERT_OK(test_util::range_compressed_test_case(5, &test_case));
+  TF_ASSERT_OK(MaxNumSplits(test_case.graph_def, max_num_splits));
+  EXPECT_EQ(max_num_splits, 5);
+  TF_ASSERT_OK(test_util::tf_record_compressed_test_case(
+      testing::TmpDir(), /*num_files=*/3, /*records_per_file=*/2, &test_case));
+  TF_ASSERT_OK(MaxNumSplits(test_case.graph_def, max_num_splits));
+  EXPECT_EQ(max_num_splits, 3);
+  TF_ASSERT_OK(test_util::tf_record_reader_compressed_test_case(
+      testing::TmpDir(), /*num_files=*/4, /*records_per_file=*/2, &test_case));
+  TF_ASSERT_OK(MaxNumSplits(test_case.graph_def, max_num_splits));
+  EXPECT_EQ(max_num_splits, 4);
+  EXPECT_EQ(MaxNumSplits(GraphDef(), max_num_splits).code(), error::NOT_FOUND);
+}
+
+TEST(Utils, MaxNumSplitsWithComputedInputs) {
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::range_compressed_test_case(5, &test_case));
+  GraphDef graph = test_case.graph_def;
+  for (NodeDef& node : *graph.mutable_node()) {
+    if (node.name() == "stop") {
+      node.set_op("Placeholder");
+    }
+  }
+  int64 max_num_splits;
+  TF_ASSERT_OK(MaxNumSplits(graph, max_num_splits));
+  EXPECT_EQ(max_num_splits, -1);
+}
+
 }  // namespace data
 }  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/worker_impl.h"
 
+#include <algorithm>
+
 #include "grpcpp/create_channel.h"
 #include "absl/memory/memory.h"
 #include "tensorflow/c/c_api_internal.h"
@@ -39,17 +41,99 @@ namespace tensorflow {
 namespace data {
 
 const constexpr uint64 kRetryIntervalMicros = 5ull * 1000 * 1000;
+// The default number of elements each task produces ahead of client requests.
+const constexpr int64 kDefaultTaskBufferSize = 8;
+// The default number of elements kept by each shared epoch cache.
+const constexpr int64 kDefaultSharedEpochWindowSize = 32;
+// The default time after which an idle shared epoch consumer stops holding
+// back the others.
+const constexpr int64 kDefaultSharedEpochStallTimeoutMs = 60 * 1000;
 
 namespace {
 auto* tf_data_service_created =
     monitoring::Gauge<bool, 0>::New("/tensorflow/data/service/created",
                                     "Whether a tf.data service server "
                                     "has been created.");
+
+// Moves the `CompressedElement` produced by a data service dataset out of
+// `outputs` into `element`.
+Status ExtractCompressedElement(std::vector<Tensor>& outputs,
+                                CompressedElement* element) {
+  if (outputs.size() != 1) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a single scalar variant tensor, but the "
+        "dataset produced ",
+        outputs.size(), " outputs");
+  }
+  if (outputs[0].dtype() != DT_VARIANT) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a single scalar variant tensor, but "
+        "the dataset produced a tensor with type ",
+        DataTypeString(outputs[0].dtype()));
+  }
+  if (!TensorShapeUtils::IsScalar(outputs[0].shape())) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a single scalar variant tensor, but "
+        "the dataset produced a tensor with shape ",
+        outputs[0].shape());
+  }
+  Variant& variant = outputs[0].scalar<Variant>()();
+  CompressedElement* compressed = variant.get<CompressedElement>();
+  if (compressed == nullptr) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a CompressedElement variant tensor, but "
+        "it produced ",
+        variant.TypeName());
+  }
+  compressed->Swap(element);
+  return Status::OK();
+}
+
+// Gets the next element of `iterator` as a `CompressedElement`.
+Status GetNextCompressed(standalone::Iterator& iterator,
+                         CompressedElement* element, bool* end_of_sequence) {
+  std::vector<Tensor> outputs;
+  TF_RETURN_IF_ERROR(iterator.GetNext(&outputs, end_of_sequence));
+  if (*end_of_sequence) {
+    return Status::OK();
+  }
+  return ExtractCompressedElement(outputs, element);
+}
+
+// The dataset and iterator producing the elements of a shared epoch cache.
+struct SharedEpochIterator {
+  std::unique_ptr<standalone::Dataset> dataset;
+  std::unique_ptr<standalone::Iterator> iterator;
+};
 }  // namespace
 
+DataServiceWorkerImpl::Task::~Task() {
+  {
+    mutex_lock l(mu);
+    cancelled = true;
+    cv.notify_all();
+  }
+  if (shared_epoch_cache) {
+    // Wakes up the prefetch thread if it is waiting on the cache.
+    shared_epoch_cache->UnregisterConsumer(consumer_id);
+  }
+  prefetch_thread.reset();
+}
+
 DataServiceWorkerImpl::DataServiceWorkerImpl(
     const experimental::WorkerConfig& config)
-    : config_(config) {
+    : config_(config),
+      task_buffer_size_(config.task_buffer_size() > 0
+                            ? config.task_buffer_size()
+                            : kDefaultTaskBufferSize),
+      shared_epoch_window_size_(config.shared_epoch_window_size() > 0
+                                    ? config.shared_epoch_window_size()
+                                    : kDefaultSharedEpochWindowSize),
+      shared_epoch_stall_timeout_us_(
+          (config.shared_epoch_stall_timeout_ms() > 0
+               ? config.shared_epoch_stall_timeout_ms()
+               : kDefaultSharedEpochStallTimeoutMs) *
+          1000) {
   tf_data_service_created->GetCell()->Set(true);
 }
 
@@ -105,20 +189,18 @@ Status DataServiceWorkerImpl::ProcessTaskInternal(const TaskDef& task_def)
 }
 
 Status DataServiceWorkerImpl::EnsureTaskInitialized(
-    DataServiceWorkerImpl::Task& task) {
+    DataServiceWorkerImpl::Task& task) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   mutex_lock l(task.mu);
   if (task.initialized) {
     return Status::OK();
   }
-  standalone::Dataset::Params params;
-
+  DatasetDef def;
+  const GraphDef* graph;
   switch (task.task_def.dataset_case()) {
     case TaskDef::kDatasetDef:
-      TF_RETURN_IF_ERROR(standalone::Dataset::FromGraph(
-          params, task.task_def.dataset_def().graph(), &task.dataset));
+      graph = &task.task_def.dataset_def().graph();
       break;
     case TaskDef::kPath: {
-      DatasetDef def;
       Status s = ReadDatasetDef(task.task_def.path(), def);
       if (!s.ok()) {
         LOG(INFO) << "Failed to read dataset from " << task.task_def.path()
@@ -126,25 +208,167 @@ Status DataServiceWorkerImpl::EnsureTaskInitialized(
         TF_RETURN_IF_ERROR(
             dispatcher_->GetDatasetDef(task.task_def.dataset_id(), def));
       }
-      TF_RETURN_IF_ERROR(
-          standalone::Dataset::FromGraph(params, def.graph(), &task.dataset));
+      graph = &def.graph();
       break;
     }
     case TaskDef::DATASET_NOT_SET:
       return errors::Internal("Unrecognized dataset case: ",
                               task.task_def.dataset_case());
   }
-  TF_RETURN_IF_ERROR(task.dataset->MakeIterator(&task.iterator));
+  switch (task.task_def.processing_mode()) {
+    case ProcessingModeDef::ONE_EPOCH:
+      // Iterators are created per split in `GetNextFromTask`.
+      task.graph = *graph;
+      break;
+    case ProcessingModeDef::SHARED_EPOCH:
+      TF_RETURN_IF_ERROR(JoinSharedEpoch(task, *graph));
+      break;
+    default: {
+      standalone::Dataset::Params params;
+      TF_RETURN_IF_ERROR(
+          standalone::Dataset::FromGraph(params, *graph, &task.dataset));
+      TF_RETURN_IF_ERROR(task.dataset->MakeIterator(&task.iterator));
+      VLOG(3) << "Created iterator for task " << task.task_def.task_id();
+    }
+  }
   task.initialized = true;
-  VLOG(3) << "Created iterator for task " << task.task_def.task_id();
+  task.prefetch_thread = absl::WrapUnique(Env::Default()->StartThread(
+      {}, "data-service-worker-task-prefetch",
+      [this, task = &task]() { TaskPrefetchThread(task); }));
   return Status::OK();
 }
 
+Status DataServiceWorkerImpl::JoinSharedEpoch(Task& task,
+                                              const GraphDef& graph)
+    EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  int64 dataset_id = task.task_def.dataset_id();
+  std::shared_ptr<SharedEpochCache>& cache = shared_epoch_caches_[dataset_id];
+  if (cache != nullptr) {
+    Status s = cache->RegisterConsumer(task.consumer_id);
+    if (s.ok()) {
+      task.shared_epoch_cache = cache;
+      VLOG(3) << "Task " << task.task_def.task_id()
+              << " joined the shared epoch of dataset " << dataset_id;
+      return Status::OK();
+    }
+    // The task would miss elements of the existing epoch, so it starts a new
+    // one. Tasks of the earlier epoch keep their own reference to its cache.
+    VLOG(3) << "Task " << task.task_def.task_id()
+            << " cannot join the shared epoch of dataset " << dataset_id
+            << ": " << s;
+  }
+  auto producer = std::make_shared<SharedEpochIterator>();
+  standalone::Dataset::Params params;
+  TF_RETURN_IF_ERROR(
+      standalone::Dataset::FromGraph(params, graph, &producer->dataset));
+  TF_RETURN_IF_ERROR(producer->dataset->MakeIterator(&producer->iterator));
+  cache = std::make_shared<SharedEpochCache>(
+      shared_epoch_window_size_, shared_epoch_stall_timeout_us_,
+      [producer](CompressedElement& element, bool& end_of_sequence) {
+        Status s = GetNextCompressed(*producer->iterator, &element,
+                                     &end_of_sequence);
+        if (!s.ok() || end_of_sequence) {
+          // The cache doesn't produce again; release iterator memory.
+          producer->iterator.reset();
+          producer->dataset.reset();
+        }
+        return s;
+      });
+  VLOG(3) << "Created shared epoch cache for dataset " << dataset_id;
+  TF_RETURN_IF_ERROR(cache->RegisterConsumer(task.consumer_id));
+  task.shared_epoch_cache = cache;
+  VLOG(3) << "Task " << task.task_def.task_id()
+          << " joined the shared epoch of dataset " << dataset_id;
+  return Status::OK();
+}
+
+void DataServiceWorkerImpl::TaskPrefetchThread(Task* task) {
+  while (true) {
+    {
+      mutex_lock l(task->mu);
+      while (!task->cancelled && task->buffer.size() >= task_buffer_size_) {
+        task->cv.wait(l);
+      }
+      if (task->cancelled) {
+        return;
+      }
+    }
+    bool end_of_sequence = false;
+    CompressedElement element;
+    Status s = GetNextFromTask(*task, &element, &end_of_sequence);
+    if (!s.ok() || end_of_sequence) {
+      // Release iterator memory; the task stays behind as a tombstone.
+      task->iterator.reset();
+      task->dataset.reset();
+    }
+    mutex_lock l(task->mu);
+    task->cv.notify_all();
+    if (!s.ok()) {
+      task->status = s;
+      return;
+    }
+    if (end_of_sequence) {
+      VLOG(3) << "Reached end_of_sequence for task "
+              << task->task_def.task_id();
+      task->end_of_sequence = true;
+      return;
+    }
+    task->buffer.push_back(std::move(element));
+  }
+}
+
+Status DataServiceWorkerImpl::GetNextFromTask(Task& task,
+                                              CompressedElement* element,
+                                              bool* end_of_sequence) {
+  switch (task.task_def.processing_mode()) {
+    case ProcessingModeDef::ONE_EPOCH:
+      break;
+    case ProcessingModeDef::SHARED_EPOCH:
+      TF_RETURN_IF_ERROR(task.shared_epoch_cache->GetNext(
+          task.consumer_id, *element, *end_of_sequence));
+      if (*end_of_sequence) {
+        // Stop holding back eviction for the jobs still reading.
+        task.shared_epoch_cache->UnregisterConsumer(task.consumer_id);
+      }
+      return Status::OK();
+    default:
+      return GetNextCompressed(*task.iterator, element, end_of_sequence);
+  }
+  while (true) {
+    if (task.iterator != nullptr) {
+      TF_RETURN_IF_ERROR(
+          GetNextCompressed(*task.iterator, element, end_of_sequence));
+      if (!*end_of_sequence) {
+        return Status::OK();
+      }
+      task.iterator.reset();
+      task.dataset.reset();
+    }
+    int64 split_index;
+    bool end_of_splits;
+    TF_RETURN_IF_ERROR(dispatcher_->GetSplit(task.task_def.job_id(),
+                                             task.task_def.task_id(),
+                                             split_index, end_of_splits));
+    if (end_of_splits) {
+      *end_of_sequence = true;
+      return Status::OK();
+    }
+    VLOG(3) << "Processing split " << split_index << " for task "
+            << task.task_def.task_id();
+    GraphDef split_graph;
+    TF_RETURN_IF_ERROR(ShardDatasetGraph(
+        task.graph, task.task_def.num_splits(), split_index, split_graph));
+    standalone::Dataset::Params params;
+    TF_RETURN_IF_ERROR(
+        standalone::Dataset::FromGraph(params, split_graph, &task.dataset));
+    TF_RETURN_IF_ERROR(task.dataset->MakeIterator(&task.iterator));
+  }
+}
+
 Status DataServiceWorkerImpl::GetElement(const GetElementRequest* request,
                                          GetElementResponse* response) {
   VLOG(3) << "Received GetElement request for task " << request->task_id();
-  bool end_of_sequence = false;
-  std::vector<tensorflow::Tensor> outputs;
+  Task* task;
   {
     mutex_lock l(mu_);
     if (!registered_) {
@@ -159,56 +383,43 @@ Status DataServiceWorkerImpl::GetElement(const GetElementRequest* request,
       return errors::NotFound("DataServiceWorkerImpl::GetElement failed. ",
                               "Task id ", request->task_id(), " not found");
     }
-    auto& task = it->second;
+    // Tasks are never removed from `tasks_`, so `task` outlives this request.
+    task = it->second.get();
     TF_RETURN_IF_ERROR(EnsureTaskInitialized(*task));
-    std::unique_ptr<standalone::Iterator>& iter = task->iterator;
-    if (iter == nullptr) {
-      VLOG(3) << "Task " << request->task_id() << " is already finished";
-      response->set_end_of_sequence(true);
-      return Status::OK();
-    }
-    TF_RETURN_IF_ERROR(iter->GetNext(&outputs, &end_of_sequence));
-    if (end_of_sequence) {
-      VLOG(3) << "Reached end_of_sequence for task " << request->task_id();
-      // Release iterator memory and leave a null entry as a tombstone.
-      iter.reset();
-      pending_completed_tasks_.insert(request->task_id());
-      background_cv_.notify_one();
-    }
   }
 
-  if (!end_of_sequence) {
-    VLOG(3) << "Producing an element for task " << request->task_id();
-    if (outputs.size() != 1) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a single scalar variant tensor, but the "
-          "dataset produced ",
-          outputs.size(), " outputs");
+  int64 max_elements = std::max<int64>(request->max_elements(), 1);
+  {
+    mutex_lock l(task->mu);
+    while (task->buffer.empty() && !task->end_of_sequence &&
+           task->status.ok() && !task->cancelled) {
+      task->cv.wait(l);
     }
-    if (outputs[0].dtype() != DT_VARIANT) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a single scalar variant tensor, but "
-          "the dataset produced a tensor with type ",
-          DataTypeString(outputs[0].dtype()));
+    if (!task->status.ok()) {
+      return task->status;
     }
-    if (!TensorShapeUtils::IsScalar(outputs[0].shape())) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a single scalar variant tensor, but "
-          "the dataset produced a tensor with shape ",
-          outputs[0].shape());
+    if (task->cancelled) {
+      return errors::Cancelled("Task ", request->task_id(), " was cancelled");
     }
-    Variant& variant = outputs[0].scalar<Variant>()();
-    CompressedElement* compressed = variant.get<CompressedElement>();
-    if (compressed == nullptr) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a CompressedElement variant tensor, but "
-          "it produced ",
-          variant.TypeName());
+    if (!task->buffer.empty()) {
+      VLOG(3) << "Producing elements for task " << request->task_id();
+      task->buffer.front().Swap(response->mutable_compressed_element());
+      task->buffer.pop_front();
+      for (int64 i = 1; i < max_elements && !task->buffer.empty(); ++i) {
+        task->buffer.front().Swap(response->add_additional_elements());
+        task->buffer.pop_front();
+      }
+      task->cv.notify_all();
+      response->set_end_of_sequence(false);
+      return Status::OK();
     }
-    compressed->Swap(response->mutable_compressed_element());
   }
-  response->set_end_of_sequence(end_of_sequence);
 
+  VLOG(3) << "Task " << request->task_id() << " is finished";
+  response->set_end_of_sequence(true);
+  mutex_lock l(mu_);
+  pending_completed_tasks_.insert(request->task_id());
+  background_cv_.notify_one();
   return Status::OK();
 }
 
@@ -249,7 +460,6 @@ void DataServiceWorkerImpl::BackgroundThread() LOCKS_EXCLUDED(mu_) {
 }
 
 Status DataServiceWorkerImpl::SendTaskUpdates() LOCKS_EXCLUDED(mu_) {
-  WorkerUpdateRequest req;
   std::vector<TaskProgress> task_progress;
   {
     mutex_lock l(mu_);
@@ -265,10 +475,10 @@ Status DataServiceWorkerImpl::SendTaskUpdates() LOCKS_EXCLUDED(mu_) {
 
   TF_RETURN_IF_ERROR(dispatcher_->WorkerUpdate(worker_address_, task_progress));
   mutex_lock l(mu_);
-  for (const auto& update : req.updates()) {
+  for (const auto& update : task_progress) {
     pending_completed_tasks_.erase(update.task_id());
   }
-  VLOG(3) << "Sent " << req.updates().size() << " task updates ";
+  VLOG(3) << "Sent " << task_progress.size() << " task updates ";
   return Status::OK();
 }
 
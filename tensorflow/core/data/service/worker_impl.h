@@ -15,10 +15,13 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_WORKER_IMPL_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_WORKER_IMPL_H_
 
+#include <deque>
+
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/data_service.h"
 #include "tensorflow/core/data/service/dispatcher.grpc.pb.h"
+#include "tensorflow/core/data/service/shared_epoch_cache.h"
 #include "tensorflow/core/data/service/worker.pb.h"
 #include "tensorflow/core/data/standalone.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -54,14 +57,37 @@ class DataServiceWorkerImpl {
  private:
   struct Task {
     explicit Task(TaskDef task_def) : task_def(std::move(task_def)) {}
+    // Cancels and joins the prefetch thread.
+    ~Task();
 
     TaskDef task_def;
     mutex mu;
     bool initialized TF_GUARDED_BY(mu) = false;
+    // For ONE_EPOCH tasks, the dataset graph that is sharded to produce the
+    // dataset for each split. `dataset` and `iterator` are for the split
+    // being processed, and are null between splits.
+    GraphDef graph;
+    // Once the task is initialized, the dataset and iterator are only
+    // accessed by `prefetch_thread`.
     // TODO(aaudibert): Have standalone::Iterator own a reference to
     // standalone::Dataset so that we don't need to store the dataset here.
     std::unique_ptr<standalone::Dataset> dataset;
     std::unique_ptr<standalone::Iterator> iterator;
+    // For SHARED_EPOCH tasks, the cache that the task reads its elements from
+    // instead of `iterator`, and the task's consumer id in the cache.
+    std::shared_ptr<SharedEpochCache> shared_epoch_cache;
+    int64 consumer_id = -1;
+    // Elements produced by `prefetch_thread` that haven't been sent yet.
+    std::deque<CompressedElement> buffer TF_GUARDED_BY(mu);
+    // Whether the iterator has produced end_of_sequence. Elements may still
+    // remain in `buffer`.
+    bool end_of_sequence TF_GUARDED_BY(mu) = false;
+    // The error encountered by `prefetch_thread`, if any.
+    Status status TF_GUARDED_BY(mu);
+    bool cancelled TF_GUARDED_BY(mu) = false;
+    // Notified when elements are added to or removed from `buffer`.
+    condition_variable cv;
+    std::unique_ptr<Thread> prefetch_thread;
   };
 
   // Registers the worker with the dispatcher.
@@ -70,12 +96,34 @@ class DataServiceWorkerImpl {
   Status SendTaskUpdates() LOCKS_EXCLUDED(mu_);
   // Creates an iterator to process a task.
   Status ProcessTaskInternal(const TaskDef& task) EXCLUSIVE_LOCKS_REQUIRED(mu_);
-  Status EnsureTaskInitialized(Task& task);
+  // Creates the iterator for `task` and starts its prefetch thread.
+  Status EnsureTaskInitialized(Task& task) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Registers SHARED_EPOCH `task` with the shared epoch cache of its dataset,
+  // creating a new cache from `graph` if the task cannot join the existing
+  // one without missing elements.
+  Status JoinSharedEpoch(Task& task, const GraphDef& graph)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Produces the next element of `task`. For ONE_EPOCH tasks, this requests a
+  // new split from the dispatcher whenever the current split is exhausted, and
+  // produces end_of_sequence once the dispatcher runs out of splits. For
+  // SHARED_EPOCH tasks, this reads from the task's shared epoch cache.
+  Status GetNextFromTask(Task& task, CompressedElement* element,
+                         bool* end_of_sequence);
+  // Fills `task.buffer` ahead of client requests, keeping at most
+  // `task_buffer_size_` elements buffered.
+  void TaskPrefetchThread(Task* task);
   // A thread for doing async background processing not associated with a
   // specific RPC, such as reporting finished tasks.
   void BackgroundThread() LOCKS_EXCLUDED(mu_);
 
   const experimental::WorkerConfig config_;
+  // The number of elements each task produces ahead of client requests.
+  const int64 task_buffer_size_;
+  // The number of elements each shared epoch cache keeps.
+  const int64 shared_epoch_window_size_;
+  // How long a shared epoch consumer may be idle before it stops holding back
+  // the others.
+  const int64 shared_epoch_stall_timeout_us_;
   // The worker's own address.
   std::string worker_address_;
   std::unique_ptr<DataServiceDispatcherClient> dispatcher_;
@@ -85,6 +133,11 @@ class DataServiceWorkerImpl {
   absl::flat_hash_map<int64, std::unique_ptr<Task>> tasks_ TF_GUARDED_BY(mu_);
   // Completed tasks which haven't yet been communicated to the dispatcher.
   absl::flat_hash_set<int64> pending_completed_tasks_ TF_GUARDED_BY(mu_);
+  // Caches of the elements read by SHARED_EPOCH tasks, keyed by dataset id.
+  // The dispatcher gives datasets with the same fingerprint the same id, so
+  // jobs over identical datasets share a cache.
+  absl::flat_hash_map<int64, std::shared_ptr<SharedEpochCache>>
+      shared_epoch_caches_ TF_GUARDED_BY(mu_);
   bool cancelled_ TF_GUARDED_BY(mu_) = false;
   // Whether the worker has registered with the dispatcher yet.
   bool registered_ TF_GUARDED_BY(mu_) = false;
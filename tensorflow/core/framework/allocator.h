@@ -62,6 +62,11 @@ struct AllocationAttributes {
   // a memory chunk whose freed_at_count is at this value or earlier may be
   // returned.
   std::function<uint64()>* freed_by_func = nullptr;  // Not owned.
+  // EXPERIMENTAL: If non-negative, identifies the allocation within a step,
+  // for allocators that serve the allocations of repeated steps from a static
+  // memory plan. Set by OpKernelContext when the executor provides such an
+  // allocator in OpKernelContext::Params::planned_allocator.
+  int64 plan_key = -1;
 
   TF_DISALLOW_COPY_AND_ASSIGN(AllocationAttributes);
 };
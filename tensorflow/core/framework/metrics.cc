@@ -108,9 +108,26 @@ auto* tf_data_getnext_time_between_msecs_histogram =
                                         200., 225., 250., 300., 350., 400.,
                                         450., 500., 1000., 10000.})});
 
+auto* tf_data_memory_cache_lookups_counter = monitoring::Counter<1>::New(
+    "/tensorflow/data/memory_cache_lookups",
+    "The number of lookups in compressed tf.data in-memory caches, by tier.",
+    "tier");
+
+auto* tf_data_memory_cache_bytes_counter = monitoring::Counter<1>::New(
+    "/tensorflow/data/memory_cache_bytes",
+    "The number of compressed bytes written to compressed tf.data in-memory "
+    "caches, by tier.",
+    "tier");
+
 auto* tf_data_optimization_counter = monitoring::Counter<1>::New(
     "/tensorflow/data/optimization", "tf.data optimization", "name");
 
+auto* tf_data_vectorization_fallback_counter = monitoring::Counter<1>::New(
+    "/tensorflow/data/vectorization_fallback",
+    "The number of map function outputs that tf.data map vectorization could "
+    "not vectorize, by the type of the op producing the output.",
+    "op_type");
+
 auto* parse_dense_feature_counter = monitoring::Counter<0>::New(
     "/tensorflow/data/dense_feature",
     "The number of dense features parsed by ops for parsing tf.Example.");
@@ -192,6 +209,14 @@ void RecordTFDataFingerprint(const string& name) {
   tf_data_fingerprint_counter->GetCell(name)->IncrementBy(1);
 }
 
+void RecordTFDataMemoryCacheLookup(const string& tier) {
+  tf_data_memory_cache_lookups_counter->GetCell(tier)->IncrementBy(1);
+}
+
+void RecordTFDataMemoryCacheBytes(const string& tier, int64 num_bytes) {
+  tf_data_memory_cache_bytes_counter->GetCell(tier)->IncrementBy(num_bytes);
+}
+
 void RecordTFDataGetNextDuration(uint64 duration_us) {
   static auto* tfdata_getnext_duration_cell =
       tf_data_getnext_duration_usecs_histogram->GetCell();
@@ -210,6 +235,10 @@ void RecordTFDataOptimization(const string& name, int64 num_changes) {
   tf_data_optimization_counter->GetCell(name)->IncrementBy(num_changes);
 }
 
+void RecordTFDataVectorizationFallback(const string& op_type) {
+  tf_data_vectorization_fallback_counter->GetCell(op_type)->IncrementBy(1);
+}
+
 void RecordParseDenseFeature(int64 num_features) {
   static auto* parse_dense_feature_counter_cell =
       parse_dense_feature_counter->GetCell();
@@ -59,6 +59,16 @@ void RecordTFDataBytesFetched(int64 num_bytes);
 // Records the number of times tf.data experiment is applied to input pipelines.
 void RecordTFDataExperiment(const string& name);
 
+// Records a lookup in a compressed in-memory tf.data cache.
+//
+// The `tier` argument identifies where the element was found ("memory" or
+// "file").
+void RecordTFDataMemoryCacheLookup(const string& tier);
+
+// Records the number of compressed bytes written to a tier ("memory" or
+// "file") of a compressed in-memory tf.data cache.
+void RecordTFDataMemoryCacheBytes(const string& tier, int64 num_bytes);
+
 // Records the time spent in ItertatorResource::GetNext() in microseconds.
 void RecordTFDataGetNextDuration(uint64 duration_us);
 
@@ -81,6 +91,13 @@ void RecordTFDataFingerprint(const string& name);
 // The `name` argument identifies the optimization (e.g. "noop_elimination").
 void RecordTFDataOptimization(const string& name, int64 num_changes);
 
+// Records a map function output that tf.data map vectorization could not
+// vectorize, leaving it to be computed element-wise by a MapDefun op.
+//
+// The `op_type` argument identifies the op producing the output (e.g.
+// "DecodeJpeg").
+void RecordTFDataVectorizationFallback(const string& op_type);
+
 // Records parsing of dense tensor features.
 void RecordParseDenseFeature(int64 num_features);
 
@@ -82,8 +82,8 @@ class InterleaveMany : public Node {
     if (num_inputs() <= 1) {
       (*output_times)[long_name()] = self_processing_time;
       if (gradients) {
-        for (const auto& node : CollectNodes(TraversalOrder::REVERSE_BFS)) {
-          gradients->erase(node->long_name());
+        for (const auto& key : CollectParameterKeys()) {
+          gradients->erase(key);
         }
       }
       return;
@@ -94,8 +94,8 @@ class InterleaveMany : public Node {
          (*output_times)[inputs_.front()->long_name()]) /
         static_cast<double>(num_inputs() - 1);
     if (gradients) {
-      for (const auto& node : CollectNodes(TraversalOrder::REVERSE_BFS)) {
-        auto* gradient = gtl::FindOrNull(*gradients, node->long_name());
+      for (const auto& key : CollectParameterKeys()) {
+        auto* gradient = gtl::FindOrNull(*gradients, key);
         if (gradient) {
           *gradient /= static_cast<double>(num_inputs() - 1);
         }
@@ -195,12 +195,13 @@ class AsyncInterleaveMany : public Node {
 
   // The output time is the sum of self processing time and expected wait time
   // from the buffer model estimated using
-  // `ComputeWaitTime(producer_time, consumer_time, parallelism, ...)`, where
+  // `ComputeWaitTime(producer_time, consumer_time, buffer_size, ...)`, where
   // `producer_time` is the average output time of inputs comprising the
   // interleave "cycle" divided by `parallelism`, `consumer_time` is the
   // `input_time` specified through `input_times` divided by `num_inputs() - 1`,
-  // and if the node has parallelism parameter, then `buffer_size` is derived
-  // from `parallelism`.
+  // and `buffer_size` is the per-input buffer size times `num_inputs() - 1` if
+  // the node has a per-input buffer size parameter, and is derived from
+  // `parallelism` otherwise.
   void OutputTimeLocked(
       const absl::flat_hash_map<string, double>& input_times,
       absl::flat_hash_map<string, double>* gradients,
@@ -211,8 +212,8 @@ class AsyncInterleaveMany : public Node {
     if (num_inputs() <= 1) {
       (*output_times)[long_name()] = self_processing_time;
       if (gradients) {
-        for (const auto& node : CollectNodes(TraversalOrder::REVERSE_BFS)) {
-          gradients->erase(node->long_name());
+        for (const auto& key : CollectParameterKeys()) {
+          gradients->erase(key);
         }
       }
       return;
@@ -226,6 +227,13 @@ class AsyncInterleaveMany : public Node {
     if (parameter) {
       parallelism = std::min(parallelism, (*parameter)->value);
     }
+    double buffer_size = parallelism;
+    auto* buffer_size_parameter =
+        gtl::FindOrNull(parameters_, kPerInputBufferSize);
+    if (buffer_size_parameter) {
+      buffer_size = (*buffer_size_parameter)->value *
+                    static_cast<double>(num_inputs() - 1);
+    }
     double output_time_for_inputs =
         OutputTimeForInputs(*output_times) -
         (*output_times)[inputs_.front()->long_name()];
@@ -236,7 +244,7 @@ class AsyncInterleaveMany : public Node {
       double producer_time_der = 0.0L;
       double consumer_time_der = 0.0L;
       double buffer_size_der = 0.0L;
-      wait_time = ComputeWaitTime(producer_time, consumer_time, parallelism,
+      wait_time = ComputeWaitTime(producer_time, consumer_time, buffer_size,
                                   &producer_time_der, &consumer_time_der,
                                   &buffer_size_der);
       double inputs_time_der_sum =
@@ -245,8 +253,8 @@ class AsyncInterleaveMany : public Node {
           consumer_time_der +
           producer_time_der * inputs_time_der_sum / parallelism;
 
-      for (const auto& node : CollectNodes(TraversalOrder::REVERSE_BFS)) {
-        auto* gradient = gtl::FindOrNull(*gradients, node->long_name());
+      for (const auto& key : CollectParameterKeys()) {
+        auto* gradient = gtl::FindOrNull(*gradients, key);
         if (gradient) {
           *gradient *= (producer_time_der /
                         static_cast<double>(num_inputs() - 1) / parallelism);
@@ -262,13 +270,20 @@ class AsyncInterleaveMany : public Node {
       for (auto& pair : first_input_parameters) {
         (*gradients)[pair.first] = 0.0L;
       }
-      // Add derivative w.r.t. own parallelism parameter.
+      // Add derivatives w.r.t. own parallelism and buffer size parameters.
       if (parameter && (*parameter)->state->tunable) {
         (*gradients)[long_name()] =
-            buffer_size_der - producer_time_der * producer_time / parallelism;
+            -producer_time_der * producer_time / parallelism;
+        if (!buffer_size_parameter) {
+          (*gradients)[long_name()] += buffer_size_der;
+        }
+      }
+      if (buffer_size_parameter && (*buffer_size_parameter)->state->tunable) {
+        (*gradients)[ParameterKey(kPerInputBufferSize)] =
+            buffer_size_der * static_cast<double>(num_inputs() - 1);
       }
     } else {
-      wait_time = ComputeWaitTime(producer_time, consumer_time, parallelism,
+      wait_time = ComputeWaitTime(producer_time, consumer_time, buffer_size,
                                   /*producer_time_derivative=*/nullptr,
                                   /*consumer_time_derivative=*/nullptr,
                                   /*buffer_size_derivative=*/nullptr);
@@ -345,15 +360,15 @@ class KnownRatio : public Node {
     if (ratio_ == 0) {
       (*output_times)[long_name()] = self_processing_time;
       if (gradients) {
-        for (const auto& node : CollectNodes(TraversalOrder::REVERSE_BFS)) {
-          gradients->erase(node->long_name());
+        for (const auto& key : CollectParameterKeys()) {
+          gradients->erase(key);
         }
       }
       return;
     }
     if (gradients) {
-      for (const auto& node : CollectNodes(TraversalOrder::REVERSE_BFS)) {
-        auto* gradient = gtl::FindOrNull(*gradients, node->long_name());
+      for (const auto& key : CollectParameterKeys()) {
+        auto* gradient = gtl::FindOrNull(*gradients, key);
         if (gradient) {
           *gradient *= ratio_;
         }
@@ -473,8 +488,8 @@ class AsyncKnownRatio : public Node {
       consumer_time = input_time;
       producer_time = 0.0L;
       if (gradients) {
-        for (const auto& node : CollectNodes(TraversalOrder::REVERSE_BFS)) {
-          gradients->erase(node->long_name());
+        for (const auto& key : CollectParameterKeys()) {
+          gradients->erase(key);
         }
 
         double producer_time_der = 0.0L;
@@ -518,8 +533,8 @@ class AsyncKnownRatio : public Node {
       (*output_time_gradients)[long_name()] =
           consumer_time_der + producer_time_der * inputs_time_der_sum;
 
-      for (const auto& node : CollectNodes(TraversalOrder::REVERSE_BFS)) {
-        auto* gradient = gtl::FindOrNull(*gradients, node->long_name());
+      for (const auto& key : CollectParameterKeys()) {
+        auto* gradient = gtl::FindOrNull(*gradients, key);
         if (gradient) {
           *gradient *= (ratio_ * producer_time_der);
         }
@@ -618,8 +633,8 @@ class UnknownRatio : public Node {
         inputs_.front()->num_elements() == 0) {
       (*output_times)[long_name()] = self_processing_time;
       if (gradients) {
-        for (const auto& node : CollectNodes(TraversalOrder::REVERSE_BFS)) {
-          gradients->erase(node->long_name());
+        for (const auto& key : CollectParameterKeys()) {
+          gradients->erase(key);
         }
       }
       return;
@@ -629,8 +644,8 @@ class UnknownRatio : public Node {
     double ratio = static_cast<double>(inputs_.front()->num_elements()) /
                    static_cast<double>(num_elements_);
     if (gradients) {
-      for (const auto& node : CollectNodes(TraversalOrder::REVERSE_BFS)) {
-        auto* gradient = gtl::FindOrNull(*gradients, node->long_name());
+      for (const auto& key : CollectParameterKeys()) {
+        auto* gradient = gtl::FindOrNull(*gradients, key);
         if (gradient) {
           *gradient *= ratio;
         }
@@ -913,6 +928,13 @@ void Node::CollectTunableParameters(
   CollectTunableParametersHelper(parameters);
 }
 
+string Node::ParameterKey(const string& parameter_name) const {
+  if (parameter_name == kParallelism || parameter_name == kBufferSize) {
+    return long_name();
+  }
+  return strings::StrCat(long_name(), ":", parameter_name);
+}
+
 string Node::DebugString() const {
   absl::flat_hash_map<string, string> debug_strings;
   tf_shared_lock l(mu_);
@@ -1138,6 +1160,18 @@ Node::NodeVector Node::CollectNodes(TraversalOrder order) const
   return node_vector;
 }
 
+std::vector<string> Node::CollectParameterKeys() const
+    TF_SHARED_LOCKS_REQUIRED(mu_) {
+  std::vector<string> keys;
+  for (const auto& node : CollectNodes(TraversalOrder::REVERSE_BFS)) {
+    tf_shared_lock l(node->mu_);
+    for (const auto& pair : node->parameters_) {
+      keys.push_back(node->ParameterKey(pair.first));
+    }
+  }
+  return keys;
+}
+
 void Node::CollectTunableParametersHelper(
     absl::flat_hash_map<string, std::shared_ptr<Parameter>>* parameters) const
     TF_SHARED_LOCKS_REQUIRED(mu_) {
@@ -1146,7 +1180,7 @@ void Node::CollectTunableParametersHelper(
   }
   for (auto& pair : parameters_) {
     if (pair.second->state->tunable) {
-      parameters->insert(std::make_pair(long_name(), pair.second));
+      parameters->insert(std::make_pair(ParameterKey(pair.first), pair.second));
     }
   }
 }
@@ -1213,14 +1247,7 @@ void Node::TotalBufferedBytesHelper(
     return;
   }
 
-  double result = 0;
-  auto* parameter = gtl::FindOrNull(parameters_, kBufferSize);
-  if (!parameter) {
-    parameter = gtl::FindOrNull(parameters_, kParallelism);
-  }
-  if (parameter) {
-    result = buffered_bytes_;
-  }
+  double result = buffered_bytes_;
   for (auto& input : inputs_) {
     result += total_bytes->at(input->long_name());
   }
@@ -1240,8 +1267,17 @@ void Node::TotalMaximumBufferedBytesHelper(
   if (!parameter) {
     parameter = gtl::FindOrNull(parameters_, kParallelism);
   }
-  if (parameter) {
+  auto* per_input_parameter = gtl::FindOrNull(parameters_, kPerInputBufferSize);
+  if (per_input_parameter) {
+    result = (*per_input_parameter)->value *
+             static_cast<double>(std::max<int64>(num_inputs() - 1, 0)) *
+             AverageBufferedElementSize();
+  } else if (parameter) {
     result = (*parameter)->value * AverageBufferedElementSize();
+  } else {
+    // The size of buffers that are not controlled by a tunable parameter (e.g.
+    // the buffer of `shuffle`) is fixed, so they contribute their current size.
+    result = buffered_bytes_;
   }
   for (auto& input : inputs_) {
     result += total_bytes->at(input->long_name());
@@ -1369,7 +1405,17 @@ void Model::OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
   double output_time = 0;
   double new_output_time;
   double new_value;
+  // Parameter values before the most recent step.
+  absl::flat_hash_map<string, double> previous_values;
   for (int i = 0; i < kMaxIterations; ++i) {
+    if (TotalMaximumBufferedBytes(snapshot) > ram_budget) {
+      // The worst-case total buffer size exceeds the memory budget, so we undo
+      // the most recent step and terminate.
+      for (auto& pair : previous_values) {
+        parameters[pair.first]->value = pair.second;
+      }
+      break;
+    }
     absl::flat_hash_map<string, double> gradients;
     new_output_time = OutputTime(snapshot, model_input_time, &gradients);
     int64 model_parallelism = 0;
@@ -1377,11 +1423,9 @@ void Model::OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
       model_parallelism += std::round(pair.second->value);
     }
     // We terminate once the improvement of the output latency is too small or
-    // the essential transformations' parallelism reaches the CPU budget or the
-    // worst-case total buffer size exceeds the memory budget.
+    // the essential transformations' parallelism reaches the CPU budget.
     if (std::abs(output_time - new_output_time) < kOptimizationPrecision ||
-        model_parallelism > cpu_budget ||
-        TotalMaximumBufferedBytes(snapshot) > ram_budget) {
+        model_parallelism > cpu_budget) {
       break;
     }
     double max_abs_derivative = 1.0;
@@ -1392,6 +1436,7 @@ void Model::OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
       }
     }
     for (auto& pair : parameters) {
+      previous_values[pair.first] = pair.second->value;
       new_value = pair.second->value -
                   kDescentStep * gradients[pair.first] / max_abs_derivative;
       // Projection on a feasible interval.
@@ -1447,27 +1492,42 @@ void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
         break;
       }
     }
-    if (output_time < processing_time / cpu_budget || all_max ||
-        TotalMaximumBufferedBytes(snapshot) > ram_budget) {
+    if (output_time < processing_time / cpu_budget || all_max) {
       break;
     }
     double best_delta = -1.0L;
     Parameter* best_parameter = nullptr;
+    bool ram_budget_exceeded = false;
     for (auto& pair : parameters) {
       if (pair.second->value == pair.second->max) {
         continue;
       }
       pair.second->value++;
+      // Increments that would make the worst-case total buffer size exceed the
+      // memory budget are not considered.
+      if (TotalMaximumBufferedBytes(snapshot) > ram_budget) {
+        ram_budget_exceeded = true;
+        pair.second->value--;
+        continue;
+      }
       double new_output_time =
           OutputTime(snapshot, model_input_time, /*gradients=*/nullptr);
       double delta = output_time - new_output_time;
+      bool is_buffer_size = pair.second->name == kBufferSize ||
+                            pair.second->name == kPerInputBufferSize;
       if (delta > best_delta &&
-          (delta > kBufferSizeMinDelta || pair.second->name != kBufferSize)) {
+          (delta > kBufferSizeMinDelta || !is_buffer_size)) {
         best_delta = delta;
         best_parameter = pair.second.get();
       }
       pair.second->value--;
     }
+    if (!best_parameter && ram_budget_exceeded) {
+      VLOG(2) << "Increasing any tunable parameter would exceed the memory "
+                 "budget of "
+              << ram_budget << " bytes.";
+      break;
+    }
     if (!best_parameter) {
       VLOG(2) << "Failed to find a tunable parameter that would decrease the "
                  "output time. This means that the autotuning optimization got "
@@ -41,6 +41,9 @@ namespace model {
 constexpr int64 kAutotune = -1;
 constexpr char kParallelism[] = "parallelism";
 constexpr char kBufferSize[] = "buffer_size";
+// The number of elements buffered for each input of an interleave
+// transformation.
+constexpr char kPerInputBufferSize[] = "per_input_buffer_size";
 
 // A key used to identify the input time of the model.
 constexpr char kModelInputTimeKey[] = "model_input_time";
@@ -236,6 +239,12 @@ class Node {
   // Returns the node name.
   const string& name() const { return name_; }
 
+  // Returns the key identifying the given parameter of this node in the maps
+  // of tunable parameters and gradients. The parallelism and buffer size
+  // parameters are identified by the node's long name; other parameters are
+  // identified by the long name suffixed with the parameter name.
+  string ParameterKey(const string& parameter_name) const;
+
   // Returns the number of elements produced by the node.
   int64 num_elements() const TF_LOCKS_EXCLUDED(mu_) {
     return num_elements_;
@@ -351,6 +360,8 @@ class Node {
   // Collects the total buffer limit of all nodes in the subtree for which
   // autotuning is enabled. This number represents the amount of memory that
   // would be used by the subtree nodes if all of their buffers were full.
+  // Buffers whose size is not controlled by a tunable parameter contribute
+  // their current size.
   double TotalMaximumBufferedBytes() const TF_LOCKS_EXCLUDED(mu_);
 
   // Returns the per-element CPU time spent in the subtree rooted in this node.
@@ -482,6 +493,12 @@ class Node {
   NodeVector CollectNodes(TraversalOrder order) const
       TF_SHARED_LOCKS_REQUIRED(mu_);
 
+  // Returns the keys identifying the parameters of the nodes of the subtree
+  // rooted in this node (see `ParameterKey`). The root node itself is not
+  // included.
+  std::vector<string> CollectParameterKeys() const
+      TF_SHARED_LOCKS_REQUIRED(mu_);
+
   // Collect tunable parameters for the node.
   void CollectTunableParametersHelper(
       absl::flat_hash_map<string, std::shared_ptr<Parameter>>* parameters) const
@@ -609,12 +626,23 @@ class Model {
   void FlushMetrics() TF_LOCKS_EXCLUDED(mu_);
 
   // Uses the given algorithm to perform the autotuning optimization.
+  //
+  // `ram_budget` is the number of bytes, in addition to the bytes currently
+  // buffered by the model, that the model's buffers may use. The optimization
+  // never selects parameter values whose worst-case total buffer size exceeds
+  // the budget; a negative budget makes the buffers shrink.
   void Optimize(AutotuneAlgorithm algorithm, int64 cpu_budget, int64 ram_budget,
                 double model_input_time) TF_LOCKS_EXCLUDED(mu_);
 
   // Removes the given node.
   void RemoveNode(std::shared_ptr<Node> node) TF_LOCKS_EXCLUDED(mu_);
 
+  // Returns the output node of the model, or null if the model has no nodes.
+  std::shared_ptr<Node> output() TF_LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    return output_;
+  }
+
  private:
   // Collects tunable parameters in the tree rooted in the given node, returning
   // a mapping from a (unique) node name to a tunable parameter.
@@ -635,9 +663,10 @@ class Model {
   // This optimization algorithm starts by setting all tunable parallelism
   // parameters to the minimum value. It then repeatedly identifies the
   // parameter whose increase in parallelism decreases the output time the most.
-  // This process is repeated until all parameters reach their maximum values or
+  // This process is repeated until all parameters reach their maximum values,
   // the projected output time is less than or equal to the processing time
-  // needed to produce an element divided by CPU budget.
+  // needed to produce an element divided by CPU budget, or no parameter can be
+  // increased without exceeding the memory budget.
   void OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
                          double model_input_time);
 
@@ -647,7 +676,8 @@ class Model {
   // projecting resulting values on the feasible intervals. Improvement step is
   // repeated until either the output time improvement is smaller than threshold
   // value or the output time is less than the processing time needed to produce
-  // an element divided by CPU budget.
+  // an element divided by CPU budget. A step that makes the worst-case total
+  // buffer size exceed the memory budget is undone and ends the optimization.
   void OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
                                double model_input_time);
 
@@ -430,13 +430,13 @@ TEST(SetterGetterTest, Node) {
   EXPECT_EQ(node->TotalMaximumBufferedBytes(), 0);
   node->record_buffer_event(42, 0);
   EXPECT_EQ(node->buffered_bytes(), 42);
-  EXPECT_EQ(node->TotalBufferedBytes(), 0);
-  EXPECT_EQ(node->TotalMaximumBufferedBytes(), 0);
+  EXPECT_EQ(node->TotalBufferedBytes(), 42);
+  EXPECT_EQ(node->TotalMaximumBufferedBytes(), 42);
   EXPECT_EQ(node->buffered_elements(), 0);
   node->record_buffer_event(0, 11);
   EXPECT_EQ(node->buffered_bytes(), 42);
-  EXPECT_EQ(node->TotalBufferedBytes(), 0);
-  EXPECT_EQ(node->TotalMaximumBufferedBytes(), 0);
+  EXPECT_EQ(node->TotalBufferedBytes(), 42);
+  EXPECT_EQ(node->TotalMaximumBufferedBytes(), 42);
   EXPECT_EQ(node->buffered_elements(), 11);
 
   EXPECT_EQ(node->processing_time(), 0);
@@ -455,8 +455,8 @@ TEST(SetterGetterTest, Node) {
   EXPECT_EQ(node->inputs().size(), 1);
   EXPECT_EQ(node->inputs().front(), input);
   input->record_buffer_event(13, 0);
-  EXPECT_EQ(node->TotalBufferedBytes(), 0);
-  EXPECT_EQ(node->TotalMaximumBufferedBytes(), 0);
+  EXPECT_EQ(node->TotalBufferedBytes(), 55);
+  EXPECT_EQ(node->TotalMaximumBufferedBytes(), 55);
   node->remove_input(input);
   EXPECT_EQ(node->inputs().size(), 0);
 
@@ -565,6 +565,84 @@ TEST(AsyncInterleaveManyGradientTest, Model) {
               kComparisonPrecision);
 }
 
+TEST(AsyncInterleaveManyPerInputBufferSizeGradientTest, Model) {
+  const double input_time = 100;
+  std::shared_ptr<Node> async_interleave_many =
+      model::MakeAsyncInterleaveManyNode(
+          {0, "async_interleave_many", nullptr},
+          {model::MakeParameter(
+               kParallelism,
+               std::make_shared<SharedState>(kAutotune, nullptr, nullptr), 1,
+               2),
+           model::MakeParameter(
+               kPerInputBufferSize,
+               std::make_shared<SharedState>(kAutotune, nullptr, nullptr), 1,
+               10)});
+  std::shared_ptr<Node> meta_source =
+      model::MakeSourceNode({1, "meta_source", async_interleave_many});
+  async_interleave_many->add_input(meta_source);
+  auto cleanup_meta = gtl::MakeCleanup([async_interleave_many, meta_source]() {
+    async_interleave_many->remove_input(meta_source);
+  });
+  std::shared_ptr<Node> source1 =
+      model::MakeSourceNode({2, "source1", async_interleave_many});
+  async_interleave_many->add_input(source1);
+  auto cleanup1 = gtl::MakeCleanup([async_interleave_many, source1]() {
+    async_interleave_many->remove_input(source1);
+  });
+  std::shared_ptr<Node> source2 =
+      model::MakeSourceNode({3, "source2", async_interleave_many});
+  async_interleave_many->add_input(source2);
+  auto cleanup2 = gtl::MakeCleanup([async_interleave_many, source2]() {
+    async_interleave_many->remove_input(source2);
+  });
+  absl::flat_hash_map<string, double> input_times;
+  input_times[kModelInputTimeKey] = input_time;
+  absl::flat_hash_map<string, std::shared_ptr<Parameter>> parameters;
+  async_interleave_many->CollectTunableParameters(&parameters);
+  const string parallelism_key =
+      async_interleave_many->ParameterKey(kParallelism);
+  const string buffer_size_key =
+      async_interleave_many->ParameterKey(kPerInputBufferSize);
+  EXPECT_EQ(parallelism_key, async_interleave_many->long_name());
+  EXPECT_NE(buffer_size_key, parallelism_key);
+  ASSERT_EQ(parameters.size(), 2);
+  ASSERT_TRUE(parameters.contains(parallelism_key));
+  ASSERT_TRUE(parameters.contains(buffer_size_key));
+  async_interleave_many->record_element();
+  async_interleave_many->add_processing_time(100);
+  source1->record_element();
+  source1->add_processing_time(100);
+  source2->record_element();
+  source2->add_processing_time(300);
+  parameters[parallelism_key]->value = 1;
+  parameters[buffer_size_key]->value = 1;
+
+  absl::flat_hash_map<string, double> gradients;
+  double output_time =
+      async_interleave_many->OutputTime(&input_times, &gradients);
+  parameters[buffer_size_key]->value += kParameterStep;
+  double new_output_time =
+      async_interleave_many->OutputTime(&input_times, nullptr);
+  EXPECT_NEAR(gradients[buffer_size_key],
+              (new_output_time - output_time) / kParameterStep,
+              kComparisonPrecision);
+  EXPECT_LE(new_output_time, output_time);
+
+  parameters[buffer_size_key]->value -= kParameterStep;
+  parameters[parallelism_key]->value += kParameterStep;
+  new_output_time = async_interleave_many->OutputTime(&input_times, nullptr);
+  EXPECT_NEAR(gradients[parallelism_key],
+              (new_output_time - output_time) / kParameterStep,
+              kComparisonPrecision);
+
+  // The maximum buffered bytes account for a buffer for each input.
+  parameters[parallelism_key]->value = 1;
+  parameters[buffer_size_key]->value = 3;
+  async_interleave_many->record_buffer_event(100, 10);
+  EXPECT_EQ(async_interleave_many->TotalMaximumBufferedBytes(), 3 * 2 * 10);
+}
+
 class AsyncKnownRatioGradientTest : public ::testing::TestWithParam<string> {};
 
 TEST_P(AsyncKnownRatioGradientTest, Model) {
@@ -791,6 +869,59 @@ TEST(SnapshotTest, Model) {
   }
 }
 
+class OptimizeRamBudgetTest
+    : public ::testing::TestWithParam<std::tuple<AutotuneAlgorithm, int64>> {};
+
+TEST_P(OptimizeRamBudgetTest, Model) {
+  const AutotuneAlgorithm algorithm = std::get<0>(GetParam());
+  const int64 ram_budget = std::get<1>(GetParam());
+  constexpr int64 kElementSize = 100;
+  Model model;
+  auto state = std::make_shared<SharedState>(
+      kAutotune, std::make_shared<mutex>(),
+      std::make_shared<condition_variable>());
+  std::shared_ptr<Node> parallel_map;
+  model.AddNode(
+      [state](Node::Args args) {
+        return MakeAsyncKnownRatioNode(
+            std::move(args), /*ratio=*/1,
+            {MakeParameter(kParallelism, state, /*min=*/1, /*max=*/100)});
+      },
+      "parallel_map", /*parent=*/nullptr, &parallel_map);
+  std::shared_ptr<Node> source;
+  model.AddNode([](Node::Args args) { return MakeSourceNode(std::move(args)); },
+                "source", parallel_map, &source);
+  std::shared_ptr<Node> shuffle_source;
+  model.AddNode(
+      [](Node::Args args) { return MakeKnownRatioNode(std::move(args), 1); },
+      "shuffle", parallel_map, &shuffle_source);
+  // A buffer that is not controlled by a tunable parameter.
+  shuffle_source->record_buffer_event(10 * kElementSize, 10);
+  parallel_map->record_buffer_event(kElementSize, 1);
+  for (int i = 0; i < 100; ++i) {
+    source->add_processing_time(10);
+    source->record_element();
+    parallel_map->add_processing_time(1000);
+    parallel_map->record_element();
+  }
+
+  model.Optimize(algorithm, /*cpu_budget=*/4, ram_budget,
+                 /*model_input_time=*/0);
+
+  // The total buffer size may grow by at most `ram_budget` bytes, and the
+  // parallelism is never set below its minimum.
+  const int64 max_buffer_size = std::max<int64>(
+      1, (ram_budget + kElementSize) / kElementSize);
+  EXPECT_GE(state->value, 1);
+  EXPECT_LE(state->value, max_buffer_size);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Test, OptimizeRamBudgetTest,
+    ::testing::Combine(::testing::Values(AutotuneAlgorithm::HILL_CLIMB,
+                                         AutotuneAlgorithm::GRADIENT_DESCENT),
+                       ::testing::Values(-1000, 0, 250, 1000)));
+
 class ComputeWaitTimeTest
     : public ::testing::TestWithParam<std::tuple<double, double, double>> {};
 
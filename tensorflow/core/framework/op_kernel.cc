@@ -367,6 +367,8 @@ Allocator* OpKernelContext::get_allocator(AllocatorAttributes attr) {
   if (TF_PREDICT_FALSE(attr.scope_id > 0)) {
     allocator = params_->device->GetScopedAllocator(attr, step_id());
     CHECK(allocator);
+  } else if (params_->planned_allocator != nullptr && attr.value == 0) {
+    allocator = params_->planned_allocator;
   } else {
     allocator = params_->device->GetAllocator(attr);
   }
@@ -709,11 +711,17 @@ Status OpKernelContext::allocate_tensor(
     DataType type, const TensorShape& shape, Tensor* out_tensor,
     AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
   Allocator* a = get_allocator(attr);
-  Tensor new_tensor(
-      a, type, shape,
-      AllocationAttributes(
-          /*retry_on_failure=*/allocation_attr.retry_on_failure,
-          /*allocation_will_be_logged=*/true, allocation_attr.freed_by_func));
+  AllocationAttributes logged_attr(
+      /*retry_on_failure=*/allocation_attr.retry_on_failure,
+      /*allocation_will_be_logged=*/true, allocation_attr.freed_by_func);
+  if (params_->planned_allocator != nullptr) {
+    // Identifies the tensor across steps by its node and by its rank among
+    // the allocations of the node.
+    logged_attr.plan_key =
+        (static_cast<int64>(params_->planned_node_id) << 32) |
+        num_planned_allocations_.fetch_add(1, std::memory_order_relaxed);
+  }
+  Tensor new_tensor(a, type, shape, logged_attr);
 
   if (!new_tensor.IsInitialized()) {
     return errors::ResourceExhausted(
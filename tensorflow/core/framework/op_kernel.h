@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_OP_KERNEL_H_
 #define TENSORFLOW_CORE_FRAMEWORK_OP_KERNEL_H_
 
+#include <atomic>
 #include <functional>
 #include <unordered_set>
 #include <utility>
@@ -633,6 +634,14 @@ class OpKernelContext {
     bool track_allocations = false;
     bool log_memory = false;
 
+    // If not null, the tensors that this op kernel invocation allocates with
+    // default allocator attributes are allocated from this allocator instead
+    // of the device allocator, with a plan key derived from `planned_node_id`.
+    // The executor uses it to serve the tensors of repeated steps from a
+    // static memory plan.
+    Allocator* planned_allocator = nullptr;
+    int planned_node_id = -1;
+
     // Array indexed by output number for this node
     const AllocatorAttributes* output_attr_array = nullptr;
 
@@ -1270,6 +1279,10 @@ class OpKernelContext {
  private:
   bool record_memory_consumption_ = false;
 
+  // The number of tensors allocated so far with a plan key, if
+  // `params_->planned_allocator` is set.
+  std::atomic<int32> num_planned_allocations_{0};
+
   // Internal common method used when allocating tensor memory
   Status allocate_tensor(DataType type, const TensorShape& shape,
                          Tensor* out_tensor,
@@ -18,6 +18,7 @@ limitations under the License.
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
@@ -124,8 +125,9 @@ FunctionDef* AddVectorizedFunction(const NodeDef& map_node,
   DCHECK_EQ(map_defun_node.op(), "MapDefun");
 
   FunctionDef* result;
+  vectorization_utils::VectorizationReport report;
   Status s = vectorization_utils::VectorizeMapDefun(
-      *vectorized_func, map_defun_node, library, &result);
+      *vectorized_func, map_defun_node, library, &result, &report);
 
   if (!s.ok()) {
     LOG(WARNING) << "VectorizeMapDefun failed. The function will only be "
@@ -133,6 +135,18 @@ FunctionDef* AddVectorizedFunction(const NodeDef& map_node,
                  << s;
     return vectorized_func;
   }
+  // Explain which ops of the map function are still computed element-wise by
+  // a MapDefun op, so that users can restructure their map functions.
+  if (!report.failures.empty()) {
+    VLOG(1) << "Map function " << orig_func.signature().name()
+            << " was only partially vectorized. " << report.DebugString();
+    for (const auto& failure : report.failures) {
+      metrics::RecordTFDataVectorizationFallback(failure.op_type);
+    }
+  } else {
+    VLOG(1) << "Map function " << orig_func.signature().name()
+            << " was fully vectorized. " << report.DebugString();
+  }
   return result;
 }
 
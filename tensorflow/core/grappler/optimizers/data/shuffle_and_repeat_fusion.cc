@@ -42,6 +42,17 @@ constexpr char kShuffleAndRepeatDatasetV2[] = "ShuffleAndRepeatDatasetV2";
 constexpr char kOutputShapes[] = "output_shapes";
 constexpr char kOutputTypes[] = "output_types";
 constexpr char kReshuffleEachIteration[] = "reshuffle_each_iteration";
+constexpr char kMaxBufferBytes[] = "max_buffer_bytes";
+constexpr char kSpillDirectory[] = "spill_directory";
+
+// Copies the (optional) shuffle buffer spilling attributes.
+void CopySpillAttributes(const NodeDef& shuffle_node, NodeDef* fused_node) {
+  for (auto key : {kMaxBufferBytes, kSpillDirectory}) {
+    if (shuffle_node.attr().count(key) > 0) {
+      graph_utils::CopyAttribute(key, shuffle_node, fused_node);
+    }
+  }
+}
 
 Status FuseShuffleV1AndRepeat(const NodeDef& shuffle_node,
                               const NodeDef& repeat_node,
@@ -71,6 +82,7 @@ Status FuseShuffleV1AndRepeat(const NodeDef& shuffle_node,
   for (auto key : {kOutputShapes, kOutputTypes, kReshuffleEachIteration}) {
     graph_utils::CopyAttribute(key, shuffle_node, fused_node);
   }
+  CopySpillAttributes(shuffle_node, fused_node);
 
   return Status::OK();
 }
@@ -145,6 +157,7 @@ Status FuseShuffleV3AndRepeat(const NodeDef& shuffle_node,
   for (auto key : {kOutputShapes, kOutputTypes, kReshuffleEachIteration}) {
     graph_utils::CopyAttribute(key, shuffle_node, fused_node);
   }
+  CopySpillAttributes(shuffle_node, fused_node);
 
   return Status::OK();
 }
@@ -164,6 +164,49 @@ class BinaryCwiseOpVectorizer : public Vectorizer {
   }
 };
 
+// Vectorizes `ClipByValue` as `Minimum(Maximum(t, clip_value_min),
+// clip_value_max)`. The clip values may have to be broadcast against the
+// stacked input, which `ClipByValue` does not support.
+class ClipByValueVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   VectorizerInput&& inputs,
+                   VectorizerOutput* outputs) override {
+    if (inputs.size() != 3) {
+      return errors::Internal("Failed to vectorize ", node.type_string(),
+                              ". The op should have 3 inputs, but has ",
+                              inputs.size());
+    }
+    DataType dtype;
+    TF_RETURN_IF_ERROR(GetNodeAttr(node.attrs(), "T", &dtype));
+
+    auto add_binary_op = [&node, outer_scope, dtype](
+                             const string& op_type, VectorizerInput&& inputs,
+                             Node** new_node) -> Status {
+      TF_RETURN_IF_ERROR(ExpandDimsForBroadcast(&inputs, outer_scope));
+      return NodeBuilder(
+                 strings::StrCat("vectorized/", node.name(), "/", op_type),
+                 op_type)
+          .Input(inputs.at(0).node, inputs.at(0).output_index)
+          .Input(inputs.at(1).node, inputs.at(1).output_index)
+          .Attr("T", dtype)
+          .Finalize(outer_scope, new_node);
+    };
+
+    Node* max_node;
+    TF_RETURN_IF_ERROR(add_binary_op(
+        "Maximum", VectorizerInput({inputs.at(0), inputs.at(1)}), &max_node));
+    Node* min_node;
+    TF_RETURN_IF_ERROR(add_binary_op(
+        "Minimum",
+        VectorizerInput({WrappedTensor(max_node, 0, true), inputs.at(2)}),
+        &min_node));
+
+    outputs->push_back({min_node, 0, true});
+    return Status::OK();
+  }
+};
+
 // Bitwise unary
 REGISTER_VECTORIZER("Invert", UnaryCwiseOpVectorizer);
 
@@ -194,15 +237,18 @@ REGISTER_VECTORIZER("Digamma", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Elu", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Erf", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Erfc", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("Erfinv", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Exp", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Expm1", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Floor", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Inv", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("IsFinite", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("IsInf", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("IsNan", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Lgamma", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Log", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Log1p", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("Ndtri", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Neg", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Reciprocal", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Relu", UnaryCwiseOpVectorizer);
@@ -222,9 +268,29 @@ REGISTER_VECTORIZER("Square", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Tanh", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Tan", UnaryCwiseOpVectorizer);
 
+// String unary
+REGISTER_VECTORIZER("AsString", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("DecodeBase64", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("EncodeBase64", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("StaticRegexFullMatch", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("StaticRegexReplace", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("StringLength", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("StringLower", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("StringStrip", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("StringToHashBucket", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("StringToHashBucketFast", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("StringToHashBucketStrong", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("StringToNumber", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("StringUpper", UnaryCwiseOpVectorizer);
+
 // Miscellaneous unary
+REGISTER_VECTORIZER("Bucketize", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Cast", UnaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Identity", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("OnesLike", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("Snapshot", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("StopGradient", UnaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("ZerosLike", UnaryCwiseOpVectorizer);
 
 // Bitwise binary
 REGISTER_VECTORIZER("BitwiseAnd", BinaryCwiseOpVectorizer);
@@ -258,6 +324,7 @@ REGISTER_VECTORIZER("Maximum", BinaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Minimum", BinaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Mod", BinaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Mul", BinaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("MulNoNan", BinaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("NotEqual", BinaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Polygamma", BinaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Pow", BinaryCwiseOpVectorizer);
@@ -266,7 +333,13 @@ REGISTER_VECTORIZER("SquaredDifference", BinaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Sub", BinaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("TruncateDiv", BinaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("TruncateMod", BinaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("Xdivy", BinaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("Xlog1py", BinaryCwiseOpVectorizer);
+REGISTER_VECTORIZER("Xlogy", BinaryCwiseOpVectorizer);
 REGISTER_VECTORIZER("Zeta", BinaryCwiseOpVectorizer);
+
+// Ternary
+REGISTER_VECTORIZER("ClipByValue", ClipByValueVectorizer);
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -0,0 +1,63 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Vectorizes `DecodeRaw` and `DecodePaddedRaw`. Both ops decode every string
+// of their (arbitrarily shaped) input independently, appending a dimension
+// for the decoded values, so the vectorized op is the same as the original.
+// Note that the vectorized op requires all strings in a batch to decode to the
+// same number of values, which batching the original outputs requires too.
+class DecodeRawVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   VectorizerInput&& inputs,
+                   VectorizerOutput* outputs) override {
+    NodeBuilder::NodeOut bytes;
+    TF_RETURN_IF_ERROR(inputs.stacked(0, &bytes));
+
+    auto node_builder = NodeBuilder(strings::StrCat("vectorized/", node.name()),
+                                    node.type_string())
+                            .Input(bytes);
+    for (int i = 1; i < inputs.size(); ++i) {
+      // `DecodePaddedRaw` has a `fixed_length` input, which must be the same
+      // for all slices.
+      NodeBuilder::NodeOut input;
+      TF_RETURN_IF_ERROR(inputs.unstacked(i, &input));
+      node_builder = node_builder.Input(input);
+    }
+    for (const auto& attr_slice : node.attrs()) {
+      node_builder = node_builder.Attr(attr_slice.first, attr_slice.second);
+    }
+    Node* new_node;
+    TF_RETURN_IF_ERROR(node_builder.Finalize(outer_scope, &new_node));
+
+    // Add output mappings.
+    outputs->push_back({new_node, 0, true});
+    return Status::OK();
+  }
+};
+
+REGISTER_VECTORIZER("DecodePaddedRaw", DecodeRawVectorizer);
+REGISTER_VECTORIZER("DecodeRaw", DecodeRawVectorizer);
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,63 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Vectorizes image ops that operate on the innermost dimensions of their
+// `images` input and accept any number of leading (batch) dimensions. The
+// vectorized op is the same as the original, as long as all inputs other than
+// `images` (e.g. the adjustment factor) are the same for all slices.
+class ImageOpVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   VectorizerInput&& inputs,
+                   VectorizerOutput* outputs) override {
+    NodeBuilder::NodeOut images;
+    TF_RETURN_IF_ERROR(inputs.stacked(0, &images));
+
+    auto node_builder = NodeBuilder(strings::StrCat("vectorized/", node.name()),
+                                    node.type_string())
+                            .Input(images);
+    for (int i = 1; i < inputs.size(); ++i) {
+      NodeBuilder::NodeOut input;
+      TF_RETURN_IF_ERROR(inputs.unstacked(i, &input));
+      node_builder = node_builder.Input(input);
+    }
+    for (const auto& attr_slice : node.attrs()) {
+      node_builder = node_builder.Attr(attr_slice.first, attr_slice.second);
+    }
+    Node* new_node;
+    TF_RETURN_IF_ERROR(node_builder.Finalize(outer_scope, &new_node));
+
+    // Add output mappings.
+    outputs->push_back({new_node, 0, true});
+    return Status::OK();
+  }
+};
+
+REGISTER_VECTORIZER("AdjustContrastv2", ImageOpVectorizer);
+REGISTER_VECTORIZER("AdjustHue", ImageOpVectorizer);
+REGISTER_VECTORIZER("AdjustSaturation", ImageOpVectorizer);
+REGISTER_VECTORIZER("HSVToRGB", ImageOpVectorizer);
+REGISTER_VECTORIZER("RGBToHSV", ImageOpVectorizer);
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,58 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Vectorizes table lookups. The output of `LookupTableFindV2` has the shape of
+// `keys` followed by the shape of the table values, so looking up stacked keys
+// produces the stacked values, as long as the table and the default value are
+// the same for all slices.
+class LookupTableFindVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   VectorizerInput&& inputs,
+                   VectorizerOutput* outputs) override {
+    NodeBuilder::NodeOut table_handle, keys, default_value;
+    TF_RETURN_IF_ERROR(inputs.unstacked(0, &table_handle));
+    TF_RETURN_IF_ERROR(inputs.stacked(1, &keys));
+    TF_RETURN_IF_ERROR(inputs.unstacked(2, &default_value));
+
+    auto node_builder = NodeBuilder(strings::StrCat("vectorized/", node.name()),
+                                    node.type_string())
+                            .Input(table_handle)
+                            .Input(keys)
+                            .Input(default_value);
+    for (const auto& attr_slice : node.attrs()) {
+      node_builder = node_builder.Attr(attr_slice.first, attr_slice.second);
+    }
+    Node* new_node;
+    TF_RETURN_IF_ERROR(node_builder.Finalize(outer_scope, &new_node));
+
+    // Add output mappings.
+    outputs->push_back({new_node, 0, true});
+    return Status::OK();
+  }
+};
+
+REGISTER_VECTORIZER("LookupTableFindV2", LookupTableFindVectorizer);
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,80 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/framework/scope_internal.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+constexpr char kReductionPrefix[] = "vectorized/reduction";
+
+// Vectorizes reductions whose reduction indices are unstacked. The vectorized
+// reduction is the original one applied to the stacked input, with the
+// non-negative reduction indices incremented by 1 to skip the leading
+// dimension. Negative indices count from the last dimension and are unchanged.
+class ReductionVectorizer : public Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   VectorizerInput&& inputs,
+                   VectorizerOutput* outputs) override {
+    Status status;
+    Scope parent = NewInternalScope(outer_scope, &status, /*refiner=*/nullptr);
+    Scope scope = parent.NewSubScope(kReductionPrefix);
+
+    Output input, axis;
+    TF_RETURN_IF_ERROR(inputs.stacked(0, &input));
+    TF_RETURN_IF_ERROR(inputs.unstacked(1, &axis));
+
+    // axis = tf.where(axis >= 0, axis + 1, axis)
+    Output vectorized_axis = ops::SelectV2(
+        scope, ops::GreaterEqual(scope, axis, ops::ZerosLike(scope, axis)),
+        ops::Add(scope, axis, ops::OnesLike(scope, axis)), axis);
+    TF_RETURN_IF_ERROR(status);
+
+    Node* new_node;
+    auto node_builder = NodeBuilder(strings::StrCat("vectorized/", node.name()),
+                                    node.type_string())
+                            .Input(input.node(), input.index())
+                            .Input(vectorized_axis.node(),
+                                   vectorized_axis.index());
+    for (const auto& attr_slice : node.attrs()) {
+      node_builder = node_builder.Attr(attr_slice.first, attr_slice.second);
+    }
+    TF_RETURN_IF_ERROR(node_builder.Finalize(outer_scope, &new_node));
+
+    // Add output mappings.
+    outputs->push_back({new_node, 0, true});
+    return Status::OK();
+  }
+};
+
+REGISTER_VECTORIZER("All", ReductionVectorizer);
+REGISTER_VECTORIZER("Any", ReductionVectorizer);
+REGISTER_VECTORIZER("Max", ReductionVectorizer);
+REGISTER_VECTORIZER("Mean", ReductionVectorizer);
+REGISTER_VECTORIZER("Min", ReductionVectorizer);
+REGISTER_VECTORIZER("Prod", ReductionVectorizer);
+REGISTER_VECTORIZER("Sum", ReductionVectorizer);
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
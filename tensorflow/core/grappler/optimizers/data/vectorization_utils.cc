@@ -133,8 +133,9 @@ void RemoveMapDefunOutput(int output_position, Graph* outer_scope,
 // TODO(rachelim): Move this to its own header.
 class Vectorization {
  public:
-  explicit Vectorization(FunctionDefLibrary* lib)
-      : lib_(lib), lib_def_(OpRegistry::Global(), *lib) {}
+  // `report` may be null.
+  Vectorization(FunctionDefLibrary* lib, VectorizationReport* report)
+      : lib_(lib), lib_def_(OpRegistry::Global(), *lib), report_(report) {}
 
   // Adds the vectorized function and new map_defun_fn to lib, and points
   // vectorized_function to the former. Returns an error status if
@@ -212,6 +213,7 @@ class Vectorization {
 
   FunctionDefLibrary* lib_;  // Not owned
   FunctionLibraryDefinition lib_def_;
+  VectorizationReport* report_;  // Not owned
   // Note that FunctionBody has a pointer to a Graph object that corresponds
   // to the function's subgraph, with additional kArgOp and kRetValOp nodes
   // that denote that function arguments and return values. These nodes have the
@@ -348,12 +350,30 @@ void Vectorization::VectorizeHelper() {
     // No outputs left to convert
     if (output_position == -1) break;
 
+    Node* output_node = map_defun_fn_->ret_nodes.at(output_position);
+    // The op producing the output, which is the one that failed to convert.
+    const Edge* ret_edge = nullptr;
+    output_node->input_edge(0, &ret_edge).IgnoreError();
+
     Status s = ConvertOutput(output_position);
     if (!s.ok()) {
-      Node* output_node = map_defun_fn_->ret_nodes.at(output_position);
       VLOG(2) << "Could not convert the output at node: "
               << output_node->DebugString() << "\nError: " << s;
       unconvertible_.insert(output_node);
+      if (report_ != nullptr) {
+        VectorizationReport::Failure failure;
+        if (ret_edge != nullptr) {
+          failure.node_name = ret_edge->src()->name();
+          failure.op_type = ret_edge->src()->type_string();
+        } else {
+          failure.node_name = output_node->name();
+          failure.op_type = output_node->type_string();
+        }
+        failure.reason = s.error_message();
+        report_->failures.push_back(std::move(failure));
+      }
+    } else if (report_ != nullptr) {
+      ++report_->num_vectorized;
     }
   }
 
@@ -633,11 +653,30 @@ Status Vectorization::GetResult(FunctionDef** vectorized_function) {
 
 }  // namespace
 
+std::string VectorizationReport::DebugString() const {
+  std::string result = strings::StrCat(
+      "Vectorized ", num_vectorized, " of ", num_vectorized + failures.size(),
+      " MapDefun function outputs.");
+  for (const Failure& failure : failures) {
+    strings::StrAppend(&result, "\n  ", failure.op_type, " (", failure.node_name,
+                       "): ", failure.reason);
+  }
+  return result;
+}
+
 Status VectorizeMapDefun(const FunctionDef& outer_scope,
                          const NodeDef& map_defun_node, FunctionDefLibrary* lib,
                          FunctionDef** result) {
+  return VectorizeMapDefun(outer_scope, map_defun_node, lib, result,
+                           /*report=*/nullptr);
+}
+
+Status VectorizeMapDefun(const FunctionDef& outer_scope,
+                         const NodeDef& map_defun_node, FunctionDefLibrary* lib,
+                         FunctionDef** result, VectorizationReport* report) {
   *result = nullptr;
-  return Vectorization(lib).Vectorize(outer_scope, map_defun_node, result);
+  return Vectorization(lib, report).Vectorize(outer_scope, map_defun_node,
+                                              result);
 }
 
 }  // namespace vectorization_utils
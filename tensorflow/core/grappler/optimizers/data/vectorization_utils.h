@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DATA_VECTORIZATION_UTILS_H_
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DATA_VECTORIZATION_UTILS_H_
 
+#include <string>
+#include <vector>
+
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -24,6 +27,27 @@ namespace tensorflow {
 namespace grappler {
 namespace vectorization_utils {
 
+// Describes how much of a MapDefun function `VectorizeMapDefun` was able to
+// vectorize, and why the remaining outputs were left in the MapDefun function.
+struct VectorizationReport {
+  struct Failure {
+    // Name and type of the op in the MapDefun function producing the output.
+    std::string node_name;
+    std::string op_type;
+    // Why the op could not be vectorized.
+    std::string reason;
+  };
+
+  // Number of MapDefun function outputs that were vectorized. This includes
+  // intermediate tensors that became outputs while vectorizing their consumers.
+  int num_vectorized = 0;
+  // One entry for each output that could not be vectorized.
+  std::vector<Failure> failures;
+
+  // Returns a human-readable, one line per op, summary of the report.
+  std::string DebugString() const;
+};
+
 // Given a MapDefun node (`map_defun_node`) in a FunctionDef (`outer_scope`)
 // that maps a function in lib across some input vector elements,
 // `VectorizeMapDefun` attempts to create a vectorized version of `outer_scope`
@@ -90,6 +114,12 @@ Status VectorizeMapDefun(const FunctionDef& outer_scope,
                          const NodeDef& map_defun_node, FunctionDefLibrary* lib,
                          FunctionDef** result);
 
+// Like above, but additionally fills in `report` (if not null) with the ops
+// that could not be vectorized and why.
+Status VectorizeMapDefun(const FunctionDef& outer_scope,
+                         const NodeDef& map_defun_node, FunctionDefLibrary* lib,
+                         FunctionDef** result, VectorizationReport* report);
+
 }  // namespace vectorization_utils
 }  // namespace grappler
 }  // namespace tensorflow
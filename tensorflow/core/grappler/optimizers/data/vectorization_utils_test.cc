@@ -20,6 +20,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/strings/match.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph_to_functiondef.h"
@@ -94,7 +95,8 @@ Status WrapFunctionWithMapDefun(const FunctionDef& inner, FunctionDef* result) {
 // Wraps the function `fn` in another function with a MapDefun node, then
 // vectorizes the wrapper function with VectorizeMapDefun.
 Status WrapAndVectorize(const FunctionDef& fn, FunctionDefLibrary* lib,
-                        FunctionDef** result) {
+                        FunctionDef** result,
+                        VectorizationReport* report = nullptr) {
   FunctionDef outer;
   TF_RETURN_IF_ERROR(WrapFunctionWithMapDefun(fn, &outer));
   const NodeDef& map_defun_node = outer.node_def(0);
@@ -102,7 +104,8 @@ Status WrapAndVectorize(const FunctionDef& fn, FunctionDefLibrary* lib,
   *lib->add_function() = outer;
   *lib->add_function() = fn;
 
-  TF_RETURN_IF_ERROR(VectorizeMapDefun(outer, map_defun_node, lib, result));
+  TF_RETURN_IF_ERROR(
+      VectorizeMapDefun(outer, map_defun_node, lib, result, report));
 
   return Status::OK();
 }
@@ -264,6 +267,32 @@ TEST(VectorizeMapDefunTest, VectorizeWithUnvectorizableOp) {
       lib_def.Find(map_defun_node.attr().at("f").func().name());
   EXPECT_EQ(map_defun_fn->signature().output_arg_size(), 1);
 }
+
+TEST(VectorizeMapDefunTest, ReportsUnvectorizableOp) {
+  FunctionDef inner = FunctionDefHelper::Create(
+      /*function_name=*/"inner_function",
+      /*in_def=*/{"arg0: int32", "arg1: int32"},
+      /*out_def=*/{"ret0: int32", "ret1: int32"},
+      /*attr_def=*/{},
+      /*node_def=*/
+      {{{"MatMul"}, "MatMul", {"arg0", "arg0"}, {{"T", DT_INT32}}},
+       Cast("Cast", {"arg1"}, DT_INT32, DT_INT32)},  //
+      /*ret_def=*/{{"ret0", "MatMul:product:0"}, {"ret1", "Cast:y:0"}});
+
+  FunctionDefLibrary lib;
+  FunctionDef* vectorized;
+  VectorizationReport report;
+  TF_ASSERT_OK(WrapAndVectorize(inner, &lib, &vectorized, &report));
+
+  EXPECT_EQ(report.num_vectorized, 1);
+  ASSERT_EQ(report.failures.size(), 1);
+  EXPECT_EQ(report.failures[0].node_name, "MatMul");
+  EXPECT_EQ(report.failures[0].op_type, "MatMul");
+  EXPECT_TRUE(absl::StrContains(report.failures[0].reason,
+                                "No vectorizer registered for op: MatMul"));
+  EXPECT_TRUE(absl::StrContains(report.DebugString(), "MatMul (MatMul)"));
+}
+
 // Before:
 //
 //                 +------+
@@ -15,16 +15,21 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/batch_dataset_op.h"
 
 #include <algorithm>
+#include <map>
 #include <utility>
 
+#include "tensorflow/core/common_runtime/pool_allocator.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/dataset_utils.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/util/batch_util.h"
 
@@ -39,16 +44,42 @@ namespace data {
 /* static */ constexpr const char* const BatchDatasetOp::kBatchSize;
 /* static */ constexpr const char* const BatchDatasetOp::kDropRemainder;
 /* static */ constexpr const char* const BatchDatasetOp::kParallelCopy;
+/* static */ constexpr const char* const BatchDatasetOp::kPreallocateOutput;
 /* static */ constexpr const char* const BatchDatasetOp::kOutputTypes;
 /* static */ constexpr const char* const BatchDatasetOp::kOutputShapes;
 
 constexpr char kInputImplEmpty[] = "input_impl_empty";
 constexpr char kBatchDataset[] = "BatchDataset";
 
+// Maximum number of released batch buffers kept for reuse by datasets with
+// `preallocate_output` set.
+constexpr size_t kBatchBufferPoolSize = 8;
+
+// Returns the allocator for pre-allocated batches. The buffers of batches
+// released by the consumer are kept in a process-wide pool and handed out
+// again for the next batch of the same size, so that steady-state batching
+// reuses memory that is already mapped instead of faulting in fresh pages for
+// every step. There is a separate pool for each NUMA node, whose buffers are
+// local to the node.
+Allocator* BatchBufferAllocator(int numa_node) {
+  static mutex* mu = new mutex;
+  static auto* allocators = new std::map<int, Allocator*>;
+  mutex_lock l(*mu);
+  Allocator*& allocator = (*allocators)[numa_node];
+  if (allocator == nullptr) {
+    allocator = new PoolAllocator(
+        kBatchBufferPoolSize, /*auto_resize=*/false,
+        new BasicCPUAllocator(numa_node, {}, {}), new NoopRounder,
+        strings::StrCat("tf_data_batch_buffer_pool_", numa_node));
+  }
+  return allocator;
+}
+
 class BatchDatasetOp::Dataset : public DatasetBase {
  public:
   Dataset(OpKernelContext* ctx, int64 batch_size, bool drop_remainder,
-          bool parallel_copy, const DatasetBase* input, int op_version)
+          bool parallel_copy, bool preallocate_output,
+          const DatasetBase* input, int op_version)
       : DatasetBase(DatasetContext(ctx)),
         batch_size_(batch_size),
         // Dataset batch is sometimes used to stack all elements in the
@@ -59,13 +90,18 @@ class BatchDatasetOp::Dataset : public DatasetBase {
                                      : std::min<int64>(batch_size, 1 << 16)),
         drop_remainder_(drop_remainder),
         parallel_copy_(parallel_copy),
+        // Pre-allocating the batch is only possible if `reserve_size_` did
+        // not have to be limited.
+        preallocate_output_(preallocate_output &&
+                            reserve_size_ == batch_size_),
         input_(input),
         op_version_(op_version),
         traceme_metadata_(
             {{"batch_size",
               strings::Printf("%lld", static_cast<long long>(batch_size))},
              {"drop_remainder", drop_remainder ? "true" : "false"},
-             {"parallel_copy", parallel_copy ? "true" : "false"}}) {
+             {"parallel_copy", parallel_copy ? "true" : "false"},
+             {"preallocate_output", preallocate_output ? "true" : "false"}}) {
     input_->Ref();
 
     // NOTE(mrry): Currently we implement "batch up to" semantics. If
@@ -133,9 +169,17 @@ class BatchDatasetOp::Dataset : public DatasetBase {
     TF_RETURN_IF_ERROR(b->AddScalar(drop_remainder_, &drop_remainder));
     AttrValue parallel_copy;
     b->BuildAttrValue(parallel_copy_, &parallel_copy);
-    TF_RETURN_IF_ERROR(
-        b->AddDataset(this, {input_graph_node, batch_size, drop_remainder},
-                      {{kParallelCopy, parallel_copy}}, output));
+    std::vector<std::pair<StringPiece, AttrValue>> attrs = {
+        {kParallelCopy, parallel_copy}};
+    // Only added when set, so that the graphs of other batch datasets remain
+    // readable by binaries that predate the attr.
+    if (preallocate_output_) {
+      AttrValue preallocate_output;
+      b->BuildAttrValue(preallocate_output_, &preallocate_output);
+      attrs.emplace_back(kPreallocateOutput, preallocate_output);
+    }
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this, {input_graph_node, batch_size, drop_remainder}, attrs, output));
     return Status::OK();
   }
 
@@ -146,12 +190,18 @@ class BatchDatasetOp::Dataset : public DatasetBase {
         : DatasetIterator<Dataset>(params) {}
 
     Status Initialize(IteratorContext* ctx) override {
+      if (ctx->flr() != nullptr) {
+        numa_node_ = GetNUMANode(ctx->flr()->device());
+      }
       return dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_);
     }
 
     Status GetNextInternal(IteratorContext* ctx,
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
+      if (dataset()->preallocate_output_) {
+        return GetNextPreallocated(ctx, out_tensors, end_of_sequence);
+      }
       // Each row of `batch_elements` is a tuple of tensors from the
       // input iterator.
       std::vector<std::vector<Tensor>> batch_elements;
@@ -292,14 +342,98 @@ class BatchDatasetOp::Dataset : public DatasetBase {
     }
 
    private:
+    // Allocates the batch for all `batch_size` elements as soon as the first
+    // element is available, and copies every element into its slice as it is
+    // produced. Each element is released right after it has been copied,
+    // while it is still hot in cache, rather than after the whole batch has
+    // been collected; the batch buffers come from `BatchBufferAllocator()`,
+    // local to the NUMA node of the input pipeline.
+    Status GetNextPreallocated(IteratorContext* ctx,
+                               std::vector<Tensor>* out_tensors,
+                               bool* end_of_sequence) {
+      mutex_lock l(mu_);
+      if (!input_impl_) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      std::vector<Tensor> batch;
+      std::vector<TensorShape> element_shapes;
+      int64 num_batch_elements = 0;
+      *end_of_sequence = false;
+      while (num_batch_elements < dataset()->batch_size_) {
+        std::vector<Tensor> element;
+        TF_RETURN_IF_ERROR(
+            input_impl_->GetNext(ctx, &element, end_of_sequence));
+        if (*end_of_sequence) {
+          input_impl_.reset();
+          break;
+        }
+        if (num_batch_elements == 0) {
+          batch.reserve(element.size());
+          element_shapes.reserve(element.size());
+          for (size_t component_index = 0; component_index < element.size();
+               ++component_index) {
+            const Tensor& component = element[component_index];
+            TensorShape batch_component_shape({dataset()->batch_size_});
+            batch_component_shape.AppendShape(component.shape());
+            batch.emplace_back(BatchBufferAllocator(numa_node_),
+                               component.dtype(),
+                               batch_component_shape);
+            if (!batch.back().IsInitialized()) {
+              return errors::ResourceExhausted(
+                  "Failed to allocate memory for the batch of component ",
+                  component_index);
+            }
+            element_shapes.push_back(component.shape());
+          }
+        }
+        for (size_t component_index = 0; component_index < element.size();
+             ++component_index) {
+          if (element[component_index].shape() !=
+              element_shapes[component_index]) {
+            return errors::InvalidArgument(
+                "Cannot batch tensors with different shapes in component ",
+                component_index, ". First element had shape ",
+                element_shapes[component_index].DebugString(), " and element ",
+                num_batch_elements, " had shape ",
+                element[component_index].shape().DebugString(), ".");
+          }
+          TF_RETURN_IF_ERROR(batch_util::CopyElementToSlice(
+              std::move(element[component_index]), &batch[component_index],
+              num_batch_elements));
+        }
+        ++num_batch_elements;
+      }
+
+      if (num_batch_elements == 0) {
+        DCHECK(*end_of_sequence);
+        return Status::OK();
+      }
+      if (num_batch_elements < dataset()->batch_size_) {
+        if (dataset()->drop_remainder_) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        // The leading slices of the batch share its (aligned) buffer.
+        for (Tensor& batch_component : batch) {
+          batch_component = batch_component.Slice(0, num_batch_elements);
+        }
+      }
+      *out_tensors = std::move(batch);
+      *end_of_sequence = false;
+      return Status::OK();
+    }
+
     mutex mu_;
     std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
+    int numa_node_ = port::kNUMANoAffinity;
   };
 
   const int64 batch_size_;
   const int64 reserve_size_;
   const bool drop_remainder_;
   const bool parallel_copy_;
+  const bool preallocate_output_;
   const DatasetBase* const input_;
   const int op_version_;
   std::vector<PartialTensorShape> output_shapes_;
@@ -312,6 +446,10 @@ BatchDatasetOp::BatchDatasetOp(OpKernelConstruction* ctx)
   if (ctx->HasAttr(kParallelCopy)) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr(kParallelCopy, &parallel_copy_));
   }
+  if (ctx->HasAttr(kPreallocateOutput)) {
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr(kPreallocateOutput, &preallocate_output_));
+  }
 }
 
 void BatchDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
@@ -327,8 +465,8 @@ void BatchDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
         ctx, ParseScalarArgument<bool>(ctx, kDropRemainder, &drop_remainder));
   }
 
-  *output = new Dataset(ctx, batch_size, drop_remainder, parallel_copy_, input,
-                        op_version_);
+  *output = new Dataset(ctx, batch_size, drop_remainder, parallel_copy_,
+                        preallocate_output_, input, op_version_);
 }
 
 namespace {
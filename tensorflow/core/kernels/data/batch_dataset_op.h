@@ -27,6 +27,7 @@ class BatchDatasetOp : public UnaryDatasetOpKernel {
   static constexpr const char* const kBatchSize = "batch_size";
   static constexpr const char* const kDropRemainder = "drop_remainder";
   static constexpr const char* const kParallelCopy = "parallel_copy";
+  static constexpr const char* const kPreallocateOutput = "preallocate_output";
   static constexpr const char* const kOutputTypes = "output_types";
   static constexpr const char* const kOutputShapes = "output_shapes";
 
@@ -40,6 +41,7 @@ class BatchDatasetOp : public UnaryDatasetOpKernel {
   class Dataset;
   const int op_version_;
   bool parallel_copy_ = false;
+  bool preallocate_output_ = false;
 };
 
 }  // namespace data
@@ -105,7 +105,35 @@ BatchDatasetParams BatchDatasetParams7() {
                             /*node_name=*/kNodeName);
 }
 
-// Test Case 8: test BatchDatasetV2 with an invalid batch size
+// Test Case 8: test BatchDatasetV2 with `preallocate_output` = true,
+// `drop_remainder` = false and a batch size that can not evenly split the
+// input dataset.
+BatchDatasetParams BatchDatasetParams8() {
+  return BatchDatasetParams(RangeDatasetParams(0, 10, 1),
+                            /*batch_size=*/3,
+                            /*drop_remainder=*/false,
+                            /*parallel_copy=*/false,
+                            /*output_dtypes=*/{DT_INT64},
+                            /*output_shapes=*/{PartialTensorShape({-1})},
+                            /*node_name=*/kNodeName,
+                            /*preallocate_output=*/true);
+}
+
+// Test Case 9: test BatchDatasetV2 with `preallocate_output` = true,
+// `drop_remainder` = true and a batch size that can not evenly split the
+// input dataset.
+BatchDatasetParams BatchDatasetParams9() {
+  return BatchDatasetParams(RangeDatasetParams(0, 10, 1),
+                            /*batch_size=*/3,
+                            /*drop_remainder=*/true,
+                            /*parallel_copy=*/false,
+                            /*output_dtypes=*/{DT_INT64},
+                            /*output_shapes=*/{PartialTensorShape({3})},
+                            /*node_name=*/kNodeName,
+                            /*preallocate_output=*/true);
+}
+
+// Test Case 10: test BatchDatasetV2 with an invalid batch size
 BatchDatasetParams InvalidBatchSizeBatchDatasetParams() {
   return BatchDatasetParams(RangeDatasetParams(0, 10, 1),
                             /*batch_size=*/-1,
@@ -143,7 +171,17 @@ std::vector<GetNextTestCase<BatchDatasetParams>> GetNextTestCases() {
                                 {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}})},
 
           {/*dataset_params=*/BatchDatasetParams7(),
-           /*expected_outputs=*/{}}};
+           /*expected_outputs=*/{}},
+          {/*dataset_params=*/BatchDatasetParams8(),
+           /*expected_outputs=*/
+           {CreateTensor<int64>(TensorShape({3}), {0, 1, 2}),
+            CreateTensor<int64>(TensorShape({3}), {3, 4, 5}),
+            CreateTensor<int64>(TensorShape({3}), {6, 7, 8}),
+            CreateTensor<int64>(TensorShape({1}), {9})}},
+          {/*dataset_params=*/BatchDatasetParams9(),
+           /*expected_outputs=*/
+           CreateTensors<int64>(TensorShape({3}),
+                                {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}})}};
 }
 
 ITERATOR_GET_NEXT_TEST_P(BatchDatasetOpTest, BatchDatasetParams,
@@ -277,7 +315,19 @@ IteratorSaveAndRestoreTestCases() {
                                 {0, 1, 2, 3, 4, 5, 6, 7, 8, 9})}},
           {/*dataset_params=*/BatchDatasetParams7(),
            /*breakpoints=*/{0, 1, 5},
-           /*expected_outputs=*/{}}};
+           /*expected_outputs=*/{}},
+          {/*dataset_params=*/BatchDatasetParams8(),
+           /*breakpoints=*/{0, 1, 5},
+           /*expected_outputs=*/
+           {CreateTensor<int64>(TensorShape({3}), {0, 1, 2}),
+            CreateTensor<int64>(TensorShape({3}), {3, 4, 5}),
+            CreateTensor<int64>(TensorShape({3}), {6, 7, 8}),
+            CreateTensor<int64>(TensorShape({1}), {9})}},
+          {/*dataset_params=*/BatchDatasetParams9(),
+           /*breakpoints=*/{0, 1, 5},
+           /*expected_outputs=*/
+           CreateTensors<int64>(TensorShape({3}),
+                                {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}})}};
 }
 
 ITERATOR_SAVE_AND_RESTORE_TEST_P(BatchDatasetOpTest, BatchDatasetParams,
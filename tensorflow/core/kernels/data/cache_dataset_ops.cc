@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/cache_dataset_ops.h"
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -21,11 +22,18 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/dataset_utils.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/protobuf/tensor_bundle.pb.h"
+#include "tensorflow/core/util/tensor_bundle/naming.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
+#if !defined(IS_MOBILE_PLATFORM)
+#include "tensorflow/core/data/compressed_element_cache.h"
+#endif  // !IS_MOBILE_PLATFORM
+
 namespace tensorflow {
 namespace data {
 
@@ -37,6 +45,9 @@ namespace data {
 /* static */ constexpr const char* const CacheDatasetOp::kFileName;
 /* static */ constexpr const char* const CacheDatasetOp::kOutputTypes;
 /* static */ constexpr const char* const CacheDatasetOp::kOutputShapes;
+/* static */ constexpr const char* const CacheDatasetOp::kCompressInMemory;
+/* static */ constexpr const char* const CacheDatasetOp::kMaxMemoryBytes;
+/* static */ constexpr const char* const CacheDatasetOp::kSpillDirectory;
 
 constexpr char kKeyStrFormat[] = "%%%zuzu_%%%zuzu";
 constexpr char kPaddingSizeStrFormat[] = "%zu";
@@ -48,6 +59,7 @@ constexpr char kCurIndex[] = "cur_index";
 constexpr char kShardId[] = "shard_id";
 constexpr char kCreatedAt[] = "Created at";
 constexpr char kMemoryDatasetPrefix[] = "Memory";
+constexpr char kCompressedMemoryDatasetPrefix[] = "CompressedMemory";
 constexpr char kMemoryCache[] = "MemoryCache";
 constexpr char kCacheClaimed[] = "cache_claimed";
 constexpr char kCacheSize[] = "cache_size";
@@ -58,6 +70,167 @@ constexpr char kIndex[] = "index";
 constexpr char kImpl[] = "Impl";
 constexpr char kCacheDataset[] = "CacheDataset";
 
+// Returns the options used to write file caches. Tensor data is aligned so that
+// `MappedFileCache` can expose it as tensors without copying.
+BundleWriter::Options CacheWriterOptions() {
+  BundleWriter::Options options;
+  options.data_alignment = Allocator::kAllocatorAlignment;
+  return options;
+}
+
+// A tensor buffer that refers to a slice of a memory-mapped file and keeps the
+// mapping alive. The memory is read-only, so the buffer is never forwarded to
+// the outputs of kernels.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(const char* data, size_t size,
+                     std::shared_ptr<const ReadOnlyMemoryRegion> region)
+      : TensorBuffer(const_cast<char*>(data)),
+        size_(size),
+        region_(std::move(region)) {}
+
+  size_t size() const override { return size_; }
+
+  TensorBuffer* root_buffer() override { return this; }
+
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("mmap");
+  }
+
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const size_t size_;
+  const std::shared_ptr<const ReadOnlyMemoryRegion> region_;
+};
+
+// An index over a completed file cache whose data files are memory-mapped.
+// Elements can be read in any order, without system calls, and are returned as
+// tensors backed by the mapping whenever the data is suitably aligned.
+//
+// Only caches of memcpy-able tensors are supported.
+class MappedFileCache {
+ public:
+  // Builds the index of the cache with prefix `prefix`. Returns
+  // `Unimplemented` if the cache cannot be memory-mapped.
+  static Status Create(Env* env, const string& prefix, size_t num_tensors,
+                       std::unique_ptr<MappedFileCache>* cache) {
+    BundleReader reader(env, prefix);
+    TF_RETURN_IF_ERROR(reader.status());
+    // The reader is positioned at the header entry.
+    BundleHeaderProto header;
+    if (!header.ParseFromArray(reader.value().data(), reader.value().size())) {
+      return errors::DataLoss("Unable to parse the header of cache ", prefix);
+    }
+    std::vector<BundleEntryProto> entries;
+    for (reader.Next(); reader.Valid(); reader.Next()) {
+      entries.emplace_back();
+      BundleEntryProto& entry = entries.back();
+      if (!entry.ParseFromArray(reader.value().data(),
+                                reader.value().size())) {
+        return errors::DataLoss("Unable to parse entry ", reader.key(),
+                                " of cache ", prefix);
+      }
+      if (!DataTypeCanUseMemcpy(entry.dtype())) {
+        return errors::Unimplemented("Tensors of type ",
+                                     DataTypeString(entry.dtype()),
+                                     " cannot be memory-mapped.");
+      }
+      if (!TensorShape::IsValid(entry.shape()) ||
+          entry.shard_id() < 0 || entry.shard_id() >= header.num_shards() ||
+          entry.size() != TensorShape(entry.shape()).num_elements() *
+                              DataTypeSize(entry.dtype())) {
+        return errors::DataLoss("Invalid entry ", reader.key(), " of cache ",
+                                prefix);
+      }
+    }
+    if (entries.size() % num_tensors != 0) {
+      return errors::DataLoss("Cache ", prefix, " has ", entries.size(),
+                              " tensors, which is not a multiple of ",
+                              num_tensors, ".");
+    }
+    std::vector<std::shared_ptr<const ReadOnlyMemoryRegion>> regions(
+        header.num_shards());
+    for (int32 i = 0; i < header.num_shards(); ++i) {
+      const string data_filename =
+          DataFilename(prefix, i, header.num_shards());
+      uint64 file_size;
+      TF_RETURN_IF_ERROR(env->GetFileSize(data_filename, &file_size));
+      if (file_size == 0) {
+        continue;
+      }
+      std::unique_ptr<ReadOnlyMemoryRegion> region;
+      TF_RETURN_IF_ERROR(
+          env->NewReadOnlyMemoryRegionFromFile(data_filename, &region));
+      regions[i] = std::move(region);
+    }
+    for (const BundleEntryProto& entry : entries) {
+      const auto& region = regions[entry.shard_id()];
+      const uint64 length = region ? region->length() : 0;
+      if (entry.size() > 0 && (entry.offset() < 0 ||
+                               entry.offset() + entry.size() > length)) {
+        return errors::DataLoss("Cache ", prefix, " has an entry at offset ",
+                                entry.offset(), " of size ", entry.size(),
+                                " beyond the end of shard ", entry.shard_id());
+      }
+    }
+    cache->reset(new MappedFileCache(num_tensors, std::move(entries),
+                                     std::move(regions)));
+    return Status::OK();
+  }
+
+  // Returns the number of elements in the cache.
+  size_t size() const { return entries_.size() / num_tensors_; }
+
+  // Reads the element at `index`.
+  Status Read(size_t index, std::vector<Tensor>* out_tensors) const {
+    out_tensors->clear();
+    out_tensors->reserve(num_tensors_);
+    for (size_t i = 0; i < num_tensors_; ++i) {
+      const BundleEntryProto& entry = entries_[index * num_tensors_ + i];
+      TensorShape shape(entry.shape());
+      if (entry.size() == 0) {
+        out_tensors->emplace_back(entry.dtype(), shape);
+        continue;
+      }
+      const auto& region = regions_[entry.shard_id()];
+      const char* data =
+          static_cast<const char*>(region->data()) + entry.offset();
+      if (crc32c::Unmask(entry.crc32c()) != crc32c::Value(data, entry.size())) {
+        return errors::DataLoss("Checksum does not match for element ", index,
+                                " of the cache.");
+      }
+      if (reinterpret_cast<uintptr_t>(data) % Allocator::kAllocatorAlignment ==
+          0) {
+        auto* buffer = new MappedTensorBuffer(data, entry.size(), region);
+        out_tensors->emplace_back(entry.dtype(), shape, buffer);
+        buffer->Unref();
+      } else {
+        // Caches written before tensor data was aligned are copied.
+        out_tensors->emplace_back(entry.dtype(), shape);
+        std::memcpy(const_cast<char*>(out_tensors->back().tensor_data().data()),
+                    data, entry.size());
+      }
+    }
+    return Status::OK();
+  }
+
+ private:
+  MappedFileCache(
+      size_t num_tensors, std::vector<BundleEntryProto> entries,
+      std::vector<std::shared_ptr<const ReadOnlyMemoryRegion>> regions)
+      : num_tensors_(num_tensors),
+        entries_(std::move(entries)),
+        regions_(std::move(regions)) {}
+
+  const size_t num_tensors_;
+  // The entries of the tensors of all elements, in element order.
+  const std::vector<BundleEntryProto> entries_;
+  // The memory-mapped data files, indexed by shard.
+  const std::vector<std::shared_ptr<const ReadOnlyMemoryRegion>> regions_;
+};
+
 class CacheDatasetOp::FileDatasetBase : public DatasetBase {
  public:
   FileDatasetBase(OpKernelContext* ctx, const DatasetBase* input,
@@ -120,6 +293,29 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
                            tensor_index);
   }
 
+  // Returns the memory-mapped view of the completed cache, which is created on
+  // first use and shared by all iterators. Sets `*cache` to nullptr if the
+  // cache cannot be memory-mapped.
+  Status GetMappedCache(std::shared_ptr<const MappedFileCache>* cache) const
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    if (!mapped_cache_initialized_) {
+      std::unique_ptr<MappedFileCache> mapped_cache;
+      Status s = MappedFileCache::Create(env_, filename_, num_tensors_,
+                                         &mapped_cache);
+      if (errors::IsUnimplemented(s)) {
+        VLOG(2) << "Reading cache " << filename_
+                << " without memory-mapping it: " << s;
+      } else {
+        TF_RETURN_IF_ERROR(s);
+      }
+      mapped_cache_ = std::move(mapped_cache);
+      mapped_cache_initialized_ = true;
+    }
+    *cache = mapped_cache_;
+    return Status::OK();
+  }
+
   class FileIterator : public DatasetIterator<FileDatasetBase> {
    public:
     explicit FileIterator(const Params& params)
@@ -359,7 +555,8 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         }
         filename_ = strings::StrCat(dataset()->filename_, "_", shard_id_);
         lockfile_ = strings::StrCat(filename_, kLockFileSuffix);
-        writer_ = absl::make_unique<BundleWriter>(dataset()->env_, filename_);
+        writer_ = absl::make_unique<BundleWriter>(
+            dataset()->env_, filename_, CacheWriterOptions());
         return Status::OK();
       }
 
@@ -421,7 +618,8 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         // conditions are not met since BundleWriter's constructor creates
         // new temp files which can delete the temp files created by a
         // BundleWriter in another Session.
-        writer_ = absl::make_unique<BundleWriter>(dataset()->env_, filename_);
+        writer_ = absl::make_unique<BundleWriter>(
+            dataset()->env_, filename_, CacheWriterOptions());
         lockfile_created_ = true;
         return Status::OK();
       }
@@ -470,6 +668,67 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
       bool iteration_completed_ TF_GUARDED_BY(mu_);
     };  // FileWriterIterator
 
+    // FileMappedReaderIterator reads the elements of a completed cache from
+    // its memory-mapped data files. It is used instead of
+    // `FileReaderIterator` whenever the cache can be memory-mapped.
+    class FileMappedReaderIterator : public DatasetIterator<FileDatasetBase> {
+     public:
+      explicit FileMappedReaderIterator(
+          const Params& params, std::shared_ptr<const MappedFileCache> cache)
+          : DatasetIterator<FileDatasetBase>(params),
+            cache_(std::move(cache)) {}
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        size_t index;
+        {
+          mutex_lock l(mu_);
+          if (cur_index_ >= cache_->size()) {
+            *end_of_sequence = true;
+            return Status::OK();
+          }
+          index = cur_index_++;
+        }
+        *end_of_sequence = false;
+        return cache_->Read(index, out_tensors);
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        return model::MakeKnownRatioNode(std::move(args),
+                                         /*ratio=*/1);
+      }
+
+      Status SaveInternal(SerializationContext* ctx,
+                          IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(full_name(kCurIndex), cur_index_));
+        return Status::OK();
+      }
+
+      Status RestoreInternal(
+          IteratorContext* ctx,
+          IteratorStateReader* iterator_state_reader) override {
+        mutex_lock l(mu_);
+        int64 temp;
+        TF_RETURN_IF_ERROR(
+            iterator_state_reader->ReadScalar(full_name(kCurIndex), &temp));
+        if (temp < 0) {
+          return errors::Internal("Invalid value for cur_index ", temp);
+        }
+        cur_index_ = static_cast<size_t>(temp);
+        return Status::OK();
+      }
+
+     private:
+      const std::shared_ptr<const MappedFileCache> cache_;
+      mutex mu_;
+      size_t cur_index_ TF_GUARDED_BY(mu_) = 0;
+    };  // FileMappedReaderIterator
+
     class FileReaderIterator : public DatasetIterator<FileDatasetBase> {
      public:
       explicit FileReaderIterator(const Params& params)
@@ -570,11 +829,21 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
       // case we simply build a `FileReaderIterator` and seek to the
       // `cur_index`.
       switch (mode_) {
-        case Mode::read:
-          iterator_ =
-              absl::make_unique<FileReaderIterator>(FileReaderIterator::Params{
-                  dataset(), strings::StrCat(prefix(), kImpl)});
+        case Mode::read: {
+          std::shared_ptr<const MappedFileCache> mapped_cache;
+          TF_RETURN_IF_ERROR(dataset()->GetMappedCache(&mapped_cache));
+          if (mapped_cache) {
+            iterator_ = absl::make_unique<FileMappedReaderIterator>(
+                FileMappedReaderIterator::Params{
+                    dataset(), strings::StrCat(prefix(), kImpl)},
+                std::move(mapped_cache));
+          } else {
+            iterator_ = absl::make_unique<FileReaderIterator>(
+                FileReaderIterator::Params{dataset(),
+                                           strings::StrCat(prefix(), kImpl)});
+          }
           break;
+        }
         case Mode::write:
           iterator_ =
               absl::make_unique<FileWriterIterator>(FileWriterIterator::Params{
@@ -593,6 +862,10 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
   Env* const env_;
   const size_t num_tensors_;
   const size_t tensor_index_padding_size_;
+  mutable mutex mu_;
+  mutable std::shared_ptr<const MappedFileCache> mapped_cache_
+      TF_GUARDED_BY(mu_);
+  mutable bool mapped_cache_initialized_ TF_GUARDED_BY(mu_) = false;
   static constexpr size_t kMaxItems = 10000000;  // 10 million
   const size_t item_index_padding_size_;
   const string tensor_format_string_;
@@ -1001,15 +1274,321 @@ class CacheDatasetOp::MemoryDatasetV2
   ResourceMgr* const resource_mgr_;  // Not owned.
 };
 
+#if !defined(IS_MOBILE_PLATFORM)
+// Holds the completed cache of a `CompressedMemoryDataset`. Like `MemoryCache`,
+// the cache is completed by the first iterator that reads the entire input and
+// is then shared by all iterators over the dataset.
+class CompressedMemoryCache {
+ public:
+  // Completes the cache with `cache`, unless it has already been completed,
+  // and returns the completed cache.
+  std::shared_ptr<CompressedElementCache> Complete(
+      std::shared_ptr<CompressedElementCache> cache) TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    if (!cache_) {
+      cache_ = std::move(cache);
+    }
+    return cache_;
+  }
+
+  // Returns the completed cache, or nullptr if the cache is not completed.
+  std::shared_ptr<CompressedElementCache> Get() TF_LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    return cache_;
+  }
+
+ private:
+  mutex mu_;
+  std::shared_ptr<CompressedElementCache> cache_ TF_GUARDED_BY(mu_);
+};
+
+// This version of memory dataset stores elements compressed and, if the
+// dataset has a memory budget, moves the least recently used elements to a
+// scratch file once the budget is exceeded. The cache is owned by the dataset
+// and shared by all of its iterators.
+class CacheDatasetOp::CompressedMemoryDataset : public DatasetBase {
+ public:
+  CompressedMemoryDataset(OpKernelContext* ctx, const DatasetBase* input,
+                          const CompressedElementCache::Options& options,
+                          int op_version, const Tensor& resource_handle)
+      : DatasetBase(DatasetContext(ctx)),
+        input_(input),
+        options_(options),
+        op_version_(op_version),
+        resource_handle_(resource_handle),
+        cache_(std::make_shared<CompressedMemoryCache>()) {
+    input_->Ref();
+  }
+
+  ~CompressedMemoryDataset() override { input_->Unref(); }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    name_utils::IteratorPrefixParams params;
+    params.dataset_prefix = kCompressedMemoryDatasetPrefix;
+    return absl::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix, params)});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return input_->output_dtypes();
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return input_->output_shapes();
+  }
+
+  string DebugString() const override {
+    name_utils::DatasetDebugStringParams params;
+    params.dataset_prefix = kCompressedMemoryDatasetPrefix;
+    return name_utils::DatasetDebugString(kDatasetType, params);
+  }
+
+  int64 Cardinality() const override { return input_->Cardinality(); }
+
+  Status CheckExternalState() const override {
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* input_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_node));
+    Node* filename_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(tstring(""), &filename_node));
+    std::vector<Node*> inputs = {input_node, filename_node};
+    if (op_version_ == 2) {
+      Node* resource_handle_node = nullptr;
+      TF_RETURN_IF_ERROR(
+          b->AddTensor(resource_handle_, &resource_handle_node));
+      inputs.push_back(resource_handle_node);
+    }
+    AttrValue compress_in_memory;
+    b->BuildAttrValue(true, &compress_in_memory);
+    AttrValue max_memory_bytes;
+    b->BuildAttrValue(options_.max_memory_bytes, &max_memory_bytes);
+    AttrValue spill_directory;
+    b->BuildAttrValue(options_.spill_directory, &spill_directory);
+    TF_RETURN_IF_ERROR(
+        b->AddDataset(this, inputs,
+                      {{kCompressInMemory, compress_in_memory},
+                       {kMaxMemoryBytes, max_memory_bytes},
+                       {kSpillDirectory, spill_directory}},
+                      output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<CompressedMemoryDataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<CompressedMemoryDataset>(params) {}
+
+    ~Iterator() override {
+      mutex_lock l(mu_);
+      if (temp_cache_ && temp_cache_->size() > 0) {
+        LOG(WARNING)
+            << "The calling iterator did not fully read the dataset being "
+               "cached. In order to avoid unexpected truncation of the "
+               "dataset, the partially cached contents of the dataset "
+               "will be discarded. This can happen if you have an input "
+               "pipeline similar to `dataset.cache().take(k).repeat()`. "
+               "You should use `dataset.take(k).cache().repeat()` instead.";
+      }
+    }
+
+    Status Initialize(IteratorContext* ctx) override {
+      mutex_lock l(mu_);
+      cache_ = dataset()->cache_->Get();
+      if (cache_) {
+        return Status::OK();
+      }
+      temp_cache_ = MakeCache();
+      return dataset()->input_->MakeIterator(ctx, this, prefix(),
+                                             &input_impl_);
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      mutex_lock l(mu_);
+      if (cache_) {
+        if (index_ >= cache_->size()) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        TF_RETURN_IF_ERROR(cache_->Get(index_, out_tensors));
+        index_++;
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(
+          input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
+      if (*end_of_sequence) {
+        VLOG(2) << "Finalizing the cache because EOF has been reached.";
+        CompleteCache();
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(temp_cache_->Append(*out_tensors));
+      if (temp_cache_->size() == dataset()->input_->Cardinality()) {
+        VLOG(2) << "Finalizing the cache because its size matches the "
+                   "expected input cardinality.";
+        CompleteCache();
+      }
+      return Status::OK();
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeKnownRatioNode(std::move(args),
+                                       /*ratio=*/1);
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      if (cache_) {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kCacheCompleted), ""));
+        TF_RETURN_IF_ERROR(WriteCache(writer, cache_.get()));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kIndex), index_));
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(WriteCache(writer, temp_cache_.get()));
+      return SaveInput(ctx, writer, input_impl_);
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      input_impl_.reset();
+      cache_.reset();
+      temp_cache_ = MakeCache();
+      TF_RETURN_IF_ERROR(ReadCache(reader, temp_cache_.get()));
+      if (reader->Contains(full_name(kCacheCompleted))) {
+        cache_ = dataset()->cache_->Complete(std::move(temp_cache_));
+        return reader->ReadScalar(full_name(kIndex), &index_);
+      }
+      TF_RETURN_IF_ERROR(dataset()->input_->MakeIterator(ctx, this, prefix(),
+                                                         &input_impl_));
+      return RestoreInput(ctx, reader, input_impl_);
+    }
+
+   private:
+    std::shared_ptr<CompressedElementCache> MakeCache() {
+      return std::make_shared<CompressedElementCache>(Env::Default(),
+                                                      dataset()->options_);
+    }
+
+    void CompleteCache() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      cache_ = dataset()->cache_->Complete(std::move(temp_cache_));
+      index_ = cache_->size();
+      input_impl_.reset();
+    }
+
+    Status WriteCache(IteratorStateWriter* writer,
+                      CompressedElementCache* cache) {
+      const int64 size = cache->size();
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kCacheSize), size));
+      for (int64 i = 0; i < size; ++i) {
+        std::shared_ptr<const CompressedElement> element;
+        TF_RETURN_IF_ERROR(cache->GetCompressed(i, &element));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            full_name(strings::StrCat(kCache, "[", i, "]")),
+            element->SerializeAsString()));
+      }
+      return Status::OK();
+    }
+
+    Status ReadCache(IteratorStateReader* reader,
+                     CompressedElementCache* cache) {
+      int64 size;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kCacheSize), &size));
+      for (int64 i = 0; i < size; ++i) {
+        tstring serialized;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            full_name(strings::StrCat(kCache, "[", i, "]")), &serialized));
+        auto element = std::make_shared<CompressedElement>();
+        if (!element->ParseFromArray(serialized.data(), serialized.size())) {
+          return errors::DataLoss("Failed to parse cached element ", i, ".");
+        }
+        TF_RETURN_IF_ERROR(cache->AppendCompressed(std::move(element)));
+      }
+      return Status::OK();
+    }
+
+    mutex mu_;
+    std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
+    // The cache being written, until the input is exhausted.
+    std::shared_ptr<CompressedElementCache> temp_cache_ TF_GUARDED_BY(mu_);
+    // The completed cache, once the input is exhausted.
+    std::shared_ptr<CompressedElementCache> cache_ TF_GUARDED_BY(mu_);
+    int64 index_ TF_GUARDED_BY(mu_) = 0;
+  };
+
+  const DatasetBase* const input_;
+  const CompressedElementCache::Options options_;
+  const int op_version_;
+  const Tensor resource_handle_;
+  const std::shared_ptr<CompressedMemoryCache> cache_;
+};
+#endif  // !IS_MOBILE_PLATFORM
+
 CacheDatasetOp::CacheDatasetOp(OpKernelConstruction* ctx)
     : UnaryDatasetOpKernel(ctx),
-      op_version_(ctx->def().op() == kCacheDataset ? 1 : 2) {}
+      op_version_(ctx->def().op() == kCacheDataset ? 1 : 2) {
+  if (ctx->HasAttr(kCompressInMemory)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kCompressInMemory, &compress_in_memory_));
+  }
+  if (ctx->HasAttr(kMaxMemoryBytes)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kMaxMemoryBytes, &max_memory_bytes_));
+  }
+  if (ctx->HasAttr(kSpillDirectory)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kSpillDirectory, &spill_directory_));
+  }
+  OP_REQUIRES(ctx, max_memory_bytes_ >= 0,
+              errors::InvalidArgument("`", kMaxMemoryBytes,
+                                      "` must be non-negative, but got ",
+                                      max_memory_bytes_, "."));
+  OP_REQUIRES(ctx, compress_in_memory_ || max_memory_bytes_ == 0,
+              errors::InvalidArgument("`", kMaxMemoryBytes, "` requires `",
+                                      kCompressInMemory, "` to be set."));
+}
 
 void CacheDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                                  DatasetBase** output) {
   // Parse out the filenames tensor.
   tstring filename;
   OP_REQUIRES_OK(ctx, ParseScalarArgument<tstring>(ctx, kFileName, &filename));
+  if (compress_in_memory_) {
+    OP_REQUIRES(ctx, filename.empty(),
+                errors::InvalidArgument(
+                    "`", kCompressInMemory,
+                    "` is only supported for in-memory caches, but got "
+                    "filename ",
+                    filename, "."));
+    for (DataType dtype : input->output_dtypes()) {
+      OP_REQUIRES(
+          ctx, dtype != DT_VARIANT && dtype != DT_RESOURCE,
+          errors::InvalidArgument("`", kCompressInMemory,
+                                  "` does not support elements of type ",
+                                  DataTypeString(dtype), "."));
+    }
+#if defined(IS_MOBILE_PLATFORM)
+    ctx->SetStatus(errors::Unimplemented(
+        "`", kCompressInMemory, "` is not supported on mobile platforms."));
+#else
+    CompressedElementCache::Options options;
+    options.max_memory_bytes = max_memory_bytes_;
+    options.spill_directory = spill_directory_;
+    *output = new CompressedMemoryDataset(
+        ctx, input, options, op_version_,
+        op_version_ == 2 ? ctx->input(2) : Tensor());
+#endif  // IS_MOBILE_PLATFORM
+    return;
+  }
   if (filename.empty()) {
     static std::atomic<int64> resource_id_counter(0);
     const string& container = ctx->resource_manager()->default_container();
@@ -30,6 +30,9 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
   static constexpr const char* const kFileName = "filename";
   static constexpr const char* const kOutputTypes = "output_types";
   static constexpr const char* const kOutputShapes = "output_shapes";
+  static constexpr const char* const kCompressInMemory = "compress_in_memory";
+  static constexpr const char* const kMaxMemoryBytes = "max_memory_bytes";
+  static constexpr const char* const kSpillDirectory = "spill_directory";
 
   explicit CacheDatasetOp(OpKernelConstruction* ctx);
 
@@ -42,8 +45,12 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
   class FileDatasetV2;
   class MemoryDataset;
   class MemoryDatasetV2;
+  class CompressedMemoryDataset;
 
   const int op_version_;
+  bool compress_in_memory_ = false;
+  int64 max_memory_bytes_ = 0;
+  string spill_directory_;
 };
 
 }  // namespace data
@@ -14,9 +14,13 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/captured_function.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_map>
 #include <utility>
 
 #include "absl/time/clock.h"
+#include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
@@ -25,6 +29,8 @@ limitations under the License.
 #include "tensorflow/core/framework/function_handle_cache.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/stats_aggregator.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
 #include "tensorflow/core/kernels/data/stats_utils.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -46,6 +52,12 @@ namespace {
 
 const char kDataServiceDataset[] = "DataServiceDataset";
 
+// The maximum number of ops in a function body that is run by calling the
+// kernels of the ops directly. For larger functions, the overhead of the
+// executor is small compared to the cost of the ops, and the executor can run
+// independent ops in parallel.
+constexpr int kMaxDirectKernelNodes = 4;
+
 // Simplistic implementation of the `StepStatsCollectorInterface` that only
 // cares about collecting the CPU time needed to execute a captured function.
 class SimpleStepStatsCollector : public StepStatsCollectorInterface {
@@ -165,9 +177,89 @@ Status RunShortCircuit(const ShortCircuitInfo& info, std::vector<Tensor>&& args,
   return Status::OK();
 }
 
+}  // namespace
+
+Status CreateDirectKernelInfo(const FunctionLibraryDefinition& lib_def,
+                              const FunctionBody& fn_body,
+                              DirectKernelInfo* info) {
+  const Graph& graph = *fn_body.graph;
+  const int num_nodes = graph.num_op_nodes() - fn_body.arg_nodes.size() -
+                        fn_body.ret_nodes.size();
+  if (num_nodes > kMaxDirectKernelNodes) {
+    return Status::OK();
+  }
+  for (const Edge* edge : graph.edges()) {
+    if (edge->IsControlEdge() && !edge->src()->IsSource() &&
+        !edge->dst()->IsSink()) {
+      return Status::OK();
+    }
+  }
+  auto is_supported_type = [](DataType dtype) {
+    return !IsRefType(dtype) && dtype != DT_RESOURCE;
+  };
+
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order);
+  std::vector<DirectKernelInfo::Node> nodes;
+  std::unordered_map<const Node*, int> node_index;
+  auto get_input = [&node_index](const Edge* edge,
+                                 DirectKernelInfo::Input* input) {
+    if (edge->src()->IsArg()) {
+      input->node = -1;
+      return GetNodeAttr(edge->src()->attrs(), "index", &input->index);
+    }
+    input->node = node_index.at(edge->src());
+    input->index = edge->src_output();
+    return Status::OK();
+  };
+  for (Node* node : order) {
+    if (!node->IsOp() || node->IsArg() || node->IsRetval()) {
+      continue;
+    }
+    // Stateful ops may depend on the per-step state, e.g. the rendezvous, that
+    // the executor sets up, so they are left to the runtime.
+    if (node->op_def().is_stateful() || node->IsControlFlow() ||
+        node->IsFunctionCall() ||
+        lib_def.Find(node->type_string()) != nullptr ||
+        !node->requested_device().empty() ||
+        !std::all_of(node->input_types().begin(), node->input_types().end(),
+                     is_supported_type) ||
+        !std::all_of(node->output_types().begin(), node->output_types().end(),
+                     is_supported_type)) {
+      return Status::OK();
+    }
+    DirectKernelInfo::Node direct_node;
+    direct_node.props = node->properties();
+    direct_node.inputs.resize(node->num_inputs());
+    for (const Edge* edge : node->in_edges()) {
+      if (!edge->IsControlEdge()) {
+        TF_RETURN_IF_ERROR(
+            get_input(edge, &direct_node.inputs[edge->dst_input()]));
+      }
+    }
+    node_index[node] = nodes.size();
+    nodes.push_back(std::move(direct_node));
+  }
+
+  std::vector<DirectKernelInfo::Input> rets(fn_body.ret_nodes.size());
+  for (size_t i = 0; i < fn_body.ret_nodes.size(); ++i) {
+    const Edge* edge;
+    TF_RETURN_IF_ERROR(fn_body.ret_nodes[i]->input_edge(0, &edge));
+    TF_RETURN_IF_ERROR(get_input(edge, &rets[i]));
+  }
+  info->nodes = std::move(nodes);
+  info->rets = std::move(rets);
+  return Status::OK();
+}
+
+namespace {
+
+// Computes the short-circuit information of the function and, if the function
+// cannot be short-circuited, its direct kernel information.
 Status CreateShortCircuitInfo(OpKernelConstruction* ctx,
                               const NameAttrList& func,
-                              ShortCircuitInfo* info) {
+                              ShortCircuitInfo* info,
+                              DirectKernelInfo* direct_kernel_info) {
   auto& indices = info->indices;
 
   FunctionLibraryRuntime::Handle fn_handle;
@@ -219,9 +311,12 @@ Status CreateShortCircuitInfo(OpKernelConstruction* ctx,
     for (int i = 0, end = indices.size(); i < end; ++i) {
       can_move[i] = last_use[indices[i]] == i;
     }
+    return Status::OK();
   }
 
-  return Status::OK();
+  return CreateDirectKernelInfo(
+      *ctx->function_library()->GetFunctionLibraryDefinition(), *fn_body,
+      direct_kernel_info);
 }
 
 Status CreateFunctionLibraryDefinition(
@@ -487,7 +582,8 @@ Status FunctionMetadata::Create(
       ctx->function_library()->GetFunctionLibraryDefinition(),
       (*out_metadata)->func_.name(), &(*out_metadata)->lib_def_));
   TF_RETURN_IF_ERROR(CreateShortCircuitInfo(
-      ctx, (*out_metadata)->func_, &(*out_metadata)->short_circuit_info_));
+      ctx, (*out_metadata)->func_, &(*out_metadata)->short_circuit_info_,
+      &(*out_metadata)->direct_kernel_info_));
   const FunctionDef* fdef;
   TF_RETURN_IF_ERROR(LookupFunction(*(*out_metadata)->lib_def(),
                                     (*out_metadata)->func().name(), &fdef));
@@ -799,6 +895,7 @@ Status InstantiatedCapturedFunction::Create(
     std::unique_ptr<InstantiatedCapturedFunction>* out_function) {
   out_function->reset(new InstantiatedCapturedFunction(
       lib, f_handle, ret_types, runner, captured_func, is_multi_device));
+  (*out_function)->CreateDirectKernels();
   return Status::OK();
 }
 
@@ -813,6 +910,118 @@ InstantiatedCapturedFunction::InstantiatedCapturedFunction(
       captured_func_(captured_func),
       is_multi_device_(is_multi_device) {}
 
+void InstantiatedCapturedFunction::CreateDirectKernels() {
+  const DirectKernelInfo& info = captured_func_->direct_kernel_info();
+  if (info.nodes.empty() || is_multi_device_ ||
+      lib_->device()->device_type() != DEVICE_CPU) {
+    return;
+  }
+  int max_num_outputs = 0;
+  for (const auto& node : info.nodes) {
+    OpKernel* kernel;
+    Status s = lib_->CreateKernel(node.props, &kernel);
+    if (!s.ok()) {
+      VLOG(1) << "Not running function " << captured_func_->func().name()
+              << " directly because its kernels could not be created: " << s;
+      direct_kernels_.clear();
+      return;
+    }
+    direct_kernels_.emplace_back(kernel);
+    if (kernel->AsAsync() != nullptr) {
+      direct_kernels_.clear();
+      return;
+    }
+    max_num_outputs = std::max(max_num_outputs, kernel->num_outputs());
+  }
+  direct_output_attrs_.resize(max_num_outputs);
+  VLOG(3) << "Running function " << captured_func_->func().name()
+          << " directly";
+}
+
+Status InstantiatedCapturedFunction::RunDirect(
+    const std::vector<Tensor>& args, CancellationManager* cancellation_manager,
+    std::function<void(std::function<void()>)>* runner,
+    std::vector<Tensor>* rets) const {
+  profiler::TraceMe activity("InstantiatedCapturedFunction::RunDirect",
+                             profiler::TraceMeLevel::kInfo);
+  const DirectKernelInfo& info = captured_func_->direct_kernel_info();
+  const int num_args = args.size();
+  std::vector<gtl::InlinedVector<Tensor, 4>> outputs(direct_kernels_.size());
+  auto get_tensor = [&](const DirectKernelInfo::Input& input,
+                        const Tensor** out) {
+    if (input.node >= 0) {
+      *out = &outputs[input.node][input.index];
+      return Status::OK();
+    }
+    if (input.index < num_args) {
+      *out = &args[input.index];
+      return Status::OK();
+    }
+    return GetCapturedInput(captured_func_, input.index - num_args, out);
+  };
+
+  // Set up the same per-step state as the function runtime does for a
+  // single-device CPU function, which runs without a rendezvous.
+  DCHECK(!ShouldCreateRendezvous());
+  Device* device = lib_->device();
+  const int64 step_id = -std::abs(static_cast<int64>(random::New64()));
+  ScopedStepContainer step_container(step_id, [device](const string& name) {
+    device->resource_manager()->Cleanup(name).IgnoreError();
+  });
+  OpKernelContext::Params params;
+  params.step_id = step_id;
+  params.step_container = &step_container;
+  params.rendezvous = nullptr;
+  params.device = device;
+  params.resource_manager = device->resource_manager();
+  params.function_library = lib_;
+  params.runner = runner;
+  params.cancellation_manager = cancellation_manager;
+  params.output_attr_array = direct_output_attrs_.data();
+  gtl::InlinedVector<Tensor, 4> inputs;
+  gtl::InlinedVector<TensorValue, 4> input_values;
+  for (size_t i = 0; i < direct_kernels_.size(); ++i) {
+    OpKernel* kernel = direct_kernels_[i].get();
+    // The inputs are copied so that their buffers are never forwarded to the
+    // outputs: they may still be referenced by the arguments, the captured
+    // inputs or other nodes.
+    inputs.clear();
+    for (const auto& input : info.nodes[i].inputs) {
+      const Tensor* tensor;
+      TF_RETURN_IF_ERROR(get_tensor(input, &tensor));
+      inputs.push_back(*tensor);
+    }
+    input_values.clear();
+    for (Tensor& tensor : inputs) {
+      input_values.emplace_back(&tensor);
+    }
+    params.op_kernel = kernel;
+    params.inputs = &input_values;
+    OpKernelContext op_ctx(&params, kernel->num_outputs());
+    device->Compute(kernel, &op_ctx);
+    TF_RETURN_IF_ERROR(op_ctx.status());
+    auto& node_outputs = outputs[i];
+    node_outputs.reserve(kernel->num_outputs());
+    for (int j = 0; j < kernel->num_outputs(); ++j) {
+      TensorValue value = op_ctx.release_output(j);
+      if (value.tensor == nullptr) {
+        return errors::Internal("Kernel ", kernel->name(),
+                                " did not produce output ", j);
+      }
+      node_outputs.push_back(std::move(*value.tensor));
+      delete value.tensor;
+    }
+  }
+
+  rets->reserve(info.rets.size());
+  for (const auto& ret : info.rets) {
+    const Tensor* tensor;
+    TF_RETURN_IF_ERROR(get_tensor(ret, &tensor));
+    rets->push_back(*tensor);
+  }
+  return Status::OK();
+}
+
 Status InstantiatedCapturedFunction::Run(IteratorContext* ctx,
                                          std::vector<Tensor>&& args,
                                          std::vector<Tensor>* rets) const {
@@ -820,6 +1029,9 @@ Status InstantiatedCapturedFunction::Run(IteratorContext* ctx,
   if (!info.indices.empty()) {
     return RunShortCircuit(info, std::move(args), captured_func_, rets);
   }
+  if (!direct_kernels_.empty()) {
+    return RunDirect(args, ctx->cancellation_manager(), ctx->runner(), rets);
+  }
 
   FunctionLibraryRuntime::Options f_opts;
   ScopedStepContainer step_container(
@@ -851,6 +1063,9 @@ Status InstantiatedCapturedFunction::RunWithBorrowedArgs(
   if (!info.indices.empty()) {
     return RunShortCircuit(info, args, captured_func_, rets);
   }
+  if (!direct_kernels_.empty()) {
+    return RunDirect(args, ctx->cancellation_manager(), ctx->runner(), rets);
+  }
 
   FunctionLibraryRuntime::Options f_opts;
   ScopedStepContainer step_container(
@@ -882,6 +1097,10 @@ Status InstantiatedCapturedFunction::RunInstantiated(
   if (!info.indices.empty()) {
     return RunShortCircuit(info, args, captured_func_, rets);
   }
+  if (!direct_kernels_.empty()) {
+    return RunDirect(args, /*cancellation_manager=*/nullptr, &captured_runner_,
+                     rets);
+  }
 
   FunctionLibraryRuntime::Options f_opts;
   ScopedStepContainer step_container(
@@ -921,6 +1140,48 @@ void InstantiatedCapturedFunction::RunAsync(
                   std::move(done)));
     return;
   }
+  if (!direct_kernels_.empty()) {
+    // As above, run the function and the `done` callback on a threadpool
+    // thread. The function runs on the calling thread of the closure, so its
+    // processing time is measured directly instead of by a stats collector.
+    const bool collect_usage =
+        node && ctx->model() && ctx->model()->collect_resource_usage();
+    CancellationManager* cancellation_manager = ctx->cancellation_manager();
+    std::function<void(std::function<void()>)> runner = *ctx->runner();
+    (*ctx->runner())(std::bind(
+        [this, rets, node, cancellation_manager, collect_usage](
+            const std::vector<Tensor>& args,
+            std::function<void(std::function<void()>)>& runner,
+            const std::shared_ptr<StatsAggregator>& stats_aggregator,
+            const FunctionLibraryRuntime::DoneCallback& done) {
+          const int64 start_time_ns = absl::GetCurrentTimeNanos();
+          Status s = RunDirect(args, cancellation_manager, &runner, rets);
+          const int64 processing_time =
+              absl::GetCurrentTimeNanos() - start_time_ns;
+          if (node) {
+            if (stats_aggregator) {
+              string prefix_with_func_name =
+                  strings::StrCat(node->name(), stats_utils::kDelimiter,
+                                  captured_func_->func().name());
+              stats_aggregator->AddToHistogram(
+                  stats_utils::ExecutionTimeHistogramName(
+                      prefix_with_func_name),
+                  {static_cast<float>(processing_time)}, node->num_elements());
+            }
+            node->add_processing_time(processing_time);
+          }
+          if (collect_usage) {
+            node->record_start(EnvTime::NowNanos());
+          }
+          done(s);
+          if (collect_usage) {
+            node->record_stop(EnvTime::NowNanos());
+          }
+        },
+        std::move(args), std::move(runner), ctx->stats_aggregator(),
+        std::move(done)));
+    return;
+  }
 
   // NOTE(mrry): This method does not transfer ownership of `ctx`, and it may
   // be deleted before `done` is called. Take care not to capture `ctx` in any
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/framework/node_properties.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -57,6 +58,34 @@ struct ShortCircuitInfo {
   std::vector<bool> can_move;
 };
 
+// Describes a function whose body is a small graph of stateless ops, which can
+// be run by calling the kernels of the ops directly, without the overhead of
+// the function runtime and executor.
+struct DirectKernelInfo {
+  // Identifies the tensor consumed by a node or returned by the function.
+  struct Input {
+    // The index of the node that produces the tensor, or -1 if the tensor is a
+    // function argument.
+    int node;
+    // The output index of the node, or the index of the function argument.
+    int index;
+  };
+  struct Node {
+    std::shared_ptr<const NodeProperties> props;
+    std::vector<Input> inputs;
+  };
+  // The nodes of the function body in topological order.
+  std::vector<Node> nodes;
+  std::vector<Input> rets;
+};
+
+// Determines whether the function body can be run by calling the kernels of
+// its ops directly, and if so, records the order of the ops and how their
+// inputs connect. Leaves `info` empty otherwise.
+Status CreateDirectKernelInfo(const FunctionLibraryDefinition& lib_def,
+                              const FunctionBody& fn_body,
+                              DirectKernelInfo* info);
+
 // Metadata shared across all captures of the same function.
 class FunctionMetadata {
  public:
@@ -89,6 +118,11 @@ class FunctionMetadata {
     return short_circuit_info_;
   }
 
+  // Returns direct kernel information.
+  const DirectKernelInfo& direct_kernel_info() const {
+    return direct_kernel_info_;
+  }
+
   // Indicates whether a default device should be used for executing function
   // ops.
   bool use_default_device() const { return use_default_device_; }
@@ -109,6 +143,7 @@ class FunctionMetadata {
   NameAttrList func_;
   std::unique_ptr<FunctionLibraryDefinition> lib_def_ = nullptr;
   ShortCircuitInfo short_circuit_info_;
+  DirectKernelInfo direct_kernel_info_;
   bool use_default_device_ = true;
   bool use_inter_op_parallelism_ = true;
   bool use_multi_device_function_ = true;
@@ -170,6 +205,13 @@ class CapturedFunction {
     return metadata_->short_circuit_info();
   }
 
+  // If the function body is a small graph of stateless ops, the method returns
+  // the nodes of the graph and how their inputs and the function outputs
+  // connect. Otherwise, it returns an empty list of nodes.
+  const DirectKernelInfo& direct_kernel_info() const {
+    return metadata_->direct_kernel_info();
+  }
+
   // Indicates whether the function should use inter op parallelism.
   bool use_inter_op_parallelism() const {
     return metadata_->use_inter_op_parallelism();
@@ -251,6 +293,17 @@ class InstantiatedCapturedFunction {
   // instantiated function.
   bool ShouldCreateRendezvous() const;
 
+  // Creates the kernels for running the function directly, if the function
+  // qualifies for it. Leaves `direct_kernels_` empty otherwise.
+  void CreateDirectKernels();
+
+  // Runs the function on the calling thread by calling the kernels in
+  // `direct_kernels_` one after the other.
+  Status RunDirect(const std::vector<Tensor>& args,
+                   CancellationManager* cancellation_manager,
+                   std::function<void(std::function<void()>)>* runner,
+                   std::vector<Tensor>* rets) const;
+
   FunctionLibraryRuntime* const lib_;  // Not owned.
   const FunctionLibraryRuntime::Handle f_handle_;
   const DataTypeVector ret_types_;
@@ -259,6 +312,11 @@ class InstantiatedCapturedFunction {
   std::function<void(std::function<void()>)> captured_runner_;
   CapturedFunction* const captured_func_;  // Not owned.
   const bool is_multi_device_;
+  // The kernels of `captured_func_->direct_kernel_info().nodes`, if the
+  // function runs by calling them directly.
+  std::vector<std::unique_ptr<OpKernel>> direct_kernels_;
+  // Default allocator attributes for the outputs of `direct_kernels_`.
+  std::vector<AllocatorAttributes> direct_output_attrs_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(InstantiatedCapturedFunction);
 };
@@ -0,0 +1,102 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/captured_function.h"
+
+#include "tensorflow/core/common_runtime/function_body.h"
+#include "tensorflow/core/common_runtime/function_def_utils.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+using FDH = FunctionDefHelper;
+
+// Computes the direct kernel information of `fdef` instantiated with `attrs`.
+DirectKernelInfo GetDirectKernelInfo(const FunctionDef& fdef,
+                                     AttrSlice attrs = AttrSlice()) {
+  FunctionLibraryDefinition lib_def(OpRegistry::Global(), {});
+  TF_CHECK_OK(lib_def.AddFunctionDef(fdef));
+  std::unique_ptr<FunctionBody> fn_body;
+  TF_CHECK_OK(FunctionDefToBodyHelper(fdef, attrs, &lib_def, &fn_body));
+  DirectKernelInfo info;
+  TF_CHECK_OK(CreateDirectKernelInfo(lib_def, *fn_body, &info));
+  return info;
+}
+
+TEST(CreateDirectKernelInfoTest, StatelessFunction) {
+  DirectKernelInfo info = GetDirectKernelInfo(
+      test::function::XTimesTwo(), test::function::Attrs({{"T", DT_INT64}}));
+  // Const, Cast and Mul, with Mul last.
+  ASSERT_EQ(info.nodes.size(), 3);
+  const DirectKernelInfo::Node& mul = info.nodes[2];
+  EXPECT_EQ(mul.props->node_def.op(), "Mul");
+  ASSERT_EQ(mul.inputs.size(), 2);
+  EXPECT_EQ(mul.inputs[0].node, -1);
+  EXPECT_EQ(mul.inputs[0].index, 0);
+  EXPECT_EQ(mul.inputs[1].node, 1);
+  EXPECT_EQ(mul.inputs[1].index, 0);
+  ASSERT_EQ(info.rets.size(), 1);
+  EXPECT_EQ(info.rets[0].node, 2);
+  EXPECT_EQ(info.rets[0].index, 0);
+}
+
+TEST(CreateDirectKernelInfoTest, MultiOutputNode) {
+  FunctionDef fdef = FDH::Create(
+      "UniqueValuesAndIndices", {"x: int64"}, {"y: int64", "idx: int32"}, {},
+      {{{"unique"},
+        "Unique",
+        {"x"},
+        {{"T", DT_INT64}, {"out_idx", DT_INT32}}}},
+      {{"y", "unique:y:0"}, {"idx", "unique:idx:0"}});
+  DirectKernelInfo info = GetDirectKernelInfo(fdef);
+  ASSERT_EQ(info.nodes.size(), 1);
+  ASSERT_EQ(info.rets.size(), 2);
+  EXPECT_EQ(info.rets[0].node, 0);
+  EXPECT_EQ(info.rets[0].index, 0);
+  EXPECT_EQ(info.rets[1].node, 0);
+  EXPECT_EQ(info.rets[1].index, 1);
+}
+
+TEST(CreateDirectKernelInfoTest, StatefulFunction) {
+  FunctionDef fdef = FDH::Create(
+      "PrintX", {"x: int64"}, {"y: int64"}, {},
+      {{{"print"},
+        "Print",
+        {"x", "x"},
+        {{"T", DT_INT64}, {"U", DataTypeSlice{DT_INT64}}}}},
+      {{"y", "print:output:0"}});
+  EXPECT_TRUE(GetDirectKernelInfo(fdef).nodes.empty());
+}
+
+TEST(CreateDirectKernelInfoTest, TooManyNodes) {
+  FunctionDef fdef = FDH::Create(
+      "AddFiveTimes", {"x: int64"}, {"y: int64"}, {},
+      {{{"a1"}, "Add", {"x", "x"}, {{"T", DT_INT64}}},
+       {{"a2"}, "Add", {"a1:z:0", "x"}, {{"T", DT_INT64}}},
+       {{"a3"}, "Add", {"a2:z:0", "x"}, {{"T", DT_INT64}}},
+       {{"a4"}, "Add", {"a3:z:0", "x"}, {{"T", DT_INT64}}},
+       {{"a5"}, "Add", {"a4:z:0", "x"}, {{"T", DT_INT64}}}},
+      {{"y", "a5:z:0"}});
+  EXPECT_TRUE(GetDirectKernelInfo(fdef).nodes.empty());
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
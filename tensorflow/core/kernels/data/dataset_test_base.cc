@@ -950,7 +950,8 @@ Status BatchDatasetParams::GetInputNames(
 Status BatchDatasetParams::GetAttributes(AttributeVector* attr_vector) const {
   *attr_vector = {{BatchDatasetOp::kParallelCopy, parallel_copy_},
                   {BatchDatasetOp::kOutputTypes, output_dtypes_},
-                  {BatchDatasetOp::kOutputShapes, output_shapes_}};
+                  {BatchDatasetOp::kOutputShapes, output_shapes_},
+                  {BatchDatasetOp::kPreallocateOutput, preallocate_output_}};
   return Status::OK();
 }
 
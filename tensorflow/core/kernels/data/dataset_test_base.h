@@ -209,12 +209,13 @@ class BatchDatasetParams : public DatasetParams {
                      bool drop_remainder, bool parallel_copy,
                      DataTypeVector output_dtypes,
                      std::vector<PartialTensorShape> output_shapes,
-                     string node_name)
+                     string node_name, bool preallocate_output = false)
       : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
                       std::move(node_name)),
         batch_size_(batch_size),
         drop_remainder_(drop_remainder),
-        parallel_copy_(parallel_copy) {
+        parallel_copy_(parallel_copy),
+        preallocate_output_(preallocate_output) {
     input_dataset_params_.push_back(std::make_unique<T>(input_dataset_params));
     op_version_ = 2;
     iterator_prefix_ =
@@ -234,6 +235,7 @@ class BatchDatasetParams : public DatasetParams {
   int64 batch_size_;
   bool drop_remainder_;
   bool parallel_copy_;
+  bool preallocate_output_;
 };
 
 // `MapDatasetParams` is a common dataset parameter type that are used in
@@ -20,6 +20,7 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/common_runtime/process_state.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/function.h"
@@ -33,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/regexp.h"
 #include "tensorflow/core/util/work_sharder.h"
 
@@ -865,6 +867,24 @@ std::function<void(std::function<void()>)> RunnerWithMaxParallelism(
       std::move(runner), std::placeholders::_1);
 }
 
+int GetNUMANode(const DeviceBase* device) {
+  if (device == nullptr || !ProcessState::singleton()->NUMAEnabled() ||
+      device->attributes().device_type() != DEVICE_CPU) {
+    return port::kNUMANoAffinity;
+  }
+  const int numa_node = device->NumaNode();
+  if (numa_node < 0 || numa_node >= port::NUMANumNodes()) {
+    return port::kNUMANoAffinity;
+  }
+  return numa_node;
+}
+
+ThreadOptions GetThreadOptions(const DeviceBase* device) {
+  ThreadOptions thread_options;
+  thread_options.numa_node = GetNUMANode(device);
+  return thread_options;
+}
+
 Status DeterminismPolicy::FromString(const std::string& s,
                                      DeterminismPolicy* out) {
   DeterminismPolicy::Type type;
@@ -274,6 +274,17 @@ Status AddToFunctionLibrary(FunctionLibraryDefinition* base,
 std::function<void(std::function<void()>)> RunnerWithMaxParallelism(
     std::function<void(std::function<void()>)> runner, int max_parallelism);
 
+// Returns the NUMA node that the threads and buffers of an input pipeline
+// running on `device` should be local to, or `port::kNUMANoAffinity` if the
+// input pipeline is not NUMA-aware. Input pipelines are NUMA-aware if they run
+// on a CPU device with NUMA-local allocators, which is the case when the
+// session is configured with `use_numa_affinity`.
+int GetNUMANode(const DeviceBase* device);
+
+// Returns the options for the threads of an input pipeline running on
+// `device`, which pin the threads to the NUMA node returned by `GetNUMANode`.
+ThreadOptions GetThreadOptions(const DeviceBase* device);
+
 // Op for creating a typed dummy resource.
 //
 // This op is used to provide a resource "placeholder" for ops such as
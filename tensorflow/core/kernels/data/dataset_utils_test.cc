@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/dataset_utils.h"
 
+#include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op.h"
@@ -22,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
 #include "tensorflow/core/util/work_sharder.h"
@@ -1350,6 +1352,14 @@ INSTANTIATE_TEST_SUITE_P(Test, SelectOptimizationsJobTest,
                                             ::testing::Values("",
                                                               "exp2,exp3")));
 
+TEST(DatasetUtilsTest, GetNUMANodeWithoutNUMAAffinity) {
+  EXPECT_EQ(GetNUMANode(nullptr), port::kNUMANoAffinity);
+  std::unique_ptr<Device> device = DeviceFactory::NewDevice(
+      "CPU", {}, "/job:localhost/replica:0/task:0");
+  EXPECT_EQ(GetNUMANode(device.get()), port::kNUMANoAffinity);
+  EXPECT_EQ(GetThreadOptions(device.get()).numa_node, port::kNUMANoAffinity);
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
@@ -0,0 +1,467 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/columnar_file.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/platform/byte_order.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr uint64 kTrailerSize = sizeof(uint64) + kColumnarFileMagicSize;
+
+// A tensor buffer that refers to a column chunk of a memory-mapped file and
+// keeps the mapping alive. The memory is read-only, so the buffer is never
+// forwarded to the outputs of kernels.
+class MappedChunkBuffer : public TensorBuffer {
+ public:
+  MappedChunkBuffer(const char* data, size_t size,
+                    std::shared_ptr<const ReadOnlyMemoryRegion> region)
+      : TensorBuffer(const_cast<char*>(data)),
+        size_(size),
+        region_(std::move(region)) {}
+
+  size_t size() const override { return size_; }
+
+  TensorBuffer* root_buffer() override { return this; }
+
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("mmap");
+  }
+
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const size_t size_;
+  const std::shared_ptr<const ReadOnlyMemoryRegion> region_;
+};
+
+bool HasStatistics(DataType dtype) {
+  switch (dtype) {
+#define HANDLE_TYPE(T)           \
+  case DataTypeToEnum<T>::value: \
+    return true;
+    TF_CALL_REAL_NUMBER_TYPES_NO_BFLOAT16(HANDLE_TYPE);
+#undef HANDLE_TYPE
+    default:
+      return false;
+  }
+}
+
+template <typename T>
+void UpdateStatisticsImpl(const Tensor& tensor,
+                          ColumnarFileFooter::ColumnChunk* chunk) {
+  auto values = tensor.flat<T>();
+  double min = chunk->min();
+  double max = chunk->max();
+  for (int64 i = 0; i < values.size(); ++i) {
+    const double value = static_cast<double>(values(i));
+    if (std::isnan(value)) {
+      continue;
+    }
+    min = std::min(min, value);
+    max = std::max(max, value);
+  }
+  chunk->set_min(min);
+  chunk->set_max(max);
+}
+
+void UpdateStatistics(const Tensor& tensor,
+                      ColumnarFileFooter::ColumnChunk* chunk) {
+  switch (tensor.dtype()) {
+#define HANDLE_TYPE(T)                      \
+  case DataTypeToEnum<T>::value:            \
+    UpdateStatisticsImpl<T>(tensor, chunk); \
+    break;
+    TF_CALL_REAL_NUMBER_TYPES_NO_BFLOAT16(HANDLE_TYPE);
+#undef HANDLE_TYPE
+    default:
+      break;
+  }
+}
+
+// Resets `chunk` to describe an empty chunk of a column of type `dtype`.
+void ResetChunk(DataType dtype, ColumnarFileFooter::ColumnChunk* chunk) {
+  chunk->Clear();
+  if (HasStatistics(dtype)) {
+    chunk->set_has_statistics(true);
+    chunk->set_min(std::numeric_limits<double>::infinity());
+    chunk->set_max(-std::numeric_limits<double>::infinity());
+  }
+}
+
+}  // namespace
+
+Status ColumnarFileWriter::Create(
+    Env* env, const std::string& filename, int64 rows_per_row_group,
+    std::unique_ptr<ColumnarFileWriter>* out_writer) {
+  if (rows_per_row_group <= 0) {
+    return errors::InvalidArgument(
+        "The number of rows per row group must be positive, but got ",
+        rows_per_row_group, ".");
+  }
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(filename, &file));
+  out_writer->reset(
+      new ColumnarFileWriter(std::move(file), rows_per_row_group));
+  return Status::OK();
+}
+
+ColumnarFileWriter::ColumnarFileWriter(std::unique_ptr<WritableFile> file,
+                                       int64 rows_per_row_group)
+    : file_(std::move(file)), rows_per_row_group_(rows_per_row_group) {}
+
+Status ColumnarFileWriter::WriteRow(const std::vector<Tensor>& row) {
+  if (row.empty()) {
+    return errors::InvalidArgument("Rows of columnar files must not be empty.");
+  }
+  if (shapes_.empty()) {
+    for (const Tensor& tensor : row) {
+      if (!DataTypeCanUseMemcpy(tensor.dtype())) {
+        return errors::InvalidArgument(
+            "Columnar files do not support columns of type ",
+            DataTypeString(tensor.dtype()), ".");
+      }
+      ColumnarFileFooter::Column* column = footer_.add_columns();
+      column->set_dtype(tensor.dtype());
+      tensor.shape().AsProto(column->mutable_shape());
+      shapes_.push_back(tensor.shape());
+      buffers_.emplace_back();
+      chunks_.emplace_back();
+      ResetChunk(tensor.dtype(), &chunks_.back());
+    }
+  }
+  if (row.size() != shapes_.size()) {
+    return errors::InvalidArgument("Expected rows with ", shapes_.size(),
+                                   " columns, but got a row with ", row.size(),
+                                   " columns.");
+  }
+  for (size_t i = 0; i < row.size(); ++i) {
+    if (row[i].dtype() != footer_.columns(i).dtype() ||
+        row[i].shape() != shapes_[i]) {
+      return errors::InvalidArgument(
+          "Expected column ", i, " to have type ",
+          DataTypeString(footer_.columns(i).dtype()), " and shape ",
+          shapes_[i].DebugString(), ", but got a value of type ",
+          DataTypeString(row[i].dtype()), " and shape ",
+          row[i].shape().DebugString(), ".");
+    }
+  }
+  for (size_t i = 0; i < row.size(); ++i) {
+    StringPiece data = row[i].tensor_data();
+    buffers_[i].append(data.data(), data.size());
+    UpdateStatistics(row[i], &chunks_[i]);
+  }
+  if (++num_buffered_rows_ == rows_per_row_group_) {
+    TF_RETURN_IF_ERROR(FlushRowGroup());
+  }
+  return Status::OK();
+}
+
+Status ColumnarFileWriter::Close() {
+  TF_RETURN_IF_ERROR(FlushRowGroup());
+  footer_.set_version(kColumnarFileVersion);
+  footer_.set_little_endian(port::kLittleEndian);
+  std::string footer;
+  if (!footer_.SerializeToString(&footer)) {
+    return errors::Internal("Failed to serialize the columnar file footer.");
+  }
+  TF_RETURN_IF_ERROR(file_->Append(footer));
+  char footer_size[sizeof(uint64)];
+  core::EncodeFixed64(footer_size, footer.size());
+  TF_RETURN_IF_ERROR(file_->Append(StringPiece(footer_size, sizeof(uint64))));
+  TF_RETURN_IF_ERROR(file_->Append(
+      StringPiece(kColumnarFileMagic, kColumnarFileMagicSize)));
+  return file_->Close();
+}
+
+Status ColumnarFileWriter::FlushRowGroup() {
+  if (num_buffered_rows_ == 0) {
+    return Status::OK();
+  }
+  ColumnarFileFooter::RowGroup* row_group = footer_.add_row_groups();
+  row_group->set_num_rows(num_buffered_rows_);
+  for (size_t i = 0; i < buffers_.size(); ++i) {
+    TF_RETURN_IF_ERROR(Pad());
+    ColumnarFileFooter::ColumnChunk* chunk = row_group->add_chunks();
+    *chunk = chunks_[i];
+    chunk->set_offset(offset_);
+    chunk->set_size(buffers_[i].size());
+    chunk->set_crc32c(crc32c::Mask(crc32c::Value(buffers_[i])));
+    TF_RETURN_IF_ERROR(file_->Append(buffers_[i]));
+    offset_ += buffers_[i].size();
+    buffers_[i].clear();
+    ResetChunk(footer_.columns(i).dtype(), &chunks_[i]);
+  }
+  num_buffered_rows_ = 0;
+  return Status::OK();
+}
+
+Status ColumnarFileWriter::Pad() {
+  static constexpr char kZeros[kColumnarFileAlignment] = {};
+  const uint64 padding =
+      (kColumnarFileAlignment - offset_ % kColumnarFileAlignment) %
+      kColumnarFileAlignment;
+  if (padding == 0) {
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(file_->Append(StringPiece(kZeros, padding)));
+  offset_ += padding;
+  return Status::OK();
+}
+
+Status ColumnarFileReader::Open(
+    Env* env, const std::string& filename,
+    std::unique_ptr<ColumnarFileReader>* out_reader) {
+  uint64 file_size;
+  TF_RETURN_IF_ERROR(env->GetFileSize(filename, &file_size));
+  if (file_size < kTrailerSize) {
+    return errors::DataLoss(filename, " is too small to be a columnar file.");
+  }
+  std::shared_ptr<const ReadOnlyMemoryRegion> region;
+  std::unique_ptr<RandomAccessFile> file;
+  std::unique_ptr<ReadOnlyMemoryRegion> mapped_region;
+  Status s = env->NewReadOnlyMemoryRegionFromFile(filename, &mapped_region);
+  if (s.ok()) {
+    region = std::move(mapped_region);
+  } else if (errors::IsUnimplemented(s)) {
+    VLOG(2) << "Reading " << filename << " without memory-mapping it: " << s;
+    TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &file));
+  } else {
+    return s;
+  }
+  auto read = [&](uint64 offset, size_t n, std::string* result) -> Status {
+    if (region) {
+      result->assign(static_cast<const char*>(region->data()) + offset, n);
+      return Status::OK();
+    }
+    result->resize(n);
+    StringPiece data;
+    TF_RETURN_IF_ERROR(file->Read(offset, n, &data, &(*result)[0]));
+    if (data.size() != n) {
+      return errors::DataLoss("Unexpected end of file ", filename);
+    }
+    if (data.data() != result->data()) {
+      std::memcpy(&(*result)[0], data.data(), n);
+    }
+    return Status::OK();
+  };
+  if (region && region->length() != file_size) {
+    return errors::DataLoss("The memory-mapped region of ", filename, " has ",
+                            region->length(), " bytes, but the file has ",
+                            file_size, " bytes.");
+  }
+  std::string trailer;
+  TF_RETURN_IF_ERROR(read(file_size - kTrailerSize, kTrailerSize, &trailer));
+  if (StringPiece(trailer).substr(sizeof(uint64)) !=
+      StringPiece(kColumnarFileMagic, kColumnarFileMagicSize)) {
+    return errors::DataLoss(filename, " is not a columnar file.");
+  }
+  const uint64 footer_size = core::DecodeFixed64(trailer.data());
+  if (footer_size > file_size - kTrailerSize) {
+    return errors::DataLoss("The footer of columnar file ", filename,
+                            " is truncated.");
+  }
+  const uint64 data_size = file_size - kTrailerSize - footer_size;
+  std::string serialized_footer;
+  TF_RETURN_IF_ERROR(read(data_size, footer_size, &serialized_footer));
+  ColumnarFileFooter footer;
+  if (!footer.ParseFromString(serialized_footer)) {
+    return errors::DataLoss("Unable to parse the footer of columnar file ",
+                            filename);
+  }
+  std::unique_ptr<ColumnarFileReader> reader(new ColumnarFileReader(
+      filename, std::move(footer), std::move(region), std::move(file)));
+  TF_RETURN_IF_ERROR(reader->Initialize(data_size));
+  *out_reader = std::move(reader);
+  return Status::OK();
+}
+
+ColumnarFileReader::ColumnarFileReader(
+    std::string filename, ColumnarFileFooter footer,
+    std::shared_ptr<const ReadOnlyMemoryRegion> region,
+    std::unique_ptr<RandomAccessFile> file)
+    : filename_(std::move(filename)),
+      footer_(std::move(footer)),
+      region_(std::move(region)),
+      file_(std::move(file)) {}
+
+Status ColumnarFileReader::Initialize(uint64 data_size) {
+  if (footer_.version() != kColumnarFileVersion) {
+    return errors::Unimplemented("Columnar file ", filename_,
+                                 " has unsupported version ",
+                                 footer_.version(), ".");
+  }
+  if (footer_.little_endian() != port::kLittleEndian) {
+    return errors::Unimplemented(
+        "Columnar file ", filename_,
+        " was written on a machine with a different byte order.");
+  }
+  for (const auto& column : footer_.columns()) {
+    if (!DataTypeCanUseMemcpy(column.dtype()) ||
+        !TensorShape::IsValid(column.shape())) {
+      return errors::DataLoss("Columnar file ", filename_,
+                              " has an invalid column.");
+    }
+    shapes_.emplace_back(column.shape());
+  }
+  row_group_starts_.push_back(0);
+  for (int64 i = 0; i < footer_.row_groups_size(); ++i) {
+    const auto& row_group = footer_.row_groups(i);
+    if (row_group.num_rows() < 0 ||
+        row_group.chunks_size() != footer_.columns_size()) {
+      return errors::DataLoss("Columnar file ", filename_,
+                              " has an invalid row group ", i, ".");
+    }
+    for (int64 j = 0; j < row_group.chunks_size(); ++j) {
+      const auto& chunk = row_group.chunks(j);
+      const int64 expected_size = row_group.num_rows() *
+                                  shapes_[j].num_elements() *
+                                  DataTypeSize(footer_.columns(j).dtype());
+      if (chunk.size() != expected_size || chunk.offset() < 0 ||
+          chunk.offset() % kColumnarFileAlignment != 0 ||
+          chunk.offset() + chunk.size() > data_size) {
+        return errors::DataLoss("Columnar file ", filename_,
+                                " has an invalid chunk for column ", j,
+                                " of row group ", i, ".");
+      }
+    }
+    row_group_starts_.push_back(row_group_starts_.back() +
+                                row_group.num_rows());
+  }
+  verified_.resize(footer_.row_groups_size() * footer_.columns_size());
+  cached_chunks_.resize(footer_.columns_size());
+  return Status::OK();
+}
+
+int64 ColumnarFileReader::RowGroupForRow(int64 row) const {
+  return std::upper_bound(row_group_starts_.begin(), row_group_starts_.end(),
+                          row) -
+         row_group_starts_.begin() - 1;
+}
+
+bool ColumnarFileReader::RowGroupMayContain(int64 row_group, int64 column,
+                                            double min, double max) const {
+  const auto& chunk = footer_.row_groups(row_group).chunks(column);
+  if (!chunk.has_statistics()) {
+    return true;
+  }
+  return chunk.min() <= max && chunk.max() >= min;
+}
+
+Status ColumnarFileReader::Read(int64 row, int64 num_rows, int64 column,
+                                Tensor* out) {
+  if (column < 0 || column >= footer_.columns_size()) {
+    return errors::InvalidArgument("Columnar file ", filename_, " has ",
+                                   footer_.columns_size(),
+                                   " columns, but column ", column,
+                                   " was requested.");
+  }
+  const int64 row_group = RowGroupForRow(row);
+  if (row < 0 || num_rows < 0 || row_group >= num_row_groups() ||
+      row + num_rows > row_group_start(row_group + 1)) {
+    return errors::InvalidArgument("Rows [", row, ", ", row + num_rows,
+                                   ") are not part of a single row group of ",
+                                   filename_, ".");
+  }
+  Tensor chunk;
+  TF_RETURN_IF_ERROR(ReadChunk(row_group, column, &chunk));
+  const int64 start = row - row_group_start(row_group);
+  if (start == 0 && num_rows == chunk.dim_size(0)) {
+    *out = std::move(chunk);
+    return Status::OK();
+  }
+  *out = chunk.Slice(start, start + num_rows);
+  if (!out->IsAligned()) {
+    *out = tensor::DeepCopy(*out);
+  }
+  return Status::OK();
+}
+
+Status ColumnarFileReader::ReadChunk(int64 row_group, int64 column,
+                                     Tensor* chunk) {
+  const auto& chunk_info = footer_.row_groups(row_group).chunks(column);
+  const DataType dtype = footer_.columns(column).dtype();
+  TensorShape shape({footer_.row_groups(row_group).num_rows()});
+  shape.AppendShape(shapes_[column]);
+  if (chunk_info.size() == 0) {
+    *chunk = Tensor(dtype, shape);
+    return Status::OK();
+  }
+  const int64 index = row_group * footer_.columns_size() + column;
+  if (region_) {
+    const char* data =
+        static_cast<const char*>(region_->data()) + chunk_info.offset();
+    if (!verified_[index]) {
+      if (crc32c::Unmask(chunk_info.crc32c()) !=
+          crc32c::Value(data, chunk_info.size())) {
+        return errors::DataLoss("Checksum does not match for column ", column,
+                                " of row group ", row_group, " of ",
+                                filename_, ".");
+      }
+      verified_[index] = true;
+    }
+    auto* buffer = new MappedChunkBuffer(data, chunk_info.size(), region_);
+    *chunk = Tensor(dtype, shape, buffer);
+    buffer->Unref();
+    return Status::OK();
+  }
+  if (cached_row_group_ != row_group) {
+    for (Tensor& cached_chunk : cached_chunks_) {
+      cached_chunk = Tensor();
+    }
+    cached_row_group_ = row_group;
+  }
+  Tensor& cached_chunk = cached_chunks_[column];
+  if (!cached_chunk.IsInitialized()) {
+    Tensor result(dtype, shape);
+    char* scratch = const_cast<char*>(result.tensor_data().data());
+    StringPiece data;
+    TF_RETURN_IF_ERROR(
+        file_->Read(chunk_info.offset(), chunk_info.size(), &data, scratch));
+    if (data.size() != chunk_info.size()) {
+      return errors::DataLoss("Unexpected end of file ", filename_);
+    }
+    if (data.data() != scratch) {
+      std::memcpy(scratch, data.data(), data.size());
+    }
+    if (crc32c::Unmask(chunk_info.crc32c()) !=
+        crc32c::Value(scratch, chunk_info.size())) {
+      return errors::DataLoss("Checksum does not match for column ", column,
+                              " of row group ", row_group, " of ", filename_,
+                              ".");
+    }
+    cached_chunk = std::move(result);
+  }
+  *chunk = cached_chunk;
+  return Status::OK();
+}
+
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
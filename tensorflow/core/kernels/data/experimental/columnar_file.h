@@ -0,0 +1,171 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_COLUMNAR_FILE_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_COLUMNAR_FILE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/protobuf/data/experimental/columnar_file.pb.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+// Columnar files store a sequence of rows, each of which is a list of dense
+// tensors of memcpy-able types, column by column. Rows are grouped into row
+// groups, and the values of a column for the rows of a row group are stored
+// contiguously as a "column chunk":
+//
+//   [chunk (row group 0, column 0)][padding][chunk (row group 0, column 1)]...
+//   [chunk (row group 1, column 0)]...
+//   [footer: serialized `ColumnarFileFooter`]
+//   [footer size: fixed64][magic: "TFCOLUMN"]
+//
+// Chunks start at offsets that are multiples of `kColumnarFileAlignment`, so
+// that readers can memory-map the file and expose batches of rows as tensors
+// without copying them. The footer records the location, checksum, and the
+// minimum and maximum values of each chunk, which allows readers to read a
+// subset of the columns and to skip row groups without touching their data.
+
+constexpr int64 kColumnarFileVersion = 1;
+constexpr int64 kColumnarFileAlignment = 64;
+constexpr char kColumnarFileMagic[] = "TFCOLUMN";
+constexpr int64 kColumnarFileMagicSize = sizeof(kColumnarFileMagic) - 1;
+
+// Writes rows to a columnar file.
+//
+// Note: this class is not thread safe; external synchronization required.
+class ColumnarFileWriter {
+ public:
+  // Creates a writer for `filename`, which buffers up to `rows_per_row_group`
+  // rows in memory before writing them out as a row group.
+  static Status Create(Env* env, const std::string& filename,
+                       int64 rows_per_row_group,
+                       std::unique_ptr<ColumnarFileWriter>* out_writer);
+
+  // Appends a row. The first row determines the type and shape of the
+  // columns; subsequent rows must match them.
+  Status WriteRow(const std::vector<Tensor>& row);
+
+  // Writes the buffered rows and the footer, and closes the file. The file is
+  // not valid until `Close()` returns OK.
+  Status Close();
+
+ private:
+  ColumnarFileWriter(std::unique_ptr<WritableFile> file,
+                     int64 rows_per_row_group);
+
+  // Writes the buffered rows as a row group.
+  Status FlushRowGroup();
+  // Appends zeros until `offset_` is a multiple of `kColumnarFileAlignment`.
+  Status Pad();
+
+  std::unique_ptr<WritableFile> file_;
+  const int64 rows_per_row_group_;
+  uint64 offset_ = 0;
+  ColumnarFileFooter footer_;
+  // The shapes of the rows of each column.
+  std::vector<TensorShape> shapes_;
+  // The values of each column for the buffered rows.
+  std::vector<std::string> buffers_;
+  // The statistics of each column for the buffered rows.
+  std::vector<ColumnarFileFooter::ColumnChunk> chunks_;
+  int64 num_buffered_rows_ = 0;
+};
+
+// Reads row groups of a columnar file. The file is memory-mapped if the file
+// system supports it, in which case column chunks are checksummed on first use
+// and read without copying them whenever the rows are suitably aligned.
+//
+// Note: this class is not thread safe; external synchronization required.
+class ColumnarFileReader {
+ public:
+  // Opens `filename` and reads its footer.
+  static Status Open(Env* env, const std::string& filename,
+                     std::unique_ptr<ColumnarFileReader>* out_reader);
+
+  const ColumnarFileFooter& footer() const { return footer_; }
+
+  // Returns the shape of the rows of `column`.
+  const TensorShape& shape(int64 column) const { return shapes_[column]; }
+
+  // Returns the total number of rows in the file.
+  int64 num_rows() const { return row_group_starts_.back(); }
+
+  int64 num_row_groups() const { return footer_.row_groups_size(); }
+
+  // Returns the index of the first row of `row_group`. `row_group` may be
+  // `num_row_groups()`, in which case `num_rows()` is returned.
+  int64 row_group_start(int64 row_group) const {
+    return row_group_starts_[row_group];
+  }
+
+  // Returns the index of the row group containing `row`.
+  int64 RowGroupForRow(int64 row) const;
+
+  // Returns false if no value of `column` in `row_group` lies in the closed
+  // interval [`min`, `max`], based on the statistics of the column chunk.
+  bool RowGroupMayContain(int64 row_group, int64 column, double min,
+                          double max) const;
+
+  // Reads `num_rows` rows of `column` starting at `row` into `*out`, whose
+  // shape is `[num_rows] + shape(column)`. The rows must be part of a single
+  // row group.
+  Status Read(int64 row, int64 num_rows, int64 column, Tensor* out);
+
+ private:
+  ColumnarFileReader(std::string filename, ColumnarFileFooter footer,
+                     std::shared_ptr<const ReadOnlyMemoryRegion> region,
+                     std::unique_ptr<RandomAccessFile> file);
+
+  // Validates the footer and computes `shapes_` and `row_group_starts_`.
+  Status Initialize(uint64 data_size);
+
+  // Makes the chunk of `column` in `row_group` available as `*chunk`, which is
+  // backed by the mapped file if the file is mapped and is read from the file
+  // otherwise.
+  Status ReadChunk(int64 row_group, int64 column, Tensor* chunk);
+
+  const std::string filename_;
+  const ColumnarFileFooter footer_;
+  // The memory-mapped file, or null if the file system does not support
+  // memory-mapping.
+  const std::shared_ptr<const ReadOnlyMemoryRegion> region_;
+  // The file, used if it is not memory-mapped.
+  const std::unique_ptr<RandomAccessFile> file_;
+  std::vector<TensorShape> shapes_;
+  std::vector<int64> row_group_starts_;
+  // Whether the checksum of the chunk of each (row group, column) has been
+  // verified, in row-group-major order.
+  std::vector<bool> verified_;
+  // The chunks of the most recently read row group, if the file is not
+  // memory-mapped.
+  int64 cached_row_group_ = -1;
+  std::vector<Tensor> cached_chunks_;
+};
+
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_COLUMNAR_FILE_H_
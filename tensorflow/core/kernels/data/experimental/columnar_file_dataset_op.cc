@@ -0,0 +1,376 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/columnar_file_dataset_op.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/experimental/columnar_file.h"
+#include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+/* static */ constexpr const char* const ColumnarFileDatasetOp::kDatasetType;
+/* static */ constexpr const char* const ColumnarFileDatasetOp::kFileNames;
+/* static */ constexpr const char* const ColumnarFileDatasetOp::kColumns;
+/* static */ constexpr const char* const ColumnarFileDatasetOp::kBatchSize;
+/* static */ constexpr const char* const ColumnarFileDatasetOp::kFilterColumn;
+/* static */ constexpr const char* const ColumnarFileDatasetOp::kFilterMin;
+/* static */ constexpr const char* const ColumnarFileDatasetOp::kFilterMax;
+/* static */ constexpr const char* const ColumnarFileDatasetOp::kOutputTypes;
+/* static */ constexpr const char* const ColumnarFileDatasetOp::kOutputShapes;
+
+namespace {
+
+constexpr char kCurrentFileIndex[] = "current_file_index";
+constexpr char kCurrentRow[] = "current_row";
+
+}  // namespace
+
+class ColumnarFileDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, std::vector<tstring> filenames,
+          std::vector<int64> columns, int64 batch_size, int64 filter_column,
+          double filter_min, double filter_max,
+          const DataTypeVector& output_types,
+          const std::vector<PartialTensorShape>& output_shapes)
+      : DatasetBase(DatasetContext(ctx)),
+        filenames_(std::move(filenames)),
+        columns_(std::move(columns)),
+        batch_size_(batch_size),
+        filter_column_(filter_column),
+        filter_min_(filter_min),
+        filter_max_(filter_max),
+        output_types_(output_types),
+        output_shapes_(output_shapes) {}
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return absl::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return output_types_;
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return output_shapes_;
+  }
+
+  string DebugString() const override {
+    return name_utils::DatasetDebugString(kDatasetType);
+  }
+
+  Status CheckExternalState() const override { return Status::OK(); }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* filenames = nullptr;
+    TF_RETURN_IF_ERROR(b->AddVector(filenames_, &filenames));
+    Node* columns = nullptr;
+    TF_RETURN_IF_ERROR(b->AddVector(columns_, &columns));
+    Node* batch_size = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(batch_size_, &batch_size));
+    Node* filter_column = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(filter_column_, &filter_column));
+    Node* filter_min = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(filter_min_, &filter_min));
+    Node* filter_max = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(filter_max_, &filter_max));
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this,
+        {filenames, columns, batch_size, filter_column, filter_min, filter_max},
+        output));
+    return Status::OK();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params) {}
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      mutex_lock l(mu_);
+      const int64 num_outputs = dataset()->output_types_.size();
+      // The slices of each output that make up the batch. Batches may span
+      // several row groups and files, but usually consist of a single slice
+      // of a single row group, which is returned without copying it.
+      std::vector<std::vector<Tensor>> slices(num_outputs);
+      int64 num_rows = 0;
+      while (num_rows < dataset()->batch_size_) {
+        if (!reader_) {
+          if (current_file_index_ == dataset()->filenames_.size()) {
+            break;
+          }
+          TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
+        }
+        int64 row_group;
+        if (!SkipFilteredRowGroupsLocked(&row_group)) {
+          reader_.reset();
+          ++current_file_index_;
+          current_row_ = 0;
+          continue;
+        }
+        const int64 n =
+            std::min(dataset()->batch_size_ - num_rows,
+                     reader_->row_group_start(row_group + 1) - current_row_);
+        for (int64 i = 0; i < num_outputs; ++i) {
+          slices[i].emplace_back();
+          TF_RETURN_IF_ERROR(
+              reader_->Read(current_row_, n, Column(i), &slices[i].back()));
+        }
+        current_row_ += n;
+        num_rows += n;
+      }
+      if (num_rows == 0) {
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      *end_of_sequence = false;
+      out_tensors->reserve(num_outputs);
+      for (int64 i = 0; i < num_outputs; ++i) {
+        if (slices[i].size() == 1) {
+          out_tensors->push_back(std::move(slices[i][0]));
+          continue;
+        }
+        TensorShape shape = slices[i][0].shape();
+        shape.set_dim(0, num_rows);
+        out_tensors->emplace_back(ctx->allocator({}),
+                                  dataset()->output_types_[i], shape);
+        char* dst =
+            const_cast<char*>(out_tensors->back().tensor_data().data());
+        for (const Tensor& slice : slices[i]) {
+          StringPiece src = slice.tensor_data();
+          std::memcpy(dst, src.data(), src.size());
+          dst += src.size();
+        }
+      }
+      return Status::OK();
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeSourceNode(std::move(args));
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kCurrentFileIndex),
+                                             current_file_index_));
+      if (reader_) {
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(full_name(kCurrentRow), current_row_));
+      }
+      return Status::OK();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      reader_.reset();
+      current_row_ = 0;
+      int64 current_file_index;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kCurrentFileIndex),
+                                            &current_file_index));
+      current_file_index_ = size_t(current_file_index);
+      if (reader->Contains(full_name(kCurrentRow))) {
+        int64 current_row;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(full_name(kCurrentRow), &current_row));
+        TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
+        if (current_row < 0 || current_row > reader_->num_rows()) {
+          return errors::DataLoss("Row ", current_row, " of ",
+                                  dataset()->filenames_[current_file_index_],
+                                  " is out of range.");
+        }
+        current_row_ = current_row;
+      }
+      return Status::OK();
+    }
+
+   private:
+    // Returns the column of the files that holds output `i`.
+    int64 Column(int64 i) const {
+      return dataset()->columns_.empty() ? i : dataset()->columns_[i];
+    }
+
+    // Opens the file at `current_file_index_` and checks that its columns
+    // match the outputs of the dataset.
+    Status SetupStreamsLocked(Env* env) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (current_file_index_ >= dataset()->filenames_.size()) {
+        return errors::InvalidArgument(
+            "current_file_index_:", current_file_index_,
+            " >= filenames_.size():", dataset()->filenames_.size());
+      }
+      const tstring& filename = dataset()->filenames_[current_file_index_];
+      std::unique_ptr<ColumnarFileReader> reader;
+      TF_RETURN_IF_ERROR(ColumnarFileReader::Open(env, filename, &reader));
+      const int64 num_columns = reader->footer().columns_size();
+      const int64 num_outputs = dataset()->output_types_.size();
+      if (dataset()->columns_.empty() && num_columns != num_outputs) {
+        return errors::InvalidArgument(
+            "Expected ", dataset()->output_types_.size(), " columns in ",
+            filename, ", but found ", num_columns, ".");
+      }
+      if (dataset()->filter_column_ >= num_columns) {
+        return errors::InvalidArgument("Filter column ",
+                                       dataset()->filter_column_,
+                                       " is out of range for ", filename,
+                                       ", which has ", num_columns,
+                                       " columns.");
+      }
+      for (int64 i = 0; i < num_outputs; ++i) {
+        const int64 column = Column(i);
+        if (column >= num_columns) {
+          return errors::InvalidArgument("Column ", column,
+                                         " is out of range for ", filename,
+                                         ", which has ", num_columns,
+                                         " columns.");
+        }
+        const DataType dtype = reader->footer().columns(column).dtype();
+        PartialTensorShape shape = PartialTensorShape({-1}).Concatenate(
+            PartialTensorShape(reader->shape(column).dim_sizes()));
+        if (dtype != dataset()->output_types_[i] ||
+            !shape.IsCompatibleWith(dataset()->output_shapes_[i])) {
+          return errors::InvalidArgument(
+              "Column ", column, " of ", filename, " has type ",
+              DataTypeString(dtype), " and batched shape ",
+              shape.DebugString(), ", which does not match the expected type ",
+              DataTypeString(dataset()->output_types_[i]), " and shape ",
+              dataset()->output_shapes_[i].DebugString(), ".");
+        }
+      }
+      reader_ = std::move(reader);
+      return Status::OK();
+    }
+
+    // Advances `current_row_` past the row groups whose statistics rule out
+    // values in the filter range. Returns false if no rows remain in the
+    // current file, and otherwise sets `*row_group` to the row group of
+    // `current_row_`.
+    bool SkipFilteredRowGroupsLocked(int64* row_group)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      while (current_row_ < reader_->num_rows()) {
+        *row_group = reader_->RowGroupForRow(current_row_);
+        if (dataset()->filter_column_ < 0 ||
+            reader_->RowGroupMayContain(*row_group, dataset()->filter_column_,
+                                        dataset()->filter_min_,
+                                        dataset()->filter_max_)) {
+          return true;
+        }
+        current_row_ = reader_->row_group_start(*row_group + 1);
+      }
+      return false;
+    }
+
+    mutex mu_;
+    size_t current_file_index_ TF_GUARDED_BY(mu_) = 0;
+    // The index of the next row to read from the current file.
+    int64 current_row_ TF_GUARDED_BY(mu_) = 0;
+    std::unique_ptr<ColumnarFileReader> reader_ TF_GUARDED_BY(mu_);
+  };
+
+  const std::vector<tstring> filenames_;
+  const std::vector<int64> columns_;
+  const int64 batch_size_;
+  const int64 filter_column_;
+  const double filter_min_;
+  const double filter_max_;
+  const DataTypeVector output_types_;
+  const std::vector<PartialTensorShape> output_shapes_;
+};
+
+ColumnarFileDatasetOp::ColumnarFileDatasetOp(OpKernelConstruction* ctx)
+    : DatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputTypes, &output_types_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputShapes, &output_shapes_));
+  OP_REQUIRES(ctx, output_types_.size() == output_shapes_.size(),
+              errors::InvalidArgument(
+                  "`output_types` and `output_shapes` must have the same "
+                  "length."));
+}
+
+void ColumnarFileDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                        DatasetBase** output) {
+  const Tensor* filenames_tensor;
+  OP_REQUIRES_OK(ctx, ctx->input(kFileNames, &filenames_tensor));
+  OP_REQUIRES(
+      ctx, filenames_tensor->dims() <= 1,
+      errors::InvalidArgument("`filenames` must be a scalar or a vector."));
+  std::vector<tstring> filenames;
+  filenames.reserve(filenames_tensor->NumElements());
+  for (int i = 0; i < filenames_tensor->NumElements(); ++i) {
+    filenames.push_back(filenames_tensor->flat<tstring>()(i));
+  }
+
+  std::vector<int64> columns;
+  OP_REQUIRES_OK(ctx, ParseVectorArgument<int64>(ctx, kColumns, &columns));
+  OP_REQUIRES(ctx, columns.empty() || columns.size() == output_types_.size(),
+              errors::InvalidArgument(
+                  "`columns` must be empty or have one element per output, "
+                  "but got ",
+                  columns.size(), " columns for ", output_types_.size(),
+                  " outputs."));
+  for (int64 column : columns) {
+    OP_REQUIRES(ctx, column >= 0,
+                errors::InvalidArgument(
+                    "`columns` must be non-negative, but got ", column, "."));
+  }
+
+  int64 batch_size;
+  OP_REQUIRES_OK(ctx,
+                 ParseScalarArgument<int64>(ctx, kBatchSize, &batch_size));
+  OP_REQUIRES(ctx, batch_size > 0,
+              errors::InvalidArgument("`batch_size` must be positive, but got ",
+                                      batch_size, "."));
+
+  int64 filter_column;
+  OP_REQUIRES_OK(
+      ctx, ParseScalarArgument<int64>(ctx, kFilterColumn, &filter_column));
+  double filter_min;
+  OP_REQUIRES_OK(ctx,
+                 ParseScalarArgument<double>(ctx, kFilterMin, &filter_min));
+  double filter_max;
+  OP_REQUIRES_OK(ctx,
+                 ParseScalarArgument<double>(ctx, kFilterMax, &filter_max));
+
+  *output = new Dataset(ctx, std::move(filenames), std::move(columns),
+                        batch_size, filter_column, filter_min, filter_max,
+                        output_types_, output_shapes_);
+}
+
+namespace {
+
+REGISTER_KERNEL_BUILDER(Name("ColumnarFileDataset").Device(DEVICE_CPU),
+                        ColumnarFileDatasetOp);
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
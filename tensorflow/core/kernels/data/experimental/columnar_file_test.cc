@@ -0,0 +1,150 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/data/experimental/columnar_file.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+// Writes `num_rows` rows to `filename`, where row `i` has an int64 scalar
+// column with value `i` and a float vector column with values `[i, -i]`.
+void WriteTestFile(const std::string& filename, int64 num_rows,
+                   int64 rows_per_row_group) {
+  std::unique_ptr<ColumnarFileWriter> writer;
+  TF_ASSERT_OK(ColumnarFileWriter::Create(Env::Default(), filename,
+                                          rows_per_row_group, &writer));
+  for (int64 i = 0; i < num_rows; ++i) {
+    TF_ASSERT_OK(writer->WriteRow(
+        {test::AsScalar<int64>(i),
+         test::AsTensor<float>({static_cast<float>(i),
+                                -static_cast<float>(i)})}));
+  }
+  TF_ASSERT_OK(writer->Close());
+}
+
+TEST(ColumnarFileTest, RoundTrip) {
+  std::string filename;
+  ASSERT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  WriteTestFile(filename, /*num_rows=*/10, /*rows_per_row_group=*/4);
+
+  std::unique_ptr<ColumnarFileReader> reader;
+  TF_ASSERT_OK(ColumnarFileReader::Open(Env::Default(), filename, &reader));
+  EXPECT_EQ(reader->num_rows(), 10);
+  EXPECT_EQ(reader->num_row_groups(), 3);
+  EXPECT_EQ(reader->row_group_start(2), 8);
+  EXPECT_EQ(reader->RowGroupForRow(7), 1);
+  EXPECT_EQ(reader->shape(1), TensorShape({2}));
+
+  Tensor ids;
+  TF_ASSERT_OK(reader->Read(/*row=*/4, /*num_rows=*/4, /*column=*/0, &ids));
+  test::ExpectTensorEqual<int64>(ids, test::AsTensor<int64>({4, 5, 6, 7}));
+
+  Tensor values;
+  TF_ASSERT_OK(reader->Read(/*row=*/9, /*num_rows=*/1, /*column=*/1, &values));
+  test::ExpectTensorEqual<float>(
+      values, test::AsTensor<float>({9.0f, -9.0f}, TensorShape({1, 2})));
+}
+
+TEST(ColumnarFileTest, ReadAcrossRowGroups) {
+  std::string filename;
+  ASSERT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  WriteTestFile(filename, /*num_rows=*/10, /*rows_per_row_group=*/4);
+
+  std::unique_ptr<ColumnarFileReader> reader;
+  TF_ASSERT_OK(ColumnarFileReader::Open(Env::Default(), filename, &reader));
+  Tensor ids;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      reader->Read(/*row=*/2, /*num_rows=*/4, /*column=*/0, &ids)));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      reader->Read(/*row=*/0, /*num_rows=*/1, /*column=*/2, &ids)));
+}
+
+TEST(ColumnarFileTest, RowGroupStatistics) {
+  std::string filename;
+  ASSERT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  WriteTestFile(filename, /*num_rows=*/10, /*rows_per_row_group=*/4);
+
+  std::unique_ptr<ColumnarFileReader> reader;
+  TF_ASSERT_OK(ColumnarFileReader::Open(Env::Default(), filename, &reader));
+  EXPECT_TRUE(reader->RowGroupMayContain(/*row_group=*/0, /*column=*/0,
+                                         /*min=*/3.0, /*max=*/5.0));
+  EXPECT_TRUE(reader->RowGroupMayContain(/*row_group=*/1, /*column=*/0,
+                                         /*min=*/3.0, /*max=*/5.0));
+  EXPECT_FALSE(reader->RowGroupMayContain(/*row_group=*/2, /*column=*/0,
+                                          /*min=*/3.0, /*max=*/5.0));
+  EXPECT_TRUE(reader->RowGroupMayContain(/*row_group=*/2, /*column=*/1,
+                                         /*min=*/-8.5, /*max=*/-8.0));
+  EXPECT_FALSE(reader->RowGroupMayContain(/*row_group=*/0, /*column=*/1,
+                                          /*min=*/-8.5, /*max=*/-8.0));
+}
+
+TEST(ColumnarFileTest, MismatchedRows) {
+  std::string filename;
+  ASSERT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  std::unique_ptr<ColumnarFileWriter> writer;
+  TF_ASSERT_OK(ColumnarFileWriter::Create(Env::Default(), filename,
+                                          /*rows_per_row_group=*/2, &writer));
+  TF_ASSERT_OK(writer->WriteRow({test::AsScalar<int64>(0)}));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      writer->WriteRow({test::AsTensor<int64>({1, 2})})));
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(writer->WriteRow({test::AsScalar<float>(1)})));
+  EXPECT_TRUE(errors::IsInvalidArgument(writer->WriteRow(
+      {test::AsScalar<int64>(1), test::AsScalar<int64>(2)})));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      writer->WriteRow({test::AsScalar<tstring>("a")})));
+}
+
+TEST(ColumnarFileTest, CorruptedChunk) {
+  std::string filename;
+  ASSERT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  WriteTestFile(filename, /*num_rows=*/10, /*rows_per_row_group=*/4);
+
+  std::string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), filename, &contents));
+  // The first chunk holds the ids of the first row group.
+  contents[0] ^= 1;
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename, contents));
+
+  std::unique_ptr<ColumnarFileReader> reader;
+  TF_ASSERT_OK(ColumnarFileReader::Open(Env::Default(), filename, &reader));
+  Tensor ids;
+  EXPECT_TRUE(errors::IsDataLoss(
+      reader->Read(/*row=*/0, /*num_rows=*/1, /*column=*/0, &ids)));
+  TF_EXPECT_OK(reader->Read(/*row=*/4, /*num_rows=*/1, /*column=*/0, &ids));
+}
+
+TEST(ColumnarFileTest, NotAColumnarFile) {
+  std::string filename;
+  ASSERT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename,
+                                 "this is not a columnar file"));
+  std::unique_ptr<ColumnarFileReader> reader;
+  EXPECT_TRUE(errors::IsDataLoss(
+      ColumnarFileReader::Open(Env::Default(), filename, &reader)));
+}
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
+#include "tensorflow/core/util/csv_parsing.h"
 
 namespace tensorflow {
 namespace data {
@@ -270,7 +271,9 @@ class CSVDatasetOp : public DatasetOpKernel {
     class Iterator : public DatasetIterator<Dataset> {
      public:
       explicit Iterator(const Params& params)
-          : DatasetIterator<Dataset>(params) {}
+          : DatasetIterator<Dataset>(params),
+            scanner_(params.dataset->delim_,
+                     params.dataset->use_quote_delim_) {}
 
       Status GetNextInternal(IteratorContext* ctx,
                              std::vector<Tensor>* out_tensors,
@@ -556,7 +559,10 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
 
           } else {
-            pos_++;
+            // Skip to the next quotation mark, which is the only character
+            // that can end the field.
+            pos_ = std::min(StringPiece(buffer_).find('"', pos_),
+                            buffer_.size());
           }
         }
       }
@@ -651,6 +657,12 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
           }
 
+          // Skip to the next delimiter, line break or quotation mark, which
+          // are the only characters that can end the field.
+          pos_ = scanner_.Find(buffer_, pos_);
+          if (pos_ >= buffer_.size()) {
+            continue;
+          }
           char ch = buffer_[pos_];
 
           if (ch == dataset()->delim_) {
@@ -682,6 +694,7 @@ class CSVDatasetOp : public DatasetOpKernel {
       }
 
       Status FillBuffer(tstring* result) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        scanner_.Reset();
         result->clear();
         ++num_buffer_reads_;
         Status s = input_stream_->ReadNBytes(
@@ -724,7 +737,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                   dataset()->record_defaults_[output_idx].flat<int32>()(0);
             } else {
               int32 value;
-              if (!strings::safe_strto32(field, &value)) {
+              if (!csv::ParseInt32(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid int32: ", field);
@@ -739,7 +752,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                   dataset()->record_defaults_[output_idx].flat<int64>()(0);
             } else {
               int64 value;
-              if (!strings::safe_strto64(field, &value)) {
+              if (!csv::ParseInt64(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid int64: ", field);
@@ -754,7 +767,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                   dataset()->record_defaults_[output_idx].flat<float>()(0);
             } else {
               float value;
-              if (!strings::safe_strtof(field, &value)) {
+              if (!csv::ParseFloat(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid float: ", field);
@@ -769,7 +782,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                   dataset()->record_defaults_[output_idx].flat<double>()(0);
             } else {
               double value;
-              if (!strings::safe_strtod(field, &value)) {
+              if (!csv::ParseDouble(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid double: ", field);
@@ -891,6 +904,8 @@ class CSVDatasetOp : public DatasetOpKernel {
       size_t pos_ TF_GUARDED_BY(
           mu_);  // Index into the buffer must be maintained between iters
       size_t num_buffer_reads_ TF_GUARDED_BY(mu_);
+      // Finds the ends of unquoted fields in `buffer_`.
+      csv::StructuralScanner scanner_ TF_GUARDED_BY(mu_);
       std::shared_ptr<io::RandomAccessInputStream> random_access_input_stream_
           TF_GUARDED_BY(mu_);
       std::shared_ptr<io::InputStreamInterface> input_stream_
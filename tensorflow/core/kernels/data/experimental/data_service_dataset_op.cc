@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/experimental/data_service_dataset_op.h"
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <queue>
@@ -298,11 +299,16 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     struct Task {
       Task(int64 task_id, const std::string& address,
            std::unique_ptr<DataServiceWorkerClient> worker)
-          : task_id(task_id), address(address), worker(std::move(worker)) {}
+          : task_id(task_id),
+            address(address),
+            local(IsLocalAddress(address)),
+            worker(std::move(worker)) {}
 
       const int64 task_id;
       // Address of the tf.data service worker for task `task_id`.
       const std::string address;
+      // Whether the worker runs on the same host as this iterator.
+      const bool local;
       // Client for fetching task elements from the tf.data service worker.
       const std::unique_ptr<DataServiceWorkerClient> worker;
       // Indicates whether a worker thread is currently processing the task.
@@ -422,12 +428,14 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       });
       VLOG(1) << "Starting worker thread";
       std::shared_ptr<Task> task_to_process;
+      int64 max_elements = 1;
       while (true) {
         {
           mutex_lock l(mu_);
           if (task_to_process) {
             task_to_process->in_use = false;
             task_to_process = nullptr;
+            reserved_elements_ -= max_elements - 1;
             worker_thread_cv_.notify_one();
           }
           outstanding_requests_--;
@@ -446,29 +454,48 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
           if (cancelled_) {
             return;
           }
-          // Search for a task to update.
+          // Search for a task to update, preferring tasks on co-located
+          // workers so that they never sit idle, and visiting the remaining
+          // tasks round-robin.
           int num_tasks = tasks_.size();
-          for (int i = 0; i < num_tasks; ++i) {
+          for (const std::shared_ptr<Task>& task : tasks_) {
+            if (task->local && !task->in_use && !task->end_of_sequence) {
+              task->in_use = true;
+              task_to_process = task;
+              break;
+            }
+          }
+          for (int i = 0; !task_to_process && i < num_tasks; ++i) {
             int index = (next_task_index_ + i) % num_tasks;
             std::shared_ptr<Task>& task = tasks_[index];
             if (!task->in_use && !task->end_of_sequence) {
               task->in_use = true;
               task_to_process = task;
               next_task_index_ = (index + 1) % num_tasks;
-              break;
             }
           }
           DCHECK(task_to_process != nullptr);
+          // Let the request take its share of the free buffer space, so that
+          // small elements are fetched several at a time. The extra space is
+          // reserved until the request completes.
+          int64 free_space = max_outstanding_requests_ - results_.size() -
+                             outstanding_requests_ - reserved_elements_;
+          int64 active_tasks = tasks_.size() - finished_tasks_;
+          max_elements = 1 + std::max<int64>(free_space, 0) /
+                                 std::max<int64>(active_tasks, 1);
+          reserved_elements_ += max_elements - 1;
           VLOG(3) << "Processing task " << task_to_process->task_id;
         }
         int64 deadline_micros =
             Env::Default()->NowMicros() + kRetryTimeoutMicros;
-        Status s = GetElement(task_to_process.get(), deadline_micros);
+        Status s =
+            GetElements(task_to_process.get(), max_elements, deadline_micros);
         if (!s.ok()) {
           mutex_lock l(mu_);
           VLOG(1) << "Failed to get element for task "
                   << task_to_process->task_id << ": " << s;
           task_to_process->in_use = false;
+          reserved_elements_ -= max_elements - 1;
           status_ = s;
           get_next_cv_.notify_all();
           return;
@@ -476,21 +503,23 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       }
     }
 
-    // Gets an element from a task and adds the element to `results_`.
+    // Gets up to `max_elements` elements from a task and adds the elements to
+    // `results_`.
     //
     // If the task reaches end_of_sequence or is cancelled (e.g. due to a
-    // worker dying), GetElement returns Status::OK() without adding to
+    // worker dying), GetElements returns Status::OK() without adding to
     // `results_`.
-    Status GetElement(Task* task, int64 deadline_micros)
+    Status GetElements(Task* task, int64 max_elements, int64 deadline_micros)
         TF_LOCKS_EXCLUDED(mu_) {
-      VLOG(3) << "Getting an element for task id " << task->task_id;
+      VLOG(3) << "Getting up to " << max_elements
+              << " elements for task id " << task->task_id;
       tensorflow::profiler::TraceMe activity(
           "GetDataServiceElement", tensorflow::profiler::TraceMeLevel::kInfo);
-      CompressedElement compressed;
+      std::vector<CompressedElement> compressed;
       bool end_of_sequence;
       for (int num_retries = 0;; ++num_retries) {
-        Status s = task->worker->GetElement(task->task_id, &compressed,
-                                            &end_of_sequence);
+        Status s = task->worker->GetElements(task->task_id, max_elements,
+                                             &compressed, &end_of_sequence);
         if (s.ok()) {
           break;
         }
@@ -523,11 +552,12 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
         Env::Default()->SleepForMicroseconds(backoff_until - now_micros);
       }
 
-      std::vector<Tensor> element;
-      if (!end_of_sequence) {
+      std::vector<std::vector<Tensor>> elements;
+      elements.reserve(compressed.size());
+      for (CompressedElement& element : compressed) {
         Tensor tensor(DT_VARIANT, TensorShape{});
-        tensor.scalar<Variant>()() = std::move(compressed);
-        element.push_back(tensor);
+        tensor.scalar<Variant>()() = std::move(element);
+        elements.push_back({std::move(tensor)});
       }
       mutex_lock l(mu_);
       if (end_of_sequence) {
@@ -535,14 +565,17 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
         finished_tasks_++;
         return Status::OK();
       }
-      results_.push(std::move(element));
+      for (std::vector<Tensor>& element : elements) {
+        results_.push(std::move(element));
+      }
       get_next_cv_.notify_all();
-      VLOG(3) << "Got an element for task id " << task->task_id;
+      VLOG(3) << "Got " << elements.size() << " elements for task id "
+              << task->task_id;
       return Status::OK();
     }
 
     bool SpaceInBuffer() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-      return results_.size() + outstanding_requests_ <
+      return results_.size() + outstanding_requests_ + reserved_elements_ <
              max_outstanding_requests_;
     }
 
@@ -565,6 +598,9 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     // at the same time. This count includes both in-progress requests for
     // elements as well as completed requests which haven't yet been produced.
     int64 max_outstanding_requests_ TF_GUARDED_BY(mu_);
+    // Buffer space reserved by in-progress requests for elements beyond the
+    // first, counted against `max_outstanding_requests_`.
+    int64 reserved_elements_ TF_GUARDED_BY(mu_) = 0;
 
     // The number of threads in `worker_threads_` which are still running.
     int64 num_running_worker_threads_ TF_GUARDED_BY(mu_) = 0;
@@ -244,6 +244,12 @@ class MapAndBatchDatasetOp::Dataset : public DatasetBase {
         batch_results_.pop_front();
         cond_var_->notify_all();
       }
+      {
+        mutex_lock l(result->mu);
+        if (result->output_allocated) {
+          RecordBufferDequeue(ctx, result->output);
+        }
+      }
       profiler::TraceMe traceme([&] {
         return profiler::TraceMeEncode("MapAndBatchConsume",
                                        {{"element_id", result->id}});
@@ -523,6 +529,10 @@ class MapAndBatchDatasetOp::Dataset : public DatasetBase {
         }
       }
       result->output_allocated = true;
+      // The batch is buffered from the time its output is allocated until it
+      // is consumed, so that the model accounts for its memory while the
+      // batch is being filled in.
+      RecordBufferEnqueue(ctx.get(), result->output);
       return Status::OK();
     }
 
@@ -70,6 +70,9 @@ namespace experimental {
     SnapshotDatasetV2Op::kReaderFuncTarguments;
 /* static */ constexpr const char* const
     SnapshotDatasetV2Op::kShardFuncTarguments;
+/* static */ constexpr const char* const
+    SnapshotDatasetV2Op::kPipelineBufferSize;
+/* static */ constexpr const char* const SnapshotDatasetV2Op::kShardSizeBytes;
 /* static */ constexpr const int SnapshotDatasetV2Op::kFileFormatVersion;
 
 // ==== Snapshot Implementation ====
@@ -83,6 +86,8 @@ namespace experimental {
  *           // new checkpoint files are created on all threads at once, either
  *           // when a file gets too big, or when a TF checkpoint happens.
  *           - 00000000.snapshot  // checkpoint file 0
+ *           - 00000000_00000001.snapshot  // part 1 of checkpoint file 0, if
+ *                                         // `shard_size_bytes` is set
  *           - 00000001.snapshot  // checkpoint file 1
  *           - ...
  *         - 00000001.shard/
@@ -106,6 +111,7 @@ class SnapshotDatasetV2Op::Dataset : public DatasetBase {
  public:
   Dataset(OpKernelContext* ctx, const DatasetBase* input, uint64 hash,
           const std::string& path, const std::string& compression,
+          int64 pipeline_buffer_size, int64 shard_size_bytes,
           std::unique_ptr<CapturedFunction> reader_func,
           std::unique_ptr<CapturedFunction> shard_func);
 
@@ -130,10 +136,18 @@ class SnapshotDatasetV2Op::Dataset : public DatasetBase {
                             Node** output) const override;
 
  private:
+  // Returns the options for overlapping (de)compression with file I/O.
+  snapshot_util::PipelineOptions GetPipelineOptions(IteratorContext* ctx) const;
+
+  // Returns the file format version that new snapshots are written in.
+  int64 GetFileFormatVersion() const;
+
   const DatasetBase* input_;
   const uint64 hash_;
   const tstring path_;
   const std::string compression_;
+  const int64 pipeline_buffer_size_;
+  const int64 shard_size_bytes_;
 
   std::unique_ptr<CapturedFunction> reader_func_;
   std::unique_ptr<CapturedFunction> shard_func_;
@@ -289,6 +303,7 @@ class SnapshotDatasetV2Op::Dataset::Iterator::Passthrough
 SnapshotDatasetV2Op::Dataset::Dataset(
     OpKernelContext* ctx, const DatasetBase* input, uint64 hash,
     const std::string& path, const std::string& compression,
+    int64 pipeline_buffer_size, int64 shard_size_bytes,
     std::unique_ptr<CapturedFunction> reader_func,
     std::unique_ptr<CapturedFunction> shard_func)
     : DatasetBase(DatasetContext(ctx)),
@@ -296,6 +311,8 @@ SnapshotDatasetV2Op::Dataset::Dataset(
       hash_(hash),
       path_(path),
       compression_(compression),
+      pipeline_buffer_size_(pipeline_buffer_size),
+      shard_size_bytes_(shard_size_bytes),
       reader_func_(std::move(reader_func)),
       shard_func_(std::move(shard_func)) {
   input_->Ref();
@@ -330,6 +347,27 @@ Status SnapshotDatasetV2Op::Dataset::CheckExternalState() const {
   return input_->CheckExternalState();
 }
 
+snapshot_util::PipelineOptions SnapshotDatasetV2Op::Dataset::GetPipelineOptions(
+    IteratorContext* ctx) const {
+  snapshot_util::PipelineOptions options;
+  if (pipeline_buffer_size_ > 0) {
+    options.runner = *ctx->runner();
+    options.max_elements_in_flight = pipeline_buffer_size_;
+  }
+  options.file_size_bytes = shard_size_bytes_;
+  return options;
+}
+
+int64 SnapshotDatasetV2Op::Dataset::GetFileFormatVersion() const {
+  // Version 2 files compress the whole record stream, which can only be done
+  // by the thread writing the file. Version 1 files compress each element
+  // separately with snappy, so pipelined writers can compress on the runner.
+  if (pipeline_buffer_size_ > 0 && compression_ == io::compression::kSnappy) {
+    return 1;
+  }
+  return kFileFormatVersion;
+}
+
 Status SnapshotDatasetV2Op::Dataset::AsGraphDefInternal(
     SerializationContext* ctx, DatasetGraphDefBuilder* b, Node** output) const {
   Node* input_graph_node = nullptr;
@@ -365,6 +403,27 @@ Status SnapshotDatasetV2Op::Dataset::AsGraphDefInternal(
   b->BuildAttrValue(shard_func_other_args_types,
                     &shard_func_arguments_types_attr);
 
+  std::vector<std::pair<StringPiece, AttrValue>> attrs = {
+      {kCompression, compression_attr},
+      {kReaderFunc, reader_func_attr},
+      {kShardFunc, shard_func_attr},
+      {kReaderFuncTarguments, reader_func_arguments_types_attr},
+      {kShardFuncTarguments, shard_func_arguments_types_attr}};
+
+  // The pipelined writer attrs are only added when they are set, so that the
+  // graphs of other snapshots remain readable by binaries that predate them.
+  if (pipeline_buffer_size_ > 0) {
+    AttrValue pipeline_buffer_size_attr;
+    b->BuildAttrValue(pipeline_buffer_size_, &pipeline_buffer_size_attr);
+    attrs.emplace_back(kPipelineBufferSize, pipeline_buffer_size_attr);
+  }
+
+  if (shard_size_bytes_ > 0) {
+    AttrValue shard_size_bytes_attr;
+    b->BuildAttrValue(shard_size_bytes_, &shard_size_bytes_attr);
+    attrs.emplace_back(kShardSizeBytes, shard_size_bytes_attr);
+  }
+
   return b->AddDataset(
       this,
       /*inputs=*/
@@ -372,13 +431,7 @@ Status SnapshotDatasetV2Op::Dataset::AsGraphDefInternal(
       /*list_inputs=*/
       {std::make_pair(2, reader_func_other_args),
        std::make_pair(3, shard_func_other_args)},
-      /*attrs=*/
-      {{kCompression, compression_attr},
-       {kReaderFunc, reader_func_attr},
-       {kShardFunc, shard_func_attr},
-       {kReaderFuncTarguments, reader_func_arguments_types_attr},
-       {kShardFuncTarguments, shard_func_arguments_types_attr}},
-      output);
+      /*attrs=*/attrs, output);
 }
 
 SnapshotDatasetV2Op::Dataset::Iterator::Iterator(const Params& params)
@@ -531,7 +584,8 @@ Status SnapshotDatasetV2Op::Dataset::Iterator::Reader::Initialize(
   TF_RETURN_IF_ERROR(snapshot_util::Reader::MakeNestedDataset(
       ctx->env(), snapshot_shard_dirs, dataset()->compression_,
       metadata.version(), dataset()->output_dtypes(),
-      dataset()->output_shapes(), start_index_, &dataset_of_snapshot_files));
+      dataset()->output_shapes(), start_index_, &dataset_of_snapshot_files,
+      dataset()->GetPipelineOptions(ctx)));
 
   Tensor input_dataset_tensor(DT_VARIANT, TensorShape({}));
   TF_RETURN_IF_ERROR(StoreDatasetInVariantTensor(dataset_of_snapshot_files,
@@ -607,7 +661,7 @@ Status SnapshotDatasetV2Op::Dataset::Iterator::Writer::WriteMetadataFile(
   metadata.set_creation_timestamp(EnvTime::NowMicros());
   metadata.set_graph_hash(strings::StrCat(dataset()->hash_));
   metadata.set_run_id(strings::StrCat(run_id_));
-  metadata.set_version(kFileFormatVersion);
+  metadata.set_version(dataset()->GetFileFormatVersion());
   for (const auto& output_dtype : dataset()->output_dtypes()) {
     metadata.add_dtype(output_dtype);
   }
@@ -696,13 +750,15 @@ Status SnapshotDatasetV2Op::Dataset::Iterator::Writer::GetNextInternal(
           snapshot_util::ShardDirectory(run_dir_, shard_index);
       auto writer = std::make_unique<snapshot_util::AsyncWriter>(
           ctx->env(), shard_index, snapshot_shard_directory,
-          current_checkpoint_id_, dataset()->compression_, kFileFormatVersion,
-          dataset()->output_dtypes(), [this](Status s) {
+          current_checkpoint_id_, dataset()->compression_,
+          dataset()->GetFileFormatVersion(), dataset()->output_dtypes(),
+          [this](Status s) {
             if (!s.ok()) {
               mutex_lock l(mu_);
               writer_status_ = s;
             }
-          });
+          },
+          dataset()->GetPipelineOptions(ctx));
       writers_.insert({shard_index, std::move(writer)});
     }
     current_writer = writers_[shard_index].get();
@@ -778,6 +834,17 @@ SnapshotDatasetV2Op::SnapshotDatasetV2Op(OpKernelConstruction* ctx)
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputTypes, &output_types_));
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputShapes, &output_shapes_));
   OP_REQUIRES_OK(ctx, ctx->GetAttr(kCompression, &compression_));
+  if (ctx->HasAttr(kPipelineBufferSize)) {
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr(kPipelineBufferSize, &pipeline_buffer_size_));
+  }
+  if (ctx->HasAttr(kShardSizeBytes)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kShardSizeBytes, &shard_size_bytes_));
+  }
+  OP_REQUIRES(ctx, pipeline_buffer_size_ >= 0,
+              errors::InvalidArgument("`pipeline_buffer_size` must be >= 0."));
+  OP_REQUIRES(ctx, shard_size_bytes_ >= 0,
+              errors::InvalidArgument("`shard_size_bytes` must be >= 0."));
 
   OP_REQUIRES_OK(ctx, FunctionMetadata::Create(ctx, kReaderFunc, reader_params,
                                                &reader_func_metadata_));
@@ -812,8 +879,8 @@ void SnapshotDatasetV2Op::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                                           kShardFuncOtherArgs, &shard_func));
 
   *output = new SnapshotDatasetV2Op::Dataset(
-      ctx, input, graph_hash, path, compression_, std::move(reader_func),
-      std::move(shard_func));
+      ctx, input, graph_hash, path, compression_, pipeline_buffer_size_,
+      shard_size_bytes_, std::move(reader_func), std::move(shard_func));
 }
 
 namespace {
@@ -53,6 +53,9 @@ class SnapshotDatasetV2Op : public UnaryDatasetOpKernel {
   static constexpr const char* const kReaderFuncTarguments =
       "Treader_func_args";
   static constexpr const char* const kShardFuncTarguments = "Tshard_func_args";
+  static constexpr const char* const kPipelineBufferSize =
+      "pipeline_buffer_size";
+  static constexpr const char* const kShardSizeBytes = "shard_size_bytes";
 
   explicit SnapshotDatasetV2Op(OpKernelConstruction* ctx);
 
@@ -70,6 +73,8 @@ class SnapshotDatasetV2Op : public UnaryDatasetOpKernel {
   std::vector<PartialTensorShape> output_shapes_;
 
   std::string compression_;
+  int64 pipeline_buffer_size_ = 0;
+  int64 shard_size_bytes_ = 0;
 
   std::shared_ptr<FunctionMetadata> reader_func_metadata_;
   std::shared_ptr<FunctionMetadata> shard_func_metadata_;
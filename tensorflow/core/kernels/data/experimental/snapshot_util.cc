@@ -15,13 +15,18 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/experimental/snapshot_util.h"
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
 #include <queue>
 
 #include "absl/memory/memory.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
@@ -35,7 +40,9 @@ limitations under the License.
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/protobuf/data/experimental/snapshot.pb.h"
@@ -49,6 +56,163 @@ namespace snapshot_util {
 /* static */ constexpr const int64
     CustomReader::kSnappyReaderOutputBufferSizeBytes;
 
+namespace {
+
+// Wire format tags of the `SnapshotRecord` and `TensorProto` fields that
+// tensors are encoded with.
+constexpr uint32 kSnapshotRecordTensorTag = (1 << 3) | 2;
+constexpr uint32 kTensorProtoDtypeTag = (1 << 3) | 0;
+constexpr uint32 kTensorProtoShapeTag = (2 << 3) | 2;
+constexpr uint32 kTensorProtoVersionNumberTag = (3 << 3) | 0;
+constexpr uint32 kTensorProtoContentTag = (4 << 3) | 2;
+
+// A `TensorProto` serialized in two parts: `header` holds every field but
+// `tensor_content`, and `content` points at the tensor's own buffer. This lets
+// encoders copy the tensor data straight into the output record.
+struct EncodedTensor {
+  std::string header;
+  StringPiece content;
+
+  // The size of the serialized `TensorProto`.
+  size_t size() const {
+    if (content.empty()) return header.size();
+    return header.size() + 1 + core::VarintLength(content.size()) +
+           content.size();
+  }
+
+  void AppendTo(std::string* output) const {
+    output->append(header);
+    if (!content.empty()) {
+      output->push_back(static_cast<char>(kTensorProtoContentTag));
+      core::PutVarint64(output, content.size());
+      output->append(content.data(), content.size());
+    }
+  }
+};
+
+// Produces the same bytes as `AsProtoTensorContent` followed by serialization,
+// since fields are serialized in field number order.
+EncodedTensor EncodeTensor(const Tensor& tensor) {
+  EncodedTensor encoded;
+  TensorProto proto;
+  if (DataTypeCanUseMemcpy(tensor.dtype())) {
+    proto.set_dtype(tensor.dtype());
+    tensor.shape().AsProto(proto.mutable_tensor_shape());
+    encoded.content = tensor.tensor_data();
+  } else {
+    tensor.AsProtoTensorContent(&proto);
+  }
+  proto.SerializeToString(&encoded.header);
+  return encoded;
+}
+
+// A tensor buffer that aliases part of a record read from a snapshot file and
+// keeps the record alive.
+class RecordTensorBuffer : public TensorBuffer {
+ public:
+  RecordTensorBuffer(const char* data, size_t size,
+                     std::shared_ptr<const tstring> record)
+      : TensorBuffer(const_cast<char*>(data)),
+        size_(size),
+        record_(std::move(record)) {}
+
+  size_t size() const override { return size_; }
+
+  TensorBuffer* root_buffer() override { return this; }
+
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("snapshot_record");
+  }
+
+ private:
+  const size_t size_;
+  const std::shared_ptr<const tstring> record_;
+};
+
+bool IsAligned(const char* data) {
+#if EIGEN_MAX_ALIGN_BYTES == 0
+  return true;
+#else
+  return reinterpret_cast<uintptr_t>(data) % EIGEN_MAX_ALIGN_BYTES == 0;
+#endif
+}
+
+// Decodes the `TensorProto` serialized at `data[0, size)`, which lies within
+// `*record`. If the proto stores its values in `tensor_content`, the tensor
+// aliases `*record` when the content is suitably aligned and is copied from it
+// once otherwise; any other proto is parsed as usual.
+Status DecodeTensorProto(const std::shared_ptr<const tstring>& record,
+                         const char* data, size_t size, Tensor* tensor) {
+  protobuf::io::CodedInputStream input(reinterpret_cast<const uint8*>(data),
+                                       size);
+  uint32 dtype = DT_INVALID;
+  const char* shape_data = nullptr;
+  uint32 shape_size = 0;
+  const char* content = nullptr;
+  uint32 content_size = 0;
+  bool fast_path = true;
+  while (fast_path) {
+    const uint32 tag = input.ReadTag();
+    if (tag == 0) break;
+    // Anything malformed or unexpected is left to the proto parser.
+    uint32 value;
+    if ((tag != kTensorProtoDtypeTag && tag != kTensorProtoShapeTag &&
+         tag != kTensorProtoVersionNumberTag &&
+         tag != kTensorProtoContentTag) ||
+        !input.ReadVarint32(&value)) {
+      fast_path = false;
+      break;
+    }
+    const char* position = data + input.CurrentPosition();
+    if (tag == kTensorProtoDtypeTag) {
+      dtype = value;
+    } else if (tag == kTensorProtoShapeTag) {
+      shape_data = position;
+      shape_size = value;
+      fast_path = input.Skip(value);
+    } else if (tag == kTensorProtoContentTag) {
+      content = position;
+      content_size = value;
+      fast_path = input.Skip(value);
+    }
+  }
+  TensorShapeProto shape_proto;
+  fast_path = fast_path && DataTypeCanUseMemcpy(static_cast<DataType>(dtype)) &&
+              shape_proto.ParseFromArray(shape_data, shape_size) &&
+              TensorShape::IsValid(shape_proto);
+  if (fast_path) {
+    TensorShape shape(shape_proto);
+    const DataType data_type = static_cast<DataType>(dtype);
+    if (shape.num_elements() * DataTypeSize(data_type) ==
+        static_cast<int64>(content_size)) {
+      if (content_size > 0 && IsAligned(content)) {
+        auto* buffer = new RecordTensorBuffer(content, content_size, record);
+        *tensor = Tensor(data_type, shape, buffer);
+        buffer->Unref();
+      } else {
+        *tensor = Tensor(data_type, shape);
+        if (content_size > 0) {
+          std::memcpy(const_cast<char*>(tensor->tensor_data().data()), content,
+                      content_size);
+        }
+      }
+      return Status::OK();
+    }
+  }
+
+  TensorProto proto;
+  if (!proto.ParseFromArray(data, size)) {
+    return errors::DataLoss("Unable to parse tensor proto.");
+  }
+  if (!tensor->FromProto(proto)) {
+    return errors::DataLoss("Unable to parse tensor from stored proto.");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
 std::string HashDirectory(const std::string& path, uint64 hash) {
   return io::JoinPath(
       path, strings::Printf("%llu", static_cast<unsigned long long>(hash)));
@@ -79,6 +243,27 @@ std::string GetCheckpointFileName(const std::string& shard_directory,
                       static_cast<unsigned long long>(checkpoint_id)));
 }
 
+std::string GetCheckpointFileName(const std::string& shard_directory,
+                                  uint64 checkpoint_id, int64 part) {
+  if (part == 0) {
+    return GetCheckpointFileName(shard_directory, checkpoint_id);
+  }
+  // "." sorts before "_", so part 0 sorts before the other parts.
+  return io::JoinPath(
+      shard_directory,
+      strings::Printf("%08llu_%08llu.snapshot",
+                      static_cast<unsigned long long>(checkpoint_id),
+                      static_cast<unsigned long long>(part)));
+}
+
+Status GetShardFilenames(Env* env, const std::string& shard_directory,
+                         std::vector<std::string>* filenames) {
+  TF_RETURN_IF_ERROR(env->GetMatchingPaths(
+      io::JoinPath(shard_directory, "*.snapshot"), filenames));
+  std::sort(filenames->begin(), filenames->end());
+  return Status::OK();
+}
+
 Status Writer::Create(Env* env, const std::string& filename,
                       const std::string& compression_type, int version,
                       const DataTypeVector& dtypes,
@@ -100,6 +285,20 @@ Status Writer::Create(Env* env, const std::string& filename,
   return (*out_writer)->Initialize(env);
 }
 
+Status Writer::EncodeTensors(int version, const std::string& compression_type,
+                             const std::vector<Tensor>& tensors,
+                             std::vector<std::string>* records) {
+  switch (version) {
+    case 1:
+      return CustomWriter::EncodeTensors(compression_type, tensors, records);
+    case 2:
+      return TFRecordWriter::EncodeTensors(tensors, records);
+    default:
+      return errors::InvalidArgument("Snapshot writer version: ", version,
+                                     " is not supported.");
+  }
+}
+
 TFRecordWriter::TFRecordWriter(const std::string& filename,
                                const std::string& compression_type)
     : filename_(filename), compression_type_(compression_type) {}
@@ -114,14 +313,26 @@ Status TFRecordWriter::Initialize(tensorflow::Env* env) {
 }
 
 Status TFRecordWriter::WriteTensors(const std::vector<Tensor>& tensors) {
+  std::vector<std::string> records;
+  TF_RETURN_IF_ERROR(EncodeTensors(tensors, &records));
+  return WriteRecords(records);
+}
+
+Status TFRecordWriter::EncodeTensors(const std::vector<Tensor>& tensors,
+                                     std::vector<std::string>* records) {
+  records->reserve(records->size() + tensors.size());
   for (const auto& tensor : tensors) {
-    TensorProto proto;
-    tensor.AsProtoTensorContent(&proto);
-#if defined(PLATFORM_GOOGLE)
-    TF_RETURN_IF_ERROR(record_writer_->WriteRecord(proto.SerializeAsCord()));
-#else   // PLATFORM_GOOGLE
-    TF_RETURN_IF_ERROR(record_writer_->WriteRecord(proto.SerializeAsString()));
-#endif  // PLATFORM_GOOGLE
+    EncodedTensor encoded = EncodeTensor(tensor);
+    records->emplace_back();
+    records->back().reserve(encoded.size());
+    encoded.AppendTo(&records->back());
+  }
+  return Status::OK();
+}
+
+Status TFRecordWriter::WriteRecords(const std::vector<std::string>& records) {
+  for (const auto& record : records) {
+    TF_RETURN_IF_ERROR(record_writer_->WriteRecord(record));
   }
   return Status::OK();
 }
@@ -176,95 +387,76 @@ Status CustomWriter::Initialize(tensorflow::Env* env) {
     dest_.reset(zlib_output_buffer);
   }
 #endif  // IS_SLIM_BUILD
-  simple_tensor_mask_.reserve(dtypes_.size());
-  for (const auto& dtype : dtypes_) {
-    if (DataTypeCanUseMemcpy(dtype)) {
-      simple_tensor_mask_.push_back(true);
-      num_simple_++;
-    } else {
-      simple_tensor_mask_.push_back(false);
-      num_complex_++;
-    }
-  }
-
   return Status::OK();
 }
 
 Status CustomWriter::WriteTensors(const std::vector<Tensor>& tensors) {
-  if (compression_type_ != io::compression::kSnappy) {
-    experimental::SnapshotRecord record;
+  std::vector<std::string> records;
+  TF_RETURN_IF_ERROR(EncodeTensors(compression_type_, tensors, &records));
+  return WriteRecords(records);
+}
+
+Status CustomWriter::EncodeTensors(const std::string& compression_type,
+                                   const std::vector<Tensor>& tensors,
+                                   std::vector<std::string>* records) {
+  if (compression_type != io::compression::kSnappy) {
+    std::vector<EncodedTensor> encoded;
+    encoded.reserve(tensors.size());
+    size_t record_size = 0;
     for (const auto& tensor : tensors) {
-      TensorProto* t = record.add_tensor();
-      tensor.AsProtoTensorContent(t);
+      encoded.push_back(EncodeTensor(tensor));
+      const size_t size = encoded.back().size();
+      record_size += 1 + core::VarintLength(size) + size;
     }
-#if defined(PLATFORM_GOOGLE)
-    return WriteRecord(record.SerializeAsCord());
-#else   // PLATFORM_GOOGLE
-    return WriteRecord(record.SerializeAsString());
-#endif  // PLATFORM_GOOGLE
-  }
-
-  if (compression_type_ != io::compression::kSnappy) {
-    return errors::InvalidArgument("Compression ", compression_type_,
-                                   " is not supported.");
+    std::string record;
+    record.reserve(record_size);
+    for (const auto& tensor : encoded) {
+      record.push_back(static_cast<char>(kSnapshotRecordTensorTag));
+      core::PutVarint64(&record, tensor.size());
+      tensor.AppendTo(&record);
+    }
+    records->push_back(std::move(record));
+    return Status::OK();
   }
 
-  std::vector<const TensorBuffer*> tensor_buffers;
-  tensor_buffers.reserve(num_simple_);
-  std::vector<TensorProto> tensor_protos;
-  tensor_protos.reserve(num_complex_);
+  // Compress straight out of the tensor buffers; only tensors that are not
+  // memcpy-able are serialized first.
+  std::vector<std::string> tensor_proto_strs;
+  tensor_proto_strs.reserve(tensors.size());
+  std::vector<struct iovec> iov(tensors.size());
   experimental::SnapshotTensorMetadata metadata;
-  int64 total_size = 0;
   for (int i = 0, end = tensors.size(); i < end; ++i) {
     const Tensor& tensor = tensors[i];
     experimental::TensorMetadata* tensor_metadata =
         metadata.add_tensor_metadata();
     tensor.shape().AsProto(tensor_metadata->mutable_tensor_shape());
-    int64 size = 0;
-    if (simple_tensor_mask_[i]) {
-      auto tensor_buffer = DMAHelper::buffer(&tensor);
-      tensor_buffers.push_back(tensor_buffer);
-      size = tensor_buffer->size();
+    if (DataTypeCanUseMemcpy(tensor.dtype())) {
+      const StringPiece data = tensor.tensor_data();
+      iov[i].iov_base = const_cast<char*>(data.data());
+      iov[i].iov_len = data.size();
     } else {
       TensorProto proto;
       tensor.AsProtoTensorContent(&proto);
-      size = proto.ByteSizeLong();
-      tensor_protos.push_back(std::move(proto));
-    }
-    tensor_metadata->set_tensor_size_bytes(size);
-    total_size += size;
-  }
-
-  std::vector<char> uncompressed(total_size);
-  char* position = uncompressed.data();
-  int buffer_index = 0;
-  int proto_index = 0;
-  for (int i = 0, end = tensors.size(); i < end; ++i) {
-    const auto& tensor_metadata = metadata.tensor_metadata(i);
-    if (simple_tensor_mask_[i]) {
-      memcpy(position, tensor_buffers[buffer_index]->data(),
-             tensor_metadata.tensor_size_bytes());
-      buffer_index++;
-    } else {
-      tensor_protos[proto_index].SerializeToArray(
-          position, tensor_metadata.tensor_size_bytes());
-      proto_index++;
+      tensor_proto_strs.push_back(proto.SerializeAsString());
+      iov[i].iov_base = &tensor_proto_strs.back()[0];
+      iov[i].iov_len = tensor_proto_strs.back().size();
     }
-    position += tensor_metadata.tensor_size_bytes();
+    tensor_metadata->set_tensor_size_bytes(iov[i].iov_len);
   }
-  DCHECK_EQ(position, uncompressed.data() + total_size);
 
   string output;
-  if (!port::Snappy_Compress(uncompressed.data(), total_size, &output)) {
+  if (!port::Snappy_CompressFromIOVec(iov.data(), iov.size(), &output)) {
     return errors::Internal("Failed to compress using snappy.");
   }
-#if defined(PLATFORM_GOOGLE)
-  absl::Cord metadata_serialized = metadata.SerializeAsCord();
-#else   // PLATFORM_GOOGLE
-  std::string metadata_serialized = metadata.SerializeAsString();
-#endif  // PLATFORM_GOOGLE
-  TF_RETURN_IF_ERROR(WriteRecord(metadata_serialized));
-  TF_RETURN_IF_ERROR(WriteRecord(output));
+  records->push_back(metadata.SerializeAsString());
+  records->push_back(std::move(output));
+  return Status::OK();
+}
+
+Status CustomWriter::WriteRecords(const std::vector<std::string>& records) {
+  for (const auto& record : records) {
+    TF_RETURN_IF_ERROR(WriteRecord(record));
+  }
   return Status::OK();
 }
 
@@ -296,15 +488,6 @@ Status CustomWriter::WriteRecord(const StringPiece& data) {
   return dest_->Append(data);
 }
 
-#if defined(PLATFORM_GOOGLE)
-Status CustomWriter::WriteRecord(const absl::Cord& data) {
-  char header[kHeaderSize];
-  core::EncodeFixed64(header, data.size());
-  TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
-  return dest_->Append(data);
-}
-#endif  // PLATFORM_GOOGLE
-
 Status Reader::Create(Env* env, const std::string& filename,
                       const string& compression_type, int version,
                       const DataTypeVector& dtypes,
@@ -330,11 +513,27 @@ Status Reader::Create(Env* env, const std::string& filename,
   return (*out_reader)->Initialize(env);
 }
 
+Status Reader::DecodeTensors(int version, const string& compression_type,
+                             const DataTypeVector& dtypes,
+                             std::vector<tstring> records,
+                             std::vector<Tensor>* read_tensors) {
+  switch (version) {
+    case 0:
+    case 1:
+      return CustomReader::DecodeTensors(version, compression_type, dtypes,
+                                         std::move(records), read_tensors);
+    case 2:
+      return TFRecordReader::DecodeTensors(std::move(records), read_tensors);
+    default:
+      return errors::InvalidArgument("Snapshot reader version: ", version,
+                                     " is not supported.");
+  }
+}
+
 Status Reader::SkipRecords(int64 num_records) {
-  // TODO(frankchn): Optimize to not parse the entire Tensor and actually skip.
   for (int i = 0; i < num_records; ++i) {
-    std::vector<Tensor> unused_tensors;
-    TF_RETURN_IF_ERROR(ReadTensors(&unused_tensors));
+    std::vector<tstring> unused_records;
+    TF_RETURN_IF_ERROR(ReadRecords(&unused_records));
   }
   return Status::OK();
 }
@@ -344,14 +543,17 @@ class Reader::Dataset : public DatasetBase {
   explicit Dataset(const std::string& shard_dir, const std::string& compression,
                    const int64 version, const DataTypeVector& dtypes,
                    const std::vector<PartialTensorShape>& shapes,
-                   const int64 start_index, DatasetContext::Params params)
+                   const int64 start_index,
+                   const PipelineOptions& pipeline_options,
+                   DatasetContext::Params params)
       : DatasetBase(DatasetContext(std::move(params))),
         shard_dir_(shard_dir),
         compression_(compression),
         version_(version),
         dtypes_(dtypes),
         shapes_(shapes),
-        start_index_(start_index) {}
+        start_index_(start_index),
+        pipeline_options_(pipeline_options) {}
 
   const DataTypeVector& output_dtypes() const override { return dtypes_; }
 
@@ -384,17 +586,36 @@ class Reader::Dataset : public DatasetBase {
   class Iterator : public DatasetIterator<Dataset> {
    public:
     explicit Iterator(const Params& params)
-        : DatasetIterator<Dataset>(params), current_checkpoint_id_(0) {}
+        : DatasetIterator<Dataset>(params) {}
 
     Status Initialize(IteratorContext* ctx) override {
-      TF_RETURN_IF_ERROR(Reader::Create(
-          ctx->env(), GetCurrentFilename(), dataset()->compression_,
-          dataset()->version_, dataset()->dtypes_, &reader_));
-      bool end_of_sequence;
-      for (int64 i = 0; i < dataset()->start_index_; ++i) {
-        // TODO(frankchn): Optimize this to not parse every single element.
-        std::vector<Tensor> unused;
-        TF_RETURN_IF_ERROR(GetNextInternal(ctx, &unused, &end_of_sequence));
+      // Checkpoint files may be split into several parts, so list the files
+      // rather than guessing their names.
+      TF_RETURN_IF_ERROR(GetShardFilenames(ctx->env(), dataset()->shard_dir_,
+                                           &filenames_));
+      if (dataset()->pipeline_options_.runner) {
+        pipelined_reader_ = absl::make_unique<PipelinedReader>(
+            ctx->env(), filenames_, dataset()->compression_,
+            dataset()->version_, dataset()->dtypes_, dataset()->start_index_,
+            dataset()->pipeline_options_);
+        return Status::OK();
+      }
+      if (!filenames_.empty()) {
+        TF_RETURN_IF_ERROR(Reader::Create(
+            ctx->env(), filenames_[0], dataset()->compression_,
+            dataset()->version_, dataset()->dtypes_, &reader_));
+      }
+      int64 num_to_skip = dataset()->start_index_;
+      while (num_to_skip > 0 && reader_) {
+        std::vector<tstring> unused;
+        Status s = reader_->ReadRecords(&unused);
+        if (s.ok()) {
+          --num_to_skip;
+        } else if (errors::IsOutOfRange(s)) {
+          TF_RETURN_IF_ERROR(AdvanceToNextFile(ctx->env()));
+        } else {
+          return s;
+        }
       }
       return Status::OK();
     }
@@ -403,18 +624,19 @@ class Reader::Dataset : public DatasetBase {
     Status GetNextInternal(IteratorContext* ctx,
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
-      *end_of_sequence = false;
-      Status s = reader_->ReadTensors(out_tensors);
-      if (!errors::IsOutOfRange(s)) {
-        return s;
+      if (pipelined_reader_) {
+        return pipelined_reader_->ReadTensors(out_tensors, end_of_sequence);
       }
-      Status status = AdvanceToNextFile(ctx->env());
-      if (errors::IsNotFound(status)) {
-        *end_of_sequence = true;
-        return Status::OK();
-      } else {
-        return status;
+      *end_of_sequence = false;
+      while (reader_) {
+        Status s = reader_->ReadTensors(out_tensors);
+        if (!errors::IsOutOfRange(s)) {
+          return s;
+        }
+        TF_RETURN_IF_ERROR(AdvanceToNextFile(ctx->env()));
       }
+      *end_of_sequence = true;
+      return Status::OK();
     }
 
     Status SaveInternal(SerializationContext* ctx,
@@ -434,24 +656,25 @@ class Reader::Dataset : public DatasetBase {
     }
 
    private:
-    std::string GetCurrentFilename() {
-      return GetCheckpointFileName(dataset()->shard_dir_,
-                                   current_checkpoint_id_);
-    }
-
+    // Opens the next file of the shard, or resets `reader_` after the last
+    // one.
     Status AdvanceToNextFile(Env* env) {
-      current_checkpoint_id_++;
-      TF_RETURN_IF_ERROR(env->FileExists(GetCurrentFilename()));
-      return Reader::Create(env, GetCurrentFilename(), dataset()->compression_,
-                            dataset()->version_, dataset()->dtypes_, &reader_);
+      file_index_++;
+      if (file_index_ >= filenames_.size()) {
+        reader_.reset();
+        return Status::OK();
+      }
+      return Reader::Create(env, filenames_[file_index_],
+                            dataset()->compression_, dataset()->version_,
+                            dataset()->dtypes_, &reader_);
     }
 
+    // The snapshot files of the shard, in the order they were written.
+    std::vector<std::string> filenames_;
+    // Index into `filenames_` of the file `reader_` reads.
+    size_t file_index_ = 0;
     std::unique_ptr<Reader> reader_;
-
-    // Stores the id current checkpoint file that we are in the process of
-    // reading (e.g. if the file is currently 00000001.snapshot, then this will
-    // be 1).
-    uint64 current_checkpoint_id_;
+    std::unique_ptr<PipelinedReader> pipelined_reader_;
   };
 
   const std::string shard_dir_;
@@ -460,6 +683,7 @@ class Reader::Dataset : public DatasetBase {
   const DataTypeVector dtypes_;
   const std::vector<PartialTensorShape> shapes_;
   const int64 start_index_;
+  const PipelineOptions pipeline_options_;
 };
 
 class Reader::NestedDataset : public DatasetBase {
@@ -556,7 +780,8 @@ Status Reader::MakeNestedDataset(Env* env,
                                  const DataTypeVector& dtypes,
                                  const std::vector<PartialTensorShape>& shapes,
                                  const int64 start_index,
-                                 DatasetBase** output) {
+                                 DatasetBase** output,
+                                 const PipelineOptions& pipeline_options) {
   std::vector<DatasetBase*> datasets;
 
   datasets.reserve(shard_dirs.size());
@@ -570,7 +795,7 @@ Status Reader::MakeNestedDataset(Env* env,
 
     datasets.push_back(
         new Dataset(shard_dir, compression_type, version, dtypes, shapes,
-                    dataset_start_index,
+                    dataset_start_index, pipeline_options,
                     DatasetContext::Params({"snapshot_util::Reader::Dataset",
                                             "snapshot_util_reader_Dataset"})));
   }
@@ -605,19 +830,27 @@ Status TFRecordReader::Initialize(Env* env) {
 }
 
 Status TFRecordReader::ReadTensors(std::vector<Tensor>* read_tensors) {
-  read_tensors->reserve(dtypes_.size());
-  for (int i = 0; i < dtypes_.size(); ++i) {
-    tstring record;
-    TF_RETURN_IF_ERROR(record_reader_->ReadRecord(&offset_, &record));
+  std::vector<tstring> records;
+  TF_RETURN_IF_ERROR(ReadRecords(&records));
+  return DecodeTensors(std::move(records), read_tensors);
+}
 
-    TensorProto proto;
-    proto.ParseFromArray(record.data(), record.size());
+Status TFRecordReader::ReadRecords(std::vector<tstring>* records) {
+  records->resize(dtypes_.size());
+  for (auto& record : *records) {
+    TF_RETURN_IF_ERROR(record_reader_->ReadRecord(&offset_, &record));
+  }
+  return Status::OK();
+}
 
+Status TFRecordReader::DecodeTensors(std::vector<tstring> records,
+                                     std::vector<Tensor>* read_tensors) {
+  read_tensors->reserve(read_tensors->size() + records.size());
+  for (auto& record : records) {
+    auto shared_record = std::make_shared<const tstring>(std::move(record));
     Tensor tensor;
-    if (!tensor.FromProto(proto)) {
-      return errors::DataLoss("Unable to parse tensor from stored proto.");
-    }
-
+    TF_RETURN_IF_ERROR(DecodeTensorProto(shared_record, shared_record->data(),
+                                         shared_record->size(), &tensor));
     read_tensors->push_back(std::move(tensor));
   }
   return Status::OK();
@@ -659,17 +892,6 @@ Status CustomReader::Initialize(Env* env) {
     }
   }
 #endif  // IS_SLIM_BUILD
-  simple_tensor_mask_.reserve(dtypes_.size());
-  for (const auto& dtype : dtypes_) {
-    if (DataTypeCanUseMemcpy(dtype)) {
-      simple_tensor_mask_.push_back(true);
-      num_simple_++;
-    } else {
-      simple_tensor_mask_.push_back(false);
-      num_complex_++;
-    }
-  }
-
   return Status::OK();
 }
 
@@ -677,36 +899,63 @@ Status CustomReader::ReadTensors(std::vector<Tensor>* read_tensors) {
   profiler::TraceMe activity(
       [&]() { return absl::StrCat(kClassName, kSeparator, "ReadTensors"); },
       profiler::TraceMeLevel::kInfo);
-  if (version_ == 0 || compression_type_ != io::compression::kSnappy) {
-    return ReadTensorsV0(read_tensors);
+  std::vector<tstring> records;
+  TF_RETURN_IF_ERROR(ReadRecords(&records));
+  return DecodeTensors(version_, compression_type_, dtypes_,
+                       std::move(records), read_tensors);
+}
+
+Status CustomReader::ReadRecords(std::vector<tstring>* records) {
+  // Version 1 snappy files store a metadata record and a compressed record per
+  // element; everything else stores a single `SnapshotRecord`.
+  const int num_records =
+      (version_ == 0 || compression_type_ != io::compression::kSnappy) ? 1 : 2;
+  records->resize(num_records);
+  for (auto& record : *records) {
+    TF_RETURN_IF_ERROR(ReadRecord(&record));
   }
-  if (version_ != 1) {
-    return errors::InvalidArgument("Version: ", version_, " is not supported.");
+  return Status::OK();
+}
+
+Status CustomReader::DecodeTensors(int version, const string& compression_type,
+                                   const DataTypeVector& dtypes,
+                                   std::vector<tstring> records,
+                                   std::vector<Tensor>* read_tensors) {
+  if (version == 0 || compression_type != io::compression::kSnappy) {
+    if (records.size() != 1) {
+      return errors::Internal("Expected 1 record per element, got ",
+                              records.size());
+    }
+    return DecodeTensorsV0(std::move(records[0]), read_tensors);
   }
-  if (compression_type_ != io::compression::kSnappy) {
-    return errors::InvalidArgument("Compression ", compression_type_,
-                                   " is not supported.");
+  if (version != 1) {
+    return errors::InvalidArgument("Version: ", version, " is not supported.");
+  }
+  if (records.size() != 2) {
+    return errors::Internal("Expected 2 records per element, got ",
+                            records.size());
   }
 
   experimental::SnapshotTensorMetadata metadata;
-  tstring metadata_str;
-  TF_RETURN_IF_ERROR(ReadRecord(&metadata_str));
-  if (!metadata.ParseFromArray(metadata_str.data(), metadata_str.size())) {
+  if (!metadata.ParseFromArray(records[0].data(), records[0].size())) {
     return errors::DataLoss("Could not parse SnapshotTensorMetadata");
   }
+  if (metadata.tensor_metadata_size() != dtypes.size()) {
+    return errors::DataLoss("Expected ", dtypes.size(),
+                            " tensors per element, but the snapshot has ",
+                            metadata.tensor_metadata_size());
+  }
   read_tensors->reserve(metadata.tensor_metadata_size());
 
   std::vector<Tensor> simple_tensors;
-  simple_tensors.reserve(num_simple_);
   std::vector<std::pair<std::unique_ptr<char[]>, size_t>> tensor_proto_strs;
-  tensor_proto_strs.reserve(num_complex_);
-  TF_RETURN_IF_ERROR(
-      SnappyUncompress(&metadata, &simple_tensors, &tensor_proto_strs));
+  TF_RETURN_IF_ERROR(SnappyUncompress(dtypes, &metadata, records[1],
+                                      &simple_tensors, &tensor_proto_strs));
 
   int simple_index = 0;
   int complex_index = 0;
-  for (int i = 0, end = simple_tensor_mask_.size(); i < end; ++i) {
-    if (simple_tensor_mask_[i]) {
+  for (int i = 0, end = dtypes.size(); i < end; ++i) {
+    if (DataTypeCanUseMemcpy(dtypes[i])) {
       read_tensors->push_back(std::move(simple_tensors[simple_index]));
       simple_index++;
     } else {
@@ -737,17 +986,44 @@ Status CustomReader::ReadTensors(std::vector<Tensor>* read_tensors) {
   return Status::OK();
 }
 
-Status CustomReader::ReadTensorsV0(std::vector<Tensor>* read_tensors) {
+Status CustomReader::DecodeTensorsV0(tstring record_bytes,
+                                     std::vector<Tensor>* read_tensors) {
+  // Walk the `SnapshotRecord` wire format so that each `TensorProto` is
+  // decoded in place, letting tensors alias the record.
+  auto shared_record = std::make_shared<const tstring>(std::move(record_bytes));
+  const char* data = shared_record->data();
+  protobuf::io::CodedInputStream input(reinterpret_cast<const uint8*>(data),
+                                       shared_record->size());
+  std::vector<Tensor> tensors;
+  bool fast_path = true;
+  while (fast_path) {
+    const uint32 tag = input.ReadTag();
+    if (tag == 0) break;
+    uint32 size;
+    if (tag != kSnapshotRecordTensorTag || !input.ReadVarint32(&size)) {
+      fast_path = false;
+      break;
+    }
+    const char* tensor_data = data + input.CurrentPosition();
+    if (!input.Skip(size)) {
+      return errors::DataLoss("Unable to parse snapshot record.");
+    }
+    tensors.emplace_back();
+    TF_RETURN_IF_ERROR(DecodeTensorProto(shared_record, tensor_data, size,
+                                         &tensors.back()));
+  }
+  if (fast_path) {
+    read_tensors->reserve(read_tensors->size() + tensors.size());
+    for (auto& tensor : tensors) {
+      read_tensors->push_back(std::move(tensor));
+    }
+    return Status::OK();
+  }
+
   experimental::SnapshotRecord record;
-#if defined(PLATFORM_GOOGLE)
-  absl::Cord c;
-  TF_RETURN_IF_ERROR(ReadRecord(&c));
-  record.ParseFromCord(c);
-#else   // PLATFORM_GOOGLE
-  tstring record_bytes;
-  TF_RETURN_IF_ERROR(ReadRecord(&record_bytes));
-  record.ParseFromArray(record_bytes.data(), record_bytes.size());
-#endif  // PLATFORM_GOOGLE
+  if (!record.ParseFromArray(data, shared_record->size())) {
+    return errors::DataLoss("Unable to parse snapshot record.");
+  }
   read_tensors->reserve(record.tensor_size());
   for (int i = 0; i < record.tensor_size(); ++i) {
     read_tensors->emplace_back();
@@ -759,12 +1035,11 @@ Status CustomReader::ReadTensorsV0(std::vector<Tensor>* read_tensors) {
 }
 
 Status CustomReader::SnappyUncompress(
+    const DataTypeVector& dtypes,
     const experimental::SnapshotTensorMetadata* metadata,
-    std::vector<Tensor>* simple_tensors,
+    const tstring& compressed, std::vector<Tensor>* simple_tensors,
     std::vector<std::pair<std::unique_ptr<char[]>, size_t>>*
         tensor_proto_strs) {
-  tstring compressed;
-  TF_RETURN_IF_ERROR(ReadRecord(&compressed));
   size_t size;
   if (!port::Snappy_GetUncompressedLength(compressed.data(), compressed.size(),
                                           &size)) {
@@ -775,11 +1050,11 @@ Status CustomReader::SnappyUncompress(
   std::vector<struct iovec> iov(num_tensors);
   int index = 0;
   int64 total_size = 0;
-  for (int i = 0, end = simple_tensor_mask_.size(); i < end; ++i) {
+  for (int i = 0, end = dtypes.size(); i < end; ++i) {
     const auto& tensor_metadata = metadata->tensor_metadata(i);
-    if (simple_tensor_mask_[i]) {
+    if (DataTypeCanUseMemcpy(dtypes[i])) {
       TensorShape shape(tensor_metadata.tensor_shape());
-      Tensor simple_tensor(dtypes_[i], shape);
+      Tensor simple_tensor(dtypes[i], shape);
       TensorBuffer* buffer = DMAHelper::buffer(&simple_tensor);
       iov[index].iov_base = buffer->data();
       iov[index].iov_len = buffer->size();
@@ -815,23 +1090,124 @@ Status CustomReader::ReadRecord(tstring* record) {
   return input_stream_->ReadNBytes(length, record);
 }
 
-#if defined(PLATFORM_GOOGLE)
-Status CustomReader::ReadRecord(absl::Cord* record) {
-  tstring header;
-  TF_RETURN_IF_ERROR(input_stream_->ReadNBytes(kHeaderSize, &header));
-  uint64 length = core::DecodeFixed64(header.data());
-  if (compression_type_ == io::compression::kNone) {
-    return input_stream_->ReadNBytes(length, record);
-  } else {
-    auto tmp_str = absl::make_unique<tstring>();
-    TF_RETURN_IF_ERROR(input_stream_->ReadNBytes(length, tmp_str.get()));
-    absl::string_view tmp_str_view(*tmp_str);
-    record->Append(
-        absl::MakeCordFromExternal(tmp_str_view, [s = std::move(tmp_str)] {}));
-    return Status::OK();
+PipelinedReader::PipelinedReader(Env* env, std::vector<std::string> filenames,
+                                 const string& compression_type, int version,
+                                 const DataTypeVector& dtypes,
+                                 int64 num_to_skip,
+                                 const PipelineOptions& options)
+    : env_(env),
+      filenames_(std::move(filenames)),
+      compression_type_(compression_type),
+      version_(version),
+      dtypes_(dtypes),
+      options_(options),
+      num_to_skip_(num_to_skip) {
+  thread_ = absl::WrapUnique(env->StartThread(
+      ThreadOptions(), "tf_data_snapshot_pipelined_reader",
+      [this]() { ReaderThread(); }));
+}
+
+PipelinedReader::~PipelinedReader() {
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    cv_.notify_all();
+  }
+  // Join the reader thread before waiting for decodes, since it is the only
+  // thread that schedules them.
+  thread_.reset();
+  mutex_lock l(mu_);
+  while (num_decodes_in_flight_ > 0) {
+    cv_.wait(l);
   }
 }
-#endif
+
+Status PipelinedReader::ReadTensors(std::vector<Tensor>* read_tensors,
+                                    bool* end_of_sequence) {
+  std::shared_ptr<Element> element;
+  {
+    mutex_lock l(mu_);
+    while (elements_.empty() || !elements_.front()->done) {
+      cv_.wait(l);
+    }
+    element = elements_.front();
+    // Leave the final element in place so that later calls see it too.
+    if (element->end_of_sequence || !element->status.ok()) {
+      *end_of_sequence = element->end_of_sequence;
+      return element->status;
+    }
+    elements_.pop_front();
+    cv_.notify_all();
+  }
+  *end_of_sequence = false;
+  *read_tensors = std::move(element->tensors);
+  return Status::OK();
+}
+
+void PipelinedReader::ReaderThread() {
+  Status s = ReadFiles();
+  auto element = std::make_shared<Element>();
+  element->status = s;
+  element->end_of_sequence = s.ok();
+  element->done = true;
+  Enqueue(std::move(element));
+}
+
+Status PipelinedReader::ReadFiles() {
+  for (const auto& filename : filenames_) {
+    std::unique_ptr<Reader> reader;
+    TF_RETURN_IF_ERROR(Reader::Create(env_, filename, compression_type_,
+                                      version_, dtypes_, &reader));
+    while (true) {
+      std::vector<tstring> records;
+      Status s = reader->ReadRecords(&records);
+      if (errors::IsOutOfRange(s)) {
+        break;
+      }
+      TF_RETURN_IF_ERROR(s);
+      if (num_to_skip_ > 0) {
+        --num_to_skip_;
+        continue;
+      }
+      auto element = std::make_shared<Element>();
+      if (!Enqueue(element)) {
+        return errors::Cancelled("Snapshot reader was cancelled.");
+      }
+      options_.runner([this, element,
+                       records = std::move(records)]() mutable {
+        std::vector<Tensor> tensors;
+        Status s =
+            Reader::DecodeTensors(version_, compression_type_, dtypes_,
+                                  std::move(records), &tensors);
+        mutex_lock l(mu_);
+        element->tensors = std::move(tensors);
+        element->status = s;
+        element->done = true;
+        --num_decodes_in_flight_;
+        cv_.notify_all();
+      });
+    }
+  }
+  return Status::OK();
+}
+
+bool PipelinedReader::Enqueue(std::shared_ptr<Element> element) {
+  mutex_lock l(mu_);
+  while (!cancelled_ &&
+         static_cast<int64>(elements_.size()) >=
+             options_.max_elements_in_flight) {
+    cv_.wait(l);
+  }
+  if (cancelled_) {
+    return false;
+  }
+  if (!element->done) {
+    ++num_decodes_in_flight_;
+  }
+  elements_.push_back(std::move(element));
+  cv_.notify_all();
+  return true;
+}
 
 Status WriteMetadataFile(Env* env, const string& dir,
                          const experimental::SnapshotMetadataRecord* metadata) {
@@ -924,38 +1300,85 @@ AsyncWriter::AsyncWriter(Env* env, int64 file_index,
                          const std::string& shard_directory,
                          uint64 checkpoint_id, const std::string& compression,
                          int64 version, const DataTypeVector& output_types,
-                         std::function<void(Status)> done) {
+                         std::function<void(Status)> done,
+                         const PipelineOptions& pipeline_options)
+    : compression_(compression),
+      version_(version),
+      pipeline_options_(pipeline_options) {
   thread_ = absl::WrapUnique(env->StartThread(
       ThreadOptions(), absl::StrCat("writer_thread_", file_index),
       [this, env, shard_directory, checkpoint_id, compression, version,
-       &output_types, done = std::move(done)] {
-        done(WriterThread(env, shard_directory, checkpoint_id, compression,
-                          version, output_types));
+       output_types, done = std::move(done)] {
+        Status s = WriterThread(env, shard_directory, checkpoint_id,
+                                compression, version, output_types);
+        {
+          // Encodes scheduled before the writer thread stopped reference
+          // `this`, so wait for them before reporting completion.
+          mutex_lock l(mu_);
+          closed_ = true;
+          mu_.Await(
+              tensorflow::Condition(this, &AsyncWriter::EncodesFinished));
+        }
+        done(s);
       }));
 }
 
 void AsyncWriter::Write(const std::vector<Tensor>& tensors) {
-  mutex_lock l(mu_);
-  ElementOrEOF element;
-  element.value = tensors;
-  deque_.push_back(std::move(element));
+  auto pending = std::make_shared<PendingElement>();
+  pending->element.value = tensors;
+  if (!pipeline_options_.runner) {
+    mutex_lock l(mu_);
+    pending->ready = true;
+    deque_.push_back(std::move(pending));
+    return;
+  }
+  {
+    mutex_lock l(mu_);
+    mu_.Await(tensorflow::Condition(this, &AsyncWriter::SpaceAvailable));
+    if (closed_) {
+      // The writer thread failed; its status is reported through `done`.
+      return;
+    }
+    ++num_encodes_in_flight_;
+    deque_.push_back(pending);
+  }
+  pipeline_options_.runner([this, pending]() {
+    std::vector<std::string> records;
+    Status s = Writer::EncodeTensors(version_, compression_,
+                                     pending->element.value, &records);
+    mutex_lock l(mu_);
+    pending->records = std::move(records);
+    pending->status = s;
+    pending->ready = true;
+    --num_encodes_in_flight_;
+  });
 }
 
 void AsyncWriter::SignalEOF() {
   mutex_lock l(mu_);
-  ElementOrEOF be;
-  be.end_of_sequence = true;
-  deque_.push_back(std::move(be));
+  auto pending = std::make_shared<PendingElement>();
+  pending->element.end_of_sequence = true;
+  pending->ready = true;
+  deque_.push_back(std::move(pending));
 }
 
-void AsyncWriter::Consume(ElementOrEOF* be) {
+void AsyncWriter::Consume(std::shared_ptr<PendingElement>* element) {
   mutex_lock l(mu_);
   mu_.Await(tensorflow::Condition(this, &AsyncWriter::ElementAvailable));
-  *be = deque_.front();
+  *element = std::move(deque_.front());
   deque_.pop_front();
 }
 
-bool AsyncWriter::ElementAvailable() { return !deque_.empty(); }
+bool AsyncWriter::ElementAvailable() {
+  return !deque_.empty() && deque_.front()->ready;
+}
+
+bool AsyncWriter::SpaceAvailable() {
+  return closed_ || static_cast<int64>(deque_.size()) <
+                        pipeline_options_.max_elements_in_flight;
+}
+
+bool AsyncWriter::EncodesFinished() { return num_encodes_in_flight_ == 0; }
 
 Status AsyncWriter::WriterThread(Env* env, const std::string& shard_directory,
                                  uint64 checkpoint_id,
@@ -964,20 +1387,43 @@ Status AsyncWriter::WriterThread(Env* env, const std::string& shard_directory,
   std::unique_ptr<snapshot_util::Writer> writer;
   TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(shard_directory));
 
+  int64 part = 0;
   TF_RETURN_IF_ERROR(snapshot_util::Writer::Create(
-      env, GetCheckpointFileName(shard_directory, checkpoint_id), compression,
-      version, std::move(output_types), &writer));
+      env, GetCheckpointFileName(shard_directory, checkpoint_id, part),
+      compression, version, output_types, &writer));
 
+  int64 file_bytes = 0;
   while (true) {
-    ElementOrEOF be;
-    Consume(&be);
+    std::shared_ptr<PendingElement> pending;
+    Consume(&pending);
 
-    if (be.end_of_sequence) {
+    if (pending->element.end_of_sequence) {
       TF_RETURN_IF_ERROR(writer->Close());
       break;
     }
 
-    TF_RETURN_IF_ERROR(writer->WriteTensors(be.value));
+    if (pipeline_options_.file_size_bytes > 0 &&
+        file_bytes >= pipeline_options_.file_size_bytes) {
+      TF_RETURN_IF_ERROR(writer->Close());
+      ++part;
+      TF_RETURN_IF_ERROR(snapshot_util::Writer::Create(
+          env, GetCheckpointFileName(shard_directory, checkpoint_id, part),
+          compression, version, output_types, &writer));
+      file_bytes = 0;
+    }
+
+    if (pipeline_options_.runner) {
+      TF_RETURN_IF_ERROR(pending->status);
+      TF_RETURN_IF_ERROR(writer->WriteRecords(pending->records));
+      for (const auto& record : pending->records) {
+        file_bytes += record.size();
+      }
+    } else {
+      TF_RETURN_IF_ERROR(writer->WriteTensors(pending->element.value));
+      for (const auto& tensor : pending->element.value) {
+        file_bytes += tensor.TotalBytes();
+      }
+    }
   }
   return Status::OK();
 }
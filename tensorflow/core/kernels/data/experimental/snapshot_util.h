@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_SNAPSHOT_UTIL_H_
 #define TENSORFLOW_CORE_KERNELS_DATA_EXPERIMENTAL_SNAPSHOT_UTIL_H_
 
+#include <deque>
+#include <functional>
+
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
@@ -25,8 +28,10 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
@@ -69,6 +74,35 @@ std::string ShardDirectory(const std::string& run_directory, int64 shard_id);
 std::string GetCheckpointFileName(const std::string& shard_directory,
                                   const uint64 checkpoint_id);
 
+// Returns the name of the `part`-th file of a checkpoint whose writer starts a
+// new file every time the current one reaches a size limit. Part 0 is the
+// checkpoint file itself. Sorting the names of the files in a shard directory
+// orders them by checkpoint, then by part.
+std::string GetCheckpointFileName(const std::string& shard_directory,
+                                  const uint64 checkpoint_id,
+                                  const int64 part);
+
+// Lists the snapshot files in `shard_directory` in the order they were
+// written.
+Status GetShardFilenames(Env* env, const std::string& shard_directory,
+                         std::vector<std::string>* filenames);
+
+// Options for overlapping the compression and decompression of snapshot
+// elements with file I/O.
+struct PipelineOptions {
+  // If set, elements are encoded (serialized and, for formats that compress
+  // each element separately, compressed) and decoded by functions scheduled
+  // on `runner`, while a dedicated thread per file performs the file I/O.
+  // Otherwise the I/O thread does both.
+  std::function<void(std::function<void()>)> runner;
+  // The maximum number of elements per file that are being encoded or
+  // decoded, or are waiting to be written or consumed.
+  int64 max_elements_in_flight = 16;
+  // If positive, writers move on to a new file in the same shard directory
+  // once the current file holds about this many bytes.
+  int64 file_size_bytes = 0;
+};
+
 // This is a interface class that exposes snapshot writing functionality.
 class Writer {
  public:
@@ -78,9 +112,21 @@ class Writer {
                        const DataTypeVector& dtypes,
                        std::unique_ptr<Writer>* out_writer);
 
+  // Encodes `tensors` into the records that a writer of the given `version`
+  // and `compression_type` writes for them. Does not touch any file, so
+  // callers can encode on other threads and write the result with
+  // `WriteRecords`. Formats that compress the whole file rather than each
+  // element still compress in `WriteRecords`.
+  static Status EncodeTensors(int version, const std::string& compression_type,
+                              const std::vector<Tensor>& tensors,
+                              std::vector<std::string>* records);
+
   // Writes a vector of tensors to the snapshot writer file.
   virtual Status WriteTensors(const std::vector<Tensor>& tensors) = 0;
 
+  // Writes the records of an element produced by `EncodeTensors`.
+  virtual Status WriteRecords(const std::vector<std::string>& records) = 0;
+
   // Flushes any in-memory buffers to disk.
   virtual Status Sync() = 0;
 
@@ -100,8 +146,14 @@ class TFRecordWriter : public Writer {
   TFRecordWriter(const std::string& filename,
                  const std::string& compression_type);
 
+  // See `Writer::EncodeTensors`.
+  static Status EncodeTensors(const std::vector<Tensor>& tensors,
+                              std::vector<std::string>* records);
+
   Status WriteTensors(const std::vector<Tensor>& tensors) override;
 
+  Status WriteRecords(const std::vector<std::string>& records) override;
+
   Status Sync() override;
 
   Status Close() override;
@@ -132,8 +184,15 @@ class CustomWriter : public Writer {
   CustomWriter(const std::string& filename, const std::string& compression_type,
                const DataTypeVector& dtypes);
 
+  // See `Writer::EncodeTensors`.
+  static Status EncodeTensors(const std::string& compression_type,
+                              const std::vector<Tensor>& tensors,
+                              std::vector<std::string>* records);
+
   Status WriteTensors(const std::vector<Tensor>& tensors) override;
 
+  Status WriteRecords(const std::vector<std::string>& records) override;
+
   Status Sync() override;
 
   Status Close() override;
@@ -146,10 +205,6 @@ class CustomWriter : public Writer {
  private:
   Status WriteRecord(const StringPiece& data);
 
-#if defined(PLATFORM_GOOGLE)
-  Status WriteRecord(const absl::Cord& data);
-#endif  // PLATFORM_GOOGLE
-
   std::unique_ptr<WritableFile> dest_;
   const std::string filename_;
   const std::string compression_type_;
@@ -158,9 +213,6 @@ class CustomWriter : public Writer {
   // in dest_ if we want compression. ZlibOutputBuffer doesn't own the original
   // dest_ and so we need somewhere to store the original one.
   std::unique_ptr<WritableFile> zlib_underlying_dest_;
-  std::vector<bool> simple_tensor_mask_;  // true for simple, false for complex.
-  int num_simple_ = 0;
-  int num_complex_ = 0;
 };
 
 // Interface class for reading snapshot files previous written with Writer.
@@ -179,19 +231,34 @@ class Reader {
   // This function takes a vector of snapshot files, and returns a nested
   // dataset. Each element within the nested dataset is itself a dataset, and
   // contains all the elements written out to each individual snapshot file.
-  static Status MakeNestedDataset(Env* env,
-                                  const std::vector<std::string>& shard_dirs,
-                                  const string& compression_type, int version,
-                                  const DataTypeVector& dtypes,
-                                  const std::vector<PartialTensorShape>& shapes,
-                                  const int64 start_index,
-                                  DatasetBase** output);
+  //
+  // If `pipeline_options.runner` is set, each file is read ahead by a
+  // `PipelinedReader`.
+  static Status MakeNestedDataset(
+      Env* env, const std::vector<std::string>& shard_dirs,
+      const string& compression_type, int version, const DataTypeVector& dtypes,
+      const std::vector<PartialTensorShape>& shapes, const int64 start_index,
+      DatasetBase** output,
+      const PipelineOptions& pipeline_options = PipelineOptions());
+
+  // Decodes the `records` of an element, as read by `ReadRecords` from a file
+  // of the given `version` and `compression_type`, into `read_tensors`.
+  // Does not touch any file, so callers can decode on other threads while
+  // reading ahead. Takes ownership of the records so that uncompressed tensor
+  // data can be returned without copying it out of them.
+  static Status DecodeTensors(int version, const string& compression_type,
+                              const DataTypeVector& dtypes,
+                              std::vector<tstring> records,
+                              std::vector<Tensor>* read_tensors);
 
   // Reads a vector of Tensors from the snapshot file.
   virtual Status ReadTensors(std::vector<Tensor>* read_tensors) = 0;
 
+  // Reads the records of the next element without decoding them.
+  virtual Status ReadRecords(std::vector<tstring>* records) = 0;
+
   // Skips `num_records`. Equivalent to calling `ReadTensors` `num_records`
-  // times then discarding the results.
+  // times then discarding the results, but does not decode the records.
   virtual Status SkipRecords(int64 num_records);
 
   virtual ~Reader() {}
@@ -209,8 +276,14 @@ class TFRecordReader : public Reader {
   TFRecordReader(const std::string& filename, const string& compression_type,
                  const DataTypeVector& dtypes);
 
+  // See `Reader::DecodeTensors`.
+  static Status DecodeTensors(std::vector<tstring> records,
+                              std::vector<Tensor>* read_tensors);
+
   Status ReadTensors(std::vector<Tensor>* read_tensors) override;
 
+  Status ReadRecords(std::vector<tstring>* records) override;
+
   ~TFRecordReader() override {}
 
  protected:
@@ -247,37 +320,94 @@ class CustomReader : public Reader {
   CustomReader(const std::string& filename, const string& compression_type,
                const int version, const DataTypeVector& dtypes);
 
+  // See `Reader::DecodeTensors`.
+  static Status DecodeTensors(int version, const string& compression_type,
+                              const DataTypeVector& dtypes,
+                              std::vector<tstring> records,
+                              std::vector<Tensor>* read_tensors);
+
   Status ReadTensors(std::vector<Tensor>* read_tensors) override;
 
+  Status ReadRecords(std::vector<tstring>* records) override;
+
   ~CustomReader() override {}
 
  protected:
   Status Initialize(Env* env) override;
 
  private:
-  Status ReadTensorsV0(std::vector<Tensor>* read_tensors);
+  static Status DecodeTensorsV0(tstring record,
+                                std::vector<Tensor>* read_tensors);
 
-  Status SnappyUncompress(
+  static Status SnappyUncompress(
+      const DataTypeVector& dtypes,
       const experimental::SnapshotTensorMetadata* metadata,
-      std::vector<Tensor>* simple_tensors,
+      const tstring& compressed, std::vector<Tensor>* simple_tensors,
       std::vector<std::pair<std::unique_ptr<char[]>, size_t>>*
           tensor_proto_strs);
 
   Status ReadRecord(tstring* record);
 
-#if defined(PLATFORM_GOOGLE)
-  Status ReadRecord(absl::Cord* record);
-#endif
-
   std::string filename_;
   std::unique_ptr<RandomAccessFile> file_;
   std::unique_ptr<io::InputStreamInterface> input_stream_;
   const string compression_type_;
   const int version_;
   const DataTypeVector dtypes_;
-  int num_simple_ = 0;
-  int num_complex_ = 0;
-  std::vector<bool> simple_tensor_mask_;  // true for simple, false for complex.
+};
+
+// Reads the elements of a sequence of snapshot files ahead of the consumer.
+// A dedicated thread reads the files, and elements are decoded by functions
+// scheduled on `options.runner`, with up to `options.max_elements_in_flight`
+// elements being decoded or buffered at a time.
+class PipelinedReader {
+ public:
+  // Skips the first `num_to_skip` elements without decoding them.
+  PipelinedReader(Env* env, std::vector<std::string> filenames,
+                  const string& compression_type, int version,
+                  const DataTypeVector& dtypes, int64 num_to_skip,
+                  const PipelineOptions& options);
+
+  // Stops reading and waits for pending decodes to finish.
+  ~PipelinedReader();
+
+  // Reads the next element into `read_tensors`, setting `end_of_sequence`
+  // after the last element of the last file.
+  Status ReadTensors(std::vector<Tensor>* read_tensors, bool* end_of_sequence)
+      TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Element {
+    std::vector<Tensor> tensors;
+    Status status;
+    bool end_of_sequence = false;
+    // Whether `tensors` and `status` are final. Guarded by `mu_`.
+    bool done = false;
+  };
+
+  void ReaderThread() TF_LOCKS_EXCLUDED(mu_);
+  Status ReadFiles() TF_LOCKS_EXCLUDED(mu_);
+  // Appends `element` to `elements_`, waiting for space first. Returns false
+  // if the reader was cancelled.
+  bool Enqueue(std::shared_ptr<Element> element) TF_LOCKS_EXCLUDED(mu_);
+
+  Env* const env_;
+  const std::vector<std::string> filenames_;
+  const string compression_type_;
+  const int version_;
+  const DataTypeVector dtypes_;
+  const PipelineOptions options_;
+  int64 num_to_skip_;
+
+  mutex mu_;
+  condition_variable cv_;
+  // Elements in file order, starting with the next one to return.
+  std::deque<std::shared_ptr<Element>> elements_ TF_GUARDED_BY(mu_);
+  int64 num_decodes_in_flight_ TF_GUARDED_BY(mu_) = 0;
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+
+  // Must be last; see `AsyncWriter::thread_`.
+  std::unique_ptr<Thread> thread_;
 };
 
 // Writes snapshot metadata to the given directory.
@@ -307,6 +437,13 @@ struct ElementOrEOF {
 // AsyncWriter provides API for asynchronously writing dataset elements
 // (each represented as a vector of tensors) to a file.
 //
+// If `pipeline_options.runner` is set, elements are encoded on the runner
+// while the writer thread writes previously encoded elements, and `Write`
+// blocks while `pipeline_options.max_elements_in_flight` elements are
+// pending. If `pipeline_options.file_size_bytes` is positive, the writer
+// starts a new part of the checkpoint file (see `GetCheckpointFileName`) each
+// time the current part reaches that size.
+//
 // The expected use of this API is:
 //
 // std::unique_ptr<AsyncWriter> writer = absl_make_unique<AsyncWriter>(...);
@@ -323,7 +460,9 @@ class AsyncWriter {
                        const std::string& shard_directory, uint64 checkpoint_id,
                        const std::string& compression, int64 version,
                        const DataTypeVector& output_types,
-                       std::function<void(Status)> done);
+                       std::function<void(Status)> done,
+                       const PipelineOptions& pipeline_options =
+                           PipelineOptions());
 
   // Writes the given tensors. The method is non-blocking and returns without
   // waiting for the element to be written.
@@ -334,14 +473,34 @@ class AsyncWriter {
   void SignalEOF() TF_LOCKS_EXCLUDED(mu_);
 
  private:
-  void Consume(ElementOrEOF* be) TF_LOCKS_EXCLUDED(mu_);
+  // An element waiting to be written.
+  struct PendingElement {
+    ElementOrEOF element;
+    // In pipelined mode, the encoded element and the encoding status.
+    std::vector<std::string> records;
+    Status status;
+    // Whether the element is ready to be written.
+    bool ready = false;
+  };
+
+  void Consume(std::shared_ptr<PendingElement>* element)
+      TF_LOCKS_EXCLUDED(mu_);
   bool ElementAvailable() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  bool SpaceAvailable() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  bool EncodesFinished() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   Status WriterThread(Env* env, const std::string& shard_directory,
                       uint64 checkpoint_id, const std::string& compression,
                       int64 version, DataTypeVector output_types);
 
+  const std::string compression_;
+  const int64 version_;
+  const PipelineOptions pipeline_options_;
+
   mutex mu_;
-  std::deque<ElementOrEOF> deque_ TF_GUARDED_BY(mu_);
+  std::deque<std::shared_ptr<PendingElement>> deque_ TF_GUARDED_BY(mu_);
+  int64 num_encodes_in_flight_ TF_GUARDED_BY(mu_) = 0;
+  // Set once the writer thread stops consuming elements.
+  bool closed_ TF_GUARDED_BY(mu_) = false;
 
   // This has to be last. During destruction, we need to make sure that the
   // Thread object is destroyed first as its destructor blocks on thread
@@ -15,13 +15,19 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/experimental/snapshot_util.h"
 
+#include <algorithm>
+
+#include "absl/memory/memory.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/protobuf/data/experimental/snapshot.pb.h"
 
 namespace tensorflow {
 namespace data {
@@ -91,6 +97,169 @@ TEST(SnapshotUtilTest, CombinationRoundTripTest) {
   SnapshotRoundTrip(io::compression::kSnappy, 2);
 }
 
+std::vector<Tensor> MakeNumericElement() {
+  Tensor vector(DT_FLOAT, TensorShape({1000}));
+  for (int i = 0; i < 1000; ++i) {
+    vector.flat<float>()(i) = i * 0.5f;
+  }
+  Tensor matrix(DT_UINT8, TensorShape({3, 5}));
+  matrix.flat<uint8>().setConstant(7);
+  return {vector, Tensor(int64{42}), Tensor(DT_DOUBLE, TensorShape({0})),
+          matrix, Tensor(tstring("string"))};
+}
+
+void ExpectSameTensors(const std::vector<Tensor>& expected,
+                       const std::vector<Tensor>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (int i = 0; i < expected.size(); ++i) {
+    TensorProto expected_proto;
+    TensorProto actual_proto;
+    expected[i].AsProtoTensorContent(&expected_proto);
+    actual[i].AsProtoTensorContent(&actual_proto);
+    EXPECT_EQ(expected_proto.SerializeAsString(),
+              actual_proto.SerializeAsString());
+  }
+}
+
+TEST(SnapshotUtilTest, NumericRoundTripTest) {
+  const std::vector<Tensor> tensors = MakeNumericElement();
+  DataTypeVector dtypes;
+  for (const auto& tensor : tensors) {
+    dtypes.push_back(tensor.dtype());
+  }
+  for (const auto& compression :
+       {io::compression::kNone, io::compression::kGzip,
+        io::compression::kSnappy}) {
+    for (int version : {1, 2}) {
+      std::vector<std::string> records;
+      TF_ASSERT_OK(
+          Writer::EncodeTensors(version, compression, tensors, &records));
+      std::vector<Tensor> read_tensors;
+      TF_ASSERT_OK(Reader::DecodeTensors(
+          version, compression, dtypes,
+          std::vector<tstring>(records.begin(), records.end()),
+          &read_tensors));
+      ExpectSameTensors(tensors, read_tensors);
+    }
+  }
+}
+
+TEST(SnapshotUtilTest, EncodingMatchesProtoSerialization) {
+  const std::vector<Tensor> tensors = MakeNumericElement();
+  experimental::SnapshotRecord record;
+  for (const auto& tensor : tensors) {
+    tensor.AsProtoTensorContent(record.add_tensor());
+  }
+  std::vector<std::string> records;
+  TF_ASSERT_OK(Writer::EncodeTensors(1, io::compression::kNone, tensors,
+                                     &records));
+  ASSERT_EQ(records.size(), 1);
+  EXPECT_EQ(records[0], record.SerializeAsString());
+
+  records.clear();
+  TF_ASSERT_OK(Writer::EncodeTensors(2, io::compression::kNone, tensors,
+                                     &records));
+  ASSERT_EQ(records.size(), tensors.size());
+  for (int i = 0; i < tensors.size(); ++i) {
+    EXPECT_EQ(records[i], record.tensor(i).SerializeAsString());
+  }
+}
+
+std::vector<Tensor> MakeElement(int64 index) {
+  const char c = 'a' + index % 26;
+  return {Tensor(index), Tensor(tstring(std::string(1024, c)))};
+}
+
+void PipelinedRoundTrip(std::string compression_type, int version,
+                        int64 file_size_bytes) {
+  const DataTypeVector dtypes = {DT_INT64, DT_STRING};
+  const int64 kNumElements = 100;
+  const int64 kNumToSkip = 10;
+
+  std::string shard_directory;
+  EXPECT_TRUE(Env::Default()->LocalTempFilename(&shard_directory));
+
+  thread::ThreadPool pool(Env::Default(), "pipelined_round_trip", 4);
+  PipelineOptions options;
+  options.runner = [&pool](std::function<void()> fn) {
+    pool.Schedule(std::move(fn));
+  };
+  options.max_elements_in_flight = 4;
+  options.file_size_bytes = file_size_bytes;
+
+  Notification done;
+  Status writer_status;
+  auto writer = absl::make_unique<AsyncWriter>(
+      Env::Default(), /*file_index=*/0, shard_directory, /*checkpoint_id=*/0,
+      compression_type, version, dtypes,
+      [&done, &writer_status](Status s) {
+        writer_status = s;
+        done.Notify();
+      },
+      options);
+  for (int64 i = 0; i < kNumElements; ++i) {
+    writer->Write(MakeElement(i));
+  }
+  writer->SignalEOF();
+  done.WaitForNotification();
+  writer.reset();
+  TF_ASSERT_OK(writer_status);
+
+  std::vector<std::string> filenames;
+  TF_ASSERT_OK(GetShardFilenames(Env::Default(), shard_directory, &filenames));
+  if (file_size_bytes > 0) {
+    EXPECT_GT(filenames.size(), 1);
+  } else {
+    EXPECT_EQ(filenames.size(), 1);
+  }
+
+  PipelinedReader reader(Env::Default(), filenames, compression_type, version,
+                         dtypes, kNumToSkip, options);
+  for (int64 i = kNumToSkip; i < kNumElements; ++i) {
+    std::vector<Tensor> read_tensors;
+    bool end_of_sequence;
+    TF_ASSERT_OK(reader.ReadTensors(&read_tensors, &end_of_sequence));
+    ASSERT_FALSE(end_of_sequence);
+    ASSERT_EQ(read_tensors.size(), 2);
+    EXPECT_EQ(read_tensors[0].scalar<int64>()(), i);
+    EXPECT_EQ(read_tensors[1].scalar<tstring>()(),
+              MakeElement(i)[1].scalar<tstring>()());
+  }
+  std::vector<Tensor> read_tensors;
+  bool end_of_sequence;
+  TF_ASSERT_OK(reader.ReadTensors(&read_tensors, &end_of_sequence));
+  EXPECT_TRUE(end_of_sequence);
+
+  int64 undeleted_files, undeleted_dirs;
+  TF_ASSERT_OK(Env::Default()->DeleteRecursively(
+      shard_directory, &undeleted_files, &undeleted_dirs));
+}
+
+TEST(SnapshotUtilTest, PipelinedRoundTripTest) {
+  PipelinedRoundTrip(io::compression::kNone, 1, /*file_size_bytes=*/0);
+  PipelinedRoundTrip(io::compression::kSnappy, 1, /*file_size_bytes=*/0);
+  PipelinedRoundTrip(io::compression::kNone, 2, /*file_size_bytes=*/0);
+  PipelinedRoundTrip(io::compression::kGzip, 2, /*file_size_bytes=*/0);
+}
+
+TEST(SnapshotUtilTest, PipelinedRoundTripWithFileSizeTest) {
+  PipelinedRoundTrip(io::compression::kSnappy, 1, /*file_size_bytes=*/4096);
+  PipelinedRoundTrip(io::compression::kGzip, 2, /*file_size_bytes=*/4096);
+}
+
+TEST(SnapshotUtilTest, CheckpointFileNamesSortByPart) {
+  std::vector<std::string> filenames = {GetCheckpointFileName("dir", 1, 0),
+                                        GetCheckpointFileName("dir", 0, 2),
+                                        GetCheckpointFileName("dir", 0, 1),
+                                        GetCheckpointFileName("dir", 0, 0)};
+  std::sort(filenames.begin(), filenames.end());
+  EXPECT_EQ(filenames, std::vector<std::string>(
+                           {GetCheckpointFileName("dir", 0),
+                            GetCheckpointFileName("dir", 0, 1),
+                            GetCheckpointFileName("dir", 0, 2),
+                            GetCheckpointFileName("dir", 1)}));
+}
+
 void SnapshotReaderBenchmarkLoop(int iters, std::string compression_type,
                                  int version) {
   tensorflow::testing::StopTiming();
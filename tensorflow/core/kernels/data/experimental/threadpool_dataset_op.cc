@@ -101,7 +101,9 @@ class ThreadPoolHandleOp : public OpKernel {
                               [this, ctx](ThreadPoolResource** ret)
                                   TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
                                     *ret = new ThreadPoolResource(
-                                        ctx->env(), {}, display_name_,
+                                        ctx->env(),
+                                        GetThreadOptions(ctx->device()),
+                                        display_name_,
                                         num_threads_,
                                         /*low_latency_hint=*/false,
                                         max_intra_op_parallelism_);
@@ -397,7 +399,8 @@ class PrivateThreadPoolDatasetOp : public UnaryDatasetOpKernel {
           input_(input),
           num_threads_(num_threads) {
       thread_pool_ = absl::make_unique<thread::ThreadPool>(
-          ctx->env(), ThreadOptions{}, "data_private_threadpool", num_threads,
+          ctx->env(), GetThreadOptions(ctx->device()),
+          "data_private_threadpool", num_threads,
           /*low_latency_hint=*/false);
       input_->Ref();
     }
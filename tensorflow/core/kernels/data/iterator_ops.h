@@ -38,7 +38,8 @@ class IteratorResource : public ResourceBase {
                    std::unique_ptr<FunctionLibraryDefinition> flib_def,
                    std::unique_ptr<ProcessFunctionLibraryRuntime> pflr,
                    FunctionLibraryRuntime* flr)
-      : unbounded_thread_pool_(env, "tf_data_iterator_resource"),
+      : unbounded_thread_pool_(env, "tf_data_iterator_resource",
+                               GetThreadOptions(flr->device())),
         device_mgr_(std::move(device_mgr)),
         iterator_state_(std::make_shared<State>(std::move(flib_def),
                                                 std::move(pflr), flr,
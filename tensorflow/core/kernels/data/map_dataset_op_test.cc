@@ -91,6 +91,107 @@ MapDatasetParams MapDatasetParams3() {
       /*node_name=*/kNodeName);
 }
 
+// The functions below are small enough to run by calling their kernels
+// directly, except for the stateful `PrintX`, which runs through the function
+// runtime.
+
+// Multiplies each element by a captured input.
+MapDatasetParams MapDatasetParamsWithCapturedInput() {
+  return MapDatasetParams(
+      RangeDatasetParams(0, 10, 3),
+      /*other_arguments=*/{CreateTensor<int64>(TensorShape({}), {3})},
+      /*func=*/FunctionDefHelper::FunctionRef("XTimesY", {}),
+      /*func_lib=*/
+      {FunctionDefHelper::Create(
+          "XTimesY", {"x: int64", "y: int64"}, {"z: int64"}, {},
+          {{{"mul"}, "Mul", {"x", "y"}, {{"T", DT_INT64}}}},
+          {{"z", "mul:z:0"}})},
+      /*type_arguments=*/{DT_INT64},
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*use_inter_op_parallelism=*/true,
+      /*preserve_cardinality=*/true,
+      /*node_name=*/kNodeName);
+}
+
+// Returns both outputs of a `Unique` node.
+MapDatasetParams MapDatasetParamsWithMultiOutputNode() {
+  auto batch_dataset_params =
+      BatchDatasetParams(RangeDatasetParams(0, 10, 3),
+                         /*batch_size=*/2,
+                         /*drop_remainder=*/true,
+                         /*parallel_copy=*/false,
+                         /*output_dtypes=*/{DT_INT64},
+                         /*output_shapes=*/{PartialTensorShape({2})},
+                         /*node_name=*/"batch_dataset");
+  return MapDatasetParams(
+      std::move(batch_dataset_params),
+      /*other_arguments=*/{},
+      /*func=*/FunctionDefHelper::FunctionRef("UniqueX", {}),
+      /*func_lib=*/
+      {FunctionDefHelper::Create(
+          "UniqueX", {"x: int64"}, {"y: int64", "idx: int32"}, {},
+          {{{"unique"},
+            "Unique",
+            {"x"},
+            {{"T", DT_INT64}, {"out_idx", DT_INT32}}}},
+          {{"y", "unique:y:0"}, {"idx", "unique:idx:0"}})},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT64, DT_INT32},
+      /*output_shapes=*/{PartialTensorShape({-1}), PartialTensorShape({-1})},
+      /*use_inter_op_parallelism=*/true,
+      /*preserve_cardinality=*/true,
+      /*node_name=*/kNodeName);
+}
+
+// Reshapes each scalar element to a vector of two elements, which fails.
+MapDatasetParams MapDatasetParamsWithFailingOp() {
+  return MapDatasetParams(
+      RangeDatasetParams(0, 10, 3),
+      /*other_arguments=*/{},
+      /*func=*/FunctionDefHelper::FunctionRef("ReshapeX", {}),
+      /*func_lib=*/
+      {FunctionDefHelper::Create(
+          "ReshapeX", {"x: int64"}, {"y: int64"}, {},
+          {{{"shape"},
+            "Const",
+            {},
+            {{"value", test::AsTensor<int32>({2})}, {"dtype", DT_INT32}}},
+           {{"reshape"},
+            "Reshape",
+            {"x", "shape:output:0"},
+            {{"T", DT_INT64}, {"Tshape", DT_INT32}}}},
+          {{"y", "reshape:output:0"}})},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({2})},
+      /*use_inter_op_parallelism=*/true,
+      /*preserve_cardinality=*/true,
+      /*node_name=*/kNodeName);
+}
+
+// Passes each element through the stateful `Print` op.
+MapDatasetParams MapDatasetParamsWithStatefulOp() {
+  return MapDatasetParams(
+      RangeDatasetParams(0, 10, 3),
+      /*other_arguments=*/{},
+      /*func=*/FunctionDefHelper::FunctionRef("PrintX", {}),
+      /*func_lib=*/
+      {FunctionDefHelper::Create(
+          "PrintX", {"x: int64"}, {"y: int64"}, {},
+          {{{"print"},
+            "Print",
+            {"x", "x"},
+            {{"T", DT_INT64}, {"U", DataTypeSlice{DT_INT64}}}}},
+          {{"y", "print:output:0"}})},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*use_inter_op_parallelism=*/true,
+      /*preserve_cardinality=*/true,
+      /*node_name=*/kNodeName);
+}
+
 std::vector<GetNextTestCase<MapDatasetParams>> GetNextTestCases() {
   return {{/*dataset_params=*/MapDatasetParams1(),
            /*expected_outputs=*/
@@ -100,11 +201,32 @@ std::vector<GetNextTestCase<MapDatasetParams>> GetNextTestCases() {
            CreateTensors<int64>(TensorShape({2}), {{20, 14}, {8, 2}})},
           {/*dataset_params=*/MapDatasetParams3(),
            /*expected_outputs=*/
-           CreateTensors<int64>(TensorShape({}), {{0}, {12}, {24}, {36}})}};
+           CreateTensors<int64>(TensorShape({}), {{0}, {12}, {24}, {36}})},
+          {/*dataset_params=*/MapDatasetParamsWithCapturedInput(),
+           /*expected_outputs=*/
+           CreateTensors<int64>(TensorShape({}), {{0}, {9}, {18}, {27}})},
+          {/*dataset_params=*/MapDatasetParamsWithMultiOutputNode(),
+           /*expected_outputs=*/
+           {CreateTensor<int64>(TensorShape({2}), {0, 3}),
+            CreateTensor<int32>(TensorShape({2}), {0, 1}),
+            CreateTensor<int64>(TensorShape({2}), {6, 9}),
+            CreateTensor<int32>(TensorShape({2}), {0, 1})}},
+          {/*dataset_params=*/MapDatasetParamsWithStatefulOp(),
+           /*expected_outputs=*/
+           CreateTensors<int64>(TensorShape({}), {{0}, {3}, {6}, {9}})}};
 }
 
 ITERATOR_GET_NEXT_TEST_P(MapDatasetOpTest, MapDatasetParams, GetNextTestCases())
 
+TEST_F(MapDatasetOpTest, FailingOp) {
+  auto dataset_params = MapDatasetParamsWithFailingOp();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence)));
+}
+
 TEST_F(MapDatasetOpTest, DatasetNodeName) {
   auto dataset_params = MapDatasetParams1();
   TF_ASSERT_OK(Initialize(dataset_params));
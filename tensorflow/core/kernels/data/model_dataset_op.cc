@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
@@ -50,12 +51,31 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
     OP_REQUIRES(ctx, cpu_budget_ > 0,
                 errors::InvalidArgument("CPU budget must be positive but is ",
                                         cpu_budget_, "."));
-    ram_budget_ = kRamBudgetShare * port::AvailableRam();
+    ram_budget_ = 0;
+    if (ctx->HasAttr("ram_budget")) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("ram_budget", &ram_budget_));
+    }
+    OP_REQUIRES(ctx, ram_budget_ >= 0,
+                errors::InvalidArgument(
+                    "RAM budget must be non-negative but is ", ram_budget_,
+                    "."));
+    if (ram_budget_ == 0) {
+      ram_budget_ = kRamBudgetShare * port::AvailableRam();
+    }
+    rss_limit_ = 0;
+    if (ctx->HasAttr("rss_limit")) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("rss_limit", &rss_limit_));
+    }
+    OP_REQUIRES(ctx, rss_limit_ >= 0,
+                errors::InvalidArgument(
+                    "RSS limit must be non-negative but is ", rss_limit_,
+                    "."));
   }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                    DatasetBase** output) override {
-    *output = new Dataset(ctx, input, algorithm_, cpu_budget_, ram_budget_);
+    *output = new Dataset(ctx, input, algorithm_, cpu_budget_, ram_budget_,
+                          rss_limit_);
   }
 
  private:
@@ -63,12 +83,13 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
    public:
     Dataset(OpKernelContext* ctx, const DatasetBase* input,
             model::AutotuneAlgorithm algorithm, int64 cpu_budget,
-            int64 ram_budget)
+            int64 ram_budget, int64 rss_limit)
         : DatasetBase(DatasetContext(ctx)),
           input_(input),
           algorithm_(algorithm),
           cpu_budget_(cpu_budget),
-          ram_budget_(ram_budget) {
+          ram_budget_(ram_budget),
+          rss_limit_(rss_limit) {
       input_->Ref();
     }
 
@@ -204,7 +225,7 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
             model_input_time = SelfInputTime();
           }
           model_->Optimize(dataset()->algorithm_, dataset()->cpu_budget_,
-                           dataset()->ram_budget_, /*model_input_time=*/0);
+                           RamBudget(), /*model_input_time=*/0);
           // Exponentially increase the period of running the optimization
           // until a threshold is reached.
           if (optimization_period_ms != kOptimizationPeriodThresholdMs) {
@@ -217,6 +238,23 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
         }
       }
 
+      // Returns the RAM budget for the next optimization. If the process is
+      // subject to an RSS limit, the budget is capped by the remaining
+      // headroom, which becomes negative (and thus makes the optimizer shrink
+      // the buffers) once the limit has been exceeded.
+      int64 RamBudget() const {
+        int64 ram_budget = dataset()->ram_budget_;
+        if (dataset()->rss_limit_ > 0) {
+          int64 rss = port::ResidentSetSize();
+          if (rss != INT64_MAX) {
+            ram_budget = std::min(ram_budget, dataset()->rss_limit_ - rss);
+            VLOG(2) << "Resident set size: " << rss
+                    << " bytes, RAM budget: " << ram_budget << " bytes.";
+          }
+        }
+        return ram_budget;
+      }
+
       void RecordInput(int64 time_nanos) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         if (last_output_time_ != 0) {
           DCHECK_LE(last_output_time_, time_nanos);
@@ -252,11 +290,15 @@ class ModelDatasetOp : public UnaryDatasetOpKernel {
     const model::AutotuneAlgorithm algorithm_;
     const int64 cpu_budget_;
     const int64 ram_budget_;
+    const int64 rss_limit_;
   };
 
   model::AutotuneAlgorithm algorithm_;
   int64 cpu_budget_;
   int64 ram_budget_;
+  // If positive, the resident set size (in bytes) that the process should not
+  // exceed.
+  int64 rss_limit_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("ModelDataset").Device(DEVICE_CPU),
@@ -59,7 +59,8 @@ class MultiDeviceIterator : public ResourceBase {
       std::unique_ptr<ProcessFunctionLibraryRuntime> pflr,
       FunctionLibraryRuntime* flr,
       std::unique_ptr<FunctionHandleCache> function_handle_cache)
-      : unbounded_thread_pool_(env, "tf_data_multi_device_iterator_resource"),
+      : unbounded_thread_pool_(env, "tf_data_multi_device_iterator_resource",
+                               GetThreadOptions(flr->device())),
         output_types_(output_types),
         output_shapes_(output_shapes),
         devices_(devices),
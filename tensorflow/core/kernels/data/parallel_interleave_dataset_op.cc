@@ -41,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
@@ -115,6 +116,10 @@ constexpr double kDefaultCyclePrefetchFactor = 2.0L;
 // match the behavior of the original implementation.
 constexpr double kDefaultPerIteratorPrefetchFactor = 2.0L;
 
+// `kMaxPerIteratorPrefetchFactor * block_length + 1` is the maximum number of
+// per-iterator results that autotuning will prefetch ahead of time.
+constexpr double kMaxPerIteratorPrefetchFactor = 8.0L;
+
 // Period between reporting dataset statistics.
 constexpr int kStatsReportingPeriodMillis = 1000;
 
@@ -169,8 +174,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         captured_func_(std::move(captured_func)),
         cycle_length_(cycle_length),
         block_length_(block_length),
-        buffer_output_elements_(
-            ComputeBufferOutputElements(buffer_output_elements, block_length)),
+        buffer_output_elements_(buffer_output_elements),
         prefetch_input_elements_(ComputePrefetchInputElements(
             prefetch_input_elements, cycle_length)),
         num_parallel_calls_(num_parallel_calls),
@@ -297,10 +301,12 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     ParallelInterleaveIterator(const Params& params, bool deterministic)
         : DatasetIterator<Dataset>(params),
           mu_(std::make_shared<mutex>()),
-          num_parallel_calls_cond_var_(std::make_shared<condition_variable>()),
+          autotune_cond_var_(std::make_shared<condition_variable>()),
           num_parallel_calls_(std::make_shared<model::SharedState>(
-              params.dataset->num_parallel_calls_, mu_,
-              num_parallel_calls_cond_var_)),
+              params.dataset->num_parallel_calls_, mu_, autotune_cond_var_)),
+          buffer_output_elements_(std::make_shared<model::SharedState>(
+              params.dataset->buffer_output_elements_, mu_,
+              autotune_cond_var_)),
           deterministic_(deterministic),
           current_elements_(params.dataset->cycle_length_) {}
 
@@ -331,6 +337,8 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       if (num_parallel_calls_->value == model::kAutotune) {
         num_parallel_calls_->value = dataset()->cycle_length_;
       }
+      buffer_output_elements_->value = ComputeBufferOutputElements(
+          buffer_output_elements_->value, dataset()->block_length_);
       // TODO(jsimsa): Register cancellation callback once the implementation is
       // refactored not to hold mu_ while calling `GetNext` on the input.
       ctx_ = std::make_unique<IteratorContext>(*ctx);
@@ -382,10 +390,16 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
    protected:
     std::shared_ptr<model::Node> CreateNode(
         IteratorContext* ctx, model::Node::Args args) const override {
+      const int64 max_buffer_output_elements = std::max<int64>(
+          dataset()->buffer_output_elements_,
+          kMaxPerIteratorPrefetchFactor * dataset()->block_length_ + 1);
       return model::MakeAsyncInterleaveManyNode(
           std::move(args),
           {model::MakeParameter(kParallelism, num_parallel_calls_, /*min=*/1,
-                                /*max=*/dataset()->cycle_length_)});
+                                /*max=*/dataset()->cycle_length_),
+           model::MakeParameter(model::kPerInputBufferSize,
+                                buffer_output_elements_, /*min=*/1,
+                                /*max=*/max_buffer_output_elements)});
     }
 
     // TODO(aaudibert): Refactor the implementations to avoid the need for
@@ -559,7 +573,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       }
       current_workers_cond_var_.notify_all();
       future_workers_cond_var_.notify_all();
-      num_parallel_calls_cond_var_->notify_all();
+      autotune_cond_var_->notify_all();
       stats_thread_cond_var_.notify_all();
       while (wait && outstanding_threads_ > 0) {
         outstanding_threads_finished_cond_var_.wait(l);
@@ -628,6 +642,61 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         }
         AdvanceToNextInCycle();
       }
+      // None of the elements in the cycle has a result available. Rather than
+      // waiting on a slow (e.g. remote or cold) input, skip ahead to a future
+      // element which already has results available.
+      if (SkipStragglerElement()) {
+        return ConsumeHelper(result);
+      }
+      return false;
+    }
+
+    // Swaps a cycle element which has no results available yet with the first
+    // future element that has results available. The swapped out element
+    // becomes the first future element, so that it re-enters the cycle when
+    // another cycle element is exhausted or is skipped in turn. Returns whether
+    // an element was swapped. Only used when `deterministic` is false.
+    bool SkipStragglerElement() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      int64 ready_index = -1;
+      for (int64 i = 0; i < future_elements_.size(); ++i) {
+        if (!future_elements_[i]->results.empty()) {
+          ready_index = i;
+          break;
+        }
+      }
+      if (ready_index == -1 || last_valid_current_element_ == -1) {
+        return false;
+      }
+      for (int64 i = 0; i < (last_valid_current_element_ + 1); ++i) {
+        int64 index = (cycle_index_ + i) % (last_valid_current_element_ + 1);
+        std::shared_ptr<Element> straggler = current_elements_[index];
+        if (!straggler || !straggler->results.empty() ||
+            (straggler->initialized && !straggler->iterator)) {
+          continue;
+        }
+        std::shared_ptr<Element> element =
+            std::move(future_elements_[ready_index]);
+        future_elements_.erase(future_elements_.begin() + ready_index);
+        VLOG(3) << "Skipping element " << straggler->id << " for element "
+                << element->id;
+        if (element->iterator) {
+          EnableAutotune(ctx_.get(), element->iterator.get());
+        }
+        element->cycle_index = index;
+        if (!element->active) {
+          elements_to_process_.push_back(index);
+          current_workers_cond_var_.notify_one();
+        }
+        current_elements_[index] = std::move(element);
+        if (straggler->iterator) {
+          DisableAutotune(ctx_.get(), straggler->iterator.get());
+        }
+        straggler->cycle_index = -1;
+        future_elements_.push_front(std::move(straggler));
+        cycle_index_ = index;
+        block_index_ = 0;
+        return true;
+      }
       return false;
     }
 
@@ -737,8 +806,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       // future worker available to create a new future element.
       int future_workers =
           dataset()->prefetch_input_elements_ + dataset()->cycle_length_;
+      int64 buffer_output_elements;
       {
         mutex_lock l(*mu_);
+        buffer_output_elements = buffer_output_elements_->value;
         initial_current_workers = num_parallel_calls_->value;
         outstanding_threads_ += initial_current_workers + future_workers;
         num_current_workers_ += initial_current_workers;
@@ -758,8 +829,12 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           while (!cancelled_ &&
                  num_current_workers_ >= num_parallel_calls_->value) {
             RecordStop(ctx_.get());
-            num_parallel_calls_cond_var_->wait(l);
+            autotune_cond_var_->wait(l);
             RecordStart(ctx_.get());
+            if (buffer_output_elements_->value > buffer_output_elements) {
+              ResumeCurrentElements();
+            }
+            buffer_output_elements = buffer_output_elements_->value;
           }
           if (cancelled_ || end_of_input_) {
             return;
@@ -773,6 +848,18 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       }
     }
 
+    // Schedules the current elements whose results buffer is no longer full
+    // (e.g. because autotuning increased its size) for further processing.
+    void ResumeCurrentElements() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      for (int i = 0; i <= last_valid_current_element_; ++i) {
+        const auto& element = current_elements_[i];
+        if (NeedsProcessing(element) && !element->active) {
+          elements_to_process_.push_back(i);
+        }
+      }
+      current_workers_cond_var_.notify_all();
+    }
+
     void StartCurrentWorkerThread() {
       thread_pool_->Schedule([this]() { CurrentWorkerThread(); });
     }
@@ -936,8 +1023,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
                {"element_id", result->id}});
         });
         bool end_of_input = false;
+        const uint64 start_time_ns = EnvTime::NowNanos();
         result->status = iterator->GetNext(ctx_.get(), &result->return_values,
                                            &end_of_input);
+        RecordInputLatency(EnvTime::NowNanos() - start_time_ns);
         if (end_of_input) {
           mutex_lock l(*mu_);
           element->iterator.reset();
@@ -949,12 +1038,23 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         mutex_lock l(*mu_);
         element->results.push_back(std::move(result));
         NotifyElementUpdate(element);
-        if (element->results.size() == dataset()->buffer_output_elements_) {
+        if (element->results.size() >= buffer_output_elements_->value) {
           break;
         }
       }
     }
 
+    // Records the time it took an input to produce an element, so that slow
+    // inputs show up in the tail of the latency histogram.
+    void RecordInputLatency(uint64 latency_ns) {
+      const auto& stats_aggregator = ctx_->stats_aggregator();
+      if (stats_aggregator) {
+        stats_aggregator->AddToHistogram(
+            stats_utils::InputLatencyHistogramName(dataset()->node_name()),
+            {static_cast<float>(latency_ns)}, num_elements());
+      }
+    }
+
     // Initialize inputs and create an iterator for all elements up to
     // element_id.
     void InitializeInputs(int element_id) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -1047,7 +1147,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         return true;
       }
       return element->iterator &&
-             element->results.size() < dataset()->buffer_output_elements_;
+             element->results.size() < buffer_output_elements_->value;
     }
 
     inline void IncrementCurrentWorkers() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -1448,13 +1548,17 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     // drops to zero. Used for checkpointing.
     condition_variable zero_active_workers_cond_var_;
 
-    // Condition notified whenever num_parallel_calls_ changes. Shared so that
-    // autotuning can notify us when num_parallel_calls_ changes.
-    std::shared_ptr<condition_variable> num_parallel_calls_cond_var_;
+    // Condition notified whenever num_parallel_calls_ or
+    // buffer_output_elements_ changes. Shared so that autotuning can notify us
+    // when they change.
+    std::shared_ptr<condition_variable> autotune_cond_var_;
 
     // Identifies the maximum number of parallel calls.
     const std::shared_ptr<model::SharedState> num_parallel_calls_;
 
+    // Identifies the maximum number of results buffered for each element.
+    const std::shared_ptr<model::SharedState> buffer_output_elements_;
+
     // The number of current workers currently alive or scheduled to be started.
     // This includes current workers which are blocked waiting for work.
     int num_current_workers_ TF_GUARDED_BY(mu_) = 0;
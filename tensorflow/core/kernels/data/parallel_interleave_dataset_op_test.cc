@@ -11,7 +11,9 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/parallel_interleave_dataset_op.h"
 
+#include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
+#include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
 namespace data {
@@ -124,6 +126,105 @@ FunctionDefHelper::AttrValueWrapper MakeTensorSliceDatasetFunc(
                  {"output_shapes", output_shapes}});
 }
 
+// Returns a function that slices `x` into a dataset which sleeps for
+// `sleep_microseconds` before producing each element.
+FunctionDef MakeSleepingTensorSliceDataset() {
+  return FunctionDefHelper::Define(
+      // Name
+      "MakeSleepingTensorSliceDataset",
+      // Args
+      {"x: int64", "sleep_microseconds: int64"},
+      // Return values
+      {"y: variant"},
+      // Attr def
+      {},
+      // Nodes
+      {{{"slices"},
+        "TensorSliceDataset",
+        {"x"},
+        {{"Toutput_types", DataTypeVector({DT_INT64})},
+         {"output_shapes",
+          std::vector<PartialTensorShape>({PartialTensorShape({1})})}}},
+       {{"y"},
+        "SleepDataset",
+        {"slices", "sleep_microseconds"},
+        {{"output_types", DataTypeVector({DT_INT64})},
+         {"output_shapes",
+          std::vector<PartialTensorShape>({PartialTensorShape({1})})}}}});
+}
+
+// Interleaves a slow input producing {0, 1, 2} and a fast input producing
+// {3, 4, 5}. The slow input comes first and is the only element of the cycle,
+// while the fast input is prefetched as a future element.
+ParallelInterleaveDatasetParams StragglerParallelInterleaveDatasetParams(
+    const std::string& deterministic) {
+  auto tensor_slice_dataset_params = TensorSliceDatasetParams(
+      /*components=*/{CreateTensor<int64>(TensorShape{2, 3, 1},
+                                          {0, 1, 2, 3, 4, 5}),
+                      CreateTensor<int64>(TensorShape{2}, {500000, 0})},
+      /*node_name=*/"tensor_slice");
+  return ParallelInterleaveDatasetParams(
+      tensor_slice_dataset_params,
+      /*other_arguments=*/{},
+      /*cycle_length=*/1,
+      /*block_length=*/1,
+      /*buffer_output_elements=*/1,
+      /*prefetch_input_elements=*/1,
+      /*num_parallel_calls=*/1,
+      /*func=*/
+      FunctionDefHelper::FunctionRef(/*name=*/"MakeSleepingTensorSliceDataset",
+                                     /*attrs=*/{}),
+      /*func_lib=*/{MakeSleepingTensorSliceDataset()},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({1})},
+      /*deterministic=*/deterministic,
+      /*node_name=*/kNodeName);
+}
+
+// Interleaves a single input producing {0, ..., 19} with an autotuned
+// per-input buffer.
+ParallelInterleaveDatasetParams
+AutotunedBufferParallelInterleaveDatasetParams() {
+  std::vector<int64> values(20);
+  for (int i = 0; i < values.size(); ++i) {
+    values[i] = i;
+  }
+  auto tensor_slice_dataset_params = TensorSliceDatasetParams(
+      /*components=*/{CreateTensor<int64>(TensorShape{1, 20, 1}, values)},
+      /*node_name=*/"tensor_slice");
+  return ParallelInterleaveDatasetParams(
+      tensor_slice_dataset_params,
+      /*other_arguments=*/{},
+      /*cycle_length=*/1,
+      /*block_length=*/1,
+      /*buffer_output_elements=*/model::kAutotune,
+      /*prefetch_input_elements=*/0,
+      /*num_parallel_calls=*/1,
+      /*func=*/
+      MakeTensorSliceDatasetFunc(
+          DataTypeVector({DT_INT64}),
+          std::vector<PartialTensorShape>({PartialTensorShape({1})})),
+      /*func_lib=*/{test::function::MakeTensorSliceDataset()},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({1})},
+      /*deterministic=*/DeterminismPolicy::kDeterministic,
+      /*node_name=*/kNodeName);
+}
+
+// Polls `condition` until it holds or a timeout expires, and returns whether it
+// holds.
+bool WaitFor(const std::function<bool()>& condition) {
+  constexpr int kTimeoutMicros = 10 * 1000 * 1000;
+  constexpr int kPollMicros = 1000;
+  for (int waited = 0; waited < kTimeoutMicros; waited += kPollMicros) {
+    if (condition()) return true;
+    Env::Default()->SleepForMicroseconds(kPollMicros);
+  }
+  return condition();
+}
+
 ParallelInterleaveDatasetParams ParallelInterleaveDatasetParams1() {
   auto tensor_slice_dataset_params = TensorSliceDatasetParams(
       /*components=*/{CreateTensor<int64>(TensorShape{3, 3, 1},
@@ -774,6 +875,133 @@ TEST_F(ParallelInterleaveDatasetOpTest, InvalidArguments) {
   }
 }
 
+TEST_F(ParallelInterleaveDatasetOpTest, SkipsStragglerWhenNondeterministic) {
+  auto dataset_params = StragglerParallelInterleaveDatasetParams(
+      DeterminismPolicy::kNondeterministic);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> out_tensors;
+  bool end_of_sequence = false;
+  while (!end_of_sequence) {
+    std::vector<Tensor> next;
+    TF_ASSERT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+    out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+  }
+  // The fast input is swapped into the cycle rather than waiting for the slow
+  // input, which still produces all of its elements afterwards.
+  ASSERT_FALSE(out_tensors.empty());
+  TF_EXPECT_OK(
+      ExpectEqual(out_tensors[0], CreateTensor<int64>(TensorShape{1}, {3})));
+  TF_EXPECT_OK(ExpectEqual(
+      out_tensors,
+      CreateTensors<int64>(TensorShape{1}, {{0}, {1}, {2}, {3}, {4}, {5}}),
+      /*compare_order=*/false));
+}
+
+TEST_F(ParallelInterleaveDatasetOpTest, DoesNotSkipStragglerWhenDeterministic) {
+  auto dataset_params = StragglerParallelInterleaveDatasetParams(
+      DeterminismPolicy::kDeterministic);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_EXPECT_OK(CheckIteratorGetNext(
+      CreateTensors<int64>(TensorShape{1}, {{0}, {1}, {2}, {3}, {4}, {5}}),
+      /*compare_order=*/true));
+}
+
+TEST_F(ParallelInterleaveDatasetOpTest, SaveAndRestoreAfterSkippingStraggler) {
+  auto dataset_params = StragglerParallelInterleaveDatasetParams(
+      DeterminismPolicy::kNondeterministic);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> out_tensors;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence));
+  // The slow input has been swapped out of the cycle.
+  TF_ASSERT_OK(
+      ExpectEqual(out_tensors[0], CreateTensor<int64>(TensorShape{1}, {3})));
+
+  std::unique_ptr<SerializationContext> serialization_ctx;
+  TF_ASSERT_OK(CreateSerializationContext(&serialization_ctx));
+  VariantTensorDataWriter writer;
+  TF_ASSERT_OK(iterator_->Save(serialization_ctx.get(), &writer));
+  std::vector<const VariantTensorData*> data;
+  writer.GetData(&data);
+  VariantTensorDataReader reader(data);
+  TF_ASSERT_OK(RestoreIterator(iterator_ctx_.get(), &reader,
+                               dataset_params.iterator_prefix(), *dataset_,
+                               &iterator_));
+
+  // The restored iterator produces the remaining elements of both inputs
+  // exactly once.
+  while (!end_of_sequence) {
+    std::vector<Tensor> next;
+    TF_ASSERT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+    out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+  }
+  TF_EXPECT_OK(ExpectEqual(
+      out_tensors,
+      CreateTensors<int64>(TensorShape{1}, {{0}, {1}, {2}, {3}, {4}, {5}}),
+      /*compare_order=*/false));
+}
+
+TEST_F(ParallelInterleaveDatasetOpTest, AutotuneGrowsPerInputBuffer) {
+  auto dataset_params = AutotunedBufferParallelInterleaveDatasetParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  // Iterates with a performance model. The iterator created by `Initialize()`
+  // has no model node, so the interleave node becomes the output of the model.
+  IteratorContext::Params params(iterator_ctx_.get());
+  params.model = std::make_shared<model::Model>();
+  IteratorContext ctx(std::move(params));
+  std::unique_ptr<IteratorBase> iterator;
+  TF_ASSERT_OK(dataset_->MakeIterator(&ctx, iterator_.get(),
+                                      dataset_params.iterator_prefix(),
+                                      &iterator));
+  std::vector<Tensor> out_tensors;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(iterator->GetNext(&ctx, &out_tensors, &end_of_sequence));
+
+  std::shared_ptr<model::Node> node = ctx.model()->output();
+  ASSERT_NE(node, nullptr);
+  absl::flat_hash_map<string, std::shared_ptr<model::Parameter>> parameters;
+  node->CollectTunableParameters(&parameters);
+  std::shared_ptr<model::Parameter> buffer_size;
+  for (const auto& pair : parameters) {
+    if (pair.second->name == model::kPerInputBufferSize) {
+      buffer_size = pair.second;
+    }
+  }
+  ASSERT_NE(buffer_size, nullptr);
+  const int64 initial_buffer_size = buffer_size->state->value;
+  ASSERT_LT(initial_buffer_size, buffer_size->max);
+  // The buffer of the input fills up to its initial size.
+  EXPECT_TRUE(WaitFor([&node, initial_buffer_size]() {
+    return node->buffered_elements() == initial_buffer_size;
+  }));
+
+  // Grows the buffer as the optimization of the model would.
+  {
+    mutex_lock l(*buffer_size->state->mu);
+    buffer_size->state->value = buffer_size->max;
+    buffer_size->state->cond_var->notify_all();
+  }
+  const int64 max_buffer_size = buffer_size->max;
+  EXPECT_TRUE(WaitFor([&node, max_buffer_size]() {
+    return node->buffered_elements() == max_buffer_size;
+  }));
+
+  while (!end_of_sequence) {
+    std::vector<Tensor> next;
+    TF_ASSERT_OK(iterator->GetNext(&ctx, &next, &end_of_sequence));
+    out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+  }
+  std::vector<Tensor> expected_outputs;
+  for (int64 i = 0; i < 20; ++i) {
+    expected_outputs.push_back(CreateTensor<int64>(TensorShape{1}, {i}));
+  }
+  TF_EXPECT_OK(ExpectEqual(out_tensors, expected_outputs,
+                           /*compare_order=*/true));
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/parallel_map_dataset_op.h"
 
 #include <deque>
+#include <iterator>
 
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/input_colocation_exemption_registry.h"
@@ -54,6 +55,7 @@ namespace data {
 /* static */ constexpr const char* const ParallelMapDatasetOp::kSloppy;
 /* static */ constexpr const char* const
     ParallelMapDatasetOp::kPreserveCardinality;
+/* static */ constexpr const char* const ParallelMapDatasetOp::kMicroBatchSize;
 
 namespace {
 
@@ -76,7 +78,7 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
           const std::vector<PartialTensorShape>& output_shapes,
           DeterminismPolicy deterministic,
           std::unique_ptr<CapturedFunction> captured_func,
-          bool preserve_cardinality, int op_version)
+          bool preserve_cardinality, int64 micro_batch_size, int op_version)
       : DatasetBase(DatasetContext(ctx)),
         input_(input),
         num_parallel_calls_(num_parallel_calls),
@@ -85,6 +87,7 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
         deterministic_(deterministic),
         preserve_cardinality_(preserve_cardinality),
         captured_func_(std::move(captured_func)),
+        micro_batch_size_(micro_batch_size),
         op_version_(op_version) {
     input_->Ref();
   }
@@ -95,6 +98,10 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
       const string& prefix) const override {
     name_utils::IteratorPrefixParams params;
     params.op_version = op_version_;
+    if (micro_batch_size_ > 0) {
+      return absl::make_unique<MicroBatchIterator>(MicroBatchIterator::Params{
+          this, name_utils::IteratorPrefix(kDatasetType, prefix, params)});
+    }
     return absl::make_unique<Iterator>(Iterator::Params{
         this, name_utils::IteratorPrefix(kDatasetType, prefix, params)});
   }
@@ -176,6 +183,11 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
       AttrValue deterministic_attr;
       b->BuildAttrValue(deterministic_.String(), &deterministic_attr);
       attrs.emplace_back(kDeterministic, deterministic_attr);
+
+      // Attr: micro_batch_size
+      AttrValue micro_batch_size_attr;
+      b->BuildAttrValue(micro_batch_size_, &micro_batch_size_attr);
+      attrs.emplace_back(kMicroBatchSize, micro_batch_size_attr);
     }
 
     // Attr: preserve_cardinality
@@ -646,6 +658,539 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
     std::function<void()> deregister_fn_;
   };
 
+  // Iterator used when `micro_batch_size` is positive. It is designed for
+  // cheap map functions, for which scheduling one closure per element and
+  // waking up the consumer for every result dominates the cost of the map.
+  //
+  // The iterator runs `num_parallel_calls` dedicated worker threads. Each
+  // worker reads a micro-batch of input elements into its own task queue and
+  // applies the map function to them in order. A worker whose queue is empty
+  // steals half of the tasks from the back of another worker's queue before
+  // reading more input, so that the owner keeps working on the front of its
+  // micro-batch. Results are handed over to the consumer one micro-batch at a
+  // time and the consumer is only notified if it is waiting.
+  class MicroBatchIterator : public DatasetIterator<Dataset> {
+   public:
+    explicit MicroBatchIterator(const Params& params)
+        : DatasetIterator<Dataset>(params),
+          deterministic_(params.dataset->deterministic_.IsDeterministic() ||
+                         params.dataset->deterministic_.IsDefault()),
+          preserve_cardinality_(params.dataset->preserve_cardinality_),
+          micro_batch_size_(params.dataset->micro_batch_size_) {}
+
+    ~MicroBatchIterator() override {
+      std::vector<std::unique_ptr<Thread>> worker_threads;
+      {
+        mutex_lock l(mu_);
+        CancelThreadsLocked();
+        worker_threads.swap(worker_threads_);
+      }
+      // Joins the worker threads.
+      worker_threads.clear();
+      if (deregister_fn_) deregister_fn_();
+    }
+
+    Status Initialize(IteratorContext* ctx) override {
+      mutex_lock l(mu_);
+      num_workers_ = dataset()->num_parallel_calls_;
+      if (num_workers_ == model::kAutotune) {
+        num_workers_ = ctx->runner_threadpool_size();
+      }
+      capacity_ = 2 * num_workers_ * micro_batch_size_;
+      workers_.clear();
+      for (int64 i = 0; i < num_workers_; ++i) {
+        workers_.push_back(absl::make_unique<WorkerState>());
+      }
+      TF_RETURN_IF_ERROR(RegisterCancellationCallback(
+          ctx->cancellation_manager(),
+          [this]() {
+            mutex_lock l(mu_);
+            CancelThreadsLocked();
+          },
+          &deregister_fn_));
+      TF_RETURN_IF_ERROR(
+          dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_));
+      return dataset()->captured_func_->Instantiate(
+          ctx, &instantiated_captured_func_);
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      std::shared_ptr<Result> result;
+      {
+        mutex_lock l(mu_);
+        EnsureThreadsStarted(ctx);
+        while (!cancelled_ && !ResultReady() &&
+               !(end_of_input_ && outstanding_ == 0)) {
+          ++num_waiting_consumers_;
+          RecordStop(ctx);
+          consumer_cond_var_.wait(l);
+          RecordStart(ctx);
+          --num_waiting_consumers_;
+        }
+        if (cancelled_) {
+          return errors::Cancelled("Iterator was cancelled");
+        }
+        if (!ResultReady()) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        result = std::move(results_.front());
+        results_.pop_front();
+        --outstanding_;
+        if (capacity_ - outstanding_ >= micro_batch_size_) {
+          // There is room for another micro-batch of input.
+          ++epoch_;
+          if (num_idle_workers_ > 0) {
+            worker_cond_var_.notify_one();
+          }
+        }
+      }
+      profiler::TraceMe traceme([&] {
+        return profiler::TraceMeEncode("ParallelMapConsume",
+                                       {{"element_id", result->id}});
+      });
+      return ProcessResult(ctx, result, out_tensors, end_of_sequence);
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      // The number of workers is fixed when the iterator is created, so there
+      // is nothing to tune.
+      return model::MakeAsyncKnownRatioNode(std::move(args),
+                                            /*ratio=*/1, /*parameters=*/{});
+    }
+
+    // Uses the same format as `Iterator`, so that checkpoints can be restored
+    // regardless of the execution mode.
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      TF_RETURN_IF_ERROR(ctx->HandleCheckExternalStateStatus(
+          dataset()->captured_func_->CheckExternalState()));
+      mutex_lock l(mu_);
+      // Stop reading input and wait for all tasks to complete.
+      saving_ = true;
+      while (!cancelled_ && num_unfinished_ > 0) {
+        ++num_waiting_consumers_;
+        consumer_cond_var_.wait(l);
+        --num_waiting_consumers_;
+      }
+      Status s = cancelled_ ? errors::Cancelled("Iterator was cancelled")
+                            : SaveLocked(ctx, writer);
+      saving_ = false;
+      ++epoch_;
+      worker_cond_var_.notify_all();
+      return s;
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+      int64 num_results;
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(absl::StrCat(prefix(), "::", kInvocationResults),
+                             kSize, &num_results));
+      results_.clear();
+      for (int64 i = 0; i < num_results; ++i) {
+        std::string element_prefix =
+            absl::StrCat(prefix(), "::", kInvocationResults, "::", i);
+        if (reader->Contains(element_prefix, kEndOfInput)) {
+          // The input iterator has been restored to its end, so reading from
+          // it again produces the end of input.
+          continue;
+        }
+        auto result = std::make_shared<Result>(next_id_++);
+        TF_RETURN_IF_ERROR(
+            ReadStatusLocked(reader, element_prefix, &result->status));
+        int64 num_return_values;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(element_prefix, kSize, &num_return_values));
+        result->return_values.reserve(num_return_values);
+        for (int64 j = 0; j < num_return_values; ++j) {
+          result->return_values.emplace_back();
+          TF_RETURN_IF_ERROR(reader->ReadTensor(
+              element_prefix, absl::StrCat(kComponent, "[", j, "]"),
+              &result->return_values.back()));
+        }
+        result->done = true;
+        results_.push_back(std::move(result));
+      }
+      outstanding_ = results_.size();
+      return Status::OK();
+    }
+
+   private:
+    struct Result {
+      explicit Result(int64 id) : id(id) {}
+
+      const int64 id;
+      Status status;
+      std::vector<Tensor> return_values;
+      // Whether the result has been handed over to the consumer. Guarded by
+      // the iterator's `mu_`.
+      bool done = false;
+    };
+
+    struct Task {
+      std::vector<Tensor> input;
+      std::shared_ptr<Result> result;
+    };
+
+    struct WorkerState {
+      mutex mu;
+      // The owner pops tasks from the front and thieves steal from the back.
+      std::deque<Task> tasks TF_GUARDED_BY(mu);
+    };
+
+    void CancelThreadsLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      cancelled_ = true;
+      worker_cond_var_.notify_all();
+      consumer_cond_var_.notify_all();
+    }
+
+    void EnsureThreadsStarted(IteratorContext* ctx)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (worker_threads_.empty()) {
+        auto ctx_copy = std::make_shared<IteratorContext>(*ctx);
+        for (int64 i = 0; i < num_workers_; ++i) {
+          worker_threads_.push_back(ctx->StartThread(
+              "tf_data_parallel_map_worker",
+              std::bind(&MicroBatchIterator::WorkerThread, this, ctx_copy, i)));
+        }
+      }
+    }
+
+    // Returns whether the next result to hand over to the consumer is ready.
+    bool ResultReady() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      return !results_.empty() && results_.front()->done;
+    }
+
+    void WorkerThread(const std::shared_ptr<IteratorContext>& ctx,
+                      int64 index) TF_LOCKS_EXCLUDED(mu_) {
+      RecordStart(ctx.get());
+      auto cleanup = gtl::MakeCleanup([this, ctx] { RecordStop(ctx.get()); });
+      WorkerState* const worker = workers_[index].get();
+      std::vector<std::shared_ptr<Result>> completed;
+      completed.reserve(micro_batch_size_);
+      while (true) {
+        Task task;
+        bool has_task = PopTask(worker, &task);
+        if (!has_task) {
+          // Hand over the results of the current micro-batch before looking
+          // for more work, so that they are not delayed by input reads.
+          if (!completed.empty() && !Publish(ctx.get(), &completed)) {
+            return;
+          }
+          int64 epoch;
+          {
+            mutex_lock l(mu_);
+            if (cancelled_) {
+              return;
+            }
+            epoch = epoch_;
+          }
+          has_task = StealTask(index, &task) ||
+                     (FetchTasks(ctx, worker) && PopTask(worker, &task));
+          if (!has_task) {
+            // Wait until more work may be available.
+            mutex_lock l(mu_);
+            while (!cancelled_ && epoch_ == epoch) {
+              ++num_idle_workers_;
+              RecordStop(ctx.get());
+              worker_cond_var_.wait(l);
+              RecordStart(ctx.get());
+              --num_idle_workers_;
+            }
+            if (cancelled_) {
+              return;
+            }
+            continue;
+          }
+        }
+        RunTask(ctx, &task);
+        completed.push_back(std::move(task.result));
+        if (completed.size() >= micro_batch_size_ &&
+            !Publish(ctx.get(), &completed)) {
+          return;
+        }
+      }
+    }
+
+    bool PopTask(WorkerState* worker, Task* task) {
+      mutex_lock l(worker->mu);
+      if (worker->tasks.empty()) {
+        return false;
+      }
+      *task = std::move(worker->tasks.front());
+      worker->tasks.pop_front();
+      return true;
+    }
+
+    // Steals half of the tasks of the first worker, in order of distance from
+    // `index`, that has any. The first stolen task is returned in `task` and
+    // the rest are added to the thief's queue.
+    bool StealTask(int64 index, Task* task) {
+      std::vector<Task> stolen;
+      for (int64 i = 1; i < num_workers_ && stolen.empty(); ++i) {
+        WorkerState* victim = workers_[(index + i) % num_workers_].get();
+        mutex_lock l(victim->mu);
+        const int64 num_stolen = (victim->tasks.size() + 1) / 2;
+        auto begin = victim->tasks.end() - num_stolen;
+        stolen.insert(stolen.end(), std::make_move_iterator(begin),
+                      std::make_move_iterator(victim->tasks.end()));
+        victim->tasks.erase(begin, victim->tasks.end());
+      }
+      if (stolen.empty()) {
+        return false;
+      }
+      *task = std::move(stolen.front());
+      if (stolen.size() > 1) {
+        WorkerState* thief = workers_[index].get();
+        mutex_lock l(thief->mu);
+        thief->tasks.insert(thief->tasks.end(),
+                            std::make_move_iterator(stolen.begin() + 1),
+                            std::make_move_iterator(stolen.end()));
+      }
+      return true;
+    }
+
+    // Reads up to a micro-batch of input elements into the queue of `worker`.
+    // Returns false if no input could be read because the buffer is full, the
+    // input is exhausted, or the iterator is being saved or cancelled.
+    bool FetchTasks(const std::shared_ptr<IteratorContext>& ctx,
+                    WorkerState* worker) TF_LOCKS_EXCLUDED(mu_) {
+      mutex_lock input_l(input_mu_);
+      int64 num_reserved;
+      {
+        mutex_lock l(mu_);
+        if (cancelled_ || saving_ || end_of_input_) {
+          return false;
+        }
+        num_reserved = std::min(micro_batch_size_, capacity_ - outstanding_);
+        if (num_reserved <= 0) {
+          return false;
+        }
+        outstanding_ += num_reserved;
+        num_unfinished_ += num_reserved;
+      }
+      std::vector<std::shared_ptr<Result>> results;
+      std::vector<Task> tasks;
+      results.reserve(num_reserved);
+      tasks.reserve(num_reserved);
+      bool end_of_input = false;
+      // The result of a failed input read, which is handed over without
+      // applying the map function.
+      std::shared_ptr<Result> input_error;
+      while (results.size() < num_reserved) {
+        std::vector<Tensor> input_element;
+        auto result = std::make_shared<Result>(next_id_);
+        result->status =
+            input_impl_->GetNext(ctx.get(), &input_element, &end_of_input);
+        if (end_of_input) {
+          break;
+        }
+        ++next_id_;
+        results.push_back(result);
+        if (!result->status.ok()) {
+          input_error = std::move(result);
+          break;
+        }
+        tasks.push_back({std::move(input_element), std::move(result)});
+      }
+      const int64 num_tasks = tasks.size();
+      {
+        mutex_lock l(worker->mu);
+        worker->tasks.insert(worker->tasks.end(),
+                             std::make_move_iterator(tasks.begin()),
+                             std::make_move_iterator(tasks.end()));
+      }
+      // NOTE: From here on, other workers may be running the tasks, so only
+      // `input_error` can be accessed without holding `mu_`.
+      mutex_lock l(mu_);
+      outstanding_ -= num_reserved - results.size();
+      num_unfinished_ -= num_reserved - num_tasks;
+      end_of_input_ = end_of_input_ || end_of_input;
+      if (input_error) {
+        input_error->done = true;
+      }
+      if (deterministic_) {
+        results_.insert(results_.end(), results.begin(), results.end());
+      } else if (input_error) {
+        // The results of the tasks are added when their map functions
+        // complete.
+        results_.push_back(std::move(input_error));
+      }
+      ++epoch_;
+      if (num_idle_workers_ > 0) {
+        worker_cond_var_.notify_all();
+      }
+      if (num_waiting_consumers_ > 0) {
+        consumer_cond_var_.notify_all();
+      }
+      return true;
+    }
+
+    void RunTask(const std::shared_ptr<IteratorContext>& ctx, Task* task)
+        TF_LOCKS_EXCLUDED(mu_) {
+      profiler::TraceMe traceme([&] {
+        return profiler::TraceMeEncode("ParallelMapProduce",
+                                       {{"element_id", task->result->id}});
+      });
+      task->result->status = instantiated_captured_func_->Run(
+          ctx.get(), std::move(task->input), &task->result->return_values);
+    }
+
+    // Hands over `completed` to the consumer. Returns false if the iterator
+    // has been cancelled.
+    bool Publish(IteratorContext* ctx,
+                 std::vector<std::shared_ptr<Result>>* completed)
+        TF_LOCKS_EXCLUDED(mu_) {
+      mutex_lock l(mu_);
+      for (auto& result : *completed) {
+        RecordBufferEnqueue(ctx, result->return_values);
+        result->done = true;
+        if (!deterministic_) {
+          results_.push_back(std::move(result));
+        }
+      }
+      num_unfinished_ -= completed->size();
+      completed->clear();
+      if (num_waiting_consumers_ > 0) {
+        consumer_cond_var_.notify_all();
+      }
+      return !cancelled_;
+    }
+
+    Status ProcessResult(IteratorContext* ctx,
+                         const std::shared_ptr<Result>& result,
+                         std::vector<Tensor>* out_tensors,
+                         bool* end_of_sequence) TF_LOCKS_EXCLUDED(mu_) {
+      if (result->status.ok()) {
+        *out_tensors = std::move(result->return_values);
+        RecordBufferDequeue(ctx, *out_tensors);
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+      if (errors::IsOutOfRange(result->status)) {
+        if (preserve_cardinality_) {
+          // To guarantee that the transformation preserves the cardinality of
+          // the dataset, we convert `OutOfRange` to `InvalidArgument` as the
+          // former may be interpreted by a caller as the end of sequence.
+          return errors::InvalidArgument(
+              "Function invocation produced OutOfRangeError: ",
+              result->status.error_message());
+        } else {
+          // `f` may deliberately raise `errors::OutOfRange` to indicate
+          // that we should terminate the iteration early.
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+      }
+      *end_of_sequence = false;
+      return result->status;
+    }
+
+    Status SaveLocked(SerializationContext* ctx, IteratorStateWriter* writer)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      // No input is read while `saving_` is set and all reads have finished.
+      TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(absl::StrCat(prefix(), "::", kInvocationResults),
+                              kSize, results_.size()));
+      for (size_t i = 0; i < results_.size(); i++) {
+        const Result& result = *results_[i];
+        std::string element_prefix =
+            absl::StrCat(prefix(), "::", kInvocationResults, "::", i);
+        TF_RETURN_IF_ERROR(
+            WriteStatusLocked(writer, element_prefix, result.status));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(element_prefix, kSize,
+                                               result.return_values.size()));
+        for (size_t j = 0; j < result.return_values.size(); j++) {
+          TF_RETURN_IF_ERROR(writer->WriteTensor(
+              element_prefix, absl::StrCat(kComponent, "[", j, "]"),
+              result.return_values[j]));
+        }
+      }
+      return Status::OK();
+    }
+
+    Status WriteStatusLocked(IteratorStateWriter* writer,
+                             const std::string& key, const Status& status)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      TF_RETURN_IF_ERROR(writer->WriteScalar(
+          key, kErrorCode, static_cast<int64>(status.code())));
+      if (!status.ok()) {
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(key, kErrorMessage, status.error_message()));
+      }
+      return Status::OK();
+    }
+
+    Status ReadStatusLocked(IteratorStateReader* reader, const std::string& key,
+                            Status* status) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      int64 code_int;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(key, kErrorCode, &code_int));
+      error::Code code = static_cast<error::Code>(code_int);
+
+      if (code != error::Code::OK) {
+        tstring error_message;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(key, kErrorMessage, &error_message));
+        *status = Status(code, error_message);
+      } else {
+        *status = Status::OK();
+      }
+      return Status::OK();
+    }
+
+    const bool deterministic_;
+    const bool preserve_cardinality_;
+    const int64 micro_batch_size_;
+    // Set in `Initialize()`.
+    int64 num_workers_ = 0;
+    int64 capacity_ = 0;
+    std::vector<std::unique_ptr<WorkerState>> workers_;
+
+    mutex mu_;
+    // Used by the workers to wait for work.
+    condition_variable worker_cond_var_;
+    // Used by `GetNext()` and `Save()` to wait for results.
+    condition_variable consumer_cond_var_;
+    // Results that have not been consumed yet. In deterministic mode, this
+    // contains the results of all input elements in input order, including
+    // the ones still being computed. Otherwise, it only contains completed
+    // results in completion order.
+    std::deque<std::shared_ptr<Result>> results_ TF_GUARDED_BY(mu_);
+    // Number of input elements read but not consumed yet, including reserved
+    // slots of reads in progress. Bounded by `capacity_`.
+    int64 outstanding_ TF_GUARDED_BY(mu_) = 0;
+    // Number of input elements read (or being read) whose map function has
+    // not completed yet.
+    int64 num_unfinished_ TF_GUARDED_BY(mu_) = 0;
+    // Incremented whenever workers may find new work.
+    int64 epoch_ TF_GUARDED_BY(mu_) = 0;
+    int64 num_idle_workers_ TF_GUARDED_BY(mu_) = 0;
+    int64 num_waiting_consumers_ TF_GUARDED_BY(mu_) = 0;
+    bool end_of_input_ TF_GUARDED_BY(mu_) = false;
+    bool saving_ TF_GUARDED_BY(mu_) = false;
+    bool cancelled_ TF_GUARDED_BY(mu_) = false;
+
+    // Serializes reads from `input_impl_` so that input elements are assigned
+    // consecutive ids. Acquired before `mu_`.
+    mutex input_mu_;
+    int64 next_id_ = 0;
+
+    std::unique_ptr<InstantiatedCapturedFunction> instantiated_captured_func_;
+    std::unique_ptr<IteratorBase> input_impl_;
+    std::vector<std::unique_ptr<Thread>> worker_threads_ TF_GUARDED_BY(mu_);
+
+    // Method for deregistering the cancellation callback.
+    std::function<void()> deregister_fn_;
+  };
+
   const DatasetBase* const input_;
   const int64 num_parallel_calls_;
   const DataTypeVector output_types_;
@@ -653,6 +1198,7 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
   const DeterminismPolicy deterministic_;
   const bool preserve_cardinality_;
   const std::unique_ptr<CapturedFunction> captured_func_;
+  const int64 micro_batch_size_;
   const int op_version_;
 };
 
@@ -680,6 +1226,13 @@ ParallelMapDatasetOp::ParallelMapDatasetOp(OpKernelConstruction* ctx)
     OP_REQUIRES_OK(ctx, ctx->GetAttr(kDeterministic, &deterministic));
     OP_REQUIRES_OK(
         ctx, DeterminismPolicy::FromString(deterministic, &deterministic_));
+    if (ctx->HasAttr(kMicroBatchSize)) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr(kMicroBatchSize, &micro_batch_size_));
+    }
+    OP_REQUIRES(ctx, micro_batch_size_ >= 0,
+                errors::InvalidArgument(
+                    "micro_batch_size must be non-negative but is ",
+                    micro_batch_size_, "."));
   }
   OP_REQUIRES_OK(ctx,
                  ctx->GetAttr(kPreserveCardinality, &preserve_cardinality_));
@@ -714,7 +1267,7 @@ void ParallelMapDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
   *output =
       new Dataset(ctx, input, num_parallel_calls, output_types_, output_shapes_,
                   deterministic_, std::move(captured_func),
-                  preserve_cardinality_, op_version_);
+                  preserve_cardinality_, micro_batch_size_, op_version_);
 }
 
 namespace {
@@ -31,7 +31,7 @@ class ParallelMapDatasetParams : public DatasetParams {
       const DataTypeVector& output_dtypes,
       const std::vector<PartialTensorShape>& output_shapes,
       bool use_inter_op_parallelism, const std::string& deterministic,
-      bool preserve_cardinality, string node_name)
+      bool preserve_cardinality, string node_name, int64 micro_batch_size = 0)
       : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
                       std::move(node_name)),
         other_arguments_(std::move(other_arguments)),
@@ -41,7 +41,8 @@ class ParallelMapDatasetParams : public DatasetParams {
         type_arguments_(std::move(type_arguments)),
         use_inter_op_parallelism_(use_inter_op_parallelism),
         deterministic_(deterministic),
-        preserve_cardinality_(preserve_cardinality) {
+        preserve_cardinality_(preserve_cardinality),
+        micro_batch_size_(micro_batch_size) {
     input_dataset_params_.push_back(absl::make_unique<T>(input_dataset_params));
     op_version_ = kOpVersion;
     name_utils::IteratorPrefixParams params;
@@ -77,7 +78,8 @@ class ParallelMapDatasetParams : public DatasetParams {
         {ParallelMapDatasetOp::kUseInterOpParallelism,
          use_inter_op_parallelism_},
         {ParallelMapDatasetOp::kDeterministic, deterministic_},
-        {ParallelMapDatasetOp::kPreserveCardinality, preserve_cardinality_}};
+        {ParallelMapDatasetOp::kPreserveCardinality, preserve_cardinality_},
+        {ParallelMapDatasetOp::kMicroBatchSize, micro_batch_size_}};
     return Status::OK();
   }
 
@@ -96,6 +98,7 @@ class ParallelMapDatasetParams : public DatasetParams {
   bool use_inter_op_parallelism_;
   std::string deterministic_;
   bool preserve_cardinality_;
+  int64 micro_batch_size_;
 };
 
 class ParallelMapDatasetOpTest : public DatasetOpsTestBase {};
@@ -252,6 +255,46 @@ ParallelMapDatasetParams ParallelMapDatasetParams8() {
       /*node_name=*/kNodeName);
 }
 
+// test case 9: num_parallel_calls = 2, use_inter_op_parallelism = false,
+// deterministic = true, preserve_cardinality = false, MapFunc = XTimesTwo,
+// micro_batch_size = 2
+ParallelMapDatasetParams ParallelMapDatasetParams9() {
+  return ParallelMapDatasetParams(
+      RangeDatasetParams(0, 10, 3),
+      /*other_arguments=*/{},
+      /*num_parallel_calls=*/2,
+      /*func=*/MapFunc("XTimesTwo", DT_INT64),
+      /*func_lib*/ {test::function::XTimesTwo()},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*use_inter_op_parallelism=*/false,
+      /*deterministic=*/DeterminismPolicy::kDeterministic,
+      /*preserve_cardinality=*/false,
+      /*node_name=*/kNodeName,
+      /*micro_batch_size=*/2);
+}
+
+// test case 10: num_parallel_calls = 3, use_inter_op_parallelism = true,
+// deterministic = false, preserve_cardinality = true, MapFunc = XTimesFour,
+// micro_batch_size = 4
+ParallelMapDatasetParams ParallelMapDatasetParams10() {
+  return ParallelMapDatasetParams(
+      RangeDatasetParams(0, 10, 3),
+      /*other_arguments=*/{},
+      /*num_parallel_calls=*/3,
+      /*func=*/MapFunc("XTimesFour", DT_INT64),
+      /*func_lib*/ {test::function::XTimesTwo(), test::function::XTimesFour()},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*use_inter_op_parallelism=*/true,
+      /*deterministic=*/DeterminismPolicy::kNondeterministic,
+      /*preserve_cardinality=*/true,
+      /*node_name=*/kNodeName,
+      /*micro_batch_size=*/4);
+}
+
 ParallelMapDatasetParams ParallelMapDatasetParamsWithInvalidNumParallelCalls() {
   return ParallelMapDatasetParams(
       RangeDatasetParams(0, 10, 3),
@@ -268,6 +311,23 @@ ParallelMapDatasetParams ParallelMapDatasetParamsWithInvalidNumParallelCalls() {
       /*node_name=*/kNodeName);
 }
 
+ParallelMapDatasetParams ParallelMapDatasetParamsWithInvalidMicroBatchSize() {
+  return ParallelMapDatasetParams(
+      RangeDatasetParams(0, 10, 3),
+      /*other_arguments=*/{},
+      /*num_parallel_calls=*/2,
+      /*func=*/MapFunc("XTimesTwo", DT_INT64),
+      /*func_lib*/ {test::function::XTimesTwo()},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*use_inter_op_parallelism=*/true,
+      /*deterministic=*/DeterminismPolicy::kNondeterministic,
+      /*preserve_cardinality=*/true,
+      /*node_name=*/kNodeName,
+      /*micro_batch_size=*/-1);
+}
+
 std::vector<GetNextTestCase<ParallelMapDatasetParams>> GetNextTestCases() {
   return {{/*dataset_params=*/ParallelMapDatasetParams1(),
            /*expected_outputs=*/
@@ -293,7 +353,15 @@ std::vector<GetNextTestCase<ParallelMapDatasetParams>> GetNextTestCases() {
            ParallelMapDatasetParams6(),
            /*expected_outputs=*/
            CreateTensors<int64>(TensorShape{}, {{0}, {12}, {24}, {36}}),
-           /*compare_order=*/true}};
+           /*compare_order=*/true},
+          {/*dataset_params=*/ParallelMapDatasetParams9(),
+           /*expected_outputs=*/
+           CreateTensors<int64>(TensorShape{}, {{0}, {6}, {12}, {18}}),
+           /*compare_order=*/true},
+          {/*dataset_params=*/ParallelMapDatasetParams10(),
+           /*expected_outputs=*/
+           CreateTensors<int64>(TensorShape{}, {{0}, {12}, {24}, {36}}),
+           /*compare_order=*/false}};
 }
 
 ITERATOR_GET_NEXT_TEST_P(ParallelMapDatasetOpTest, ParallelMapDatasetParams,
@@ -399,7 +467,17 @@ IteratorSaveAndRestoreTestCases() {
            /*breakpoints=*/{0, 1, 5},
            /*expected_outputs=*/
            CreateTensors<int64>(TensorShape{}, {{0}, {12}, {24}, {36}}),
-           /*compare_order=*/true}};
+           /*compare_order=*/true},
+          {/*dataset_params=*/ParallelMapDatasetParams9(),
+           /*breakpoints=*/{0, 1, 5},
+           /*expected_outputs=*/
+           CreateTensors<int64>(TensorShape{}, {{0}, {6}, {12}, {18}}),
+           /*compare_order=*/true},
+          {/*dataset_params=*/ParallelMapDatasetParams10(),
+           /*breakpoints=*/{0, 1, 5},
+           /*expected_outputs=*/
+           CreateTensors<int64>(TensorShape{}, {{0}, {12}, {24}, {36}}),
+           /*compare_order=*/false}};
 }
 
 ITERATOR_SAVE_AND_RESTORE_TEST_P(ParallelMapDatasetOpTest,
@@ -412,6 +490,12 @@ TEST_F(ParallelMapDatasetOpTest, InvalidNumParallelCalls) {
             tensorflow::error::INVALID_ARGUMENT);
 }
 
+TEST_F(ParallelMapDatasetOpTest, InvalidMicroBatchSize) {
+  auto dataset_params = ParallelMapDatasetParamsWithInvalidMicroBatchSize();
+  EXPECT_EQ(Initialize(dataset_params).code(),
+            tensorflow::error::INVALID_ARGUMENT);
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
@@ -22,14 +22,18 @@ limitations under the License.
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
 #include "tensorflow/core/kernels/data/random_seed_ops.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/stringprintf.h"
 
 namespace tensorflow {
@@ -46,6 +50,8 @@ namespace data {
 /* static */ constexpr const char* const ShuffleDatasetOpBase::kOutputShapes;
 /* static */ constexpr const char* const
     ShuffleDatasetOpBase::kReshuffleEachIteration;
+/* static */ constexpr const char* const ShuffleDatasetOpBase::kMaxBufferBytes;
+/* static */ constexpr const char* const ShuffleDatasetOpBase::kSpillDirectory;
 
 /* static */ constexpr const char* const ShuffleDatasetOp::kDatasetType;
 
@@ -55,6 +61,8 @@ namespace data {
 
 const int64 kLogIntervalMicros = 10 * 1000000;  // 10 seconds.
 const int64 kMaxEpochsInBuffer = 3;
+// Size of the read-ahead buffer of each spilled run of the shuffle buffer.
+const int64 kSpillReadBufferSize = 256 << 10;  // 256 KiB
 
 constexpr char kNumRandomSamples[] = "num_random_samples";
 constexpr char kDataProduced[] = "data_produced";
@@ -76,19 +84,50 @@ constexpr char kShuffleAndRepeatDatasetV1[] = "ShuffleAndRepeatDataset";
 constexpr char kShuffleAndRepeatDatasetV2[] = "ShuffleAndRepeatDatasetV2";
 
 ShuffleDatasetOpBase::ShuffleDatasetOpBase(OpKernelConstruction* ctx)
-    : UnaryDatasetOpKernel(ctx) {}
+    : UnaryDatasetOpKernel(ctx) {
+  if (ctx->HasAttr(kMaxBufferBytes)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kMaxBufferBytes,
+                                     &spill_options_.max_buffer_bytes));
+  }
+  if (ctx->HasAttr(kSpillDirectory)) {
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr(kSpillDirectory, &spill_options_.directory));
+  }
+}
+
+Status ShuffleDatasetOpBase::CheckSpillOptions(
+    const DatasetBase* input) const {
+  if (spill_options_.max_buffer_bytes < 0) {
+    return errors::InvalidArgument(kMaxBufferBytes,
+                                   " must be greater than or equal to zero.");
+  }
+  if (spill_options_.max_buffer_bytes == 0) {
+    return Status::OK();
+  }
+  for (DataType dtype : input->output_dtypes()) {
+    if (dtype == DT_VARIANT || dtype == DT_RESOURCE) {
+      return errors::InvalidArgument(
+          "Spilling the shuffle buffer to disk is not supported for elements "
+          "of type ",
+          DataTypeString(dtype), ".");
+    }
+  }
+  return Status::OK();
+}
 
 // Abstract base dataset that implements a shuffling iterator.
 class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
  public:
   ShuffleDatasetBase(OpKernelContext* ctx, const DatasetBase* input,
                      int64 buffer_size,
-                     std::shared_ptr<SeedGenerator> seed_generator, int64 count)
+                     std::shared_ptr<SeedGenerator> seed_generator, int64 count,
+                     const SpillOptions& spill_options)
       : DatasetBase(DatasetContext(ctx)),
         input_(input),
         buffer_size_(buffer_size),
         seed_generator_(std::move(seed_generator)),
         count_(count),
+        spill_options_(spill_options),
         traceme_metadata_(
             {{"buffer_size",
               strings::Printf("%lld", static_cast<long long>(buffer_size))}}) {
@@ -130,12 +169,35 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
 
   std::unique_ptr<IteratorBase> MakeIteratorInternal(
       const string& prefix) const override {
+    if (spill_options_.max_buffer_bytes > 0) {
+      return absl::make_unique<SpillingIterator>(
+          SpillingIterator::Params{
+              this, name_utils::IteratorPrefix(op_type(), prefix)},
+          seed_generator_.get());
+    }
     return absl::make_unique<Iterator>(
         Iterator::Params{this, name_utils::IteratorPrefix(op_type(), prefix)},
         seed_generator_.get());
   }
 
  protected:
+  // Appends the spill attributes to `attrs` if spilling is enabled. They are
+  // omitted otherwise, so that the serialized graph can be loaded by binaries
+  // that predate these attributes.
+  void AddSpillAttrs(
+      DatasetGraphDefBuilder* b,
+      std::vector<std::pair<StringPiece, AttrValue>>* attrs) const {
+    if (spill_options_.max_buffer_bytes <= 0) {
+      return;
+    }
+    AttrValue max_buffer_bytes;
+    b->BuildAttrValue(spill_options_.max_buffer_bytes, &max_buffer_bytes);
+    attrs->emplace_back(kMaxBufferBytes, max_buffer_bytes);
+    AttrValue spill_directory;
+    b->BuildAttrValue(spill_options_.directory, &spill_directory);
+    attrs->emplace_back(kSpillDirectory, spill_directory);
+  }
+
   class Iterator : public DatasetIterator<ShuffleDatasetBase> {
    public:
     explicit Iterator(const Params& params, SeedGenerator* seed_generator)
@@ -415,6 +477,331 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
     bool data_produced_ TF_GUARDED_BY(mu_) = false;
   };
 
+  // Iterator used when the shuffle buffer has a memory budget. The buffer
+  // still holds up to `buffer_size_` elements, but at most
+  // `spill_options_.max_buffer_bytes` of them are resident in memory. When the
+  // budget is exceeded, the resident elements of an epoch are shuffled and
+  // written to a scratch file as a "run". Since each run is written in random
+  // order, reading a run sequentially yields a uniformly random element of the
+  // run. Choosing between the in-memory elements and the runs with probability
+  // proportional to their sizes therefore produces the same distribution as an
+  // in-memory buffer of `buffer_size_` elements.
+  //
+  // Note that every run keeps its scratch file open until it is exhausted, so
+  // the number of open files is roughly the size of the buffer in bytes
+  // divided by the memory budget.
+  class SpillingIterator : public DatasetIterator<ShuffleDatasetBase> {
+   public:
+    explicit SpillingIterator(const Params& params,
+                              SeedGenerator* seed_generator)
+        : DatasetIterator<ShuffleDatasetBase>(params),
+          seed_generator_(seed_generator),
+          parent_generator_(seed_generator->seed(), seed_generator->seed2()),
+          generator_(&parent_generator_) {
+      epochs_.push_back(absl::make_unique<EpochBuffer>());
+    }
+
+    ~SpillingIterator() override {
+      for (auto& epoch : epochs_) {
+        for (auto& run : epoch->runs) {
+          DeleteRun(run.get());
+        }
+      }
+    }
+
+    Status Initialize(IteratorContext* ctx) override {
+      mutex_lock l(mu_);
+      seed_generator_->GenerateSeeds(&seed_, &seed2_);
+      ResetRngs();
+      env_ = ctx->env();
+      string directory = this->dataset()->spill_options_.directory;
+      if (directory.empty()) {
+        std::vector<string> temp_directories;
+        env_->GetLocalTempDirectories(&temp_directories);
+        if (temp_directories.empty()) {
+          return errors::FailedPrecondition(
+              "Could not find a local temporary directory to spill the "
+              "shuffle buffer to. Please set `",
+              kSpillDirectory, "`.");
+        }
+        directory = temp_directories[0];
+      }
+      TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(directory));
+      spill_prefix_ = io::JoinPath(
+          directory, strings::StrCat("shuffle_", strings::Hex(random::New64())));
+      return Status::OK();
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      mutex_lock l(mu_);
+      if (!input_impl_ && epoch_ == 0) {
+        TF_RETURN_IF_ERROR(this->dataset()->input_->MakeIterator(
+            ctx, this, this->prefix(), &input_impl_));
+      }
+      while (input_impl_ && num_elements_ < this->dataset()->buffer_size_) {
+        std::vector<Tensor> input_element;
+        bool end_of_input_sequence = false;
+        while (this->dataset()->count_ == -1 ||
+               epoch_ < this->dataset()->count_) {
+          TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &input_element,
+                                                  &end_of_input_sequence));
+          if (!end_of_input_sequence) {
+            data_produced_ = true;
+            break;
+          }
+          if (!data_produced_ && this->dataset()->count_ == -1) {
+            // If we encounter the end of sequence without producing data, we
+            // terminate the iteration immediately. (Otherwise, this iterator
+            // would loop infinitely and never produce a value.)
+            *end_of_sequence = true;
+            return Status::OK();
+          }
+          epoch_++;
+          epochs_.push_back(absl::make_unique<EpochBuffer>());
+          TF_RETURN_IF_ERROR(this->dataset()->input_->MakeIterator(
+              ctx, this, this->prefix(), &input_impl_));
+        }
+        if (!end_of_input_sequence) {
+          this->RecordBufferEnqueue(ctx, input_element);
+          EpochBuffer* epoch = epochs_.back().get();
+          const int64 num_bytes = GetAllocatedBytes(input_element);
+          epoch->resident_bytes += num_bytes;
+          resident_bytes_ += num_bytes;
+          epoch->elements.push_back(std::move(input_element));
+          epoch->num_elements++;
+          num_elements_++;
+          if (resident_bytes_ >
+              this->dataset()->spill_options_.max_buffer_bytes) {
+            TF_RETURN_IF_ERROR(Spill(ctx));
+          }
+        } else {
+          input_impl_.reset();
+        }
+        if (epochs_.size() > kMaxEpochsInBuffer) {
+          // See the comment in `Iterator::GetNextInternal`.
+          break;
+        }
+      }
+
+      if (num_elements_ == 0) {
+        DCHECK(input_impl_ == nullptr);
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+      *end_of_sequence = false;
+      // Garbage collect all exhausted epochs.
+      while (!epochs_.empty() && epochs_.front()->num_elements == 0) {
+        epochs_.pop_front();
+        // Reinitialize the RNG state for the next epoch.
+        num_random_samples_ = 0;
+        seed_generator_->GenerateSeeds(&seed_, &seed2_);
+        ResetRngs();
+      }
+      DCHECK(!epochs_.empty());
+      // Choose an element to produce uniformly at random from the earliest
+      // epoch. The first `elements.size()` indices refer to the resident
+      // elements and the remaining ones to the spilled runs.
+      EpochBuffer* epoch = epochs_.front().get();
+      int64 index = Random() % epoch->num_elements;
+      const int64 num_resident = epoch->elements.size();
+      if (index < num_resident) {
+        if (index != num_resident - 1) {
+          std::swap(epoch->elements[index], epoch->elements.back());
+        }
+        *out_tensors = std::move(epoch->elements.back());
+        epoch->elements.pop_back();
+        this->RecordBufferDequeue(ctx, *out_tensors);
+        const int64 num_bytes = GetAllocatedBytes(*out_tensors);
+        epoch->resident_bytes -= num_bytes;
+        resident_bytes_ -= num_bytes;
+      } else {
+        index -= num_resident;
+        auto it = epoch->runs.begin();
+        while (index >= (*it)->num_elements) {
+          index -= (*it)->num_elements;
+          ++it;
+        }
+        Run* run = it->get();
+        TF_RETURN_IF_ERROR(ReadFromRun(run, out_tensors));
+        if (--run->num_elements == 0) {
+          DeleteRun(run);
+          epoch->runs.erase(it);
+        }
+      }
+      epoch->num_elements--;
+      num_elements_--;
+      return Status::OK();
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeKnownRatioNode(std::move(args),
+                                       /*ratio=*/1);
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      return errors::Unimplemented(
+          "Checkpointing is not supported for a shuffle buffer that spills "
+          "to disk.");
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      return errors::Unimplemented(
+          "Checkpointing is not supported for a shuffle buffer that spills "
+          "to disk.");
+    }
+
+    TraceMeMetadata GetTraceMeMetadata() const override {
+      return this->dataset()->traceme_metadata_;
+    }
+
+   private:
+    // A shuffled sequence of elements that has been written to a scratch
+    // file and is read back sequentially. Every element component is stored as
+    // a serialized `TensorProto` record.
+    struct Run {
+      string filename;
+      std::unique_ptr<RandomAccessFile> file;
+      std::unique_ptr<io::SequentialRecordReader> reader;
+      // Number of elements in the run that have not been read yet.
+      int64 num_elements = 0;
+    };
+
+    // The buffered elements of a single epoch.
+    struct EpochBuffer {
+      // Elements resident in memory, in no particular order.
+      std::vector<std::vector<Tensor>> elements;
+      // Total allocated bytes of `elements`.
+      int64 resident_bytes = 0;
+      std::vector<std::unique_ptr<Run>> runs;
+      // Total number of elements, resident or spilled.
+      int64 num_elements = 0;
+    };
+
+    void ResetRngs() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      // Reset the generators based on the current iterator seeds.
+      parent_generator_ = random::PhiloxRandom(seed_, seed2_);
+      generator_ =
+          random::SingleSampleAdapter<random::PhiloxRandom>(&parent_generator_);
+      generator_.Skip(num_random_samples_);
+    }
+
+    random::SingleSampleAdapter<random::PhiloxRandom>::ResultType Random()
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      num_random_samples_++;
+      auto out = generator_();
+      return out;
+    }
+
+    // Shuffles the resident elements of the epoch that holds the most
+    // resident bytes and writes them to a new run.
+    Status Spill(IteratorContext* ctx) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      EpochBuffer* epoch = nullptr;
+      for (auto& candidate : epochs_) {
+        if (epoch == nullptr ||
+            candidate->resident_bytes > epoch->resident_bytes) {
+          epoch = candidate.get();
+        }
+      }
+      auto& elements = epoch->elements;
+      for (int64 i = static_cast<int64>(elements.size()) - 1; i > 0; --i) {
+        int64 j = Random() % (i + 1);
+        if (i != j) {
+          std::swap(elements[i], elements[j]);
+        }
+      }
+      auto run = absl::make_unique<Run>();
+      run->filename = strings::StrCat(spill_prefix_, "_", num_runs_++);
+      {
+        std::unique_ptr<WritableFile> file;
+        TF_RETURN_IF_ERROR(env_->NewWritableFile(run->filename, &file));
+        io::RecordWriter writer(file.get());
+        for (const auto& element : elements) {
+          for (const Tensor& component : element) {
+            TensorProto proto;
+            component.AsProtoTensorContent(&proto);
+            TF_RETURN_IF_ERROR(writer.WriteRecord(proto.SerializeAsString()));
+          }
+          this->RecordBufferDequeue(ctx, element);
+        }
+        TF_RETURN_IF_ERROR(writer.Close());
+        TF_RETURN_IF_ERROR(file->Close());
+      }
+      TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(run->filename, &run->file));
+      io::RecordReaderOptions options;
+      options.buffer_size = kSpillReadBufferSize;
+      run->reader = absl::make_unique<io::SequentialRecordReader>(
+          run->file.get(), options);
+      VLOG(2) << "Spilled " << elements.size() << " elements ("
+              << epoch->resident_bytes << " bytes) of the shuffle buffer to "
+              << run->filename;
+      run->num_elements = elements.size();
+      resident_bytes_ -= epoch->resident_bytes;
+      epoch->resident_bytes = 0;
+      elements.clear();
+      epoch->runs.push_back(std::move(run));
+      return Status::OK();
+    }
+
+    // Reads the next element of `run`.
+    Status ReadFromRun(Run* run, std::vector<Tensor>* out_tensors)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      const int num_components = this->dataset()->output_dtypes().size();
+      out_tensors->clear();
+      out_tensors->reserve(num_components);
+      for (int i = 0; i < num_components; ++i) {
+        tstring record;
+        TF_RETURN_IF_ERROR(run->reader->ReadRecord(&record));
+        TensorProto proto;
+        Tensor tensor;
+        if (!proto.ParseFromArray(record.data(), record.size()) ||
+            !tensor.FromProto(proto)) {
+          return errors::DataLoss("Failed to parse an element of ",
+                                  run->filename);
+        }
+        out_tensors->push_back(std::move(tensor));
+      }
+      return Status::OK();
+    }
+
+    void DeleteRun(Run* run) {
+      run->reader.reset();
+      run->file.reset();
+      Status s = env_->DeleteFile(run->filename);
+      if (!s.ok()) {
+        LOG(WARNING) << "Failed to delete shuffle buffer spill file "
+                     << run->filename << ": " << s;
+      }
+    }
+
+    mutex mu_;
+    SeedGenerator* const seed_generator_ TF_GUARDED_BY(mu_);  // Not owned.
+    Env* env_ = nullptr;                                        // Not owned.
+    string spill_prefix_ TF_GUARDED_BY(mu_);
+    int64 num_runs_ TF_GUARDED_BY(mu_) = 0;
+    std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_) = nullptr;
+    int64 epoch_ TF_GUARDED_BY(mu_) = 0;
+    // Total number of buffered elements, resident or spilled.
+    int64 num_elements_ TF_GUARDED_BY(mu_) = 0;
+    // Total allocated bytes of the resident elements of all epochs.
+    int64 resident_bytes_ TF_GUARDED_BY(mu_) = 0;
+    int64 seed_ TF_GUARDED_BY(mu_) = 0;
+    int64 seed2_ TF_GUARDED_BY(mu_) = 0;
+    // The epoch at the front of the deque is the earliest buffered epoch.
+    // Input elements are added to the epoch at the back.
+    std::deque<std::unique_ptr<EpochBuffer>> epochs_ TF_GUARDED_BY(mu_);
+    random::PhiloxRandom parent_generator_ TF_GUARDED_BY(mu_);
+    random::SingleSampleAdapter<random::PhiloxRandom> generator_
+        TF_GUARDED_BY(mu_);
+    int64 num_random_samples_ TF_GUARDED_BY(mu_) = 0;
+    bool data_produced_ TF_GUARDED_BY(mu_) = false;
+  };
+
   const DatasetBase* const input_;
   const int64 buffer_size_;
   const std::shared_ptr<SeedGenerator> seed_generator_;
@@ -422,6 +809,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
   // fuse shuffle and repeat together, and make the shuffle dataset op
   // responsible for repeating as well.
   const int64 count_;
+  const SpillOptions spill_options_;
   const TraceMeMetadata traceme_metadata_;
 };  // ShuffleDatasetBase
 
@@ -433,8 +821,9 @@ class ShuffleDatasetOp::Dataset : public ShuffleDatasetBase {
  public:
   Dataset(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
           int64 count, RandomSeeds&& seeds, SeedGeneratorManager* manager,
-          ResourceHandle&& resource_handle)
-      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count),
+          ResourceHandle&& resource_handle, const SpillOptions& spill_options)
+      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count,
+                           spill_options),
         manager_(manager),
         resource_handle_(std::move(resource_handle)),
         resource_mgr_(ctx->resource_manager()),
@@ -467,11 +856,13 @@ class ShuffleDatasetOp::Dataset : public ShuffleDatasetBase {
     TF_RETURN_IF_ERROR(b->AddScalar(seeds_.input_seed2(), &seed2_node));
     b->BuildAttrValue(seed_generator_->reshuffle_each_iteration(),
                       &reshuffle_each_iteration);
+    std::vector<std::pair<StringPiece, AttrValue>> attrs = {
+        std::make_pair(kReshuffleEachIteration, reshuffle_each_iteration)};
+    AddSpillAttrs(b, &attrs);
     TF_RETURN_IF_ERROR(b->AddDataset(
         this,
         {input_graph_node, buffer_size_node, seed_node, seed2_node},  // Inputs
-        {std::make_pair(kReshuffleEachIteration,
-                        reshuffle_each_iteration)},  // Attrs
+        attrs,                                                        // Attrs
         output));
     return Status::OK();
   }
@@ -491,8 +882,10 @@ class ShuffleDatasetOp::DatasetV2 : public ShuffleDatasetBase {
  public:
   DatasetV2(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
             int64 count, SeedGeneratorManager* manager,
-            ResourceHandle&& resource_handle, bool owns_resource)
-      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count),
+            ResourceHandle&& resource_handle, bool owns_resource,
+            const SpillOptions& spill_options)
+      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count,
+                           spill_options),
         manager_(manager),
         owns_resource_(owns_resource),
         resource_handle_(std::move(resource_handle)),
@@ -545,8 +938,10 @@ class ShuffleDatasetOp::DatasetV3 : public ShuffleDatasetBase {
  public:
   DatasetV3(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
             int64 count, RandomSeeds&& seeds, SeedGeneratorManager* manager,
-            ResourceHandle&& resource_handle, bool owns_resource)
-      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count),
+            ResourceHandle&& resource_handle, bool owns_resource,
+            const SpillOptions& spill_options)
+      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count,
+                           spill_options),
         manager_(manager),
         owns_resource_(owns_resource),
         resource_handle_(std::move(resource_handle)),
@@ -585,12 +980,14 @@ class ShuffleDatasetOp::DatasetV3 : public ShuffleDatasetBase {
     AttrValue reshuffle_each_iteration;
     b->BuildAttrValue(seed_generator_->reshuffle_each_iteration(),
                       &reshuffle_each_iteration);
+    std::vector<std::pair<StringPiece, AttrValue>> attrs = {
+        std::make_pair(kReshuffleEachIteration, reshuffle_each_iteration)};
+    AddSpillAttrs(b, &attrs);
     TF_RETURN_IF_ERROR(
         b->AddDataset(this,
                       {input_graph_node, buffer_size_node, seed_node,
                        seed2_node, resource_handle_node},  // Inputs
-                      {std::make_pair(kReshuffleEachIteration,
-                                      reshuffle_each_iteration)},  // Attrs
+                      attrs,                               // Attrs
                       output));
     return Status::OK();
   }
@@ -627,6 +1024,7 @@ void ShuffleDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
   OP_REQUIRES(
       ctx, buffer_size > 0,
       errors::InvalidArgument("buffer_size must be greater than zero."));
+  OP_REQUIRES_OK(ctx, CheckSpillOptions(input));
 
   int64 count = 1;
   static std::atomic<int64> resource_id_counter(0);
@@ -667,9 +1065,9 @@ void ShuffleDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
     }
 
     // Ownership of manager is transferred onto `DatasetV3`.
-    *output = new ShuffleDatasetOp::DatasetV3(ctx, input, buffer_size, count,
-                                              std::move(seeds), manager,
-                                              std::move(handle), owns_resource);
+    *output = new ShuffleDatasetOp::DatasetV3(
+        ctx, input, buffer_size, count, std::move(seeds), manager,
+        std::move(handle), owns_resource, spill_options_);
   } else if (op_version_ == 2) {
     auto handle = HandleFromInput(ctx, 2);
     SeedGeneratorManager* manager = nullptr;
@@ -696,9 +1094,9 @@ void ShuffleDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
     }
 
     // Ownership of manager is transferred onto `DatasetV2`.
-    *output =
-        new ShuffleDatasetOp::DatasetV2(ctx, input, buffer_size, count, manager,
-                                        std::move(handle), owns_resource);
+    *output = new ShuffleDatasetOp::DatasetV2(ctx, input, buffer_size, count,
+                                              manager, std::move(handle),
+                                              owns_resource, spill_options_);
   } else {
     if (op_version_ != 1) {
       LOG(WARNING) << "Unsupported version of shuffle dataset op: "
@@ -731,7 +1129,7 @@ void ShuffleDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
     // Ownership of manager is transferred onto `Dataset`.
     *output = new ShuffleDatasetOp::Dataset(ctx, input, buffer_size, count,
                                             std::move(seeds), manager,
-                                            std::move(handle));
+                                            std::move(handle), spill_options_);
   }
 }
 
@@ -739,8 +1137,9 @@ class ShuffleAndRepeatDatasetOp::Dataset : public ShuffleDatasetBase {
  public:
   Dataset(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
           RandomSeeds&& seeds, SeedGeneratorManager* manager, int64 count,
-          ResourceHandle&& resource_handle)
-      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count),
+          ResourceHandle&& resource_handle, const SpillOptions& spill_options)
+      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count,
+                           spill_options),
         manager_(manager),
         resource_handle_(std::move(resource_handle)),
         resource_mgr_(ctx->resource_manager()),
@@ -775,10 +1174,12 @@ class ShuffleAndRepeatDatasetOp::Dataset : public ShuffleDatasetBase {
     AttrValue reshuffle_each_iteration;
     b->BuildAttrValue(seed_generator_->reshuffle_each_iteration(),
                       &reshuffle_each_iteration);
+    std::vector<std::pair<StringPiece, AttrValue>> attrs = {
+        std::make_pair(kReshuffleEachIteration, reshuffle_each_iteration)};
+    AddSpillAttrs(b, &attrs);
     TF_RETURN_IF_ERROR(b->AddDataset(
         this, {input_graph_node, buffer_size, seed, seed2, count},  // Inputs
-        {std::make_pair(kReshuffleEachIteration,
-                        reshuffle_each_iteration)},  // Attrs
+        attrs,                                                      // Attrs
         output));
     return Status::OK();
   }
@@ -794,8 +1195,10 @@ class ShuffleAndRepeatDatasetOp::DatasetV2 : public ShuffleDatasetBase {
  public:
   DatasetV2(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
             int64 count, RandomSeeds&& seeds, SeedGeneratorManager* manager,
-            ResourceHandle&& resource_handle, bool owns_resource)
-      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count),
+            ResourceHandle&& resource_handle, bool owns_resource,
+            const SpillOptions& spill_options)
+      : ShuffleDatasetBase(ctx, input, buffer_size, manager->get(), count,
+                           spill_options),
         manager_(manager),
         owns_resource_(owns_resource),
         resource_handle_(std::move(resource_handle)),
@@ -836,12 +1239,14 @@ class ShuffleAndRepeatDatasetOp::DatasetV2 : public ShuffleDatasetBase {
     AttrValue reshuffle_each_iteration;
     b->BuildAttrValue(seed_generator_->reshuffle_each_iteration(),
                       &reshuffle_each_iteration);
+    std::vector<std::pair<StringPiece, AttrValue>> attrs = {
+        std::make_pair(kReshuffleEachIteration, reshuffle_each_iteration)};
+    AddSpillAttrs(b, &attrs);
     TF_RETURN_IF_ERROR(
         b->AddDataset(this,
                       {input_graph_node, buffer_size_node, seed_node,
                        seed2_node, count_node, resource_handle_node},  // Inputs
-                      {std::make_pair(kReshuffleEachIteration,
-                                      reshuffle_each_iteration)},  // Attrs
+                      attrs,                                          // Attrs
                       output));
     return Status::OK();
   }
@@ -877,6 +1282,7 @@ void ShuffleAndRepeatDatasetOp::MakeDataset(OpKernelContext* ctx,
   OP_REQUIRES(
       ctx, buffer_size > 0,
       errors::InvalidArgument("buffer_size must be greater than zero."));
+  OP_REQUIRES_OK(ctx, CheckSpillOptions(input));
 
   int64 seed;
   OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, kSeed, &seed));
@@ -928,7 +1334,7 @@ void ShuffleAndRepeatDatasetOp::MakeDataset(OpKernelContext* ctx,
     // Ownership of manager is transferred onto `DatasetV2`.
     *output = new ShuffleAndRepeatDatasetOp::DatasetV2(
         ctx, input, buffer_size, count, std::move(seeds), manager,
-        std::move(handle), owns_resource);
+        std::move(handle), owns_resource, spill_options_);
   } else {
     if (op_version_ != 1) {
       LOG(WARNING) << "Unsupported version of shuffle dataset op: "
@@ -955,7 +1361,7 @@ void ShuffleAndRepeatDatasetOp::MakeDataset(OpKernelContext* ctx,
 
     // Ownership of manager is transferred onto `Dataset`.
     *output = new Dataset(ctx, input, buffer_size, std::move(seeds), manager,
-                          count, std::move(handle));
+                          count, std::move(handle), spill_options_);
   }
 }
 
@@ -30,11 +30,29 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
   static constexpr const char* const kOutputShapes = "output_shapes";
   static constexpr const char* const kReshuffleEachIteration =
       "reshuffle_each_iteration";
+  static constexpr const char* const kMaxBufferBytes = "max_buffer_bytes";
+  static constexpr const char* const kSpillDirectory = "spill_directory";
 
   explicit ShuffleDatasetOpBase(OpKernelConstruction* ctx);
 
  protected:
+  // Configuration for spilling the shuffle buffer to local scratch files.
+  struct SpillOptions {
+    // If positive, at most this many bytes of buffered elements are kept in
+    // memory. The remaining elements of the shuffle buffer are spilled to
+    // scratch files.
+    int64 max_buffer_bytes = 0;
+    // Directory for the scratch files. If empty, a local temporary directory
+    // is used.
+    string directory;
+  };
+
   class ShuffleDatasetBase;
+
+  // Returns an error if `spill_options_` cannot be used for `input`.
+  Status CheckSpillOptions(const DatasetBase* input) const;
+
+  SpillOptions spill_options_;
 };
 
 class ShuffleDatasetOp : public ShuffleDatasetOpBase {
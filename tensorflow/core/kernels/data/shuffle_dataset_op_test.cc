@@ -28,14 +28,15 @@ class ShuffleDatasetParams : public DatasetParams {
                        int64 seed2, int64 count, bool reshuffle_each_iteration,
                        DataTypeVector output_dtypes,
                        std::vector<PartialTensorShape> output_shapes,
-                       string node_name)
+                       string node_name, int64 max_buffer_bytes = 0)
       : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
                       std::move(node_name)),
         buffer_size_(buffer_size),
         seed_(seed),
         seed2_(seed2),
         count_(count),
-        reshuffle_each_iteration_(reshuffle_each_iteration) {
+        reshuffle_each_iteration_(reshuffle_each_iteration),
+        max_buffer_bytes_(max_buffer_bytes) {
     input_dataset_params_.push_back(absl::make_unique<T>(input_dataset_params));
     iterator_prefix_ =
         name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
@@ -74,6 +75,9 @@ class ShuffleDatasetParams : public DatasetParams {
                               output_shapes_);
     attr_vector->emplace_back(ShuffleDatasetOp::kReshuffleEachIteration,
                               reshuffle_each_iteration_);
+    attr_vector->emplace_back(ShuffleDatasetOpBase::kMaxBufferBytes,
+                              max_buffer_bytes_);
+    attr_vector->emplace_back(ShuffleDatasetOpBase::kSpillDirectory, "");
     return Status::OK();
   }
 
@@ -92,6 +96,7 @@ class ShuffleDatasetParams : public DatasetParams {
   int64 seed2_;
   int64 count_;
   bool reshuffle_each_iteration_;
+  int64 max_buffer_bytes_;
 };
 
 class ShuffleDatasetOpTest : public DatasetOpsTestBase {};
@@ -204,6 +209,49 @@ ShuffleDatasetParams ShuffleDatasetParams8() {
                               /*node_name=*/kShuffleAndRepeatNodeName);
 }
 
+// Test case 9: test shuffle_dataset with a memory budget that is much smaller
+// than the shuffle buffer, so that the buffer is spilled to disk.
+ShuffleDatasetParams SpillingShuffleDatasetParams() {
+  return ShuffleDatasetParams(RangeDatasetParams(0, 100, 1),
+                              /*buffer_size=*/50,
+                              /*seed=*/1,
+                              /*seed2=*/2,
+                              /*count=*/1,
+                              /*reshuffle_each_iteration=*/true,
+                              /*output_dtypes=*/{DT_INT64},
+                              /*output_shapes=*/{PartialTensorShape({})},
+                              /*node_name=*/kShuffleNodeName,
+                              /*max_buffer_bytes=*/64);
+}
+
+// Test case 10: test shuffle_and_repeat_dataset with count = 3 and a memory
+// budget that is much smaller than the shuffle buffer.
+ShuffleDatasetParams SpillingShuffleAndRepeatDatasetParams() {
+  return ShuffleDatasetParams(RangeDatasetParams(0, 20, 1),
+                              /*buffer_size=*/30,
+                              /*seed=*/1,
+                              /*seed2=*/2,
+                              /*count=*/3,
+                              /*reshuffle_each_iteration=*/false,
+                              /*output_dtypes=*/{DT_INT64},
+                              /*output_shapes=*/{PartialTensorShape({})},
+                              /*node_name=*/kShuffleAndRepeatNodeName,
+                              /*max_buffer_bytes=*/64);
+}
+
+ShuffleDatasetParams ShuffleDatasetParamsWithInvalidMaxBufferBytes() {
+  return ShuffleDatasetParams(RangeDatasetParams(0, 10, 1),
+                              /*buffer_size=*/10,
+                              /*seed=*/1,
+                              /*seed2=*/2,
+                              /*count=*/1,
+                              /*reshuffle_each_iteration=*/false,
+                              /*output_dtypes=*/{DT_INT64},
+                              /*output_shapes=*/{PartialTensorShape({})},
+                              /*node_name=*/kShuffleNodeName,
+                              /*max_buffer_bytes=*/-1);
+}
+
 ShuffleDatasetParams ShuffleDatasetParamsWithInvalidBufferSize() {
   return ShuffleDatasetParams(RangeDatasetParams(0, 0, 1),
                               /*buffer_size=*/-1,
@@ -549,11 +597,71 @@ INSTANTIATE_TEST_CASE_P(ShuffleDatasetOpTest,
                         ParameterizedIteratorSaveAndRestoreTest,
                         ::testing::ValuesIn(IteratorSaveAndRestoreTestCases()));
 
+TEST_F(ShuffleDatasetOpTest, SpillToDisk) {
+  auto dataset_params = SpillingShuffleDatasetParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  while (!end_of_sequence) {
+    std::vector<Tensor> next;
+    TF_EXPECT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+    out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+  }
+
+  std::vector<Tensor> expected_outputs;
+  for (int64 i = 0; i < 100; ++i) {
+    expected_outputs.push_back(CreateTensor<int64>(TensorShape({}), {i}));
+  }
+  TF_EXPECT_OK(ExpectEqual(out_tensors, expected_outputs,
+                           /*compare_order=*/false));
+}
+
+TEST_F(ShuffleDatasetOpTest, SpillToDiskWithRepeat) {
+  auto dataset_params = SpillingShuffleAndRepeatDatasetParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  while (!end_of_sequence) {
+    std::vector<Tensor> next;
+    TF_EXPECT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+    out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+  }
+
+  // Every epoch must be produced in full before the next one starts.
+  ASSERT_EQ(out_tensors.size(), 60);
+  for (int epoch = 0; epoch < 3; ++epoch) {
+    std::vector<Tensor> epoch_tensors(out_tensors.begin() + epoch * 20,
+                                      out_tensors.begin() + (epoch + 1) * 20);
+    TF_EXPECT_OK(ExpectEqual(
+        epoch_tensors,
+        CreateTensors<int64>(TensorShape({}),
+                             {{0},  {1},  {2},  {3},  {4},  {5},  {6},
+                              {7},  {8},  {9},  {10}, {11}, {12}, {13},
+                              {14}, {15}, {16}, {17}, {18}, {19}}),
+        /*compare_order=*/false));
+  }
+}
+
+TEST_F(ShuffleDatasetOpTest, SpillToDiskSaveIsUnimplemented) {
+  auto dataset_params = SpillingShuffleDatasetParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::unique_ptr<SerializationContext> serialization_ctx;
+  TF_ASSERT_OK(CreateSerializationContext(&serialization_ctx));
+  VariantTensorDataWriter writer;
+  EXPECT_EQ(iterator_->Save(serialization_ctx.get(), &writer).code(),
+            tensorflow::error::UNIMPLEMENTED);
+}
+
 TEST_F(ShuffleDatasetOpTest, InvalidArguments) {
   std::vector<ShuffleDatasetParams> dataset_params_vec(
       {ShuffleDatasetParamsWithInvalidBufferSize(),
        ShuffleAndRepeatDatasetParamsWithInvalidBufferSize(),
-       ShuffleAndRepeatDatasetParamsWithInvalidCount()});
+       ShuffleAndRepeatDatasetParamsWithInvalidCount(),
+       ShuffleDatasetParamsWithInvalidMaxBufferBytes()});
   for (const auto& dataset_params : dataset_params_vec) {
     EXPECT_EQ(Initialize(dataset_params).code(),
               tensorflow::error::INVALID_ARGUMENT);
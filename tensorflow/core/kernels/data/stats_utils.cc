@@ -23,6 +23,7 @@ namespace stats_utils {
 
 ABSL_CONST_INIT const char kDelimiter[] = "::";
 ABSL_CONST_INIT const char kExecutionTime[] = "execution_time";
+ABSL_CONST_INIT const char kInputLatency[] = "input_latency";
 ABSL_CONST_INIT const char kThreadUtilization[] = "thread_utilization";
 ABSL_CONST_INIT const char kBufferSize[] = "buffer_size";
 ABSL_CONST_INIT const char kBufferCapacity[] = "buffer_capacity";
@@ -37,6 +38,10 @@ string ExecutionTimeHistogramName(const string& prefix) {
   return strings::StrCat(prefix, kDelimiter, kExecutionTime);
 }
 
+string InputLatencyHistogramName(const string& prefix) {
+  return strings::StrCat(prefix, kDelimiter, kInputLatency);
+}
+
 string ThreadUtilizationScalarName(const string& prefix) {
   return strings::StrCat(prefix, kDelimiter, kThreadUtilization);
 }
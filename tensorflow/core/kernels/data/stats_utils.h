@@ -35,6 +35,9 @@ extern const char kExamplesCount[];
 // Name for tf.data function execution time (in ns) histogram metrics.
 string ExecutionTimeHistogramName(const string& prefix);
 
+// Name for per-input element production latency (in ns) histogram metrics.
+string InputLatencyHistogramName(const string& prefix);
+
 // Name for thread utilization (ratio of threads being used and maximum number
 // of threads allocated) scalar metrics.
 string ThreadUtilizationScalarName(const string& prefix);
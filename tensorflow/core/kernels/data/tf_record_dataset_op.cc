@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 namespace data {
@@ -35,13 +36,22 @@ namespace data {
 /* static */ constexpr const char* const TFRecordDatasetOp::kFileNames;
 /* static */ constexpr const char* const TFRecordDatasetOp::kCompressionType;
 /* static */ constexpr const char* const TFRecordDatasetOp::kBufferSize;
+/* static */ constexpr const char* const TFRecordDatasetOp::kReadAheadSize;
+/* static */ constexpr const char* const TFRecordDatasetOp::kUseDirectIO;
 
 constexpr char kCurrentFileIndex[] = "current_file_index";
 constexpr char kOffset[] = "offset";
 constexpr char kGcsFsPrefix[] = "gs://";
 constexpr char kS3FsPrefix[] = "s3://";
+constexpr char kReadAheadThreadPool[] = "tf_record_read_ahead";
 constexpr int64 kCloudTpuBlockSize = 127LL << 20;  // 127MB.
 constexpr int64 kS3BlockSize = kCloudTpuBlockSize;
+// Number of reads in flight per file in read-ahead mode. Each read is for
+// `read_ahead_size / kReadAheadReadsInFlight` bytes, or `buffer_size` bytes if
+// that is larger.
+constexpr int64 kReadAheadReadsInFlight = 4;
+// Maximum number of records parsed at once in read-ahead mode.
+constexpr int64 kReadAheadBatchSize = 64;
 
 bool is_cloud_tpu_gcs_fs() {
 #if defined(PLATFORM_CLOUD_TPU) && defined(TPU_GCS_FS)
@@ -53,15 +63,31 @@ bool is_cloud_tpu_gcs_fs() {
 class TFRecordDatasetOp::Dataset : public DatasetBase {
  public:
   explicit Dataset(OpKernelContext* ctx, std::vector<string> filenames,
-                   const string& compression_type, int64 buffer_size)
+                   const string& compression_type, int64 buffer_size,
+                   int64 read_ahead_size, bool use_direct_io)
       : DatasetBase(DatasetContext(ctx)),
         filenames_(std::move(filenames)),
         compression_type_(compression_type),
         options_(io::RecordReaderOptions::CreateRecordReaderOptions(
-            compression_type)) {
+            compression_type)),
+        read_ahead_size_(read_ahead_size),
+        use_direct_io_(use_direct_io) {
     if (buffer_size > 0) {
       options_.buffer_size = buffer_size;
     }
+    // Compressed files must be decompressed sequentially, so read-ahead only
+    // applies to uncompressed files.
+    if (read_ahead_size_ > 0 &&
+        options_.compression_type == io::RecordReaderOptions::NONE) {
+      read_ahead_ = true;
+      read_ahead_options_.block_size = std::max<int64>(
+          options_.buffer_size, read_ahead_size_ / kReadAheadReadsInFlight);
+      read_ahead_options_.max_reads_in_flight =
+          (read_ahead_size_ + read_ahead_options_.block_size - 1) /
+          read_ahead_options_.block_size;
+    } else if (read_ahead_size_ > 0) {
+      VLOG(1) << "Read-ahead is not supported for compressed TFRecord files.";
+    }
   }
 
   std::unique_ptr<IteratorBase> MakeIteratorInternal(
@@ -97,8 +123,22 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     TF_RETURN_IF_ERROR(b->AddScalar(compression_type_, &compression_type));
     Node* buffer_size = nullptr;
     TF_RETURN_IF_ERROR(b->AddScalar(options_.buffer_size, &buffer_size));
+    // The attrs are only added when they differ from their defaults, so that
+    // graphs of datasets that do not use them remain readable by older
+    // binaries.
+    std::vector<std::pair<StringPiece, AttrValue>> attrs;
+    if (read_ahead_size_ > 0) {
+      AttrValue read_ahead_size_attr;
+      b->BuildAttrValue(read_ahead_size_, &read_ahead_size_attr);
+      attrs.emplace_back(kReadAheadSize, read_ahead_size_attr);
+    }
+    if (use_direct_io_) {
+      AttrValue use_direct_io_attr;
+      b->BuildAttrValue(use_direct_io_, &use_direct_io_attr);
+      attrs.emplace_back(kUseDirectIO, use_direct_io_attr);
+    }
     TF_RETURN_IF_ERROR(b->AddDataset(
-        this, {filenames, compression_type, buffer_size}, output));
+        this, {filenames, compression_type, buffer_size}, attrs, output));
     return Status::OK();
   }
 
@@ -114,6 +154,39 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
       out_tensors->reserve(1);
       mutex_lock l(mu_);
       do {
+        // Records read ahead of time are returned first.
+        if (next_record_ < records_.size()) {
+          out_tensors->emplace_back(ctx->allocator({}), DT_STRING,
+                                    TensorShape({}));
+          out_tensors->back().scalar<tstring>()() =
+              std::move(records_[next_record_++]);
+          static monitoring::CounterCell* bytes_counter =
+              metrics::GetTFDataBytesReadCounter(kDatasetType);
+          bytes_counter->IncrementBy(
+              out_tensors->back().scalar<tstring>()().size());
+          *end_of_sequence = false;
+          return Status::OK();
+        }
+
+        // We are currently processing a file in read-ahead mode, so try to
+        // read the next batch of records.
+        if (read_ahead_reader_) {
+          records_.clear();
+          next_record_ = 0;
+          Status s =
+              read_ahead_reader_->ReadRecords(kReadAheadBatchSize, &records_);
+          if (s.ok()) {
+            continue;
+          }
+          ResetStreamsLocked();
+          ++current_file_index_;
+          if (!errors::IsOutOfRange(s)) {
+            // As below, move on to the next file so that this works with
+            // ignore_errors.
+            return s;
+          }
+        }
+
         // We are currently processing a file, so try to read the next record.
         if (reader_) {
           out_tensors->emplace_back(ctx->allocator({}), DT_STRING,
@@ -150,7 +223,7 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
           return Status::OK();
         }
 
-        TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
+        TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx, /*offset=*/0));
       } while (true);
     }
 
@@ -170,6 +243,16 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
         TF_RETURN_IF_ERROR(
             writer->WriteScalar(full_name(kOffset), reader_->TellOffset()));
       }
+      if (read_ahead_reader_) {
+        // Records that have been read but not returned yet are read again
+        // after restoring, so save the offset of the first of them.
+        uint64 offset = read_ahead_reader_->TellOffset();
+        for (size_t i = next_record_; i < records_.size(); ++i) {
+          offset -= io::RecordReader::kHeaderSize + records_[i].size() +
+                    io::RecordReader::kFooterSize;
+        }
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kOffset), offset));
+      }
       return Status::OK();
     }
 
@@ -184,15 +267,20 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
       if (reader->Contains(full_name(kOffset))) {
         int64 offset;
         TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kOffset), &offset));
-        TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
-        TF_RETURN_IF_ERROR(reader_->SeekOffset(offset));
+        TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx, offset));
+        if (reader_) {
+          TF_RETURN_IF_ERROR(reader_->SeekOffset(offset));
+        }
       }
       return Status::OK();
     }
 
    private:
     // Sets up reader streams to read from the file at `current_file_index_`.
-    Status SetupStreamsLocked(Env* env) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    // In read-ahead mode, reading starts at `offset`; otherwise the caller is
+    // responsible for seeking to `offset`.
+    Status SetupStreamsLocked(IteratorContext* ctx, uint64 offset)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       if (current_file_index_ >= dataset()->filenames_.size()) {
         return errors::InvalidArgument(
             "current_file_index_:", current_file_index_,
@@ -201,16 +289,47 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
 
       // Actually move on to next file.
       const string& next_filename = dataset()->filenames_[current_file_index_];
-      TF_RETURN_IF_ERROR(env->NewRandomAccessFile(next_filename, &file_));
-      reader_ = absl::make_unique<io::SequentialRecordReader>(
-          file_.get(), dataset()->options_);
+      if (!dataset()->read_ahead_) {
+        TF_RETURN_IF_ERROR(
+            ctx->env()->NewRandomAccessFile(next_filename, &file_));
+        reader_ = absl::make_unique<io::SequentialRecordReader>(
+            file_.get(), dataset()->options_);
+        return Status::OK();
+      }
+
+      if (dataset()->use_direct_io_) {
+        Status s =
+            ctx->env()->NewDirectRandomAccessFile(next_filename, &file_);
+        if (errors::IsUnimplemented(s)) {
+          VLOG(1) << "Falling back to buffered reads: " << s;
+        } else {
+          TF_RETURN_IF_ERROR(s);
+        }
+      }
+      if (!file_) {
+        TF_RETURN_IF_ERROR(
+            ctx->env()->NewRandomAccessFile(next_filename, &file_));
+      }
+      if (!thread_pool_) {
+        thread_pool_ = ctx->CreateThreadPool(
+            kReadAheadThreadPool,
+            dataset()->read_ahead_options_.max_reads_in_flight);
+      }
+      read_ahead_reader_ = absl::make_unique<io::ReadAheadRecordReader>(
+          file_.get(), offset, dataset()->read_ahead_options_,
+          [pool = thread_pool_.get()](std::function<void()> fn) {
+            pool->Schedule(std::move(fn));
+          });
       return Status::OK();
     }
 
     // Resets all reader streams.
     void ResetStreamsLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       reader_.reset();
+      read_ahead_reader_.reset();
       file_.reset();
+      records_.clear();
+      next_record_ = 0;
     }
 
     mutex mu_;
@@ -220,15 +339,41 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     // we must destroy `reader_` before `file_`.
     std::unique_ptr<RandomAccessFile> file_ TF_GUARDED_BY(mu_);
     std::unique_ptr<io::SequentialRecordReader> reader_ TF_GUARDED_BY(mu_);
+
+    // Read-ahead mode only. The thread pool must outlive `read_ahead_reader_`,
+    // which waits for its reads to finish when it is destroyed.
+    std::unique_ptr<thread::ThreadPool> thread_pool_ TF_GUARDED_BY(mu_);
+    std::unique_ptr<io::ReadAheadRecordReader> read_ahead_reader_
+        TF_GUARDED_BY(mu_);
+    // Records read from `read_ahead_reader_` and the index of the next one to
+    // return.
+    std::vector<tstring> records_ TF_GUARDED_BY(mu_);
+    size_t next_record_ TF_GUARDED_BY(mu_) = 0;
   };
 
   const std::vector<string> filenames_;
   const tstring compression_type_;
   io::RecordReaderOptions options_;
+  const int64 read_ahead_size_;
+  const bool use_direct_io_;
+  // Whether files are read with an `io::ReadAheadRecordReader`.
+  bool read_ahead_ = false;
+  io::ReadAheadRecordReader::Options read_ahead_options_;
 };
 
 TFRecordDatasetOp::TFRecordDatasetOp(OpKernelConstruction* ctx)
-    : DatasetOpKernel(ctx) {}
+    : DatasetOpKernel(ctx) {
+  if (ctx->HasAttr(kReadAheadSize)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kReadAheadSize, &read_ahead_size_));
+  }
+  if (ctx->HasAttr(kUseDirectIO)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kUseDirectIO, &use_direct_io_));
+  }
+  OP_REQUIRES(ctx, read_ahead_size_ >= 0,
+              errors::InvalidArgument("`", kReadAheadSize,
+                                      "` must be non-negative, but got ",
+                                      read_ahead_size_, "."));
+}
 
 void TFRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
                                     DatasetBase** output) {
@@ -275,8 +420,8 @@ void TFRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
     buffer_size = kS3BlockSize;
   }
 
-  *output =
-      new Dataset(ctx, std::move(filenames), compression_type, buffer_size);
+  *output = new Dataset(ctx, std::move(filenames), compression_type,
+                        buffer_size, read_ahead_size_, use_direct_io_);
 }
 
 namespace {
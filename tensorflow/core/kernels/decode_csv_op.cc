@@ -14,13 +14,15 @@ limitations under the License.
 ==============================================================================*/
 
 // See docs in ../ops/parsing_ops.cc.
+#include <deque>
 #include <vector>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
-#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/util/csv_parsing.h"
 
 namespace tensorflow {
 
@@ -81,10 +83,15 @@ class DecodeCSVOp : public OpKernel {
       OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &out));
     }
 
+    csv::StructuralScanner scanner(delim_, use_quote_delim_);
+    std::vector<StringPiece> fields;
+    std::deque<string> unescaped_fields;
     for (int64 i = 0; i < records_size; ++i) {
       const StringPiece record(records_t(i));
-      std::vector<string> fields;
-      ExtractFields(ctx, record, &fields);
+      fields.clear();
+      unescaped_fields.clear();
+      OP_REQUIRES_OK(ctx, ExtractFields(record, &scanner, &fields,
+                                        &unescaped_fields));
       OP_REQUIRES(ctx, fields.size() == out_type_.size(),
                   errors::InvalidArgument("Expect ", out_type_.size(),
                                           " fields but have ", fields.size(),
@@ -93,11 +100,12 @@ class DecodeCSVOp : public OpKernel {
       // Check each field in the record
       for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
         const DataType& dtype = out_type_[f];
+        const StringPiece field = fields[f];
         switch (dtype) {
           case DT_INT32: {
             // If this field is empty or NA value, check if default is given:
             // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
+            if (field.empty() || field == na_value_) {
               OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
                           errors::InvalidArgument(
                               "Field ", f,
@@ -106,10 +114,10 @@ class DecodeCSVOp : public OpKernel {
               output[f]->flat<int32>()(i) = record_defaults[f].flat<int32>()(0);
             } else {
               int32 value;
-              OP_REQUIRES(ctx, strings::safe_strto32(fields[f], &value),
+              OP_REQUIRES(ctx, csv::ParseInt32(field, &value),
                           errors::InvalidArgument(
                               "Field ", f, " in record ", i,
-                              " is not a valid int32: ", fields[f]));
+                              " is not a valid int32: ", field));
               output[f]->flat<int32>()(i) = value;
             }
             break;
@@ -117,7 +125,7 @@ class DecodeCSVOp : public OpKernel {
           case DT_INT64: {
             // If this field is empty or NA value, check if default is given:
             // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
+            if (field.empty() || field == na_value_) {
               OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
                           errors::InvalidArgument(
                               "Field ", f,
@@ -126,10 +134,10 @@ class DecodeCSVOp : public OpKernel {
               output[f]->flat<int64>()(i) = record_defaults[f].flat<int64>()(0);
             } else {
               int64 value;
-              OP_REQUIRES(ctx, strings::safe_strto64(fields[f], &value),
+              OP_REQUIRES(ctx, csv::ParseInt64(field, &value),
                           errors::InvalidArgument(
                               "Field ", f, " in record ", i,
-                              " is not a valid int64: ", fields[f]));
+                              " is not a valid int64: ", field));
               output[f]->flat<int64>()(i) = value;
             }
             break;
@@ -137,7 +145,7 @@ class DecodeCSVOp : public OpKernel {
           case DT_FLOAT: {
             // If this field is empty or NA value, check if default is given:
             // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
+            if (field.empty() || field == na_value_) {
               OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
                           errors::InvalidArgument(
                               "Field ", f,
@@ -145,10 +153,10 @@ class DecodeCSVOp : public OpKernel {
               output[f]->flat<float>()(i) = record_defaults[f].flat<float>()(0);
             } else {
               float value;
-              OP_REQUIRES(ctx, strings::safe_strtof(fields[f], &value),
+              OP_REQUIRES(ctx, csv::ParseFloat(field, &value),
                           errors::InvalidArgument(
                               "Field ", f, " in record ", i,
-                              " is not a valid float: ", fields[f]));
+                              " is not a valid float: ", field));
               output[f]->flat<float>()(i) = value;
             }
             break;
@@ -156,7 +164,7 @@ class DecodeCSVOp : public OpKernel {
           case DT_DOUBLE: {
             // If this field is empty or NA value, check if default is given:
             // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
+            if (field.empty() || field == na_value_) {
               OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
                           errors::InvalidArgument(
                               "Field ", f,
@@ -165,10 +173,10 @@ class DecodeCSVOp : public OpKernel {
                   record_defaults[f].flat<double>()(0);
             } else {
               double value;
-              OP_REQUIRES(ctx, strings::safe_strtod(fields[f], &value),
+              OP_REQUIRES(ctx, csv::ParseDouble(field, &value),
                           errors::InvalidArgument(
                               "Field ", f, " in record ", i,
-                              " is not a valid double: ", fields[f]));
+                              " is not a valid double: ", field));
               output[f]->flat<double>()(i) = value;
             }
             break;
@@ -176,7 +184,7 @@ class DecodeCSVOp : public OpKernel {
           case DT_STRING: {
             // If this field is empty or NA value, check if default is given:
             // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
+            if (field.empty() || field == na_value_) {
               OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
                           errors::InvalidArgument(
                               "Field ", f,
@@ -184,7 +192,8 @@ class DecodeCSVOp : public OpKernel {
               output[f]->flat<tstring>()(i) =
                   record_defaults[f].flat<tstring>()(0);
             } else {
-              output[f]->flat<tstring>()(i) = std::move(fields[f]);
+              output[f]->flat<tstring>()(i).assign(field.data(),
+                                                   field.size());
             }
             break;
           }
@@ -205,91 +214,108 @@ class DecodeCSVOp : public OpKernel {
   bool select_all_cols_;
   string na_value_;
 
-  void ExtractFields(OpKernelContext* ctx, StringPiece input,
-                     std::vector<string>* result) {
-    int64 current_idx = 0;
+  // Splits `input` into the selected fields. Fields refer to `input` unless
+  // they contain escaped quotes, in which case they refer to unescaped copies
+  // in `unescaped_fields`.
+  Status ExtractFields(StringPiece input, csv::StructuralScanner* scanner,
+                       std::vector<StringPiece>* result,
+                       std::deque<string>* unescaped_fields) {
+    size_t current_idx = 0;
     int64 num_fields_parsed = 0;
     int64 selector_idx = 0;  // Keep track of index into select_cols
 
-    if (!input.empty()) {
-      while (static_cast<size_t>(current_idx) < input.size()) {
-        if (input[current_idx] == '\n' || input[current_idx] == '\r') {
-          current_idx++;
-          continue;
-        }
+    if (input.empty()) {
+      return Status::OK();
+    }
+    scanner->Reset();
+    while (current_idx < input.size()) {
+      if (input[current_idx] == '\n' || input[current_idx] == '\r') {
+        current_idx++;
+        continue;
+      }
+
+      bool quoted = false;
+      bool include =
+          (select_all_cols_ || select_cols_[selector_idx] ==
+                                   static_cast<size_t>(num_fields_parsed));
 
-        bool quoted = false;
-        bool include =
-            (select_all_cols_ || select_cols_[selector_idx] ==
-                                     static_cast<size_t>(num_fields_parsed));
+      if (use_quote_delim_ && input[current_idx] == '"') {
+        quoted = true;
+        current_idx++;
+      }
 
-        if (use_quote_delim_ && input[current_idx] == '"') {
-          quoted = true;
-          current_idx++;
+      // This is the body of the field;
+      StringPiece field;
+      if (!quoted) {
+        // The field ends at the next structural character, which has to be
+        // the delimiter.
+        const size_t end = scanner->Find(input, current_idx);
+        if (end < input.size() && input[end] != delim_) {
+          return errors::InvalidArgument(
+              "Unquoted fields cannot have quotes/CRLFs inside");
         }
+        field = input.substr(current_idx, end - current_idx);
 
-        // This is the body of the field;
-        string field;
-        if (!quoted) {
-          while (static_cast<size_t>(current_idx) < input.size() &&
-                 input[current_idx] != delim_) {
-            OP_REQUIRES(ctx,
-                        (!use_quote_delim_ || input[current_idx] != '"') &&
-                            input[current_idx] != '\n' &&
-                            input[current_idx] != '\r',
-                        errors::InvalidArgument(
-                            "Unquoted fields cannot have quotes/CRLFs inside"));
-            if (include) field += input[current_idx];
-            current_idx++;
+        // Go to next field or the end
+        current_idx = end + 1;
+      } else {
+        // Quoted field needs to be ended with '"' and delim or end
+        const size_t start = current_idx;
+        string* unescaped = nullptr;
+        while (true) {
+          const size_t quote = input.find('"', current_idx);
+          if (quote == StringPiece::npos) {
+            current_idx = input.size();
+            break;
           }
-
-          // Go to next field or the end
-          current_idx++;
-        } else if (use_quote_delim_) {
-          // Quoted field needs to be ended with '"' and delim or end
-          while (
-              (static_cast<size_t>(current_idx) < input.size() - 1) &&
-              (input[current_idx] != '"' || input[current_idx + 1] != delim_)) {
-            if (input[current_idx] != '"') {
-              if (include) field += input[current_idx];
-              current_idx++;
-            } else {
-              OP_REQUIRES(
-                  ctx, input[current_idx + 1] == '"',
-                  errors::InvalidArgument("Quote inside a string has to be "
-                                          "escaped by another quote"));
-              if (include) field += '"';
-              current_idx += 2;
+          if (quote == input.size() - 1 || input[quote + 1] == delim_) {
+            if (unescaped != nullptr) {
+              unescaped->append(input.data() + current_idx,
+                                quote - current_idx);
             }
+            current_idx = quote;
+            break;
           }
-
-          OP_REQUIRES(
-              ctx,
-              (static_cast<size_t>(current_idx) < input.size() &&
-               input[current_idx] == '"' &&
-               (static_cast<size_t>(current_idx) == input.size() - 1 ||
-                input[current_idx + 1] == delim_)),
-              errors::InvalidArgument("Quoted field has to end with quote "
-                                      "followed by delim or end"));
-
-          current_idx += 2;
+          if (input[quote + 1] != '"') {
+            return errors::InvalidArgument(
+                "Quote inside a string has to be escaped by another quote");
+          }
+          if (unescaped == nullptr) {
+            unescaped_fields->emplace_back();
+            unescaped = &unescaped_fields->back();
+            current_idx = start;
+          }
+          unescaped->append(input.data() + current_idx,
+                            quote + 1 - current_idx);
+          current_idx = quote + 2;
         }
 
-        num_fields_parsed++;
-        if (include) {
-          result->push_back(field);
-          selector_idx++;
-          if (selector_idx == select_cols_.size()) return;
+        if (current_idx >= input.size() || input[current_idx] != '"') {
+          return errors::InvalidArgument(
+              "Quoted field has to end with quote followed by delim or end");
         }
+        field = unescaped != nullptr
+                    ? StringPiece(*unescaped)
+                    : input.substr(start, current_idx - start);
+
+        current_idx += 2;
       }
 
-      bool include =
-          (select_all_cols_ || select_cols_[selector_idx] ==
-                                   static_cast<size_t>(num_fields_parsed));
-      // Check if the last field is missing
-      if (include && input[input.size() - 1] == delim_)
-        result->push_back(string());
+      num_fields_parsed++;
+      if (include) {
+        result->push_back(field);
+        selector_idx++;
+        if (selector_idx == select_cols_.size()) return Status::OK();
+      }
     }
+
+    bool include =
+        (select_all_cols_ || select_cols_[selector_idx] ==
+                                 static_cast<size_t>(num_fields_parsed));
+    // Check if the last field is missing
+    if (include && input[input.size() - 1] == delim_)
+      result->push_back(StringPiece());
+    return Status::OK();
   }
 };
 
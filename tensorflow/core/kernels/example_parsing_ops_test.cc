@@ -66,6 +66,22 @@ class Int64Filler {
   DataType dtype = DT_INT64;
 };
 
+// Fills values that are encoded as single-byte varints, like most ids and
+// counts.
+class SmallInt64Filler {
+ public:
+  SmallInt64Filler() {}
+  void operator()(Feature* f, int feature_size) const {
+    for (int i = 0; i < feature_size; ++i) {
+      f->mutable_int64_list()->add_value(i % 128);
+    }
+  }
+  Tensor make_dense_default(int feature_size) {
+    return Tensor(dtype, TensorShape({feature_size}));
+  }
+  DataType dtype = DT_INT64;
+};
+
 class FloatFiller {
  public:
   FloatFiller() {}
@@ -107,6 +123,13 @@ struct ExampleStore {
       AddExample(&serialized_example, 10, 1, 100000);
       AddExample(&serialized_example, 100, 1, 10000);
       AddExample(&serialized_example, 1000, 1, 1000);
+      AddExample(&serialized_example, 1, 128, 10);
+      AddExample(&serialized_example, 1, 128, 100);
+      AddExample(&serialized_example, 10, 128, 10);
+      AddExample(&serialized_example, 10, 128, 100);
+      AddExample(&serialized_example, 100, 128, 10);
+      AddExample(&serialized_example, 100, 128, 100);
+      AddExample(&serialized_example, 1000, 128, 10);
     });
     return serialized_example;
   }
@@ -139,6 +162,7 @@ absl::once_flag ExampleStore<T>::flags_init;
 
 template struct ExampleStore<BytesFiller>;
 template struct ExampleStore<Int64Filler>;
+template struct ExampleStore<SmallInt64Filler>;
 template struct ExampleStore<FloatFiller>;
 
 enum BenchmarkType { kDense, kSparse, kVarLenDense, kRagged };
@@ -340,6 +364,14 @@ typedef BenchmarkOptions<ExampleStore<Int64Filler>, kDense> DenseInt64;
 typedef BenchmarkOptions<ExampleStore<Int64Filler>, kVarLenDense>
     VarLenDenseInt64;
 typedef BenchmarkOptions<ExampleStore<Int64Filler>, kRagged> RaggedInt64;
+typedef BenchmarkOptions<ExampleStore<SmallInt64Filler>, kSparse>
+    SparseSmallInt64;
+typedef BenchmarkOptions<ExampleStore<SmallInt64Filler>, kDense>
+    DenseSmallInt64;
+typedef BenchmarkOptions<ExampleStore<SmallInt64Filler>, kVarLenDense>
+    VarLenDenseSmallInt64;
+typedef BenchmarkOptions<ExampleStore<SmallInt64Filler>, kRagged>
+    RaggedSmallInt64;
 typedef BenchmarkOptions<ExampleStore<FloatFiller>, kSparse> SparseFloat;
 typedef BenchmarkOptions<ExampleStore<FloatFiller>, kDense> DenseFloat;
 typedef BenchmarkOptions<ExampleStore<FloatFiller>, kVarLenDense>
@@ -434,6 +466,33 @@ BM_AllParseExampleV2(DenseFloat);
 BM_AllParseExampleV2(VarLenDenseFloat);
 BM_AllParseExampleV2(RaggedFloat);
 
+// Batches of 128 examples with K features of F values each.
+#define BM_AllParseExampleV2FeatureCounts(Type) \
+  BM_ParseExampleV2(Type, 128, 1, 10);          \
+  BM_ParseExampleV2(Type, 128, 1, 100);         \
+  BM_ParseExampleV2(Type, 128, 10, 10);         \
+  BM_ParseExampleV2(Type, 128, 10, 100);        \
+  BM_ParseExampleV2(Type, 128, 100, 10);        \
+  BM_ParseExampleV2(Type, 128, 100, 100);       \
+  BM_ParseExampleV2(Type, 128, 1000, 10);
+
+BM_AllParseExampleV2FeatureCounts(SparseString);
+BM_AllParseExampleV2FeatureCounts(DenseString);
+BM_AllParseExampleV2FeatureCounts(VarLenDenseString);
+BM_AllParseExampleV2FeatureCounts(RaggedString);
+BM_AllParseExampleV2FeatureCounts(SparseInt64);
+BM_AllParseExampleV2FeatureCounts(DenseInt64);
+BM_AllParseExampleV2FeatureCounts(VarLenDenseInt64);
+BM_AllParseExampleV2FeatureCounts(RaggedInt64);
+BM_AllParseExampleV2FeatureCounts(SparseSmallInt64);
+BM_AllParseExampleV2FeatureCounts(DenseSmallInt64);
+BM_AllParseExampleV2FeatureCounts(VarLenDenseSmallInt64);
+BM_AllParseExampleV2FeatureCounts(RaggedSmallInt64);
+BM_AllParseExampleV2FeatureCounts(SparseFloat);
+BM_AllParseExampleV2FeatureCounts(DenseFloat);
+BM_AllParseExampleV2FeatureCounts(VarLenDenseFloat);
+BM_AllParseExampleV2FeatureCounts(RaggedFloat);
+
 // K == num_keys. F == feature_size.
 // K must be one of 10, 100, 1000
 #define BM_ParseSingleExample(TYPE, K, F)                                    \
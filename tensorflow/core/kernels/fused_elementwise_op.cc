@@ -0,0 +1,290 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_types.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// The number of elements that each op of the chain processes at a time. The
+// tiles of the output and of all inputs stay in the L1 cache while the ops run
+// over them, so that the chain makes a single pass over memory.
+constexpr int64 kTileSize = 1024;
+
+enum class FusedElementwiseOp {
+  // Unary ops.
+  kAbs,
+  kExp,
+  kLog,
+  kNeg,
+  kReciprocal,
+  kRelu,
+  kRsqrt,
+  kSigmoid,
+  kSqrt,
+  kSquare,
+  kTanh,
+  // Binary ops.
+  kAdd,
+  kDiv,
+  kMaximum,
+  kMinimum,
+  kMul,
+  kSquaredDifference,
+  kSub,
+};
+
+bool IsBinary(FusedElementwiseOp op) { return op >= FusedElementwiseOp::kAdd; }
+
+Status ParseFusedElementwiseOp(const string& name, FusedElementwiseOp* op) {
+  if (name == "Abs") {
+    *op = FusedElementwiseOp::kAbs;
+  } else if (name == "Exp") {
+    *op = FusedElementwiseOp::kExp;
+  } else if (name == "Log") {
+    *op = FusedElementwiseOp::kLog;
+  } else if (name == "Neg") {
+    *op = FusedElementwiseOp::kNeg;
+  } else if (name == "Reciprocal" || name == "Inv") {
+    *op = FusedElementwiseOp::kReciprocal;
+  } else if (name == "Relu") {
+    *op = FusedElementwiseOp::kRelu;
+  } else if (name == "Rsqrt") {
+    *op = FusedElementwiseOp::kRsqrt;
+  } else if (name == "Sigmoid") {
+    *op = FusedElementwiseOp::kSigmoid;
+  } else if (name == "Sqrt") {
+    *op = FusedElementwiseOp::kSqrt;
+  } else if (name == "Square") {
+    *op = FusedElementwiseOp::kSquare;
+  } else if (name == "Tanh") {
+    *op = FusedElementwiseOp::kTanh;
+  } else if (name == "Add" || name == "AddV2") {
+    *op = FusedElementwiseOp::kAdd;
+  } else if (name == "Div" || name == "RealDiv") {
+    *op = FusedElementwiseOp::kDiv;
+  } else if (name == "Maximum") {
+    *op = FusedElementwiseOp::kMaximum;
+  } else if (name == "Minimum") {
+    *op = FusedElementwiseOp::kMinimum;
+  } else if (name == "Mul") {
+    *op = FusedElementwiseOp::kMul;
+  } else if (name == "SquaredDifference") {
+    *op = FusedElementwiseOp::kSquaredDifference;
+  } else if (name == "Sub") {
+    *op = FusedElementwiseOp::kSub;
+  } else {
+    return errors::Unimplemented("Unsupported fused elementwise op: ", name);
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+template <typename T>
+class FusedElementwiseOpKernel : public OpKernel {
+ public:
+  explicit FusedElementwiseOpKernel(OpKernelConstruction* context)
+      : OpKernel(context) {
+    std::vector<string> fused_ops;
+    OP_REQUIRES_OK(context, context->GetAttr("fused_ops", &fused_ops));
+    int num_args;
+    OP_REQUIRES_OK(context, context->GetAttr("num_args", &num_args));
+    OP_REQUIRES(context, !fused_ops.empty(),
+                errors::InvalidArgument("fused_ops must not be empty"));
+    int num_binary_ops = 0;
+    for (const string& name : fused_ops) {
+      FusedElementwiseOp op;
+      OP_REQUIRES_OK(context, ParseFusedElementwiseOp(name, &op));
+      ops_.push_back(op);
+      if (IsBinary(op)) ++num_binary_ops;
+    }
+    OP_REQUIRES(context, num_binary_ops == num_args,
+                errors::InvalidArgument(
+                    "The number of binary fused ops (", num_binary_ops,
+                    ") must match the number of args (", num_args, ")"));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    OpInputList args;
+    OP_REQUIRES_OK(context, context->input_list("args", &args));
+    for (int i = 0; i < args.size(); ++i) {
+      OP_REQUIRES(context,
+                  args[i].shape() == x.shape() ||
+                      TensorShapeUtils::IsScalar(args[i].shape()),
+                  errors::InvalidArgument(
+                      "args[", i, "] must be a scalar or have the shape of x ",
+                      x.shape().DebugString(), ", got ",
+                      args[i].shape().DebugString()));
+    }
+
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, x.shape(), &y));
+    const int64 size = x.NumElements();
+    if (size == 0) return;
+
+    const T* x_data = x.flat<T>().data();
+    T* y_data = y->flat<T>().data();
+    auto compute_fn = [this, &args, x_data, y_data](int64 begin, int64 end) {
+      for (int64 offset = begin; offset < end; offset += kTileSize) {
+        ComputeTile(args, x_data, y_data, offset,
+                    std::min(kTileSize, end - offset));
+      }
+    };
+
+    const CPUDevice& device = context->eigen_device<CPUDevice>();
+    const int num_ops = ops_.size();
+    Eigen::TensorOpCost cost(/*bytes_loaded=*/sizeof(T) * (1 + args.size()),
+                             /*bytes_stored=*/sizeof(T),
+                             /*compute_cycles=*/num_ops * 10);
+    device.parallelFor(size, cost, AlignBlockSize, std::move(compute_fn));
+  }
+
+ private:
+  // Applies all ops to the `size` elements at `offset`.
+  void ComputeTile(const OpInputList& args, const T* x_data, T* y_data,
+                   int64 offset, int64 size) const {
+    const Eigen::DefaultDevice d;
+    typename TTypes<T>::UnalignedFlat tile(y_data + offset, size);
+    if (x_data != y_data) {
+      tile.device(d) =
+          typename TTypes<T>::UnalignedConstFlat(x_data + offset, size);
+    }
+    int arg = 0;
+    for (const FusedElementwiseOp op : ops_) {
+      if (!IsBinary(op)) {
+        ApplyUnary(op, d, tile);
+      } else if (TensorShapeUtils::IsScalar(args[arg].shape())) {
+        ApplyBinary(op, d, tile, args[arg++].scalar<T>()());
+      } else {
+        ApplyBinary(op, d, tile,
+                    typename TTypes<T>::UnalignedConstFlat(
+                        args[arg++].flat<T>().data() + offset, size));
+      }
+    }
+  }
+
+  static void ApplyUnary(FusedElementwiseOp op, const Eigen::DefaultDevice& d,
+                         typename TTypes<T>::UnalignedFlat tile) {
+    switch (op) {
+      case FusedElementwiseOp::kAbs:
+        tile.device(d) = tile.abs();
+        break;
+      case FusedElementwiseOp::kExp:
+        tile.device(d) = tile.exp();
+        break;
+      case FusedElementwiseOp::kLog:
+        tile.device(d) = tile.log();
+        break;
+      case FusedElementwiseOp::kNeg:
+        tile.device(d) = -tile;
+        break;
+      case FusedElementwiseOp::kReciprocal:
+        tile.device(d) = tile.inverse();
+        break;
+      case FusedElementwiseOp::kRelu:
+        tile.device(d) = tile.cwiseMax(static_cast<T>(0));
+        break;
+      case FusedElementwiseOp::kRsqrt:
+        tile.device(d) = tile.rsqrt();
+        break;
+      case FusedElementwiseOp::kSigmoid:
+        tile.device(d) = tile.sigmoid();
+        break;
+      case FusedElementwiseOp::kSqrt:
+        tile.device(d) = tile.sqrt();
+        break;
+      case FusedElementwiseOp::kSquare:
+        tile.device(d) = tile.square();
+        break;
+      case FusedElementwiseOp::kTanh:
+        tile.device(d) = tile.tanh();
+        break;
+      default:
+        LOG(FATAL) << "Not a unary op: " << static_cast<int>(op);
+    }
+  }
+
+  // `other` is either a scalar of type T or a tile of the same size as `tile`.
+  template <typename Other>
+  static void ApplyBinary(FusedElementwiseOp op, const Eigen::DefaultDevice& d,
+                          typename TTypes<T>::UnalignedFlat tile,
+                          const Other& other) {
+    switch (op) {
+      case FusedElementwiseOp::kAdd:
+        tile.device(d) = tile + other;
+        break;
+      case FusedElementwiseOp::kDiv:
+        tile.device(d) = tile / other;
+        break;
+      case FusedElementwiseOp::kMaximum:
+        tile.device(d) = tile.cwiseMax(other);
+        break;
+      case FusedElementwiseOp::kMinimum:
+        tile.device(d) = tile.cwiseMin(other);
+        break;
+      case FusedElementwiseOp::kMul:
+        tile.device(d) = tile * other;
+        break;
+      case FusedElementwiseOp::kSquaredDifference:
+        tile.device(d) = (tile - other).square();
+        break;
+      case FusedElementwiseOp::kSub:
+        tile.device(d) = tile - other;
+        break;
+      default:
+        LOG(FATAL) << "Not a binary op: " << static_cast<int>(op);
+    }
+  }
+
+  // Rounds the blocks of parallelFor() up to whole tiles.
+  static int64 AlignBlockSize(int64 block_size) {
+    return (block_size + kTileSize - 1) / kTileSize * kTileSize;
+  }
+
+  std::vector<FusedElementwiseOp> ops_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FusedElementwiseOpKernel);
+};
+
+#define REGISTER_CPU(T)                                                   \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("_FusedElementwise").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedElementwiseOpKernel<T>);
+
+TF_CALL_float(REGISTER_CPU);
+TF_CALL_double(REGISTER_CPU);
+
+#undef REGISTER_CPU
+
+}  // namespace tensorflow
@@ -0,0 +1,198 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class FusedElementwiseOpTest : public OpsTestBase {
+ protected:
+  template <typename T>
+  Status MakeFusedOp(const std::vector<string>& fused_ops, int num_args) {
+    TF_RETURN_IF_ERROR(
+        NodeDefBuilder("fused_elementwise", "_FusedElementwise")
+            .Input(FakeInput(DataTypeToEnum<T>::v()))
+            .Input(FakeInput(num_args, DataTypeToEnum<T>::v()))
+            .Attr("fused_ops", fused_ops)
+            .Finalize(node_def()));
+    return InitOp();
+  }
+};
+
+TEST_F(FusedElementwiseOpTest, UnaryChain) {
+  TF_ASSERT_OK(MakeFusedOp<float>({"Square", "Sqrt", "Neg", "Exp"}, 0));
+  AddInputFromArray<float>(TensorShape({4}), {-2.0f, -1.0f, 0.0f, 3.0f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({4}));
+  test::FillValues<float>(&expected, {std::exp(-2.0f), std::exp(-1.0f), 1.0f,
+                                      std::exp(-3.0f)});
+  test::ExpectClose(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, BinaryChainWithScalarArgs) {
+  // y = tanh((x + a) * 0.5) - b
+  TF_ASSERT_OK(MakeFusedOp<double>({"AddV2", "Mul", "Tanh", "Sub"}, 3));
+  AddInputFromArray<double>(TensorShape({2, 2}), {1.0, 2.0, 3.0, 4.0});
+  AddInputFromArray<double>(TensorShape({2, 2}), {-1.0, 0.0, 1.0, 2.0});
+  AddInputFromArray<double>(TensorShape({}), {0.5});
+  AddInputFromArray<double>(TensorShape({2, 2}), {1.0, 1.0, 2.0, 2.0});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_DOUBLE, TensorShape({2, 2}));
+  test::FillValues<double>(&expected, {std::tanh(0.0) - 1.0,
+                                       std::tanh(1.0) - 1.0,
+                                       std::tanh(2.0) - 2.0,
+                                       std::tanh(3.0) - 2.0});
+  test::ExpectClose(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, MultipleTiles) {
+  // The input spans several tiles, and does not end on a tile boundary.
+  const int kSize = 10000;
+  TF_ASSERT_OK(
+      MakeFusedOp<float>({"Maximum", "SquaredDifference", "Relu", "Div"}, 3));
+  std::vector<float> x(kSize), a(kSize);
+  for (int i = 0; i < kSize; ++i) {
+    x[i] = (i % 17) - 8.0f;
+    a[i] = (i % 5) * 0.25f;
+  }
+  AddInputFromArray<float>(TensorShape({kSize}), x);
+  AddInputFromArray<float>(TensorShape({}), {-4.0f});
+  AddInputFromArray<float>(TensorShape({kSize}), a);
+  AddInputFromArray<float>(TensorShape({}), {2.0f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({kSize}));
+  for (int i = 0; i < kSize; ++i) {
+    const float d = std::max(x[i], -4.0f) - a[i];
+    expected.flat<float>()(i) = std::max(d * d, 0.0f) / 2.0f;
+  }
+  test::ExpectClose(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, ArgShapeMismatch) {
+  TF_ASSERT_OK(MakeFusedOp<float>({"Add", "Tanh"}, 1));
+  AddInputFromArray<float>(TensorShape({2, 2}), {1.0f, 2.0f, 3.0f, 4.0f});
+  AddInputFromArray<float>(TensorShape({2}), {1.0f, 2.0f});
+  const Status s = RunOpKernel();
+  EXPECT_EQ(error::INVALID_ARGUMENT, s.code());
+  EXPECT_TRUE(absl::StrContains(s.error_message(), "must be a scalar"));
+}
+
+TEST_F(FusedElementwiseOpTest, UnsupportedOp) {
+  const Status s = MakeFusedOp<float>({"Tanh", "Cos"}, 0);
+  EXPECT_EQ(error::UNIMPLEMENTED, s.code());
+}
+
+TEST_F(FusedElementwiseOpTest, ArgCountMismatch) {
+  const Status s = MakeFusedOp<float>({"Tanh", "Mul"}, 0);
+  EXPECT_EQ(error::INVALID_ARGUMENT, s.code());
+}
+
+// Performance benchmarks below.
+
+// The chain y = tanh((x + a) * b) - c, where b is a scalar.
+const char* const kChainOps[] = {"AddV2", "Mul", "Tanh", "Sub"};
+
+Tensor RandomTensor(const TensorShape& shape) {
+  Tensor t(DT_FLOAT, shape);
+  t.flat<float>() = t.flat<float>().setRandom();
+  return t;
+}
+
+// Elementwise ops chained together as separate graph nodes.
+static Graph* ElementwiseChain(int tensor_size, int repeat_graph) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const TensorShape shape({tensor_size});
+  for (int i = 0; i < repeat_graph; ++i) {
+    Node* node = test::graph::Constant(g, RandomTensor(shape));
+    Node* args[] = {test::graph::Constant(g, RandomTensor(shape)),
+                    test::graph::Constant(g, RandomTensor({})), nullptr,
+                    test::graph::Constant(g, RandomTensor(shape))};
+    for (int j = 0; j < 4; ++j) {
+      NodeBuilder builder(g->NewName("n"), kChainOps[j]);
+      builder.Input(node);
+      if (args[j] != nullptr) builder.Input(args[j]);
+      TF_CHECK_OK(builder.Attr("T", DT_FLOAT).Finalize(g, &node));
+    }
+  }
+  return g;
+}
+
+// Elementwise ops fused together.
+static Graph* FusedElementwise(int tensor_size, int repeat_graph) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const TensorShape shape({tensor_size});
+  const std::vector<string> fused_ops(std::begin(kChainOps),
+                                      std::end(kChainOps));
+  for (int i = 0; i < repeat_graph; ++i) {
+    Node* node = test::graph::Constant(g, RandomTensor(shape));
+    std::vector<NodeBuilder::NodeOut> args = {
+        test::graph::Constant(g, RandomTensor(shape)),
+        test::graph::Constant(g, RandomTensor({})),
+        test::graph::Constant(g, RandomTensor(shape))};
+    TF_CHECK_OK(NodeBuilder(g->NewName("n"), "_FusedElementwise")
+                    .Input(node)
+                    .Input(args)
+                    .Attr("T", DT_FLOAT)
+                    .Attr("fused_ops", fused_ops)
+                    .Finalize(g, &node));
+  }
+  return g;
+}
+
+#define BM_ElementwiseChain(N, R, type)                             \
+  static void BM_ElementwiseChain##_##type##_##N##_##R(int iters) { \
+    testing::ItemsProcessed(static_cast<int64>(iters) * N * R);     \
+    test::Benchmark(#type, ElementwiseChain(N, R)).Run(iters);      \
+  }                                                                 \
+  BENCHMARK(BM_ElementwiseChain##_##type##_##N##_##R);
+
+#define BM_FusedElementwise(N, R, type)                             \
+  static void BM_FusedElementwise##_##type##_##N##_##R(int iters) { \
+    testing::ItemsProcessed(static_cast<int64>(iters) * N * R);     \
+    test::Benchmark(#type, FusedElementwise(N, R)).Run(iters);      \
+  }                                                                 \
+  BENCHMARK(BM_FusedElementwise##_##type##_##N##_##R);
+
+// BenchmarkName(tensor_size, repeat_graph, type)
+
+BM_ElementwiseChain(1000, 25, cpu);
+BM_FusedElementwise(1000, 25, cpu);
+
+BM_ElementwiseChain(100000, 25, cpu);
+BM_FusedElementwise(100000, 25, cpu);
+
+BM_ElementwiseChain(1000000, 25, cpu);
+BM_FusedElementwise(1000000, 25, cpu);
+
+}  // namespace
+}  // end namespace tensorflow
@@ -35,6 +35,13 @@ extern uint32 Extend(uint32 init_crc, const char* data, size_t n);
 // Return the crc32c of data[0,n-1]
 inline uint32 Value(const char* data, size_t n) { return Extend(0, data, n); }
 
+// Set crcs[i] to the crc32c of data[i][0,n[i]-1] for every i in [0,count).
+// Where the hardware allows it, independent buffers are checksummed in an
+// interleaved fashion, which is considerably faster than calling Value() on
+// each of many small buffers. Buffers of similar sizes should be adjacent.
+extern void Values(const char* const* data, const size_t* n, size_t count,
+                   uint32* crcs);
+
 #if defined(PLATFORM_GOOGLE)
 extern uint32 Extend(uint32 init_crc, const absl::Cord& cord);
 inline uint32 Value(const absl::Cord& cord) { return Extend(0, cord); }
@@ -14,6 +14,11 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/lib/hash/crc32c.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -56,12 +61,53 @@ TEST(CRC, StandardResults) {
             Value(reinterpret_cast<char*>(data) + 1, sizeof(data) - 4));
 }
 
-TEST(CRC, Values) { ASSERT_NE(Value("a", 1), Value("foo", 3)); }
+TEST(CRC, DifferentValues) { ASSERT_NE(Value("a", 1), Value("foo", 3)); }
 
 TEST(CRC, Extend) {
   ASSERT_EQ(Value("hello world", 11), Extend(Value("hello ", 6), "world", 5));
 }
 
+TEST(CRC, ExtendLong) {
+  // Long buffers are checksummed in interleaved stripes; check that the
+  // result matches checksumming the same bytes in short pieces.
+  std::string input(100000, '\0');
+  for (size_t i = 0; i < input.size(); i++) {
+    input[i] = static_cast<char>(i * 7 + (i >> 8));
+  }
+  for (size_t len : {767, 768, 769, 24575, 24576, 24577, 99000}) {
+    for (size_t offset = 0; offset < 9; offset++) {
+      uint32 expected = 0;
+      for (size_t i = 0; i < len; i += 5) {
+        expected = Extend(expected, input.data() + offset + i,
+                          std::min<size_t>(5, len - i));
+      }
+      ASSERT_EQ(expected, Value(input.data() + offset, len))
+          << "len=" << len << " offset=" << offset;
+    }
+  }
+}
+
+TEST(CRC, Values) {
+  std::string input(4096, '\0');
+  for (size_t i = 0; i < input.size(); i++) {
+    input[i] = static_cast<char>(i * 13);
+  }
+  std::vector<const char*> data;
+  std::vector<size_t> n;
+  for (size_t i = 0; i < 50; i++) {
+    data.push_back(input.data() + i * 3);
+    n.push_back(i % 7 == 0 ? 1000 + i : i * 5 % 41);
+  }
+  std::vector<uint32> crcs(data.size());
+  // Exercise complete and incomplete groups of buffers.
+  for (size_t count : {0, 1, 2, 3, 4, 50}) {
+    Values(data.data(), n.data(), count, crcs.data());
+    for (size_t i = 0; i < count; i++) {
+      ASSERT_EQ(Value(data[i], n[i]), crcs[i]) << "i=" << i;
+    }
+  }
+}
+
 TEST(CRC, Mask) {
   uint32 crc = Value("foo", 3);
   ASSERT_NE(crc, Mask(crc));
@@ -92,5 +138,25 @@ static void BM_CRC(int iters, int len) {
 }
 BENCHMARK(BM_CRC)->Range(1, 256 * 1024);
 
+// Checksums a run of 1000 records of `len` bytes, the way a TFRecord reader
+// verifies the payloads of the records in a block.
+static void BM_CRCValues(int iters, int len) {
+  constexpr int kNumRecords = 1000;
+  std::string input(kNumRecords * (len + 16), 'x');
+  std::vector<const char*> data;
+  std::vector<size_t> n(kNumRecords, len);
+  for (int i = 0; i < kNumRecords; i++) {
+    data.push_back(input.data() + i * (len + 16) + 12);
+  }
+  std::vector<uint32> crcs(kNumRecords);
+  for (int i = 0; i < iters; i++) {
+    Values(data.data(), n.data(), kNumRecords, crcs.data());
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * kNumRecords);
+  testing::BytesProcessed(static_cast<int64>(iters) * kNumRecords * len);
+  VLOG(1) << crcs[0];
+}
+BENCHMARK(BM_CRCValues)->Arg(8)->Arg(64)->Arg(256)->Arg(1024);
+
 }  // namespace crc32c
 }  // namespace tensorflow
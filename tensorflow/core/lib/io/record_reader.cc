@@ -16,6 +16,9 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 
 #include <limits.h>
+#include <string.h>
+
+#include <algorithm>
 
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -24,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mem.h"
 
 namespace tensorflow {
 namespace io {
@@ -245,5 +249,246 @@ SequentialRecordReader::SequentialRecordReader(
     RandomAccessFile* file, const RecordReaderOptions& options)
     : underlying_(file, options), offset_(0) {}
 
+ReadAheadRecordReader::Block::Block(int64 size)
+    : data(static_cast<char*>(
+          port::AlignedMalloc(size, FileSystem::kDirectIOAlignment))) {}
+
+ReadAheadRecordReader::Block::~Block() { port::AlignedFree(data); }
+
+ReadAheadRecordReader::ReadAheadRecordReader(
+    RandomAccessFile* file, uint64 offset, const Options& options,
+    std::function<void(std::function<void()>)> schedule)
+    : file_(file),
+      block_size_((std::max<int64>(options.block_size, 1) +
+                   FileSystem::kDirectIOAlignment - 1) /
+                  FileSystem::kDirectIOAlignment *
+                  FileSystem::kDirectIOAlignment),
+      max_reads_in_flight_(std::max<int64>(options.max_reads_in_flight, 1)),
+      schedule_(std::move(schedule)),
+      offset_(offset),
+      position_(offset % FileSystem::kDirectIOAlignment),
+      next_read_offset_(offset - position_) {}
+
+ReadAheadRecordReader::~ReadAheadRecordReader() {
+  mutex_lock l(mu_);
+  while (num_reads_in_flight_ > 0) {
+    cond_var_.wait(l);
+  }
+}
+
+void ReadAheadRecordReader::MaybeScheduleReads() {
+  while (!end_of_file_ &&
+         static_cast<int64>(blocks_.size()) < max_reads_in_flight_) {
+    ScheduleRead();
+  }
+}
+
+void ReadAheadRecordReader::ScheduleRead() {
+  auto block = std::make_shared<Block>(block_size_);
+  const uint64 offset = next_read_offset_;
+  next_read_offset_ += block_size_;
+  blocks_.push_back(block);
+  {
+    mutex_lock l(mu_);
+    ++num_reads_in_flight_;
+  }
+  schedule_([this, block, offset]() {
+    StringPiece result;
+    Status s = file_->Read(offset, block_size_, &result, block->data);
+    if (!result.empty() && result.data() != block->data) {
+      memcpy(block->data, result.data(), result.size());
+    }
+    mutex_lock l(mu_);
+    block->size = result.size();
+    if (errors::IsOutOfRange(s)) {
+      block->end_of_file = true;
+    } else {
+      block->status = s;
+    }
+    block->done = true;
+    --num_reads_in_flight_;
+    cond_var_.notify_all();
+  });
+}
+
+Status ReadAheadRecordReader::WaitForBlock(size_t index) {
+  while (index >= blocks_.size()) {
+    ScheduleRead();
+  }
+  Block* block = blocks_[index].get();
+  {
+    mutex_lock l(mu_);
+    while (!block->done) {
+      cond_var_.wait(l);
+    }
+  }
+  if (block->end_of_file) {
+    end_of_file_ = true;
+  }
+  return block->status;
+}
+
+Status ReadAheadRecordReader::Peek(size_t n, const char** data,
+                                   tstring* scratch) {
+  TF_RETURN_IF_ERROR(WaitForBlock(0));
+  const Block* front = blocks_.front().get();
+  if (position_ + n <= front->size) {
+    // Common case: the bytes are in the current block.
+    *data = front->data + position_;
+    return Status::OK();
+  }
+  scratch->resize_uninitialized(n);
+  size_t copied = 0;
+  size_t position = position_;
+  for (size_t index = 0; copied < n; ++index, position = 0) {
+    TF_RETURN_IF_ERROR(WaitForBlock(index));
+    const Block* block = blocks_[index].get();
+    if (block->size > position) {
+      const size_t to_copy = std::min(block->size - position, n - copied);
+      memcpy(scratch->mdata() + copied, block->data + position, to_copy);
+      copied += to_copy;
+    }
+    if (copied < n && block->end_of_file) {
+      if (copied == 0) {
+        return errors::OutOfRange("eof");
+      }
+      return errors::DataLoss("truncated record at ", offset_);
+    }
+  }
+  *data = scratch->data();
+  return Status::OK();
+}
+
+void ReadAheadRecordReader::Consume(size_t n) {
+  offset_ += n;
+  position_ += n;
+  while (position_ >= block_size_) {
+    position_ -= block_size_;
+    blocks_.pop_front();
+  }
+  MaybeScheduleReads();
+}
+
+Status ReadAheadRecordReader::ReadOneRecord(tstring* record) {
+  const char* header;
+  TF_RETURN_IF_ERROR(Peek(kHeaderSize, &header, &scratch_));
+  const uint64 length = core::DecodeFixed64(header);
+  const uint32 masked_length_crc = core::DecodeFixed32(header + sizeof(uint64));
+  if (crc32c::Unmask(masked_length_crc) !=
+      crc32c::Value(header, sizeof(uint64))) {
+    return errors::DataLoss("corrupted record at ", offset_);
+  }
+  if (length >= SIZE_MAX - kHeaderSize - kFooterSize) {
+    return errors::DataLoss("record size too large");
+  }
+
+  const size_t record_size = kHeaderSize + length + kFooterSize;
+  const char* data;
+  Status s = Peek(record_size, &data, &scratch_);
+  if (errors::IsOutOfRange(s)) {
+    s = errors::DataLoss("truncated record at ", offset_);
+  }
+  TF_RETURN_IF_ERROR(s);
+  const char* payload = data + kHeaderSize;
+  const uint32 masked_data_crc = core::DecodeFixed32(payload + length);
+  if (crc32c::Unmask(masked_data_crc) != crc32c::Value(payload, length)) {
+    return errors::DataLoss("corrupted record at ", offset_);
+  }
+  record->assign(payload, length);
+  Consume(record_size);
+  return Status::OK();
+}
+
+int64 ReadAheadRecordReader::ReadRecordsInBlock(
+    int64 max_records, std::vector<tstring>* records) {
+  if (!WaitForBlock(0).ok()) {
+    return 0;
+  }
+  const Block* front = blocks_.front().get();
+
+  // Frame the run of records that lie entirely within the block. Lengths are
+  // only trusted as far as the block bounds until their checksums are
+  // verified below.
+  batch_data_.clear();
+  batch_sizes_.clear();
+  size_t position = position_;
+  int64 num_records = 0;
+  while (num_records < max_records &&
+         front->size - std::min(front->size, position) >=
+             kHeaderSize + kFooterSize) {
+    const char* header = front->data + position;
+    const uint64 length = core::DecodeFixed64(header);
+    if (length > front->size - position - kHeaderSize - kFooterSize) {
+      break;
+    }
+    batch_data_.push_back(header);
+    batch_sizes_.push_back(length);
+    position += kHeaderSize + length + kFooterSize;
+    ++num_records;
+  }
+  if (num_records == 0) {
+    return 0;
+  }
+  // Checksum all headers, then all payloads, so that buffers of similar sizes
+  // are checksummed together.
+  batch_data_.resize(2 * num_records);
+  batch_sizes_.resize(2 * num_records);
+  for (int64 i = 0; i < num_records; ++i) {
+    batch_data_[num_records + i] = batch_data_[i] + kHeaderSize;
+    batch_sizes_[num_records + i] = batch_sizes_[i];
+    batch_sizes_[i] = sizeof(uint64);
+  }
+  batch_crcs_.resize(2 * num_records);
+  crc32c::Values(batch_data_.data(), batch_sizes_.data(), 2 * num_records,
+                 batch_crcs_.data());
+
+  size_t consumed = 0;
+  int64 num_verified = 0;
+  for (; num_verified < num_records; ++num_verified) {
+    const char* header = batch_data_[num_verified];
+    const char* payload = batch_data_[num_records + num_verified];
+    const size_t length = batch_sizes_[num_records + num_verified];
+    if (crc32c::Unmask(core::DecodeFixed32(header + sizeof(uint64))) !=
+            batch_crcs_[num_verified] ||
+        crc32c::Unmask(core::DecodeFixed32(payload + length)) !=
+            batch_crcs_[num_records + num_verified]) {
+      // Leave the corrupted record for `ReadOneRecord` to report.
+      break;
+    }
+    records->emplace_back(payload, length);
+    consumed += kHeaderSize + length + kFooterSize;
+  }
+  if (consumed > 0) {
+    Consume(consumed);
+  }
+  return num_verified;
+}
+
+Status ReadAheadRecordReader::ReadRecords(int64 max_records,
+                                          std::vector<tstring>* records) {
+  MaybeScheduleReads();
+  int64 num_read = 0;
+  while (num_read < max_records) {
+    int64 n = ReadRecordsInBlock(max_records - num_read, records);
+    if (n == 0) {
+      records->emplace_back();
+      Status s = ReadOneRecord(&records->back());
+      if (!s.ok()) {
+        records->pop_back();
+        // Return the records read so far; the next call returns the error.
+        return num_read > 0 ? Status::OK() : s;
+      }
+      n = 1;
+    }
+    num_read += n;
+  }
+  return Status::OK();
+}
+
+Status ReadAheadRecordReader::ReadRecord(tstring* record) {
+  MaybeScheduleReads();
+  return ReadOneRecord(record);
+}
+
 }  // namespace io
 }  // namespace tensorflow
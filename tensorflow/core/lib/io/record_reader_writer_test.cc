@@ -26,6 +26,8 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 
@@ -328,4 +330,248 @@ TEST(RecordReaderWriterTest, TestUseAfterClose) {
   }
 }
 
+namespace {
+
+// Writes `num_records` records of varying sizes to `fname` and returns them.
+std::vector<string> WriteReadAheadTestFile(const string& fname,
+                                           int num_records) {
+  std::vector<string> records;
+  std::unique_ptr<WritableFile> file;
+  TF_CHECK_OK(Env::Default()->NewWritableFile(fname, &file));
+  io::RecordWriter writer(file.get());
+  for (int i = 0; i < num_records; ++i) {
+    // Sizes range from empty records to records spanning several blocks.
+    records.push_back(string((i * 997) % 10000, 'a' + i % 26));
+    TF_CHECK_OK(writer.WriteRecord(records.back()));
+  }
+  TF_CHECK_OK(writer.Close());
+  TF_CHECK_OK(file->Close());
+  return records;
+}
+
+}  // namespace
+
+TEST(RecordReaderWriterTest, TestReadAhead) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_read_ahead_test";
+  std::vector<string> records = WriteReadAheadTestFile(fname, 100);
+  thread::ThreadPool pool(env, "read_ahead", 4);
+
+  for (int64 max_reads_in_flight : {1, 2, 8}) {
+    for (int64 batch_size : {1, 7, 1000}) {
+      std::unique_ptr<RandomAccessFile> file;
+      TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+      io::ReadAheadRecordReader::Options options;
+      options.block_size = 4096;
+      options.max_reads_in_flight = max_reads_in_flight;
+      io::ReadAheadRecordReader reader(
+          file.get(), /*offset=*/0, options,
+          [&pool](std::function<void()> fn) { pool.Schedule(std::move(fn)); });
+
+      std::vector<tstring> read_records;
+      Status s;
+      while ((s = reader.ReadRecords(batch_size, &read_records)).ok()) {
+      }
+      EXPECT_EQ(s.code(), error::OUT_OF_RANGE);
+      ASSERT_EQ(read_records.size(), records.size());
+      for (size_t i = 0; i < records.size(); ++i) {
+        EXPECT_EQ(read_records[i], records[i]);
+      }
+      EXPECT_EQ(reader.TellOffset(), GetFileSize(fname));
+    }
+  }
+}
+
+TEST(RecordReaderWriterTest, TestReadAheadFromOffset) {
+  Env* env = Env::Default();
+  string fname =
+      testing::TmpDir() + "/record_reader_writer_read_ahead_offset_test";
+  std::vector<string> records = WriteReadAheadTestFile(fname, 20);
+  thread::ThreadPool pool(env, "read_ahead", 2);
+  auto schedule = [&pool](std::function<void()> fn) {
+    pool.Schedule(std::move(fn));
+  };
+  io::ReadAheadRecordReader::Options options;
+  options.block_size = 4096;
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+  uint64 offset;
+  {
+    io::ReadAheadRecordReader reader(file.get(), 0, options, schedule);
+    tstring record;
+    for (int i = 0; i < 11; ++i) {
+      TF_ASSERT_OK(reader.ReadRecord(&record));
+    }
+    offset = reader.TellOffset();
+  }
+  // Resume reading from the offset of the 12th record, which is not aligned.
+  io::ReadAheadRecordReader reader(file.get(), offset, options, schedule);
+  tstring record;
+  for (int i = 11; i < records.size(); ++i) {
+    TF_ASSERT_OK(reader.ReadRecord(&record));
+    EXPECT_EQ(record, records[i]);
+  }
+  EXPECT_EQ(reader.ReadRecord(&record).code(), error::OUT_OF_RANGE);
+}
+
+TEST(RecordReaderWriterTest, TestReadAheadTruncatedAndCorrupted) {
+  Env* env = Env::Default();
+  string fname =
+      testing::TmpDir() + "/record_reader_writer_read_ahead_corrupted_test";
+  WriteReadAheadTestFile(fname, 3);
+  string contents;
+  TF_CHECK_OK(ReadFileToString(env, fname, &contents));
+  thread::ThreadPool pool(env, "read_ahead", 2);
+  auto schedule = [&pool](std::function<void()> fn) {
+    pool.Schedule(std::move(fn));
+  };
+
+  // The first record is empty and the second one has 997 bytes.
+  const size_t second_record_offset = io::RecordReader::kHeaderSize +
+                                      io::RecordReader::kFooterSize;
+  {
+    // Truncate the second record.
+    TF_CHECK_OK(WriteStringToFile(
+        env, fname, contents.substr(0, second_record_offset + 100)));
+    std::unique_ptr<RandomAccessFile> file;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+    io::ReadAheadRecordReader reader(file.get(), 0, {}, schedule);
+    std::vector<tstring> records;
+    TF_EXPECT_OK(reader.ReadRecords(10, &records));
+    EXPECT_EQ(records.size(), 1);
+    EXPECT_EQ(reader.ReadRecords(10, &records).code(), error::DATA_LOSS);
+    EXPECT_EQ(reader.TellOffset(), second_record_offset);
+  }
+  {
+    // Flip a byte of the second record's data.
+    string corrupted = contents;
+    corrupted[second_record_offset + io::RecordReader::kHeaderSize] ^= 1;
+    TF_CHECK_OK(WriteStringToFile(env, fname, corrupted));
+    std::unique_ptr<RandomAccessFile> file;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+    io::ReadAheadRecordReader reader(file.get(), 0, {}, schedule);
+    tstring record;
+    TF_EXPECT_OK(reader.ReadRecord(&record));
+    Status s = reader.ReadRecord(&record);
+    EXPECT_EQ(s.code(), error::DATA_LOSS);
+    EXPECT_NE(s.error_message().find("corrupted record"), string::npos);
+  }
+  {
+    // Flip a byte of the second record's data while reading in batches, so
+    // that the corruption is found among the checksums verified together.
+    string corrupted = contents;
+    corrupted[second_record_offset + io::RecordReader::kHeaderSize] ^= 1;
+    TF_CHECK_OK(WriteStringToFile(env, fname, corrupted));
+    std::unique_ptr<RandomAccessFile> file;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+    io::ReadAheadRecordReader reader(file.get(), 0, {}, schedule);
+    std::vector<tstring> records;
+    TF_EXPECT_OK(reader.ReadRecords(10, &records));
+    EXPECT_EQ(records.size(), 1);
+    Status s = reader.ReadRecords(10, &records);
+    EXPECT_EQ(s.code(), error::DATA_LOSS);
+    EXPECT_NE(s.error_message().find("corrupted record"), string::npos);
+    EXPECT_EQ(reader.TellOffset(), second_record_offset);
+  }
+}
+
+TEST(RecordReaderWriterTest, TestReadAheadDirectIO) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_direct_io_test";
+  std::vector<string> records = WriteReadAheadTestFile(fname, 50);
+
+  std::unique_ptr<RandomAccessFile> file;
+  Status s = env->NewDirectRandomAccessFile(fname, &file);
+  if (errors::IsUnimplemented(s)) {
+    LOG(INFO) << "Skipping test: " << s;
+    return;
+  }
+  TF_ASSERT_OK(s);
+  thread::ThreadPool pool(env, "read_ahead", 4);
+  io::ReadAheadRecordReader reader(
+      file.get(), /*offset=*/0, {},
+      [&pool](std::function<void()> fn) { pool.Schedule(std::move(fn)); });
+  std::vector<tstring> read_records;
+  while (reader.ReadRecords(16, &read_records).ok()) {
+  }
+  ASSERT_EQ(read_records.size(), records.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    EXPECT_EQ(read_records[i], records[i]);
+  }
+
+  // Unaligned reads go through a bounce buffer.
+  StringPiece result;
+  char scratch[10];
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(env, fname, &contents));
+  TF_ASSERT_OK(file->Read(5000, sizeof(scratch), &result, scratch));
+  EXPECT_EQ(result, StringPiece(contents).substr(5000, sizeof(scratch)));
+}
+
+// Writes 64MB worth of records of `record_size` bytes, once per size.
+static string WriteBenchmarkFile(int record_size) {
+  string fname = strings::StrCat(testing::TmpDir(),
+                                 "/record_reader_benchmark_", record_size);
+  if (!Env::Default()->FileExists(fname).ok()) {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(Env::Default()->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    const string record(record_size, 'x');
+    for (int64 i = 0; i < (64 << 20) / (record_size + 16); ++i) {
+      TF_CHECK_OK(writer.WriteRecord(record));
+    }
+    TF_CHECK_OK(writer.Close());
+    TF_CHECK_OK(file->Close());
+  }
+  return fname;
+}
+
+// Reads the records one by one, checksumming each header and payload as it
+// is read.
+static void BM_SequentialRecordReader(int iters, int record_size) {
+  testing::StopTiming();
+  string fname = WriteBenchmarkFile(record_size);
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  int64 num_records = 0;
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    io::SequentialRecordReader reader(
+        file.get(), io::RecordReaderOptions::CreateRecordReaderOptions(""));
+    tstring record;
+    while (reader.ReadRecord(&record).ok()) {
+      ++num_records;
+    }
+  }
+  testing::ItemsProcessed(num_records);
+  testing::BytesProcessed(num_records * record_size);
+}
+BENCHMARK(BM_SequentialRecordReader)->Arg(16)->Arg(100)->Arg(1000)->Arg(10000);
+
+// Reads the records in batches, checksumming the runs of records within each
+// block together.
+static void BM_ReadAheadRecordReader(int iters, int record_size) {
+  testing::StopTiming();
+  string fname = WriteBenchmarkFile(record_size);
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  thread::ThreadPool pool(Env::Default(), "read_ahead", 4);
+  int64 num_records = 0;
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    io::ReadAheadRecordReader reader(
+        file.get(), /*offset=*/0, {},
+        [&pool](std::function<void()> fn) { pool.Schedule(std::move(fn)); });
+    std::vector<tstring> records;
+    while (reader.ReadRecords(64, &records).ok()) {
+      num_records += records.size();
+      records.clear();
+    }
+  }
+  testing::ItemsProcessed(num_records);
+  testing::BytesProcessed(num_records * record_size);
+}
+BENCHMARK(BM_ReadAheadRecordReader)->Arg(16)->Arg(100)->Arg(1000)->Arg(10000);
+
 }  // namespace tensorflow
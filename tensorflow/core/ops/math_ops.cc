@@ -981,6 +981,33 @@ _FusedConv2D output.
 expected to create these operators.
 )doc");
 
+REGISTER_OP("_FusedElementwise")
+    .Input("x: T")
+    .Input("args: num_args * T")
+    .Output("y: T")
+    .Attr("T: {float, double}")
+    .Attr("num_args: int >= 0")
+    .Attr("fused_ops: list(string)")
+    .SetShapeFn(shape_inference::UnchangedShape)
+    .Doc(R"doc(
+Performs a chain of elementwise operations in a single pass over memory.
+
+The chain is specified by the `fused_ops` attribute, which is a list of TF op
+names specified as strings (e.g. "Tanh"). They are performed in order, where the
+first input to each op is the output of the preceding op, and the first input to
+the first op is `x`. Each binary op takes its second input from the next element
+of `args`, which must either have the shape of `x` or be a scalar.
+
+Supported unary ops are {"Abs","Exp","Inv","Log","Neg","Reciprocal","Relu",
+"Rsqrt","Sigmoid","Sqrt","Square","Tanh"}, and supported binary ops are
+{"Add","AddV2","Div","Maximum","Minimum","Mul","RealDiv","SquaredDifference",
+"Sub"}.
+
+*NOTE*: Do not invoke this operator directly in Python. The graph optimizer is
+expected to create these operators when
+`OptimizerOptions.do_elementwise_fusion` is set.
+)doc");
+
 // --------------------------------------------------------------------------
 
 // For operations where the output is a reduction function along some
@@ -28,11 +28,14 @@ limitations under the License.
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include "tensorflow/core/platform/default/posix_file_system.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/error.h"
 #include "tensorflow/core/platform/file_system_helper.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
@@ -94,6 +97,95 @@ class PosixRandomAccessFile : public RandomAccessFile {
   }
 };
 
+#if defined(O_DIRECT)
+// pread() based random-access on a file opened with O_DIRECT. Reads whose
+// offset, size and destination are aligned to kDirectIOAlignment go straight
+// to the caller's buffer; other reads go through an aligned bounce buffer.
+class PosixDirectRandomAccessFile : public RandomAccessFile {
+ private:
+  static constexpr uint64 kAlignment = FileSystem::kDirectIOAlignment;
+
+  string filename_;
+  int fd_;
+
+  // Reads at most `n` bytes at `offset` into `dst`, all of which must be
+  // aligned. Stops early only at the end of the file.
+  Status ReadAligned(uint64 offset, size_t n, char* dst,
+                     size_t* bytes_read) const {
+    *bytes_read = 0;
+    while (n > 0) {
+      size_t requested_read_length = n > INT32_MAX ? INT32_MAX : n;
+      // Keep the length aligned when splitting a large read.
+      requested_read_length -= requested_read_length % kAlignment;
+      ssize_t r =
+          pread(fd_, dst, requested_read_length, static_cast<off_t>(offset));
+      if (r < 0) {
+        if (errno == EINTR || errno == EAGAIN) continue;
+        return IOError(filename_, errno);
+      }
+      *bytes_read += r;
+      if (static_cast<size_t>(r) < requested_read_length) {
+        // With O_DIRECT, short reads only happen at the end of the file.
+        break;
+      }
+      dst += r;
+      n -= r;
+      offset += r;
+    }
+    return Status::OK();
+  }
+
+ public:
+  PosixDirectRandomAccessFile(const string& fname, int fd)
+      : filename_(fname), fd_(fd) {}
+  ~PosixDirectRandomAccessFile() override {
+    if (close(fd_) < 0) {
+      LOG(ERROR) << "close() failed: " << strerror(errno);
+    }
+  }
+
+  Status Name(StringPiece* result) const override {
+    *result = filename_;
+    return Status::OK();
+  }
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    size_t bytes_read = 0;
+    if (offset % kAlignment == 0 && n % kAlignment == 0 &&
+        reinterpret_cast<uintptr_t>(scratch) % kAlignment == 0) {
+      TF_RETURN_IF_ERROR(ReadAligned(offset, n, scratch, &bytes_read));
+    } else {
+      const uint64 aligned_offset = offset - offset % kAlignment;
+      const uint64 aligned_end =
+          (offset + n + kAlignment - 1) / kAlignment * kAlignment;
+      const size_t aligned_size = aligned_end - aligned_offset;
+      char* buffer =
+          static_cast<char*>(port::AlignedMalloc(aligned_size, kAlignment));
+      if (buffer == nullptr) {
+        return errors::ResourceExhausted("Failed to allocate ", aligned_size,
+                                         " bytes to read ", filename_);
+      }
+      size_t aligned_bytes_read = 0;
+      Status s = ReadAligned(aligned_offset, aligned_size, buffer,
+                             &aligned_bytes_read);
+      const size_t skip = offset - aligned_offset;
+      if (s.ok() && aligned_bytes_read > skip) {
+        bytes_read = std::min<size_t>(n, aligned_bytes_read - skip);
+        memcpy(scratch, buffer + skip, bytes_read);
+      }
+      port::AlignedFree(buffer);
+      TF_RETURN_IF_ERROR(s);
+    }
+    *result = StringPiece(scratch, bytes_read);
+    if (bytes_read < n) {
+      return Status(error::OUT_OF_RANGE, "Read less bytes than requested");
+    }
+    return Status::OK();
+  }
+};
+#endif  // defined(O_DIRECT)
+
 class PosixWritableFile : public WritableFile {
  private:
   string filename_;
@@ -191,6 +283,27 @@ Status PosixFileSystem::NewRandomAccessFile(
   return s;
 }
 
+Status PosixFileSystem::NewDirectRandomAccessFile(
+    const string& fname, TransactionToken* token,
+    std::unique_ptr<RandomAccessFile>* result) {
+#if defined(O_DIRECT)
+  string translated_fname = TranslateName(fname);
+  int fd = open(translated_fname.c_str(), O_RDONLY | O_DIRECT);
+  if (fd < 0) {
+    if (errno == EINVAL) {
+      // The underlying file system (e.g. tmpfs) does not support O_DIRECT.
+      return errors::Unimplemented("Direct I/O is not supported for file ",
+                                   fname);
+    }
+    return IOError(fname, errno);
+  }
+  result->reset(new PosixDirectRandomAccessFile(translated_fname, fd));
+  return Status::OK();
+#else
+  return errors::Unimplemented("Direct I/O is not supported for file ", fname);
+#endif  // defined(O_DIRECT)
+}
+
 Status PosixFileSystem::NewWritableFile(const string& fname,
                                         TransactionToken* token,
                                         std::unique_ptr<WritableFile>* result) {
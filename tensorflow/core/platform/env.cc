@@ -159,6 +159,13 @@ Status Env::NewRandomAccessFile(const string& fname,
   return fs->NewRandomAccessFile(fname, result);
 }
 
+Status Env::NewDirectRandomAccessFile(
+    const string& fname, std::unique_ptr<RandomAccessFile>* result) {
+  FileSystem* fs;
+  TF_RETURN_IF_ERROR(GetFileSystemForFile(fname, &fs));
+  return fs->NewDirectRandomAccessFile(fname, result);
+}
+
 Status Env::NewReadOnlyMemoryRegionFromFile(
     const string& fname, std::unique_ptr<ReadOnlyMemoryRegion>* result) {
   FileSystem* fs;
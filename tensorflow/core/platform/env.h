@@ -111,6 +111,15 @@ class Env {
   Status NewRandomAccessFile(const std::string& fname,
                              std::unique_ptr<RandomAccessFile>* result);
 
+  /// \brief Creates a random access read-only file that bypasses the
+  /// operating system's page cache, if the file system of `fname` supports
+  /// direct I/O. See `FileSystem::NewDirectRandomAccessFile`.
+  ///
+  /// Returns UNIMPLEMENTED if direct I/O is not supported, in which case
+  /// callers should fall back to `NewRandomAccessFile`.
+  Status NewDirectRandomAccessFile(const std::string& fname,
+                                   std::unique_ptr<RandomAccessFile>* result);
+
   /// \brief Creates an object that writes to a new file with the specified
   /// name.
   ///
@@ -80,6 +80,35 @@ class FileSystem {
     return Status::OK();
   }
 
+  /// \brief Creates a random access read-only file that transfers data
+  /// directly between the storage device and the caller's buffer, bypassing
+  /// the operating system's page cache (e.g. `O_DIRECT`).
+  ///
+  /// Direct I/O is only efficient for large reads whose offset, size and
+  /// destination buffer are aligned to `kDirectIOAlignment` bytes. Other reads
+  /// are still served correctly, but may be slower than reads through a file
+  /// returned by `NewRandomAccessFile`.
+  ///
+  /// Returns UNIMPLEMENTED if the file system or the platform does not
+  /// support direct I/O.
+  ///
+  /// The returned file may be concurrently accessed by multiple threads.
+  virtual tensorflow::Status NewDirectRandomAccessFile(
+      const std::string& fname, std::unique_ptr<RandomAccessFile>* result) {
+    return NewDirectRandomAccessFile(fname, nullptr, result);
+  };
+
+  virtual tensorflow::Status NewDirectRandomAccessFile(
+      const std::string& fname, TransactionToken* token,
+      std::unique_ptr<RandomAccessFile>* result) {
+    return errors::Unimplemented("Direct I/O is not supported for file ",
+                                 fname);
+  }
+
+  /// Alignment, in bytes, of efficient reads from files returned by
+  /// `NewDirectRandomAccessFile`.
+  static constexpr size_t kDirectIOAlignment = 4096;
+
   /// \brief Creates an object that writes to a new file with the specified
   /// name.
   ///
@@ -528,6 +557,7 @@ class FileSystem {
 // TODO(sami): Remove this macro when filesystem plugins migration is complete.
 #define TF_USE_FILESYSTEM_METHODS_WITH_NO_TRANSACTION_SUPPORT \
   using FileSystem::NewRandomAccessFile;                      \
+  using FileSystem::NewDirectRandomAccessFile;                \
   using FileSystem::NewWritableFile;                          \
   using FileSystem::NewAppendableFile;                        \
   using FileSystem::NewReadOnlyMemoryRegionFromFile;          \
@@ -563,6 +593,13 @@ class WrappedFileSystem : public FileSystem {
     return fs_->NewRandomAccessFile(fname, (token ? token : token_), result);
   }
 
+  tensorflow::Status NewDirectRandomAccessFile(
+      const std::string& fname, TransactionToken* token,
+      std::unique_ptr<RandomAccessFile>* result) override {
+    return fs_->NewDirectRandomAccessFile(fname, (token ? token : token_),
+                                          result);
+  }
+
   tensorflow::Status NewWritableFile(
       const std::string& fname, TransactionToken* token,
       std::unique_ptr<WritableFile>* result) override {
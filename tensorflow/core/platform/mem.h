@@ -72,6 +72,10 @@ MemoryInfo GetMemoryInfo();
 // Returns the amount of RAM available in bytes, or INT64_MAX if unknown.
 static inline int64 AvailableRam() { return GetMemoryInfo().free; }
 
+// Returns the resident set size of the current process in bytes, or INT64_MAX
+// if unknown.
+int64 ResidentSetSize();
+
 }  // namespace port
 }  // namespace tensorflow
 
@@ -35,6 +35,11 @@ namespace port {
 // Snappy compression/decompression support
 bool Snappy_Compress(const char* input, size_t length, string* output);
 
+// Compresses the concatenation of the `iov_cnt` buffers in `iov` into
+// `*output`, without first copying them into a single buffer.
+bool Snappy_CompressFromIOVec(const struct iovec* iov, size_t iov_cnt,
+                              string* output);
+
 bool Snappy_GetUncompressedLength(const char* input, size_t length,
                                   size_t* result);
 bool Snappy_Uncompress(const char* input, size_t length, char* output);
@@ -136,6 +136,56 @@ void MallocExtension_ReleaseToSystem(std::size_t num_bytes) {
 
 std::size_t MallocExtension_GetAllocatedSize(const void* p) { return 0; }
 
+#ifdef TF_USE_SNAPPY
+namespace {
+
+// A snappy::Source that reads the concatenation of a list of buffers, so that
+// they can be compressed without first being copied into one buffer.
+class IOVecSource : public snappy::Source {
+ public:
+  IOVecSource(const struct iovec* iov, size_t iov_cnt, size_t length)
+      : iov_(iov), iov_cnt_(iov_cnt), available_(length) {}
+
+  size_t Available() const override { return available_; }
+
+  const char* Peek(size_t* len) override {
+    while (index_ < iov_cnt_ && offset_ == iov_[index_].iov_len) {
+      ++index_;
+      offset_ = 0;
+    }
+    if (index_ == iov_cnt_) {
+      *len = 0;
+      return nullptr;
+    }
+    *len = iov_[index_].iov_len - offset_;
+    return static_cast<const char*>(iov_[index_].iov_base) + offset_;
+  }
+
+  void Skip(size_t n) override {
+    available_ -= n;
+    while (n > 0) {
+      const size_t left = iov_[index_].iov_len - offset_;
+      if (n < left) {
+        offset_ += n;
+        return;
+      }
+      n -= left;
+      ++index_;
+      offset_ = 0;
+    }
+  }
+
+ private:
+  const struct iovec* const iov_;
+  const size_t iov_cnt_;
+  size_t available_;
+  size_t index_ = 0;
+  size_t offset_ = 0;
+};
+
+}  // namespace
+#endif  // TF_USE_SNAPPY
+
 bool Snappy_Compress(const char* input, size_t length, string* output) {
 #ifdef TF_USE_SNAPPY
   output->resize(snappy::MaxCompressedLength(length));
@@ -148,6 +198,23 @@ bool Snappy_Compress(const char* input, size_t length, string* output) {
 #endif
 }
 
+bool Snappy_CompressFromIOVec(const struct iovec* iov, size_t iov_cnt,
+                              string* output) {
+#ifdef TF_USE_SNAPPY
+  size_t length = 0;
+  for (size_t i = 0; i < iov_cnt; ++i) {
+    length += iov[i].iov_len;
+  }
+  IOVecSource source(iov, iov_cnt, length);
+  output->resize(snappy::MaxCompressedLength(length));
+  snappy::UncheckedByteArraySink sink(&(*output)[0]);
+  output->resize(snappy::Compress(&source, &sink));
+  return true;
+#else
+  return false;
+#endif
+}
+
 bool Snappy_GetUncompressedLength(const char* input, size_t length,
                                   size_t* result) {
 #ifdef TF_USE_SNAPPY
@@ -202,6 +269,11 @@ MemoryInfo GetMemoryInfo() {
   return mem_info;
 }
 
+int64 ResidentSetSize() {
+  // Not available: `GetProcessMemoryInfo` would require linking psapi.
+  return INT64_MAX;
+}
+
 int NumHyperthreadsPerCore() {
   static const int ht_per_core = tensorflow::port::CPUIDNumSMT();
   return (ht_per_core > 0) ? ht_per_core : 1;
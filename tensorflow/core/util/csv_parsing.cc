@@ -0,0 +1,228 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/csv_parsing.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/numbers.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace tensorflow {
+namespace csv {
+namespace {
+
+constexpr size_t kBlockSize = 64;
+
+// The largest integers that are exactly representable as floats and doubles.
+constexpr uint64 kMaxExactFloatMantissa = uint64{1} << 24;
+constexpr uint64 kMaxExactDoubleMantissa = uint64{1} << 53;
+
+// The powers of ten that are exactly representable as floats and doubles.
+constexpr float kExactFloatPowersOfTen[] = {1e0f, 1e1f, 1e2f, 1e3f,
+                                            1e4f, 1e5f, 1e6f, 1e7f,
+                                            1e8f, 1e9f, 1e10f};
+constexpr double kExactDoublePowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+inline int CountTrailingZeros(uint64 x) {
+#ifdef __GNUC__
+  return __builtin_ctzll(x);
+#else
+  int n = 0;
+  while ((x & 1) == 0) {
+    x >>= 1;
+    ++n;
+  }
+  return n;
+#endif
+}
+
+inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Parses `field` if it is an integer of the form `-?[0-9]+` with at most
+// `max_digits` digits.
+bool ParseShortInteger(StringPiece field, int max_digits, int64* value) {
+  const char* p = field.data();
+  const char* const end = p + field.size();
+  const bool negative = p != end && *p == '-';
+  if (negative) {
+    ++p;
+  }
+  if (p == end || end - p > max_digits) {
+    return false;
+  }
+  int64 result = 0;
+  for (; p != end; ++p) {
+    if (!IsDigit(*p)) {
+      return false;
+    }
+    result = result * 10 + (*p - '0');
+  }
+  *value = negative ? -result : result;
+  return true;
+}
+
+// Parses `field` if it is a decimal number of the form
+// `-?[0-9]+(\.[0-9]+)?` with at most 19 digits, as `mantissa * 10^exponent`.
+bool ParseShortDecimal(StringPiece field, bool* negative, uint64* mantissa,
+                       int* exponent) {
+  constexpr int kMaxDigits = 19;
+  const char* p = field.data();
+  const char* const end = p + field.size();
+  *negative = p != end && *p == '-';
+  if (*negative) {
+    ++p;
+  }
+  uint64 result = 0;
+  int num_digits = 0;
+  const char* const integer_start = p;
+  for (; p != end && IsDigit(*p); ++p) {
+    if (++num_digits > kMaxDigits) {
+      return false;
+    }
+    result = result * 10 + (*p - '0');
+  }
+  if (p == integer_start) {
+    return false;
+  }
+  *exponent = 0;
+  if (p != end) {
+    if (*p != '.') {
+      return false;
+    }
+    ++p;
+    const char* const fraction_start = p;
+    for (; p != end && IsDigit(*p); ++p) {
+      if (++num_digits > kMaxDigits) {
+        return false;
+      }
+      result = result * 10 + (*p - '0');
+      --*exponent;
+    }
+    if (p == fraction_start || p != end) {
+      return false;
+    }
+  }
+  *mantissa = result;
+  return true;
+}
+
+}  // namespace
+
+StructuralScanner::StructuralScanner(char delim, bool use_quote_delim)
+    : delim_(delim), quote_(use_quote_delim ? '"' : delim) {}
+
+size_t StructuralScanner::Find(StringPiece data, size_t pos) {
+  const char* p = data.data() + pos;
+  const char* const end = data.data() + data.size();
+  while (p < end) {
+    if (p < block_ || p >= block_ + block_size_) {
+      block_ = p;
+      block_size_ = std::min<size_t>(kBlockSize, end - p);
+      bitmap_ = Classify(block_, block_size_);
+    }
+    const uint64 bitmap = bitmap_ & (~uint64{0} << (p - block_));
+    if (bitmap != 0) {
+      // The cached block may extend past the end of `data`.
+      const size_t index = block_ + CountTrailingZeros(bitmap) - data.data();
+      return std::min(index, data.size());
+    }
+    p = block_ + block_size_;
+  }
+  return data.size();
+}
+
+uint64 StructuralScanner::Classify(const char* data, size_t size) const {
+  uint64 bitmap = 0;
+  size_t i = 0;
+#ifdef __SSE2__
+  const __m128i delim = _mm_set1_epi8(delim_);
+  const __m128i quote = _mm_set1_epi8(quote_);
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i carriage_return = _mm_set1_epi8('\r');
+  for (; i + 16 <= size; i += 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i matches = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, delim),
+                     _mm_cmpeq_epi8(chunk, quote)),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, newline),
+                     _mm_cmpeq_epi8(chunk, carriage_return)));
+    const uint32 mask = _mm_movemask_epi8(matches);
+    bitmap |= static_cast<uint64>(mask) << i;
+  }
+#endif
+  for (; i < size; ++i) {
+    const char c = data[i];
+    if (c == delim_ || c == quote_ || c == '\n' || c == '\r') {
+      bitmap |= uint64{1} << i;
+    }
+  }
+  return bitmap;
+}
+
+bool ParseInt32(StringPiece field, int32* value) {
+  int64 result;
+  if (ParseShortInteger(field, /*max_digits=*/9, &result)) {
+    *value = static_cast<int32>(result);
+    return true;
+  }
+  return strings::safe_strto32(field, value);
+}
+
+bool ParseInt64(StringPiece field, int64* value) {
+  if (ParseShortInteger(field, /*max_digits=*/18, value)) {
+    return true;
+  }
+  return strings::safe_strto64(field, value);
+}
+
+bool ParseFloat(StringPiece field, float* value) {
+  // If the mantissa and the power of ten are exactly representable, a single
+  // correctly rounded division yields the correctly rounded result.
+  bool negative;
+  uint64 mantissa;
+  int exponent;
+  if (ParseShortDecimal(field, &negative, &mantissa, &exponent) &&
+      mantissa <= kMaxExactFloatMantissa && exponent >= -10) {
+    const float result = static_cast<float>(mantissa) /
+                         kExactFloatPowersOfTen[-exponent];
+    *value = negative ? -result : result;
+    return true;
+  }
+  return strings::safe_strtof(field, value);
+}
+
+bool ParseDouble(StringPiece field, double* value) {
+  bool negative;
+  uint64 mantissa;
+  int exponent;
+  if (ParseShortDecimal(field, &negative, &mantissa, &exponent) &&
+      mantissa <= kMaxExactDoubleMantissa && exponent >= -22) {
+    const double result = static_cast<double>(mantissa) /
+                          kExactDoublePowersOfTen[-exponent];
+    *value = negative ? -result : result;
+    return true;
+  }
+  return strings::safe_strtod(field, value);
+}
+
+}  // namespace csv
+}  // namespace tensorflow
@@ -0,0 +1,80 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_UTIL_CSV_PARSING_H_
+#define TENSORFLOW_CORE_UTIL_CSV_PARSING_H_
+
+#include "tensorflow/core/platform/stringpiece.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace csv {
+
+// Finds the structural characters of CSV data: the field delimiter, line
+// breaks and, if quoting is enabled, quotation marks.
+//
+// The scanner classifies the data 64 bytes at a time into a bitmap of
+// structural characters (using SSE2 where available), and answers subsequent
+// queries within the same 64 bytes from the bitmap. Fields of typical CSV data
+// are much shorter than 64 bytes, so most queries do not touch the data.
+//
+// Note: this class is not thread safe; external synchronization required.
+class StructuralScanner {
+ public:
+  StructuralScanner(char delim, bool use_quote_delim);
+
+  // Returns the index of the first structural character of `data` at or after
+  // `pos`, or `data.size()` if there is none.
+  //
+  // Consecutive calls may reuse the classification of the previous call if
+  // `data` refers to the same memory, so `Reset()` must be called whenever
+  // the contents of that memory change.
+  size_t Find(StringPiece data, size_t pos);
+
+  // Discards the cached classification.
+  void Reset() {
+    block_ = nullptr;
+    block_size_ = 0;
+    bitmap_ = 0;
+  }
+
+ private:
+  // Returns the bitmap of the structural characters among the `size` <= 64
+  // bytes starting at `data`.
+  uint64 Classify(const char* data, size_t size) const;
+
+  const char delim_;
+  // The quotation mark if quoting is enabled, and `delim_` otherwise, so that
+  // the classification does not depend on whether quoting is enabled.
+  const char quote_;
+  // The most recently classified bytes and their bitmap.
+  const char* block_ = nullptr;
+  size_t block_size_ = 0;
+  uint64 bitmap_ = 0;
+};
+
+// Convert CSV fields to numbers. These accept the same inputs and produce the
+// same values as the corresponding `strings::safe_strto*` functions, but
+// convert short decimal numbers without exponents, which make up most numeric
+// CSV data, without the general-purpose conversion.
+bool ParseInt32(StringPiece field, int32* value);
+bool ParseInt64(StringPiece field, int64* value);
+bool ParseFloat(StringPiece field, float* value);
+bool ParseDouble(StringPiece field, double* value);
+
+}  // namespace csv
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_CSV_PARSING_H_
@@ -0,0 +1,213 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/csv_parsing.h"
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/numbers.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace csv {
+namespace {
+
+std::vector<size_t> FindAll(StructuralScanner* scanner, StringPiece data) {
+  std::vector<size_t> positions;
+  size_t pos = scanner->Find(data, 0);
+  while (pos < data.size()) {
+    positions.push_back(pos);
+    pos = scanner->Find(data, pos + 1);
+  }
+  return positions;
+}
+
+std::vector<size_t> FindAllSlow(StringPiece data, char delim,
+                                bool use_quote_delim) {
+  std::vector<size_t> positions;
+  for (size_t i = 0; i < data.size(); ++i) {
+    if (data[i] == delim || data[i] == '\n' || data[i] == '\r' ||
+        (use_quote_delim && data[i] == '"')) {
+      positions.push_back(i);
+    }
+  }
+  return positions;
+}
+
+TEST(StructuralScannerTest, FindsStructuralCharacters) {
+  const string data =
+      "abc,\"d,e\"\"f\",123456789012345678901234567890123456789012345678901234"
+      "567890,x\r\ny;z\n";
+  for (bool use_quote_delim : {false, true}) {
+    for (char delim : {',', ';'}) {
+      StructuralScanner scanner(delim, use_quote_delim);
+      EXPECT_EQ(FindAll(&scanner, data),
+                FindAllSlow(data, delim, use_quote_delim));
+    }
+  }
+}
+
+TEST(StructuralScannerTest, RandomData) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  const char kAlphabet[] = "ab,\"\r\n";
+  for (int i = 0; i < 100; ++i) {
+    string data(rnd.Uniform(300), ' ');
+    for (char& c : data) {
+      c = kAlphabet[rnd.Uniform(sizeof(kAlphabet) - 1)];
+    }
+    StructuralScanner scanner(',', /*use_quote_delim=*/true);
+    EXPECT_EQ(FindAll(&scanner, data), FindAllSlow(data, ',', true));
+  }
+}
+
+TEST(StructuralScannerTest, Reset) {
+  string data(100, 'a');
+  StructuralScanner scanner(',', /*use_quote_delim=*/true);
+  EXPECT_EQ(scanner.Find(data, 0), data.size());
+  // Changing the data in place requires a reset.
+  data[55] = ',';
+  data[70] = ',';
+  scanner.Reset();
+  EXPECT_EQ(scanner.Find(data, 0), size_t{55});
+  // Queries on a prefix of the classified data ignore structural characters
+  // past its end.
+  EXPECT_EQ(scanner.Find(StringPiece(data).substr(0, 50), 0), size_t{50});
+  EXPECT_EQ(scanner.Find(data, 56), size_t{70});
+}
+
+TEST(CsvParsingTest, ParseIntegers) {
+  for (StringPiece field :
+       {"0", "-0", "7", "-123456789", "123456789", "2147483647", "-2147483648",
+        "2147483648", "9223372036854775807", "-9223372036854775808",
+        "9223372036854775808", " 12", "12 ", "+1", "1.5", "", "-", "0x10"}) {
+    int32 value32 = 0, expected32 = 0;
+    EXPECT_EQ(ParseInt32(field, &value32),
+              strings::safe_strto32(field, &expected32))
+        << field;
+    EXPECT_EQ(value32, expected32) << field;
+    int64 value64 = 0, expected64 = 0;
+    EXPECT_EQ(ParseInt64(field, &value64),
+              strings::safe_strto64(field, &expected64))
+        << field;
+    EXPECT_EQ(value64, expected64) << field;
+  }
+}
+
+TEST(CsvParsingTest, ParseFloatingPoint) {
+  for (StringPiece field :
+       {"0", "-0", "0.0", "1.5", "-1.5", "0.1", "0.3", "3.14159", "16777216",
+        "16777217", "0.0000000001", "0.00000000001", "123456.789",
+        "9007199254740993", "1e10", "1.", ".5", "nan", "-inf", " 1.5", "1.5 ",
+        "1.2.3", "", "-", "abc", "0.12345678901234567890"}) {
+    float value = 0, expected = 0;
+    EXPECT_EQ(ParseFloat(field, &value), strings::safe_strtof(field, &expected))
+        << field;
+    if (!std::isnan(expected)) {
+      EXPECT_EQ(value, expected) << field;
+      EXPECT_EQ(std::signbit(value), std::signbit(expected)) << field;
+    }
+    double double_value = 0, double_expected = 0;
+    EXPECT_EQ(ParseDouble(field, &double_value),
+              strings::safe_strtod(field, &double_expected))
+        << field;
+    if (!std::isnan(double_expected)) {
+      EXPECT_EQ(double_value, double_expected) << field;
+    }
+  }
+}
+
+TEST(CsvParsingTest, ParseRandomDecimals) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  for (int i = 0; i < 100000; ++i) {
+    string field = rnd.OneIn(2) ? "-" : "";
+    for (int j = 0, n = 1 + rnd.Uniform(8); j < n; ++j) {
+      field += static_cast<char>('0' + rnd.Uniform(10));
+    }
+    if (rnd.OneIn(4)) {
+      field += '.';
+      for (int j = 0, n = 1 + rnd.Uniform(10); j < n; ++j) {
+        field += static_cast<char>('0' + rnd.Uniform(10));
+      }
+    }
+    float value, expected;
+    ASSERT_TRUE(ParseFloat(field, &value));
+    ASSERT_TRUE(strings::safe_strtof(field, &expected));
+    EXPECT_EQ(value, expected) << field;
+    double double_value, double_expected;
+    ASSERT_TRUE(ParseDouble(field, &double_value));
+    ASSERT_TRUE(strings::safe_strtod(field, &double_expected));
+    EXPECT_EQ(double_value, double_expected) << field;
+  }
+}
+
+static void BM_ScanRecords(int iters, int use_scanner) {
+  string data;
+  while (data.size() < (1 << 20)) {
+    data += "0.125,1234,abcdef,0.5,-17,123.456,1,0,0.0001,9999\n";
+  }
+  testing::BytesProcessed(static_cast<int64>(iters) * data.size());
+  testing::SetLabel(use_scanner ? "scanner" : "byte_by_byte");
+  StructuralScanner scanner(',', /*use_quote_delim=*/true);
+  int64 num_fields = 0;
+  while (--iters > 0) {
+    scanner.Reset();
+    size_t pos = 0;
+    while (pos < data.size()) {
+      if (use_scanner) {
+        pos = scanner.Find(data, pos) + 1;
+      } else {
+        while (pos < data.size() && data[pos] != ',' && data[pos] != '"' &&
+               data[pos] != '\n' && data[pos] != '\r') {
+          ++pos;
+        }
+        ++pos;
+      }
+      ++num_fields;
+    }
+  }
+  testing::DoNotOptimize(num_fields);
+}
+BENCHMARK(BM_ScanRecords)->Arg(0)->Arg(1);
+
+static void BM_ParseFloat(int iters, int use_fast_path) {
+  const std::vector<string> fields = {"0.125", "1234", "0.5", "-17",
+                                      "123.456", "1", "0", "0.0001"};
+  testing::ItemsProcessed(static_cast<int64>(iters) * fields.size());
+  testing::SetLabel(use_fast_path ? "fast_path" : "safe_strtof");
+  float sum = 0;
+  while (--iters > 0) {
+    for (const string& field : fields) {
+      float value;
+      if (use_fast_path) {
+        ParseFloat(field, &value);
+      } else {
+        strings::safe_strtof(field, &value);
+      }
+      sum += value;
+    }
+  }
+  testing::DoNotOptimize(sum);
+}
+BENCHMARK(BM_ParseFloat)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace csv
+}  // namespace tensorflow
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
+#include <bitset>
+#include <cstring>
 #include <vector>
 
 #include "absl/base/casts.h"
@@ -36,6 +38,10 @@ limitations under the License.
 #include "tensorflow/core/util/presized_cuckoo_map.h"
 #include "tensorflow/core/util/sparse/sparse_tensor.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace tensorflow {
 namespace example {
 
@@ -113,6 +119,144 @@ constexpr uint8 kVarintTag(uint32 tag) { return (tag << 3) | 0; }
 constexpr uint8 kDelimitedTag(uint32 tag) { return (tag << 3) | 2; }
 constexpr uint8 kFixed32Tag(uint32 tag) { return (tag << 3) | 5; }
 
+bool ParseString(protobuf::io::CodedInputStream* stream, StringPiece* result) {
+  DCHECK(stream != nullptr);
+  DCHECK(result != nullptr);
+  uint32 length;
+  if (!stream->ReadVarint32(&length)) return false;
+  if (length == 0) {
+    *result = StringPiece(nullptr, 0);
+    return true;
+  }
+  const void* stream_alias;
+  int stream_size;
+  if (!stream->GetDirectBufferPointer(&stream_alias, &stream_size)) {
+    return false;
+  }
+  if (static_cast<uint32>(stream_size) < length) return false;
+  *result = StringPiece(static_cast<const char*>(stream_alias), length);
+  stream->Skip(length);
+  return true;
+}
+
+// The high bit of every byte of a 64-bit word.
+constexpr uint64 kVarintContinuationBits = 0x8080808080808080ULL;
+
+inline int CountTrailingZeros(uint64 x) {
+#ifdef __GNUC__
+  return __builtin_ctzll(x);
+#else
+  int n = 0;
+  while ((x & 1) == 0) {
+    x >>= 1;
+    ++n;
+  }
+  return n;
+#endif
+}
+
+// Returns the number of varints in the packed varints [begin, end), i.e. the
+// number of bytes without the continuation bit.
+size_t CountVarints(const uint8* begin, const uint8* end) {
+  size_t count = 0;
+  const uint8* p = begin;
+#ifdef __SSE2__
+  for (; end - p >= 16; p += 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    count += 16 - std::bitset<16>(_mm_movemask_epi8(chunk)).count();
+  }
+#endif
+  for (; p != end; ++p) {
+    count += *p < 0x80;
+  }
+  return count;
+}
+
+// Decodes the varint of at most 10 bytes at `*p` and advances `*p` past it.
+inline bool DecodeVarint(const uint8** p, const uint8* end, uint64* value) {
+  uint64 result = 0;
+  const uint8* q = *p;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (q == end) return false;
+    const uint8 byte = *q++;
+    result |= static_cast<uint64>(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      *p = q;
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns the value of a varint of at most 8 bytes, loaded little endian into
+// `word` with the bytes past its end cleared, by compacting its 7-bit groups.
+inline uint64 CompactVarint(uint64 word) {
+  word &= ~kVarintContinuationBits;
+  word = (word & 0x007f007f007f007fULL) | ((word & 0x7f007f007f007f00ULL) >> 1);
+  word = (word & 0x00003fff00003fffULL) | ((word & 0x3fff00003fff0000ULL) >> 2);
+  word = (word & 0x000000000fffffffULL) | ((word & 0x0fffffff00000000ULL) >> 4);
+  return word;
+}
+
+// Decodes the packed varints [begin, end) and stores the first `capacity` of
+// them at `out`. Returns false if the data is not a sequence of valid varints.
+//
+// Runs of single-byte varints, which make up most ids and counts, are decoded
+// 16 (with SSE2) or 8 at a time, and varints of up to 8 bytes are decoded from
+// a single 64-bit load without a loop over their bytes.
+bool DecodeVarints(const uint8* begin, const uint8* end, size_t capacity,
+                   int64* out) {
+  int64* const out_end = out + capacity;
+  const uint8* p = begin;
+  while (p != end) {
+#ifdef __SSE2__
+    if (end - p >= 16 && out_end - out >= 16) {
+      const __m128i chunk =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      if (_mm_movemask_epi8(chunk) == 0) {
+        for (int i = 0; i < 16; ++i) {
+          out[i] = p[i];
+        }
+        p += 16;
+        out += 16;
+        continue;
+      }
+    }
+#endif
+    if (port::kLittleEndian && end - p >= 8 && out != out_end) {
+      uint64 word;
+      std::memcpy(&word, p, sizeof(word));
+      const uint64 stops = ~word & kVarintContinuationBits;
+      if (stops == kVarintContinuationBits && out_end - out >= 8) {
+        for (int i = 0; i < 8; ++i) {
+          out[i] = p[i];
+        }
+        p += 8;
+        out += 8;
+        continue;
+      }
+      if (stops != 0) {
+        // The varint ends within the word.
+        const int length = CountTrailingZeros(stops) / 8 + 1;
+        if (length < 8) {
+          word &= (uint64{1} << (8 * length)) - 1;
+        }
+        *out++ = static_cast<int64>(CompactVarint(word));
+        p += length;
+        continue;
+      }
+    }
+    uint64 value;
+    if (!DecodeVarint(&p, end, &value)) return false;
+    if (out != out_end) {
+      *out++ = static_cast<int64>(value);
+    }
+  }
+  return true;
+}
+
 namespace parsed {
 
 // ParseDataType has to be called first, then appropriate ParseZzzzList.
@@ -166,6 +310,56 @@ class Feature {
     return true;
   }
 
+  bool GetNumElementsInFloatList(int* num_elements) {
+    protobuf::io::CodedInputStream stream(
+        reinterpret_cast<const uint8*>(serialized_.data()), serialized_.size());
+    EnableAliasing(&stream);
+    uint32 length = 0;
+    if (!stream.ReadVarint32(&length)) return false;
+    auto limit = stream.PushLimit(length);
+    *num_elements = 0;
+    if (!stream.ExpectAtEnd()) {
+      // Matches the number of elements that ParseFloatList() produces.
+      constexpr int32 kNumFloatBytes = 4;
+      if (stream.ExpectTag(kDelimitedTag(1))) {  // packed
+        uint32 packed_length;
+        if (!stream.ReadVarint32(&packed_length)) return false;
+        *num_elements = packed_length / kNumFloatBytes;
+      } else {  // non-packed
+        *num_elements = stream.BytesUntilLimit() / (1 + kNumFloatBytes);
+      }
+    }
+    stream.PopLimit(limit);
+    return true;
+  }
+
+  bool GetNumElementsInInt64List(int* num_elements) {
+    protobuf::io::CodedInputStream stream(
+        reinterpret_cast<const uint8*>(serialized_.data()), serialized_.size());
+    EnableAliasing(&stream);
+    uint32 length = 0;
+    if (!stream.ReadVarint32(&length)) return false;
+    auto limit = stream.PushLimit(length);
+    *num_elements = 0;
+    if (!stream.ExpectAtEnd()) {
+      if (stream.ExpectTag(kDelimitedTag(1))) {  // packed
+        StringPiece packed;
+        if (!ParseString(&stream, &packed)) return false;
+        const uint8* begin = reinterpret_cast<const uint8*>(packed.data());
+        *num_elements = CountVarints(begin, begin + packed.size());
+      } else {  // non-packed
+        while (!stream.ExpectAtEnd()) {
+          if (!stream.ExpectTag(kVarintTag(1))) return false;
+          protobuf_uint64 n;  // There is no API for int64
+          if (!stream.ReadVarint64(&n)) return false;
+          ++*num_elements;
+        }
+      }
+    }
+    stream.PopLimit(limit);
+    return true;
+  }
+
   // Helper methods
   tstring& construct_at_end(LimitedArraySlice<tstring>* bytes_list) {
     return bytes_list->construct_at_end();
@@ -293,17 +487,22 @@ class Feature {
       }
       if (peek_tag == kDelimitedTag(1)) {                       // packed
         if (!stream.ExpectTag(kDelimitedTag(1))) return false;  // packed tag
-        uint32 packed_length;
-        if (!stream.ReadVarint32(&packed_length)) return false;
-        auto packed_limit = stream.PushLimit(packed_length);
-
-        while (!stream.ExpectAtEnd()) {
-          protobuf_uint64 n;  // There is no API for int64
-          if (!stream.ReadVarint64(&n)) return false;
-          int64_list->push_back(static_cast<int64>(n));
+        StringPiece packed;
+        if (!ParseString(&stream, &packed)) return false;
+        const uint8* begin = reinterpret_cast<const uint8*>(packed.data());
+        const uint8* end = begin + packed.size();
+
+        // Resize the output "vector" once and decode the varints straight into
+        // it, instead of pushing them back one at a time.
+        const size_t initial_size = int64_list->size();
+        int64_list->resize(initial_size + CountVarints(begin, end));
+        // The buffer available can be less than what we requested in resize in
+        // case of a LimitedArraySlice.
+        const size_t capacity = int64_list->size() - initial_size;
+        if (!DecodeVarints(begin, end, capacity,
+                           int64_list->data() + initial_size)) {
+          return false;
         }
-
-        stream.PopLimit(packed_limit);
       } else {  // non-packed
         while (!stream.ExpectAtEnd()) {
           if (!stream.ExpectTag(kVarintTag(1))) return false;
@@ -354,26 +553,6 @@ inline bool SkipExtraneousTag(protobuf::io::CodedInputStream* stream) {
   return false;  // unrecognized tag type
 }
 
-bool ParseString(protobuf::io::CodedInputStream* stream, StringPiece* result) {
-  DCHECK(stream != nullptr);
-  DCHECK(result != nullptr);
-  uint32 length;
-  if (!stream->ReadVarint32(&length)) return false;
-  if (length == 0) {
-    *result = StringPiece(nullptr, 0);
-    return true;
-  }
-  const void* stream_alias;
-  int stream_size;
-  if (!stream->GetDirectBufferPointer(&stream_alias, &stream_size)) {
-    return false;
-  }
-  if (static_cast<uint32>(stream_size) < length) return false;
-  *result = StringPiece(static_cast<const char*>(stream_alias), length);
-  stream->Skip(length);
-  return true;
-}
-
 bool ParseFeatureMapEntry(protobuf::io::CodedInputStream* stream,
                           parsed::FeatureMapEntry* feature_map_entry) {
   DCHECK(stream != nullptr);
@@ -521,18 +700,18 @@ void ParallelFor(const std::function<void(size_t)>& f, size_t n,
 // and relies on the fact that they are default-initialized to Dense.
 enum class Type { Dense, Sparse, Ragged };
 
-// Note: We use SparseBuffer for sparse, ragged, and dense_varlen features.
-struct SparseBuffer {
-  // Features are in one of the 3 vectors below depending on config's dtype.
-  // Other 2 vectors remain empty.
-  SmallVector<tstring> bytes_list;
-  SmallVector<float> float_list;
-  SmallVector<int64> int64_list;
-
-  // Features of example i are elements with indices
-  // from example_end_indices[i-1] to example_end_indices[i]-1 on the
-  // appropriate xxxxx_list
-  std::vector<size_t> example_end_indices;
+// Note: We use SparseFeatureValues for sparse, ragged, and dense_varlen
+// features. FastParseExample() locates and counts their values in a first
+// pass, sizes the output tensors, and then parses the values straight into
+// them in a second pass.
+struct SparseFeatureValues {
+  // The feature after its data type has been parsed, or an empty feature if
+  // the example does not have it.
+  parsed::Feature feature;
+  // The number of values of the feature.
+  size_t num_values = 0;
+  // The index of the first value of the feature in the output values.
+  size_t offset = 0;
 };
 
 struct SeededHasher {
@@ -564,14 +743,31 @@ void LogSparseFeatureDataLoss(StringPiece feature_name) {
   duplicated_sparse_feature->GetCell()->IncrementBy(1);
 }
 
+// Returns the number of values of `feature`, whose data type `dtype` has
+// already been parsed.
+bool GetNumElementsInList(DataType dtype, parsed::Feature* feature,
+                          int* num_elements) {
+  switch (dtype) {
+    case DT_INT64:
+      return feature->GetNumElementsInInt64List(num_elements);
+    case DT_FLOAT:
+      return feature->GetNumElementsInFloatList(num_elements);
+    case DT_STRING:
+      return feature->GetNumElementsInBytesList(num_elements);
+    default:
+      LOG(FATAL) << "Should not happen.";
+      return false;
+  }
+}
+
 Status FastParseSerializedExample(
     const tstring& serialized_example, const tstring& example_name,
     const size_t example_index, const Config& config,
     const PresizedCuckooMap<std::pair<size_t, Type>>& config_index,
     SeededHasher hasher, std::vector<Tensor>* output_dense,
-    std::vector<SparseBuffer>* output_varlen_dense,
-    std::vector<SparseBuffer>* output_sparse,
-    std::vector<SparseBuffer>* output_ragged,
+    std::vector<std::vector<SparseFeatureValues>>* output_varlen_dense,
+    std::vector<std::vector<SparseFeatureValues>>* output_sparse,
+    std::vector<std::vector<SparseFeatureValues>>* output_ragged,
     PerExampleFeatureStats* output_stats) {
   DCHECK(output_dense != nullptr);
   DCHECK(output_sparse != nullptr);
@@ -706,81 +902,33 @@ Status FastParseSerializedExample(
             LOG(FATAL) << "Should not happen.";
         }
       } else {  // if variable length
-        SparseBuffer& out = (*output_varlen_dense)[d];
+        SparseFeatureValues& out = (*output_varlen_dense)[d][example_index];
 
         const std::size_t num_elements = config.dense[d].elements_per_stride;
 
-        if (example_dtype != DT_INVALID &&
-            example_dtype != config.dense[d].dtype) {
-          return example_error(strings::StrCat(
-              "Data types don't match. ",
-              "Expected type: ", DataTypeString(config.dense[d].dtype)));
+        int num_values;
+        if (!GetNumElementsInList(config.dense[d].dtype, &feature,
+                                  &num_values)) {
+          return parse_error();
         }
-
-        auto shape_error = [&](size_t size, StringPiece type_str) {
+        if (num_values % num_elements != 0) {
+          const DataType dtype = config.dense[d].dtype;
+          const string type_str =
+              dtype == DT_STRING ? "bytes" : DataTypeString(dtype);
           return example_error(strings::StrCat(
               "Number of ", type_str,
-              " values is not a multiple of stride length. Saw ", size,
+              " values is not a multiple of stride length. Saw ", num_values,
               " values but output shape is: ",
               config.dense[d].shape.DebugString()));
-        };
-
-        switch (config.dense[d].dtype) {
-          case DT_INT64: {
-            if (example_dtype != DT_INVALID) {
-              if (!feature.ParseInt64List(&out.int64_list)) {
-                return parse_error();
-              }
-              if (out.int64_list.size() % num_elements != 0) {
-                return shape_error(out.int64_list.size(), "int64");
-              }
-            }
-            out.example_end_indices.push_back(out.int64_list.size());
-            break;
-          }
-          case DT_FLOAT: {
-            if (example_dtype != DT_INVALID) {
-              if (!feature.ParseFloatList(&out.float_list)) {
-                return parse_error();
-              }
-              if (out.float_list.size() % num_elements != 0) {
-                return shape_error(out.float_list.size(), "float");
-              }
-            }
-            out.example_end_indices.push_back(out.float_list.size());
-            break;
-          }
-          case DT_STRING: {
-            if (example_dtype != DT_INVALID) {
-              if (!feature.ParseBytesList(&out.bytes_list)) {
-                return parse_error();
-              }
-              if (out.bytes_list.size() % num_elements != 0) {
-                return shape_error(out.bytes_list.size(), "bytes");
-              }
-            }
-            out.example_end_indices.push_back(out.bytes_list.size());
-            break;
-          }
-          default:
-            LOG(FATAL) << "Should not happen.";
         }
+        out.feature = feature;
+        out.num_values = num_values;
 
         if (output_stats) {
-          // Use `out.example_end_indices` to determine the feature-value count
-          // for this feature, because the preceding switch statement pushes
-          // the length of the appropriate feature list to that vector.
           // TODO(b/111553342): If desirable, we could add support for counting
           // elements in the features that aren't parsed, but this could add
           // considerable runtime cost.
-          const size_t out_examples_count = out.example_end_indices.size();
-          if (out_examples_count == 1) {
-            output_stats->feature_values_count += out.example_end_indices[0];
-          } else {
-            output_stats->feature_values_count +=
-                out.example_end_indices[out_examples_count - 1] -
-                out.example_end_indices[out_examples_count - 2];
-          }
+          output_stats->feature_values_count += num_values;
         }
       }
     } else {
@@ -797,7 +945,9 @@ Status FastParseSerializedExample(
       last_example[d] = example_index;
 
       // Handle sparse features.
-      SparseBuffer& out = is_ragged ? (*output_ragged)[d] : (*output_sparse)[d];
+      SparseFeatureValues& out = is_ragged
+                                     ? (*output_ragged)[d][example_index]
+                                     : (*output_sparse)[d][example_index];
       DataType feature_dtype =
           is_ragged ? config.ragged[d].dtype : config.sparse[d].dtype;
       if (example_dtype != DT_INVALID && example_dtype != feature_dtype) {
@@ -807,53 +957,20 @@ Status FastParseSerializedExample(
                             ", Actual type: ", DataTypeString(example_dtype)));
       }
 
-      switch (feature_dtype) {
-        case DT_INT64: {
-          if (example_dtype != DT_INVALID) {
-            if (!feature.ParseInt64List(&out.int64_list)) {
-              return parse_error();
-            }
-          }
-          out.example_end_indices.push_back(out.int64_list.size());
-          break;
+      if (example_dtype != DT_INVALID) {
+        int num_values;
+        if (!GetNumElementsInList(feature_dtype, &feature, &num_values)) {
+          return parse_error();
         }
-        case DT_FLOAT: {
-          if (example_dtype != DT_INVALID) {
-            if (!feature.ParseFloatList(&out.float_list)) {
-              return parse_error();
-            }
-          }
-          out.example_end_indices.push_back(out.float_list.size());
-          break;
-        }
-        case DT_STRING: {
-          if (example_dtype != DT_INVALID) {
-            if (!feature.ParseBytesList(&out.bytes_list)) {
-              return parse_error();
-            }
-          }
-          out.example_end_indices.push_back(out.bytes_list.size());
-          break;
-        }
-        default:
-          LOG(FATAL) << "Should not happen.";
+        out.feature = feature;
+        out.num_values = num_values;
       }
 
       if (output_stats) {
-        // Use `out.example_end_indices` to determine the feature-value count
-        // for this feature, because the preceding switch statement pushes
-        // the length of the appropriate feature list to that vector.
         // TODO(b/111553342): If desirable, we could add support for counting
         // elements in the features that aren't parsed, but this could add
         // considerable runtime cost.
-        const size_t out_examples_count = out.example_end_indices.size();
-        if (out_examples_count == 1) {
-          output_stats->feature_values_count += out.example_end_indices[0];
-        } else {
-          output_stats->feature_values_count +=
-              out.example_end_indices[out_examples_count - 1] -
-              out.example_end_indices[out_examples_count - 2];
-        }
+        output_stats->feature_values_count += out.num_values;
       }
     }
   }
@@ -894,34 +1011,6 @@ Status FastParseSerializedExample(
     }
   }
 
-  // Handle missing varlen dense features.
-  for (size_t d = 0; d < config.dense.size(); ++d) {
-    if (!config.dense[d].variable_length) continue;
-    if (dense_feature_last_example[d] == example_index) continue;
-    SparseBuffer& out = (*output_varlen_dense)[d];
-    size_t prev_example_end_index =
-        out.example_end_indices.empty() ? 0 : out.example_end_indices.back();
-    out.example_end_indices.push_back(prev_example_end_index);
-  }
-
-  // Handle missing sparse features.
-  for (size_t d = 0; d < config.sparse.size(); ++d) {
-    if (sparse_feature_last_example[d] == example_index) continue;
-    SparseBuffer& out = (*output_sparse)[d];
-    size_t prev_example_end_index =
-        out.example_end_indices.empty() ? 0 : out.example_end_indices.back();
-    out.example_end_indices.push_back(prev_example_end_index);
-  }
-
-  // Handle missing ragged features.
-  for (size_t d = 0; d < config.ragged.size(); ++d) {
-    if (ragged_feature_last_example[d] == example_index) continue;
-    SparseBuffer& out = (*output_ragged)[d];
-    size_t prev_example_end_index =
-        out.example_end_indices.empty() ? 0 : out.example_end_indices.back();
-    out.example_end_indices.push_back(prev_example_end_index);
-  }
-
   return Status::OK();
 }
 
@@ -963,23 +1052,6 @@ Status CheckConfigDataTypes(const Config& config) {
   return Status::OK();
 }
 
-template <typename T>
-const SmallVector<T>& GetListFromBuffer(const SparseBuffer& buffer);
-
-template <>
-const SmallVector<int64>& GetListFromBuffer<int64>(const SparseBuffer& buffer) {
-  return buffer.int64_list;
-}
-template <>
-const SmallVector<float>& GetListFromBuffer<float>(const SparseBuffer& buffer) {
-  return buffer.float_list;
-}
-template <>
-const SmallVector<tstring>& GetListFromBuffer<tstring>(
-    const SparseBuffer& buffer) {
-  return buffer.bytes_list;
-}
-
 template <typename T>
 void CopyOrMoveBlock(const T* b, const T* e, T* t) {
   std::copy(b, e, t);
@@ -989,49 +1061,6 @@ void CopyOrMoveBlock(const tstring* b, const tstring* e, tstring* t) {
   std::move(b, e, t);
 }
 
-template <typename T>
-void FillAndCopyVarLen(
-    const int d, const size_t num_elements,
-    const size_t num_elements_per_minibatch, const Config& config,
-    const std::vector<std::vector<SparseBuffer>>& varlen_dense_buffers,
-    Tensor* values) {
-  const Tensor& default_value = config.dense[d].default_value;
-
-  // Copy-fill the tensors (creating the zero/fill-padding)
-  std::fill(values->flat<T>().data(), values->flat<T>().data() + num_elements,
-            default_value.flat<T>()(0));
-
-  // Data is [batch_size, max_num_elements, data_stride_size]
-  //   and num_elements_per_minibatch = max_num_elements * data_stride_size
-  auto data = values->flat<T>().data();
-
-  // Iterate over minibatch elements
-  for (size_t i = 0; i < varlen_dense_buffers.size(); ++i) {
-    const SparseBuffer& buffer = varlen_dense_buffers[i][d];
-    // Number of examples being stored in this buffer
-    const auto& end_indices = buffer.example_end_indices;
-    const size_t examples_in_buffer = end_indices.size();
-    // const size_t stride_size = config.dense[d].elements_per_stride;
-
-    const auto& list = GetListFromBuffer<T>(buffer);
-    auto list_ptr = list.begin();
-
-    size_t elements_tally = 0;
-    // Iterate through all the examples stored in this buffer.
-    for (size_t j = 0; j < examples_in_buffer; ++j) {
-      // Number of elements stored for this example.
-      const size_t num_elems = end_indices[j] - elements_tally;
-      CopyOrMoveBlock(list_ptr, list_ptr + num_elems, data);
-      // Move forward this many elements in the varlen buffer.
-      list_ptr += num_elems;
-      // Move forward to the next minibatch entry in the values output.
-      data += num_elements_per_minibatch;
-      elements_tally = end_indices[j];
-    }
-    DCHECK(elements_tally == list.size());
-  }
-}
-
 // Thin vector like interface wrapper around a Tensor. This enable us to
 // directly populate a tensor during parsing instead of having to first create a
 // vactor and then copy the data over.
@@ -1067,37 +1096,50 @@ class TensorVector {
   T* data_ = nullptr;
 };
 
-void CountSparseFeatures(
-    const std::vector<std::vector<SparseBuffer>>& sparse_buffers, size_t d,
-    size_t* total_num_features, size_t* max_num_features) {
-  for (auto& sparse_values_tmp : sparse_buffers) {
-    const std::vector<size_t>& end_indices =
-        sparse_values_tmp[d].example_end_indices;
-    *total_num_features += end_indices.back();
-    *max_num_features = std::max(*max_num_features, end_indices[0]);
-    for (size_t i = 1; i < end_indices.size(); ++i) {
-      size_t example_size = end_indices[i] - end_indices[i - 1];
-      *max_num_features = std::max(*max_num_features, example_size);
+// Parses the `num_values` values of `feature` straight into the elements of
+// `out` starting at `offset`.
+bool ParseListIntoTensor(DataType dtype, parsed::Feature feature,
+                         size_t offset, size_t num_values, Tensor* out) {
+  switch (dtype) {
+    case DT_INT64: {
+      LimitedArraySlice<int64> slice(out->flat<int64>().data() + offset,
+                                     num_values);
+      return feature.ParseInt64List(&slice) && slice.EndDistance() == 0;
+    }
+    case DT_FLOAT: {
+      LimitedArraySlice<float> slice(out->flat<float>().data() + offset,
+                                     num_values);
+      return feature.ParseFloatList(&slice) && slice.EndDistance() == 0;
     }
+    case DT_STRING: {
+      LimitedArraySlice<tstring> slice(out->flat<tstring>().data() + offset,
+                                       num_values);
+      return feature.ParseBytesList(&slice) && slice.EndDistance() == 0;
+    }
+    default:
+      ReportUnexpectedDataType(dtype);
+      return false;
   }
 }
 
-void CopySparseBufferToTensor(DataType dtype, size_t offset, SparseBuffer* src,
-                              Tensor* dst) {
+// Fills the elements [begin, end) of `out` with the scalar `default_value`.
+void FillWithDefaultValue(DataType dtype, const Tensor& default_value,
+                          size_t begin, size_t end, Tensor* out) {
+  if (begin == end) return;
   switch (dtype) {
     case DT_INT64: {
-      std::copy(src->int64_list.begin(), src->int64_list.end(),
-                dst->flat<int64>().data() + offset);
+      int64* data = out->flat<int64>().data();
+      std::fill(data + begin, data + end, default_value.flat<int64>()(0));
       break;
     }
     case DT_FLOAT: {
-      std::copy(src->float_list.begin(), src->float_list.end(),
-                dst->flat<float>().data() + offset);
+      float* data = out->flat<float>().data();
+      std::fill(data + begin, data + end, default_value.flat<float>()(0));
       break;
     }
     case DT_STRING: {
-      std::move(src->bytes_list.begin(), src->bytes_list.end(),
-                dst->flat<tstring>().data() + offset);
+      tstring* data = out->flat<tstring>().data();
+      std::fill(data + begin, data + end, default_value.flat<tstring>()(0));
       break;
     }
     default:
@@ -1200,15 +1242,22 @@ Status FastParseExample(const Config& config,
   //   in small batches.
   //   Maybe accept outside parameter #num_minibatches?
 
-  // Do minibatches in parallel.
-  std::vector<std::vector<SparseBuffer>> sparse_buffers(num_minibatches);
-  std::vector<std::vector<SparseBuffer>> varlen_dense_buffers(num_minibatches);
-  std::vector<std::vector<SparseBuffer>> ragged_buffers(num_minibatches);
+  // First pass: do minibatches in parallel, parsing fixed length dense values
+  // straight into their outputs and counting all other values.
+  const size_t batch_size = serialized.size();
+  std::vector<std::vector<SparseFeatureValues>> sparse_values(
+      config.sparse.size(), std::vector<SparseFeatureValues>(batch_size));
+  std::vector<std::vector<SparseFeatureValues>> varlen_dense_values(
+      config.dense.size());
+  std::vector<std::vector<SparseFeatureValues>> ragged_values(
+      config.ragged.size(), std::vector<SparseFeatureValues>(batch_size));
+  for (size_t d = 0; d < config.dense.size(); ++d) {
+    if (config.dense[d].variable_length) {
+      varlen_dense_values[d].resize(batch_size);
+    }
+  }
   std::vector<Status> status_of_minibatch(num_minibatches);
   auto ProcessMiniBatch = [&](size_t minibatch) {
-    sparse_buffers[minibatch].resize(config.sparse.size());
-    varlen_dense_buffers[minibatch].resize(config.dense.size());
-    ragged_buffers[minibatch].resize(config.ragged.size());
     size_t start = first_example_of_minibatch(minibatch);
     size_t end = first_example_of_minibatch(minibatch + 1);
     for (size_t e = start; e < end; ++e) {
@@ -1219,9 +1268,8 @@ Status FastParseExample(const Config& config,
       status_of_minibatch[minibatch] = FastParseSerializedExample(
           serialized[e],
           (!example_names.empty() ? example_names[e] : "<unknown>"), e, config,
-          config_index, hasher, &fixed_dense_values,
-          &varlen_dense_buffers[minibatch], &sparse_buffers[minibatch],
-          &ragged_buffers[minibatch], stats);
+          config_index, hasher, &fixed_dense_values, &varlen_dense_values,
+          &sparse_values, &ragged_values, stats);
       if (!status_of_minibatch[minibatch].ok()) break;
     }
   };
@@ -1243,179 +1291,156 @@ Status FastParseExample(const Config& config,
     result->dense_values.push_back(std::move(fixed_dense_values[d]));
   }
 
-  // Merge SparseBuffers from all minibatches for every config.sparse.
-  auto MergeSparseMinibatches = [&](size_t d) {
-    // Loop over minibatches
+  // Size the outputs of every config.sparse from the counts of the first pass.
+  for (size_t d = 0; d < config.sparse.size(); ++d) {
     size_t total_num_features = 0;
     size_t max_num_features = 0;
-    CountSparseFeatures(sparse_buffers, d, &total_num_features,
-                        &max_num_features);
+    for (SparseFeatureValues& values : sparse_values[d]) {
+      values.offset = total_num_features;
+      total_num_features += values.num_values;
+      max_num_features = std::max(max_num_features, values.num_values);
+    }
 
     TensorShape indices_shape;
     indices_shape.AddDim(total_num_features);
     indices_shape.AddDim(2);
     result->sparse_indices.emplace_back(DT_INT64, indices_shape);
-    Tensor* indices = &result->sparse_indices.back();
 
     TensorShape values_shape;
     values_shape.AddDim(total_num_features);
     result->sparse_values.emplace_back(config.sparse[d].dtype, values_shape);
-    Tensor* values = &result->sparse_values.back();
 
     result->sparse_shapes.emplace_back(DT_INT64, TensorShape({2}));
     auto shapes_shape_t = result->sparse_shapes.back().vec<int64>();
-    shapes_shape_t(0) = serialized.size();
+    shapes_shape_t(0) = batch_size;
     shapes_shape_t(1) = max_num_features;
+  }
 
-    size_t offset = 0;
-    for (size_t i = 0; i < sparse_buffers.size(); ++i) {
-      SparseBuffer& buffer = sparse_buffers[i][d];
-
-      // Update indices.
-      size_t delta = 0;
-
-      if (indices->NumElements() > 0) {
-        int64* ix_p = &indices->matrix<int64>()(offset, 0);
-        size_t example_index = first_example_of_minibatch(i);
-        for (size_t example_end_index : buffer.example_end_indices) {
-          size_t feature_index = 0;
-          for (; delta < example_end_index; ++delta) {
-            // Column 0: example index
-            *ix_p = example_index;
-            // Column 1: the feature index buffer example
-            *(ix_p + 1) = feature_index;
-            ix_p += 2;
-            ++feature_index;
-          }
-          ++example_index;
-        }
-      }
-
-      CopySparseBufferToTensor(config.sparse[d].dtype, offset, &buffer, values);
-      offset += delta;
-    }
-  };
-
-  // Merge SparseBuffers from all minibatches for every config.ragged.
-  auto MergeRaggedMinibatches = [&](size_t d) {
-    // Loop over minibatches
-    size_t total_num_features = 0;
-    size_t max_num_features = 0;
-    CountSparseFeatures(ragged_buffers, d, &total_num_features,
-                        &max_num_features);
-
+  // Size the outputs of every config.ragged. Row splits are the running totals
+  // of the counts of the first pass.
+  for (size_t d = 0; d < config.ragged.size(); ++d) {
     TensorShape row_splits_shape;
-    row_splits_shape.AddDim(serialized.size() + 1);
+    row_splits_shape.AddDim(batch_size + 1);
     result->ragged_splits.emplace_back(config.ragged[d].splits_dtype,
                                        row_splits_shape);
     Tensor* row_splits = &result->ragged_splits.back();
+
+    size_t total_num_features = 0;
+    for (size_t e = 0; e < batch_size; ++e) {
+      SparseFeatureValues& values = ragged_values[d][e];
+      values.offset = total_num_features;
+      if (config.ragged[d].splits_dtype == DT_INT64) {
+        row_splits->flat<int64>()(e) = total_num_features;
+      } else {
+        row_splits->flat<int32>()(e) = total_num_features;
+      }
+      total_num_features += values.num_values;
+    }
     if (config.ragged[d].splits_dtype == DT_INT64) {
-      row_splits->flat<int64>()(0) = 0;
+      row_splits->flat<int64>()(batch_size) = total_num_features;
     } else {
-      row_splits->flat<int32>()(0) = 0;
+      row_splits->flat<int32>()(batch_size) = total_num_features;
     }
 
     TensorShape values_shape;
     values_shape.AddDim(total_num_features);
     result->ragged_values.emplace_back(config.ragged[d].dtype, values_shape);
-    Tensor* values = &result->ragged_values.back();
-
-    size_t values_offset = 0;
-    size_t splits_offset = 0;
-    for (size_t i = 0; i < ragged_buffers.size(); ++i) {
-      SparseBuffer& buffer = ragged_buffers[i][d];
-      if (buffer.example_end_indices.empty()) continue;
-
-      // Update row_splits.  row_splits are formed by concatenating the example
-      // end_indices (adjusting each to start after the previous one ends).
-      if (config.ragged[d].splits_dtype == DT_INT64) {
-        int64* row_splits_out = &row_splits->flat<int64>()(splits_offset);
-        int64 start = *row_splits_out;
-        for (size_t example_end_index : buffer.example_end_indices) {
-          *++row_splits_out = start + example_end_index;
-        }
-      } else {
-        int32* row_splits_out = &row_splits->flat<int32>()(splits_offset);
-        int32 start = *row_splits_out;
-        for (size_t example_end_index : buffer.example_end_indices) {
-          *++row_splits_out = start + example_end_index;
-        }
-      }
-
-      CopySparseBufferToTensor(config.ragged[d].dtype, values_offset, &buffer,
-                               values);
-      values_offset += buffer.example_end_indices.back();
-      splits_offset += buffer.example_end_indices.size();
-    }
-  };
-
-  // Merge SparseBuffers from all minibatches for every config.dense having
-  // variable_length.
-  auto MergeDenseVarLenMinibatches = [&](size_t d) {
-    if (!config.dense[d].variable_length) return;
+  }
 
-    // Loop over minibatches
+  // Size the outputs of every config.dense having variable_length. Their
+  // values are padded to the largest number of values of any example.
+  for (size_t d = 0; d < config.dense.size(); ++d) {
+    if (!config.dense[d].variable_length) continue;
     size_t max_num_features = 0;
-    for (auto& dense_values_tmp : varlen_dense_buffers) {
-      std::vector<size_t>& end_indices =
-          dense_values_tmp[d].example_end_indices;
-      max_num_features = std::max(max_num_features, end_indices[0]);
-      for (size_t i = 1; i < end_indices.size(); ++i) {
-        size_t example_size = end_indices[i] - end_indices[i - 1];
-        max_num_features = std::max(max_num_features, example_size);
-      }
+    for (const SparseFeatureValues& values : varlen_dense_values[d]) {
+      max_num_features = std::max(max_num_features, values.num_values);
+    }
+    for (size_t e = 0; e < batch_size; ++e) {
+      varlen_dense_values[d][e].offset = e * max_num_features;
     }
 
     const size_t stride_size = config.dense[d].elements_per_stride;
     const size_t max_num_elements = max_num_features / stride_size;
     TensorShape values_shape;
     DCHECK_EQ(max_num_features % config.dense[d].elements_per_stride, 0);
-    const size_t batch_size = serialized.size();
     values_shape.AddDim(batch_size);
     values_shape.AddDim(max_num_elements);
     for (int i = 1; i < config.dense[d].shape.dims(); ++i) {
       values_shape.AddDim(config.dense[d].shape.dim_size(i));
     }
-    Tensor values(config.dense[d].dtype, values_shape);
-    result->dense_values[d] = values;
-    const size_t num_elements = values.NumElements();
-
-    // Nothing to write, exit early.
-    if (num_elements == 0) return;
-
-    const size_t num_elements_per_minibatch = num_elements / batch_size;
+    result->dense_values[d] = Tensor(config.dense[d].dtype, values_shape);
+  }
 
-    switch (config.dense[d].dtype) {
-      case DT_INT64: {
-        FillAndCopyVarLen<int64>(d, num_elements, num_elements_per_minibatch,
-                                 config, varlen_dense_buffers, &values);
-        break;
+  // Second pass: do minibatches in parallel again, parsing all other values
+  // straight into the sized outputs.
+  auto WriteMiniBatch = [&](size_t minibatch) {
+    size_t start = first_example_of_minibatch(minibatch);
+    size_t end = first_example_of_minibatch(minibatch + 1);
+    for (size_t e = start; e < end; ++e) {
+      auto parse_error = [&](StringPiece feature_name) {
+        return errors::InvalidArgument(
+            "Name: ", (!example_names.empty() ? example_names[e] : "<unknown>"),
+            ", Key: ", feature_name, ", Index: ", e,
+            ".  Can't parse serialized Example.");
+      };
+
+      for (size_t d = 0; d < config.sparse.size(); ++d) {
+        const SparseFeatureValues& values = sparse_values[d][e];
+        if (values.num_values > 0) {
+          // Column 0: example index, column 1: the feature index in example.
+          int64* ix_p = result->sparse_indices[d].flat<int64>().data() +
+                        2 * values.offset;
+          for (size_t i = 0; i < values.num_values; ++i) {
+            *ix_p++ = e;
+            *ix_p++ = i;
+          }
+        }
+        if (!values.feature.GetSerialized().empty() &&
+            !ParseListIntoTensor(config.sparse[d].dtype, values.feature,
+                                 values.offset, values.num_values,
+                                 &result->sparse_values[d])) {
+          return parse_error(config.sparse[d].feature_name);
+        }
       }
-      case DT_FLOAT: {
-        FillAndCopyVarLen<float>(d, num_elements, num_elements_per_minibatch,
-                                 config, varlen_dense_buffers, &values);
-        break;
+
+      for (size_t d = 0; d < config.ragged.size(); ++d) {
+        const SparseFeatureValues& values = ragged_values[d][e];
+        if (!values.feature.GetSerialized().empty() &&
+            !ParseListIntoTensor(config.ragged[d].dtype, values.feature,
+                                 values.offset, values.num_values,
+                                 &result->ragged_values[d])) {
+          return parse_error(config.ragged[d].feature_name);
+        }
       }
-      case DT_STRING: {
-        FillAndCopyVarLen<tstring>(d, num_elements, num_elements_per_minibatch,
-                                   config, varlen_dense_buffers, &values);
-        break;
+
+      for (size_t d = 0; d < config.dense.size(); ++d) {
+        if (!config.dense[d].variable_length) continue;
+        const SparseFeatureValues& values = varlen_dense_values[d][e];
+        Tensor* out = &result->dense_values[d];
+        if (!values.feature.GetSerialized().empty() &&
+            !ParseListIntoTensor(config.dense[d].dtype, values.feature,
+                                 values.offset, values.num_values, out)) {
+          return parse_error(config.dense[d].feature_name);
+        }
+        // Fill the padding of the example.
+        const size_t num_elements_per_example = out->NumElements() / batch_size;
+        FillWithDefaultValue(config.dense[d].dtype,
+                             config.dense[d].default_value,
+                             values.offset + values.num_values,
+                             values.offset + num_elements_per_example, out);
       }
-      default:
-        ReportUnexpectedDataType(config.dense[d].dtype);
     }
+    return Status::OK();
   };
 
-  for (size_t d = 0; d < config.dense.size(); ++d) {
-    MergeDenseVarLenMinibatches(d);
-  }
-
-  for (size_t d = 0; d < config.sparse.size(); ++d) {
-    MergeSparseMinibatches(d);
-  }
+  ParallelFor(
+      [&](size_t minibatch) {
+        status_of_minibatch[minibatch] = WriteMiniBatch(minibatch);
+      },
+      num_minibatches, thread_pool);
 
-  for (size_t d = 0; d < config.ragged.size(); ++d) {
-    MergeRaggedMinibatches(d);
+  for (Status& status : status_of_minibatch) {
+    TF_RETURN_IF_ERROR(status);
   }
 
   return Status::OK();
@@ -249,6 +249,24 @@ static string ExampleWithSomeFeatures() {
 
 TEST(FastParse, SomeFeatures) { TestCorrectness(ExampleWithSomeFeatures()); }
 
+TEST(FastParse, PackedInt64OfAllVarintLengths) {
+  Example example;
+  Int64List* int64_list =
+      (*example.mutable_features()->mutable_feature())["int64_list"]
+          .mutable_int64_list();
+  // A run of single-byte varints, followed by varints of 1 to 10 bytes.
+  for (int i = 0; i < 40; ++i) {
+    int64_list->add_value(i);
+  }
+  for (int shift = 0; shift < 64; ++shift) {
+    const uint64 power = uint64{1} << shift;
+    int64_list->add_value(static_cast<int64>(power));
+    int64_list->add_value(static_cast<int64>(power - 1));
+    int64_list->add_value(static_cast<int64>(~power + 1));
+  }
+  TestCorrectness(Serialize(example));
+}
+
 static void AddDenseFeature(const char* feature_name, DataType dtype,
                             PartialTensorShape shape, bool variable_length,
                             size_t elements_per_stride,
@@ -413,6 +431,69 @@ TEST(FastParse, FuzzTest) {
   }
 }
 
+TEST(TestFastParseExample, SparseRaggedAndVarLenDense) {
+  // Example e has e % 4 values of every feature. Examples with no values
+  // alternately have empty features and no features at all.
+  const int kNumExamples = 20;
+  std::vector<tstring> serialized;
+  for (int e = 0; e < kNumExamples; ++e) {
+    Example example;
+    if (e % 8 != 0) {
+      auto& features = *example.mutable_features()->mutable_feature();
+      Int64List* ids = features["ids"].mutable_int64_list();
+      FloatList* scores = features["scores"].mutable_float_list();
+      BytesList* tokens = features["tokens"].mutable_bytes_list();
+      for (int i = 0; i < e % 4; ++i) {
+        ids->add_value(int64{1000} * e + i);
+        scores->add_value(e + 0.5f * i);
+        tokens->add_value(strings::StrCat(e, "_", i));
+      }
+    }
+    serialized.push_back(Serialize(example));
+  }
+
+  FastParseExampleConfig config;
+  AddSparseFeature("ids", DT_INT64, &config);
+  config.ragged.emplace_back("scores", DT_FLOAT, DT_INT64);
+  AddDenseFeature("tokens", DT_STRING, {-1}, true, 1, &config);
+  config.dense.back().default_value.scalar<tstring>()() = "pad";
+
+  Result result;
+  TF_CHECK_OK(FastParseExample(config, serialized, {}, nullptr, &result));
+
+  const int64 total = 30;  // 5 examples each with 1, 2 and 3 values.
+  ASSERT_EQ(result.sparse_indices[0].dim_size(0), total);
+  ASSERT_EQ(result.sparse_values[0].NumElements(), total);
+  EXPECT_EQ(result.sparse_shapes[0].vec<int64>()(0), kNumExamples);
+  EXPECT_EQ(result.sparse_shapes[0].vec<int64>()(1), 3);
+  ASSERT_EQ(result.ragged_splits[0].NumElements(), kNumExamples + 1);
+  ASSERT_EQ(result.ragged_values[0].NumElements(), total);
+  ASSERT_EQ(result.dense_values[0].shape(), TensorShape({kNumExamples, 3}));
+
+  const auto indices = result.sparse_indices[0].matrix<int64>();
+  const auto ids = result.sparse_values[0].vec<int64>();
+  const auto splits = result.ragged_splits[0].vec<int64>();
+  const auto scores = result.ragged_values[0].vec<float>();
+  const auto tokens = result.dense_values[0].matrix<tstring>();
+  int64 offset = 0;
+  for (int e = 0; e < kNumExamples; ++e) {
+    EXPECT_EQ(splits(e), offset);
+    for (int i = 0; i < 3; ++i) {
+      if (i < e % 4) {
+        EXPECT_EQ(indices(offset, 0), e);
+        EXPECT_EQ(indices(offset, 1), i);
+        EXPECT_EQ(ids(offset), int64{1000} * e + i);
+        EXPECT_EQ(scores(offset), e + 0.5f * i);
+        EXPECT_EQ(strings::StrCat(e, "_", i), tokens(e, i));
+        ++offset;
+      } else {
+        EXPECT_EQ("pad", tokens(e, i));
+      }
+    }
+  }
+  EXPECT_EQ(splits(kNumExamples), total);
+}
+
 TEST(TestFastParseExample, Empty) {
   Result result;
   FastParseExampleConfig config;
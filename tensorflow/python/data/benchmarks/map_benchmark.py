@@ -69,6 +69,69 @@ class MapBenchmark(benchmark_base.DatasetBenchmarkBase):
                        "_single_threaded")
       benchmark_helper(fan_out, lambda *xs: xs, True, "_short_circuit")
 
+  def benchmark_direct_kernels(self):
+    # Functions of up to four ops run by calling their kernels directly, and
+    # larger functions run through the executor, so the difference between
+    # the per-element times of the two largest functions reflects the
+    # per-element overhead of the executor.
+
+    def benchmark_helper(num_additions, use_inter_op_parallelism, label):
+
+      def fn(x):
+        one = constant_op.constant(1, dtype=x.dtype)
+        for _ in range(num_additions):
+          x = x + one
+        return x
+
+      dataset = dataset_ops.Dataset.range(10000)
+      dataset = dataset_ops.MapDataset(
+          dataset, fn, use_inter_op_parallelism=use_inter_op_parallelism)
+      self.run_and_report_benchmark(
+          dataset,
+          num_elements=10000,
+          name="direct_kernels_num_ops_%d%s" % (num_additions + 1, label),
+          extras={"direct": num_additions + 1 <= 4})
+
+    for num_additions in [1, 2, 3, 4, 8]:
+      benchmark_helper(num_additions, True, "")
+      benchmark_helper(num_additions, False, "_single_threaded")
+
+  def benchmark_parallel_map_micro_batch(self):
+
+    def benchmark_helper(cost, micro_batch_size, deterministic):
+
+      def fn(x):
+        # Each addition runs as a separate kernel, so `cost` controls the
+        # per-element cost of the map function.
+        for _ in range(cost):
+          x = x + 1
+        return x
+
+      dataset = dataset_ops.Dataset.range(1000000)
+      dataset = dataset_ops.ParallelMapDataset(
+          dataset,
+          fn,
+          num_parallel_calls=4,
+          deterministic=deterministic,
+          use_inter_op_parallelism=False,
+          micro_batch_size=micro_batch_size)
+      num_elements = 100000
+      wall_time = self.run_benchmark(dataset, num_elements=num_elements)
+      self.report_benchmark(
+          wall_time=wall_time,
+          iters=1,
+          name="parallel_map_cost_%d_micro_batch_%d%s" %
+          (cost, micro_batch_size, "" if deterministic else "_nondeterministic"),
+          extras={
+              "num_elements": num_elements,
+              "elements_per_sec": 1.0 / wall_time
+          })
+
+    for cost in [1, 4, 16, 64]:
+      for micro_batch_size in [0, 8, 64]:
+        for deterministic in [True, False]:
+          benchmark_helper(cost, micro_batch_size, deterministic)
+
   def benchmark_stats(self):
     for stats in [True, False]:
       dataset = dataset_ops.Dataset.range(1000).repeat()
@@ -40,11 +40,13 @@ from tensorflow.python.ops import bitwise_ops
 from tensorflow.python.ops import check_ops
 from tensorflow.python.ops import clip_ops
 from tensorflow.python.ops import control_flow_ops
+from tensorflow.python.ops import image_ops
 from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import nn
 from tensorflow.python.ops import parsing_ops
 from tensorflow.python.ops import script_ops
 from tensorflow.python.ops import special_math_ops
+from tensorflow.python.ops import string_ops
 from tensorflow.python.platform import test
 
 
@@ -459,6 +461,91 @@ class MapVectorizationTest(test_base.DatasetTestBase, parameterized.TestCase):
     for map_fn in map_fns:
       self._testOptimization(map_fn, dataset_factory, num_parallel_calls)
 
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         combinations.combine(num_parallel_calls=[None, 12])))
+  def testReduction(self, num_parallel_calls):
+    data = np.random.rand(10, 3, 4)
+    dataset_factory = lambda: dataset_ops.Dataset.from_tensors(data).repeat(5)
+    map_fns = [
+        lambda x: math_ops.reduce_sum(x, axis=1),
+        lambda x: math_ops.reduce_mean(x, axis=[0, -1], keepdims=True),
+        lambda x: math_ops.reduce_max(x, axis=-2),
+        lambda x: math_ops.reduce_any(x > 0.5, axis=0),
+    ]
+    for map_fn in map_fns:
+      self._testOptimization(map_fn, dataset_factory, num_parallel_calls)
+
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         combinations.combine(num_parallel_calls=[None, 12])))
+  def testExpandDimsAndSqueeze(self, num_parallel_calls):
+    data = np.random.rand(10, 1, 3)
+    dataset_factory = lambda: dataset_ops.Dataset.from_tensors(data).repeat(5)
+    map_fns = [
+        lambda x: array_ops.expand_dims(x, 0),
+        lambda x: array_ops.expand_dims(x, -1),
+        lambda x: array_ops.squeeze(x, axis=[1]),
+        lambda x: array_ops.squeeze(x, axis=[-2]),
+    ]
+    for map_fn in map_fns:
+      self._testOptimization(map_fn, dataset_factory, num_parallel_calls)
+
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         combinations.combine(num_parallel_calls=[None, 12])))
+  def testDecodeRaw(self, num_parallel_calls):
+    data = np.random.randint(0, 256, (10, 12)).astype(np.uint8)
+    records = [row.tobytes() for row in data]
+    dataset_factory = (
+        lambda: dataset_ops.Dataset.from_tensor_slices(records).repeat(5))
+
+    def map_fn(x):
+      x = parsing_ops.decode_raw(x, dtypes.uint8)
+      return array_ops.reshape(x, [3, 4])
+
+    self._testOptimization(map_fn, dataset_factory, num_parallel_calls)
+
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         combinations.combine(num_parallel_calls=[None, 12])))
+  def testImageNormalization(self, num_parallel_calls):
+    data = np.random.randint(0, 256, (8, 8, 3)).astype(np.uint8)
+    dataset_factory = lambda: dataset_ops.Dataset.from_tensors(data).repeat(5)
+
+    def map_fn(image):
+      image = math_ops.cast(image, dtypes.float32) / 255.0
+      image = image_ops.adjust_contrast(image, 1.5)
+      image = image_ops.adjust_saturation(image, 0.5)
+      image = image_ops.adjust_hue(image, 0.1)
+      image = clip_ops.clip_by_value(image, 0.0, 1.0)
+      mean = math_ops.reduce_mean(image, axis=[0, 1], keepdims=True)
+      return image - mean
+
+    self._testOptimization(map_fn, dataset_factory, num_parallel_calls)
+
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         combinations.combine(num_parallel_calls=[None, 12])))
+  def testTabularPreprocessing(self, num_parallel_calls):
+
+    def dataset_factory():
+      return dataset_ops.Dataset.from_tensor_slices(
+          ["1.5,  A,7", "-3.0,b ,2", "0.25,C,9"]).repeat(5)
+
+    def map_fn(x):
+      price, category, quantity = parsing_ops.decode_csv(
+          x, record_defaults=[[0.0], [""], [0]])
+      price = string_ops.string_to_number(string_ops.as_string(price))
+      bucket = math_ops._bucketize(  # pylint: disable=protected-access
+          price, boundaries=[-1.0, 0.0, 1.0])
+      category = string_ops.string_lower(string_ops.string_strip(category))
+      category_id = string_ops.string_to_hash_bucket_fast(category, 10)
+      quantity = math_ops.cast(quantity, dtypes.float32)
+      return bucket, category_id, math_ops.log1p(quantity)
+
+    self._testOptimization(map_fn, dataset_factory, num_parallel_calls)
+
   @combinations.generate(test_base.default_test_combinations())
   def testOptimizationBadMapFn(self):
     # Test map functions that give an error
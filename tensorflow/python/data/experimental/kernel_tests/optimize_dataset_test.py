@@ -320,6 +320,7 @@ class OptimizeDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
     options.experimental_optimization.map_fusion = True
     options.experimental_optimization.noop_elimination = True
     options.experimental_optimization.parallel_batch = True
+    options.experimental_optimization.preallocate_batch = True
     options.experimental_optimization.shuffle_and_repeat_fusion = True
     options.experimental_optimization.map_vectorization.enabled = True
     options.experimental_optimization.autotune_buffers = True
@@ -337,6 +338,7 @@ class OptimizeDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
         "map_fusion",
         "noop_elimination",
         "parallel_batch",
+        "preallocate_batch",
         "shuffle_and_repeat_fusion",
         "map_vectorization",
         "inject_prefetch",
@@ -367,6 +369,7 @@ class OptimizeDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
     options.experimental_optimization.map_fusion = False
     options.experimental_optimization.noop_elimination = False
     options.experimental_optimization.parallel_batch = False
+    options.experimental_optimization.preallocate_batch = False
     options.experimental_optimization.shuffle_and_repeat_fusion = False
     options.experimental_optimization.map_vectorization.enabled = False
     options.experimental_optimization.autotune = False
@@ -385,6 +388,7 @@ class OptimizeDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
         "map_fusion",
         "noop_elimination",
         "parallel_batch",
+        "preallocate_batch",
         "shuffle_and_repeat_fusion",
         "map_vectorization",
         "inject_prefetch",
@@ -406,23 +410,53 @@ class OptimizeDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
     options = dataset_ops.Options()
 
     # Check defaults
-    autotune, algorithm, cpu_budget = options._autotune_settings()
+    autotune, algorithm, cpu_budget, ram_budget, rss_limit = (
+        options._autotune_settings())
     self.assertTrue(autotune)
     self.assertEqual(algorithm,
                      optimization_options._AutotuneAlgorithm.HILL_CLIMB)
     self.assertEqual(cpu_budget, 0)
+    self.assertEqual(ram_budget, 0)
+    self.assertEqual(rss_limit, 0)
 
   @combinations.generate(test_base.default_test_combinations())
   def testAutotuningBufferSizes(self):
     options = dataset_ops.Options()
     options.experimental_optimization.autotune_buffers = True
     self.assertIn("inject_prefetch", options._graph_rewrites().enabled)
-    autotune, algorithm, cpu_budget = options._autotune_settings()
+    autotune, algorithm, cpu_budget, _, _ = options._autotune_settings()
     self.assertTrue(autotune)
     self.assertEqual(algorithm,
                      optimization_options._AutotuneAlgorithm.GRADIENT_DESCENT)
     self.assertEqual(cpu_budget, 0)
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testAutotuningRamBudgetAndRssLimit(self):
+    options = dataset_ops.Options()
+    options.experimental_optimization.autotune_ram_budget = 2**30
+    options.experimental_optimization.autotune_rss_limit = 2**33
+    _, _, _, ram_budget, rss_limit = options._autotune_settings()
+    self.assertEqual(ram_budget, 2**30)
+    self.assertEqual(rss_limit, 2**33)
+
+    dataset = dataset_ops.Dataset.range(10)
+    dataset = dataset.map(
+        lambda x: x * 2, num_parallel_calls=dataset_ops.AUTOTUNE)
+    dataset = dataset.with_options(options)
+    self.assertDatasetProduces(
+        dataset, expected_output=[x * 2 for x in range(10)])
+
+  @combinations.generate(test_base.graph_only_combinations())
+  def testAutotuningRamBudgetAndRssLimitAttrs(self):
+    options = dataset_ops.Options()
+    options.experimental_optimization.autotune_ram_budget = 2**30
+    options.experimental_optimization.autotune_rss_limit = 2**33
+    dataset = dataset_ops.Dataset.range(10).with_options(options)
+    model_op = dataset._apply_options()._variant_tensor.op
+    self.assertEqual(model_op.type, "ModelDataset")
+    self.assertEqual(model_op.get_attr("ram_budget"), 2**30)
+    self.assertEqual(model_op.get_attr("rss_limit"), 2**33)
+
 
 if __name__ == "__main__":
   test.main()
@@ -35,11 +35,16 @@ from tensorflow.python.util.tf_export import tf_export
 
 class ProcessingMode(object):
   PARALLEL_EPOCHS = "parallel_epochs"
+  ONE_EPOCH = "one_epoch"
+  SHARED_EPOCH = "shared_epoch"
 
   @staticmethod
   def validate(mode):
     """Raises a ValueError if the given object is not a valid processing mode."""
-    valid_modes = [ProcessingMode.PARALLEL_EPOCHS]
+    valid_modes = [
+        ProcessingMode.PARALLEL_EPOCHS, ProcessingMode.ONE_EPOCH,
+        ProcessingMode.SHARED_EPOCH
+    ]
     if mode not in valid_modes:
       raise ValueError(
           "{0} is not a valid processing mode. Valid modes: {1}".format(
@@ -303,7 +308,8 @@ def distribute(processing_mode,
   iteration.
 
   The `processing_mode` argument controls what data is produced by a tf.data
-  service job. Currently, the only supported mode is "parallel_epochs".
+  service job. The supported modes are "parallel_epochs", "one_epoch" and
+  "shared_epoch".
 
   processing_mode="parallel_epochs" means that multiple tf.data workers will
   iterate through the dataset in parallel, each producing all elements of the
@@ -314,9 +320,30 @@ def distribute(processing_mode,
   your dataset, so that different tf.data workers will iterate through the
   dataset in different orders.
 
-  In the future, there will be additional processing modes. For example,
-  a "one_epoch" mode which partitions the dataset across the tf.data
-  workers, so that the consumers see each element of the dataset only once.
+  processing_mode="one_epoch" means that the dataset is partitioned across the
+  tf.data workers, so that the consumers see each element of the dataset only
+  once. The dataset is divided into many small splits, which workers request
+  from the dispatcher as they finish their previous split, so faster workers
+  process more of the dataset. Splits are taken at the source of the dataset:
+  `TFRecordDataset`, `TextLineDataset` and `FixedLengthRecordDataset` over a
+  constant list of files read a range of the files, and datasets that start
+  from `range` or `from_tensor_slices` (e.g. a list of file names that is
+  interleaved over) are split by the elements of their source, so the rest of
+  the input pipeline only runs on the elements of each split. Datasets that
+  cannot be split this way, e.g. because they zip several datasets or use
+  `take` or `skip`, are processed by a single worker.
+
+  processing_mode="shared_epoch" produces the same elements as
+  "parallel_epochs", but lets jobs that read the same dataset (for example the
+  trainers of a hyperparameter sweep) share the elements that each tf.data
+  worker produces, instead of each job running the dataset separately. Every
+  worker keeps a sliding window of recently produced elements. Jobs that start
+  before the window drops its first element share it, and later jobs start a
+  new epoch of their own, so every job reads every element. The fastest job
+  can only get a window's worth of elements ahead of the slowest one, unless
+  the slowest job stops reading for longer than the worker's
+  `shared_epoch_stall_timeout_ms`; that job then fails with a `DataLossError`
+  if it resumes after elements it had not read were dropped.
 
   ```
   dataset = tf.data.Dataset.range(5)
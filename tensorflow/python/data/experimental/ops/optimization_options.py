@@ -117,6 +117,25 @@ class OptimizationOptions(options.OptionsBase):
       "are allowed but may result in CPU contention. If None, defaults to the "
       "number of schedulable CPU cores.")
 
+  autotune_ram_budget = options.create_option(
+      name="autotune_ram_budget",
+      ty=int,
+      docstring=
+      "When autotuning is enabled (through `autotune`), determines the RAM "
+      "budget (in bytes) for the buffers of the tuned transformations. The "
+      "autotuner never picks buffer sizes whose worst-case total size exceeds "
+      "the budget. If None, defaults to half of the available RAM.")
+
+  autotune_rss_limit = options.create_option(
+      name="autotune_rss_limit",
+      ty=int,
+      docstring=
+      "When autotuning is enabled (through `autotune`), determines the "
+      "resident set size (in bytes) of the process that the autotuner aims to "
+      "stay below. As the process approaches the limit, the autotuner shrinks "
+      "the buffers of the tuned transformations. If None, the resident set "
+      "size is not limited.")
+
   filter_fusion = options.create_option(
       name="filter_fusion",
       ty=bool,
@@ -189,6 +208,17 @@ class OptimizationOptions(options.OptionsBase):
       "batching and b) you have validated that this optimization improves "
       "performance. If None, defaults to False.")
 
+  preallocate_batch = options.create_option(
+      name="preallocate_batch",
+      ty=bool,
+      docstring="Whether to allocate each batch as soon as its first element "
+      "is available and copy every element into the batch as soon as it is "
+      "produced, recycling batch buffers across steps. This lowers the peak "
+      "memory used by batching and avoids faulting in fresh memory for every "
+      "batch. It has no effect on batches whose size is not known when they "
+      "are started, i.e. very large batches with `drop_remainder=False`. If "
+      "None, defaults to False.")
+
   reorder_data_discarding_ops = options.create_option(
       name="reorder_data_discarding_ops",
       ty=bool,
@@ -223,14 +253,20 @@ class OptimizationOptions(options.OptionsBase):
         _AutotuneAlgorithm.GRADIENT_DESCENT
         if self._autotune_buffers() else _AutotuneAlgorithm.HILL_CLIMB)
     cpu_budget = 0  # Indicates that all CPU cores should be used by default.
+    ram_budget = 0  # Indicates that half of the available RAM should be used.
+    rss_limit = 0  # Indicates that the resident set size is not limited.
 
     # Set these options if they are explicitly set by the user.
     if self.autotune is False:  # pylint: disable=g-bool-id-comparison
       autotune = False
     if self.autotune_cpu_budget is not None:
       cpu_budget = self.autotune_cpu_budget
+    if self.autotune_ram_budget is not None:
+      ram_budget = self.autotune_ram_budget
+    if self.autotune_rss_limit is not None:
+      rss_limit = self.autotune_rss_limit
 
-    return autotune, algorithm, cpu_budget
+    return autotune, algorithm, cpu_budget, ram_budget, rss_limit
 
   def _graph_rewrites(self):
     """Produces lists of enabled, disabled and default graph optimizations.
@@ -257,6 +293,7 @@ class OptimizationOptions(options.OptionsBase):
         "map_fusion",
         "noop_elimination",
         "parallel_batch",
+        "preallocate_batch",
         "reorder_data_discarding_ops",
         "shuffle_and_repeat_fusion",
     ]
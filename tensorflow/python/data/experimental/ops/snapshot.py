@@ -204,7 +204,9 @@ class _SnapshotDataset(dataset_ops.UnaryUnchangedStructureDataset):
                compression=None,
                reader_func=None,
                pending_snapshot_expiry_seconds=None,
-               use_legacy_function=False):
+               use_legacy_function=False,
+               pipeline_buffer_size=None,
+               shard_size_bytes=None):
 
     if reader_func is None:
       reader_func = lambda datasets: datasets.interleave(  # pylint:disable=g-long-lambda
@@ -244,6 +246,8 @@ class _SnapshotDataset(dataset_ops.UnaryUnchangedStructureDataset):
         compression=compression,
         reader_func=self._reader_func.function,
         shard_func=self._shard_func.function,
+        pipeline_buffer_size=pipeline_buffer_size or 0,
+        shard_size_bytes=shard_size_bytes or 0,
         **self._flat_structure)
     super(_SnapshotDataset, self).__init__(input_dataset, variant_tensor)
 
@@ -255,7 +259,12 @@ class _SnapshotDataset(dataset_ops.UnaryUnchangedStructureDataset):
 
 
 @tf_export("data.experimental.snapshot")
-def snapshot(path, compression="AUTO", reader_func=None, shard_func=None):
+def snapshot(path,
+             compression="AUTO",
+             reader_func=None,
+             shard_func=None,
+             pipeline_buffer_size=None,
+             shard_size_bytes=None):
   """API to persist the output of the input dataset.
 
   The snapshot API allows users to transparently persist the output of their
@@ -326,6 +335,13 @@ def snapshot(path, compression="AUTO", reader_func=None, shard_func=None):
       shards.
     shard_func: Optional. A function to control how to shard data when writing a
       snapshot.
+    pipeline_buffer_size: Optional. If positive, elements are compressed and
+      decompressed on the tf.data thread pool, overlapped with file I/O, with
+      up to this many elements in flight per snapshot file. With `SNAPPY`
+      compression, this writes snapshot files that compress each element
+      separately.
+    shard_size_bytes: Optional. If positive, a new snapshot file is started in
+      a shard once the current file holds about this many bytes.
 
   Returns:
     A `Dataset` transformation function, which can be passed to
@@ -341,6 +357,8 @@ def snapshot(path, compression="AUTO", reader_func=None, shard_func=None):
           path=path,
           compression=compression,
           reader_func=reader_func,
+          pipeline_buffer_size=pipeline_buffer_size,
+          shard_size_bytes=shard_size_bytes,
           # This will not do the right thing where the graph is built on a
           # different machine than the executor (e.g. Cloud TPUs).
           shard_func=lambda index, _: index % multiprocessing.cpu_count())
@@ -351,6 +369,8 @@ def snapshot(path, compression="AUTO", reader_func=None, shard_func=None):
           path=path,
           compression=compression,
           reader_func=reader_func,
-          shard_func=shard_func)
+          shard_func=shard_func,
+          pipeline_buffer_size=pipeline_buffer_size,
+          shard_size_bytes=shard_size_bytes)
 
   return _apply_fn
@@ -31,6 +31,7 @@ from tensorflow.python.data.experimental.ops import testing
 from tensorflow.python.data.experimental.service import server_lib
 from tensorflow.python.data.kernel_tests import test_base
 from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.ops import readers
 from tensorflow.python.eager import def_function
 from tensorflow.python.framework import combinations
 from tensorflow.python.framework import constant_op
@@ -39,6 +40,7 @@ from tensorflow.python.framework import errors
 from tensorflow.python.framework import random_seed
 from tensorflow.python.framework import sparse_tensor
 from tensorflow.python.framework import tensor_spec
+from tensorflow.python.lib.io import python_io
 from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import random_ops
 from tensorflow.python.ops import sparse_ops
@@ -159,6 +161,76 @@ class DataServiceOpsTest(test_base.DatasetTestBase, parameterized.TestCase):
     results = [elem.numpy() for elem in ds]
     self.assertEqual(list(range(num_elements)), results)
 
+  @combinations.generate(test_base.eager_only_combinations())
+  def testDistributeOneEpoch(self):
+    num_workers = 3
+    dispatcher, workers = self.start_cluster(num_workers)  # to avoid gcing workers, pylint: disable=unused-variable
+    num_elements = 100
+    ds = dataset_ops.Dataset.range(num_elements)
+    ds = ds.apply(
+        data_service_ops._distribute(
+            data_service_ops.ProcessingMode.ONE_EPOCH,
+            dispatcher.target,
+            task_refresh_interval_hint_ms=20))
+    results = [elem.numpy() for elem in ds]
+    self.assertCountEqual(list(range(num_elements)), results)
+
+  @combinations.generate(test_base.eager_only_combinations())
+  def testDistributeOneEpochFewerElementsThanSplits(self):
+    dispatcher, workers = self.start_cluster(2)  # to avoid gcing workers, pylint: disable=unused-variable
+    ds = dataset_ops.Dataset.range(5)
+    ds = ds.apply(
+        data_service_ops._distribute(
+            data_service_ops.ProcessingMode.ONE_EPOCH,
+            dispatcher.target,
+            task_refresh_interval_hint_ms=20))
+    results = [elem.numpy() for elem in ds]
+    self.assertCountEqual(list(range(5)), results)
+
+  @combinations.generate(test_base.eager_only_combinations())
+  def testDistributeOneEpochFewerFilesThanSplits(self):
+    dispatcher, workers = self.start_cluster(2)  # to avoid gcing workers, pylint: disable=unused-variable
+    filenames = []
+    expected = []
+    for i in range(3):
+      filename = os.path.join(self.get_temp_dir(), "file_%d.tfrecord" % i)
+      with python_io.TFRecordWriter(filename) as writer:
+        for j in range(5):
+          record = b"file_%d_record_%d" % (i, j)
+          writer.write(record)
+          expected.append(record)
+      filenames.append(filename)
+    ds = dataset_ops.Dataset.from_tensor_slices(filenames)
+    ds = ds.interleave(readers.TFRecordDataset, cycle_length=2)
+    ds = ds.apply(
+        data_service_ops._distribute(
+            data_service_ops.ProcessingMode.ONE_EPOCH,
+            dispatcher.target,
+            task_refresh_interval_hint_ms=20))
+    results = [elem.numpy() for elem in ds]
+    self.assertCountEqual(expected, results)
+
+  @combinations.generate(test_base.eager_only_combinations())
+  def testSharedEpoch(self):
+    dispatcher, workers = self.start_cluster(1)  # to avoid gcing workers, pylint: disable=unused-variable
+    num_elements = 100
+    datasets = []
+    for _ in range(2):
+      ds = dataset_ops.Dataset.range(num_elements)
+      datasets.append(
+          ds.apply(
+              data_service_ops._distribute(
+                  data_service_ops.ProcessingMode.SHARED_EPOCH,
+                  dispatcher.target,
+                  task_refresh_interval_hint_ms=20)))
+    iterators = [iter(ds) for ds in datasets]
+    results = [[], []]
+    for _ in range(num_elements):
+      for i, iterator in enumerate(iterators):
+        results[i].append(next(iterator).numpy())
+    for result in results:
+      self.assertEqual(list(range(num_elements)), result)
+
   @combinations.generate(test_base.eager_only_combinations())
   def testDispatcherStop(self):
     dispatcher, workers = self.start_cluster(1)  # to avoid gcing workers, pylint: disable=unused-variable
@@ -392,10 +392,12 @@ class DatasetV2(collections_abc.Iterable, tracking_base.Trackable,
                                  graph_rewrites.default, graph_rewrite_configs)
 
     # (3) Apply autotune options
-    autotune, algorithm, cpu_budget = options._autotune_settings()  # pylint: disable=protected-access
+    autotune, algorithm, cpu_budget, ram_budget, rss_limit = (
+        options._autotune_settings())  # pylint: disable=protected-access
 
     if autotune:
-      dataset = _ModelDataset(dataset, algorithm, cpu_budget)
+      dataset = _ModelDataset(dataset, algorithm, cpu_budget, ram_budget,
+                              rss_limit)
 
     # (4) Apply stats aggregator options
     if options.experimental_stats and options.experimental_stats.aggregator:  # pylint: disable=line-too-long
@@ -4130,10 +4132,12 @@ class ParallelMapDataset(UnaryDataset):
                deterministic,
                use_inter_op_parallelism=True,
                preserve_cardinality=False,
-               use_legacy_function=False):
+               use_legacy_function=False,
+               micro_batch_size=0):
     """See `Dataset.map()` for details."""
     self._input_dataset = input_dataset
     self._use_inter_op_parallelism = use_inter_op_parallelism
+    self._micro_batch_size = micro_batch_size
     self._map_func = StructuredFunctionWrapper(
         map_func,
         self._transformation_name(),
@@ -4156,6 +4160,7 @@ class ParallelMapDataset(UnaryDataset):
         deterministic=self._deterministic,
         use_inter_op_parallelism=self._use_inter_op_parallelism,
         preserve_cardinality=self._preserve_cardinality,
+        micro_batch_size=self._micro_batch_size,
         **self._flat_structure)
     super(ParallelMapDataset, self).__init__(input_dataset, variant_tensor)
 
@@ -4429,12 +4434,19 @@ class _OptionsDataset(UnaryUnchangedStructureDataset):
 class _ModelDataset(UnaryUnchangedStructureDataset):
   """A `Dataset` that acts as an identity, and models performance."""
 
-  def __init__(self, input_dataset, algorithm, cpu_budget):
+  def __init__(self,
+               input_dataset,
+               algorithm,
+               cpu_budget,
+               ram_budget=0,
+               rss_limit=0):
     self._input_dataset = input_dataset
     variant_tensor = gen_dataset_ops.model_dataset(
         input_dataset._variant_tensor,  # pylint: disable=protected-access
         algorithm=algorithm.value,
         cpu_budget=cpu_budget,
+        ram_budget=ram_budget,
+        rss_limit=rss_limit,
         **self._flat_structure)
     super(_ModelDataset, self).__init__(input_dataset, variant_tensor)
 
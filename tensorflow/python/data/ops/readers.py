@@ -202,7 +202,12 @@ class TextLineDatasetV1(dataset_ops.DatasetV1Adapter):
 class _TFRecordDataset(dataset_ops.DatasetSource):
   """A `Dataset` comprising records from one or more TFRecord files."""
 
-  def __init__(self, filenames, compression_type=None, buffer_size=None):
+  def __init__(self,
+               filenames,
+               compression_type=None,
+               buffer_size=None,
+               read_ahead_size=None,
+               use_direct_io=None):
     """Creates a `TFRecordDataset`.
 
     Args:
@@ -211,6 +216,11 @@ class _TFRecordDataset(dataset_ops.DatasetSource):
         `""` (no compression), `"ZLIB"`, or `"GZIP"`.
       buffer_size: (Optional.) A `tf.int64` scalar representing the number of
         bytes in the read buffer. 0 means no buffering.
+      read_ahead_size: (Optional.) A Python integer representing the number of
+        bytes of reads to keep in flight for each uncompressed file. 0 or
+        `None` disables read-ahead.
+      use_direct_io: (Optional.) A Python boolean indicating whether to read
+        uncompressed files with direct I/O in read-ahead mode.
     """
     self._filenames = filenames
     self._compression_type = convert.optional_param_to_tensor(
@@ -222,9 +232,12 @@ class _TFRecordDataset(dataset_ops.DatasetSource):
         "buffer_size",
         buffer_size,
         argument_default=_DEFAULT_READER_BUFFER_SIZE_BYTES)
-    variant_tensor = gen_dataset_ops.tf_record_dataset(self._filenames,
-                                                       self._compression_type,
-                                                       self._buffer_size)
+    variant_tensor = gen_dataset_ops.tf_record_dataset(
+        self._filenames,
+        self._compression_type,
+        self._buffer_size,
+        read_ahead_size=read_ahead_size or 0,
+        use_direct_io=bool(use_direct_io))
     super(_TFRecordDataset, self).__init__(variant_tensor)
 
   @property
@@ -294,7 +307,9 @@ class TFRecordDatasetV2(dataset_ops.DatasetV2):
                filenames,
                compression_type=None,
                buffer_size=None,
-               num_parallel_reads=None):
+               num_parallel_reads=None,
+               read_ahead_size=None,
+               use_direct_io=None):
     """Creates a `TFRecordDataset` to read one or more TFRecord files.
 
     Args:
@@ -312,6 +327,14 @@ class TFRecordDatasetV2(dataset_ops.DatasetV2):
         input pipeline is I/O bottlenecked, consider setting this parameter to a
         value greater than one to parallelize the I/O. If `None`, files will be
         read sequentially.
+      read_ahead_size: (Optional.) A Python integer representing the number of
+        bytes of reads to keep in flight for each uncompressed file, so that
+        several large reads overlap with parsing the records. Consider setting
+        this parameter on fast local storage. If `None` or 0, each file is read
+        one buffer at a time.
+      use_direct_io: (Optional.) A Python boolean. If `True` and
+        `read_ahead_size` is set, uncompressed files are read with direct I/O,
+        bypassing the page cache, where the file system supports it.
 
     Raises:
       TypeError: If any argument does not have the expected type.
@@ -323,9 +346,12 @@ class TFRecordDatasetV2(dataset_ops.DatasetV2):
     self._compression_type = compression_type
     self._buffer_size = buffer_size
     self._num_parallel_reads = num_parallel_reads
+    self._read_ahead_size = read_ahead_size
+    self._use_direct_io = use_direct_io
 
     def creator_fn(filename):
-      return _TFRecordDataset(filename, compression_type, buffer_size)
+      return _TFRecordDataset(filename, compression_type, buffer_size,
+                              read_ahead_size, use_direct_io)
 
     self._impl = _create_dataset_reader(creator_fn, filenames,
                                         num_parallel_reads)
@@ -336,11 +362,15 @@ class TFRecordDatasetV2(dataset_ops.DatasetV2):
              filenames=None,
              compression_type=None,
              buffer_size=None,
-             num_parallel_reads=None):
+             num_parallel_reads=None,
+             read_ahead_size=None,
+             use_direct_io=None):
     return TFRecordDatasetV2(filenames or self._filenames, compression_type or
                              self._compression_type, buffer_size or
                              self._buffer_size, num_parallel_reads or
-                             self._num_parallel_reads)
+                             self._num_parallel_reads, read_ahead_size or
+                             self._read_ahead_size, use_direct_io or
+                             self._use_direct_io)
 
   def _inputs(self):
     return self._impl._inputs()  # pylint: disable=protected-access
@@ -358,9 +388,12 @@ class TFRecordDatasetV1(dataset_ops.DatasetV1Adapter):
                filenames,
                compression_type=None,
                buffer_size=None,
-               num_parallel_reads=None):
+               num_parallel_reads=None,
+               read_ahead_size=None,
+               use_direct_io=None):
     wrapped = TFRecordDatasetV2(filenames, compression_type, buffer_size,
-                                num_parallel_reads)
+                                num_parallel_reads, read_ahead_size,
+                                use_direct_io)
     super(TFRecordDatasetV1, self).__init__(wrapped)
 
   __init__.__doc__ = TFRecordDatasetV2.__init__.__doc__
@@ -369,13 +402,17 @@ class TFRecordDatasetV1(dataset_ops.DatasetV1Adapter):
              filenames=None,
              compression_type=None,
              buffer_size=None,
-             num_parallel_reads=None):
+             num_parallel_reads=None,
+             read_ahead_size=None,
+             use_direct_io=None):
     # pylint: disable=protected-access
     return TFRecordDatasetV1(
         filenames or self._dataset._filenames, compression_type or
         self._dataset._compression_type, buffer_size or
         self._dataset._buffer_size, num_parallel_reads or
-        self._dataset._num_parallel_reads)
+        self._dataset._num_parallel_reads, read_ahead_size or
+        self._dataset._read_ahead_size, use_direct_io or
+        self._dataset._use_direct_io)
 
   @property
   def _filenames(self):